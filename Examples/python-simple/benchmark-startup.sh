@@ -0,0 +1,31 @@
+#!/usr/bin/env bash
+
+# Measures the cold-start time of Python under Graphene: the time to start the
+# enclave, load the interpreter with its libraries and run an empty script.
+#
+# Run like: SGX=1 ./benchmark-startup.sh
+#
+# To compare the startup time with and without precomputed chunk hashes of
+# trusted files, rebuild the manifest in between:
+#
+#   make clean && make SGX=1 && SGX=1 ./benchmark-startup.sh
+#   make clean && make SGX=1 PRECOMPUTE_CHUNK_HASHES=1 && SGX=1 ./benchmark-startup.sh
+
+LOOP=${LOOP:-10}
+SCRIPT=${SCRIPT:-scripts/helloworld.py}
+
+TOTAL=0
+RUN=0
+while [ $RUN -lt $LOOP ]
+do
+    START=$(date +%s%N)
+    ./pal_loader python.manifest $SCRIPT > /dev/null || exit $?
+    END=$(date +%s%N)
+
+    TIME=$(( (END - START) / 1000000 ))
+    echo "run $RUN: $TIME ms"
+    TOTAL=$(( TOTAL + TIME ))
+    RUN=$(( RUN + 1 ))
+done
+
+echo "average startup time: $(( TOTAL / LOOP )) ms"
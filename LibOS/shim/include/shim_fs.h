@@ -41,6 +41,13 @@ struct shim_handle;
 #define FS_POLL_ER 0x04
 #define FS_POLL_SZ 0x08
 
+/* flags of sync_file_range() */
+#ifndef SYNC_FILE_RANGE_WAIT_BEFORE
+#define SYNC_FILE_RANGE_WAIT_BEFORE 1
+#define SYNC_FILE_RANGE_WRITE       2
+#define SYNC_FILE_RANGE_WAIT_AFTER  4
+#endif
+
 struct shim_fs_ops {
     /* mount: mount an uri to the certain location */
     int (*mount)(const char* uri, void** mount_data);
@@ -55,6 +62,18 @@ struct shim_fs_ops {
     /* write: the content from the file opened as handle */
     ssize_t (*write)(struct shim_handle* hdl, const void* buf, size_t count);
 
+    /* pread, pwrite: the content at an offset, without using or moving the position of the
+     * handle; these may be called concurrently on the same handle (see shim_aio.c) */
+    ssize_t (*pread)(struct shim_handle* hdl, void* buf, size_t count, off_t pos);
+    ssize_t (*pwrite)(struct shim_handle* hdl, const void* buf, size_t count, off_t pos);
+
+    /* readv, writev: the content at the position of the handle, scattered over (gathered from)
+     * several buffers with one PAL call; preadv, pwritev: the same at an offset */
+    ssize_t (*readv)(struct shim_handle* hdl, const struct iovec* vec, size_t vlen);
+    ssize_t (*writev)(struct shim_handle* hdl, const struct iovec* vec, size_t vlen);
+    ssize_t (*preadv)(struct shim_handle* hdl, const struct iovec* vec, size_t vlen, off_t pos);
+    ssize_t (*pwritev)(struct shim_handle* hdl, const struct iovec* vec, size_t vlen, off_t pos);
+
     /* mmap: mmap handle to address */
     int (*mmap)(struct shim_handle* hdl, void** addr, size_t size, int prot, int flags,
                 off_t offset);
@@ -72,6 +91,14 @@ struct shim_fs_ops {
     /* Returns 0 on success, -errno on error */
     int (*truncate)(struct shim_handle* hdl, off_t len);
 
+    /* fallocate: allocate the storage of a range of the file (FALLOC_FL_* mode);
+     * fadvise: a hint on how the range is going to be accessed (POSIX_FADV_*);
+     * sync_range: write back the modified data of the range (SYNC_FILE_RANGE_* flags).
+     * Returns 0 on success, -errno on error */
+    int (*fallocate)(struct shim_handle* hdl, int mode, off_t offset, off_t len);
+    int (*fadvise)(struct shim_handle* hdl, off_t offset, off_t len, int advice);
+    int (*sync_range)(struct shim_handle* hdl, off_t offset, off_t nbytes, int flags);
+
     /* hstat: get status of the file */
     int (*hstat)(struct shim_handle* hdl, struct stat* buf);
 
@@ -528,6 +555,9 @@ extern struct shim_mount pipe_builtin_fs;
 extern struct shim_mount socket_builtin_fs;
 extern struct shim_mount epoll_builtin_fs;
 extern struct shim_mount eventfd_builtin_fs;
+extern struct shim_mount shm_builtin_fs;
+extern struct shim_mount timerfd_builtin_fs;
+extern struct shim_mount signalfd_builtin_fs;
 
 /* pseudo file systems (separate treatment since they don't have associated dentries) */
 #define DIR_RX_MODE  0555
@@ -540,6 +570,9 @@ extern struct shim_d_ops dev_d_ops;
 extern struct shim_fs_ops proc_fs_ops;
 extern struct shim_d_ops proc_d_ops;
 
+extern struct shim_fs_ops sys_fs_ops;
+extern struct shim_d_ops sys_d_ops;
+
 struct pseudo_name_ops {
     int (*match_name)(const char* name);
     int (*list_name)(const char* name, struct shim_dirent** buf, int count);
@@ -50,7 +50,9 @@ enum shim_handle_type {
     TYPE_FUTEX,
     TYPE_STR,
     TYPE_EPOLL,
-    TYPE_EVENTFD
+    TYPE_EVENTFD,
+    TYPE_TIMERFD,
+    TYPE_SIGNALFD
 };
 
 struct shim_handle;
@@ -224,9 +226,14 @@ struct shim_dir_handle {
     struct shim_dentry** ptr;
 };
 
+DEFINE_LIST(shim_shm_handle);
 struct shim_shm_handle {
-    /* XXX: need to implement */
-    void* __reserved;
+    unsigned long shmkey; /* segment key from user, if known to this process */
+    IDTYPE shmid;         /* segment identifier */
+    size_t size;          /* segment size, rounded up to the allocation alignment */
+    int perm;             /* access permissions */
+    int nattch;           /* number of attachments through this handle */
+    LIST_TYPE(shim_shm_handle) list;
 };
 
 struct msg_type;
@@ -302,15 +309,29 @@ DEFINE_LIST(shim_epoll_item);
 DEFINE_LISTP(shim_epoll_item);
 struct shim_epoll_handle {
     int maxfds;
-    int waiter_cnt;
 
     int pal_cnt;
-    PAL_HANDLE* pal_handles;
+    PAL_HANDLE wait_set; /* PAL wait set of the items' PAL handles, created on first use */
 
-    AEVENTTYPE event;
     LISTP_TYPE(shim_epoll_item) fds;
 };
 
+struct async_timer;
+
+/* pal_handle of a timerfd is an event which is readable while expirations are pending */
+struct shim_timerfd_handle {
+    int clockid;
+    struct async_timer* timer; /* created on first timerfd_settime() */
+};
+
+/* pal_handle of a signalfd is `event`, which is readable while signals of `mask` may be pending */
+DEFINE_LIST(shim_signalfd_handle);
+struct shim_signalfd_handle {
+    __sigset_t mask;
+    AEVENTTYPE event;
+    LIST_TYPE(shim_signalfd_handle) list; /* list of signalfds of the process */
+};
+
 struct shim_mount;
 struct shim_qstr;
 struct shim_dentry;
@@ -319,10 +340,12 @@ struct shim_dentry;
  */
 struct shim_handle {
     enum shim_handle_type type;
+    char fs_type[8];
 
+    /* Kept clear of the free-list node that memmgr overlays on freed handles: get_fd_handle()
+     * may read it on a handle that is concurrently being freed (see get_handle_if_live()). */
     REFTYPE ref_count;
 
-    char fs_type[8];
     struct shim_mount* fs;
     struct shim_qstr path;
     struct shim_dentry* dentry;
@@ -346,6 +369,8 @@ struct shim_handle {
         struct shim_sem_handle sem;
         struct shim_str_handle str;
         struct shim_epoll_handle epoll;
+        struct shim_timerfd_handle timerfd;
+        struct shim_signalfd_handle signalfd;
     } info;
 
     struct shim_dir_handle dir_info;
@@ -381,6 +406,10 @@ struct shim_handle_map {
 
     /* An array of file descriptor belong to this mapping */
     struct shim_fd_handle** map;
+
+    /* Arrays replaced by enlarging the map; lock-free readers may still be walking them, so they
+     * are only freed together with the map */
+    struct shim_retired_fd_map* retired;
 };
 
 /* allocating file descriptors */
@@ -166,6 +166,10 @@ void handle_signal (void);
 long convert_pal_errno (long err);
 void syscall_wrapper(void);
 void syscall_wrapper_after_syscalldb(void);
+void syscall_trampoline(void);
+
+/* raw syscall instructions rewritten at load time / still emulated in illegal_upcall() */
+extern unsigned long syscalls_patched, syscalls_trapped;
 
 #define PAL_ERRNO  convert_pal_errno(PAL_NATIVE_ERRNO)
 
@@ -179,15 +183,34 @@ static inline int64_t get_cur_preempt (void) {
     return atomic_read(&tcb->context.preempt);
 }
 
+/* per-syscall statistics ("sys.syscall_stats"), see shim_syscall_stats.c */
+struct syscall_stats_start {
+    uint64_t time; /* 0 if statistics were disabled when the syscall started */
+    PAL_NUM host_calls;
+    PAL_NUM host_exits;
+};
+
+extern bool syscall_stats_enabled;
+int init_syscall_stats(void);
+void syscall_stats_begin(struct syscall_stats_start* start);
+void syscall_stats_end(int sysno, const char* name, struct syscall_stats_start* start);
+int format_syscall_stats(char** strp, size_t* lenp);
+void dump_syscall_stats(void);
+
 #define BEGIN_SHIM(name, args ...)                          \
     SHIM_ARG_TYPE __shim_##name(args) {                     \
         SHIM_ARG_TYPE ret = 0;                              \
         int64_t preempt = get_cur_preempt();                \
         __UNUSED(preempt);                                  \
+        struct syscall_stats_start __stats = { .time = 0 }; \
+        if (syscall_stats_enabled)                          \
+            syscall_stats_begin(&__stats);                  \
         /* handle_signal(); */                              \
         /* check_stack_hook(); */
 
 #define END_SHIM(name)                                      \
+        if (__stats.time)                                   \
+            syscall_stats_end(__NR_##name, #name, &__stats); \
         handle_signal();                                    \
         assert(preempt == get_cur_preempt());               \
         return ret;                                         \
@@ -479,27 +502,50 @@ static inline void enable_preempt (shim_tcb_t * tcb)
     __enable_preempt(tcb);
 }
 
+/*
+ * LibOS locks live inline in the structure they protect and follow the three-state mutex from
+ * "Futexes Are Tricky": an uncontended lock() is a single compare-and-swap and an uncontended
+ * unlock() a single exchange. A thread that fails to take the lock spins for a short while
+ * (__lock_slow() in shim_lock.c) and then marks the lock as contended and sleeps on `sleep`, a
+ * PAL mutex which is only created when the lock is contended for the first time. The PAL mutex
+ * is used as a binary semaphore: it is created locked, a waiter sleeps by acquiring it and the
+ * unlocking thread wakes one waiter by releasing it. A release without a sleeping waiter is not
+ * lost, it lets the next waiter through, which then re-checks the lock state.
+ *
+ * SHIM_LOCK_UNINITIALIZED is the state of zeroed memory, so locks which have not gone through
+ * create_lock() (or were reset with clear_lock()) are detected.
+ */
+#define SHIM_LOCK_UNINITIALIZED 0
+#define SHIM_LOCK_UNLOCKED      1
+#define SHIM_LOCK_LOCKED        2
+#define SHIM_LOCK_CONTENDED     3
+
+void __lock_slow(struct shim_lock* l);
+void __unlock_wake(struct shim_lock* l);
+
 static inline bool lock_created(struct shim_lock* l)
 {
-    return l->lock != NULL;
+    return __atomic_load_n(&l->state, __ATOMIC_RELAXED) != SHIM_LOCK_UNINITIALIZED;
 }
 
 static inline void clear_lock(struct shim_lock* l)
 {
-    l->lock = NULL;
+    l->state = SHIM_LOCK_UNINITIALIZED;
+    l->sleep = NULL;
     l->owner = 0;
 }
 
 static inline bool create_lock(struct shim_lock* l) {
     l->owner = 0;
-    l->lock = DkMutexCreate(0);
-    return l->lock != NULL;
+    l->sleep = NULL;
+    __atomic_store_n(&l->state, SHIM_LOCK_UNLOCKED, __ATOMIC_RELEASE);
+    return true;
 }
 
 static inline void destroy_lock(struct shim_lock* l) {
-    DkObjectClose(l->lock);
-    l->lock = NULL;
-    l->owner = 0;
+    if (l->sleep)
+        DkObjectClose(l->sleep);
+    clear_lock(l);
 }
 
 #ifdef DEBUG
@@ -513,7 +559,7 @@ static void lock(struct shim_lock* l) {
     }
     /* TODO: This whole if should be just an assert. Change it once we are sure that it does not
      * trigger (previous code allowed for this case). Same in unlock below. */
-    if (!l->lock) {
+    if (!lock_created(l)) {
 #ifdef DEBUG
         debug("Trying to lock an uninitialized lock at %s:%d!\n", file, line);
 #endif // DEBUG
@@ -523,8 +569,10 @@ static void lock(struct shim_lock* l) {
     shim_tcb_t * tcb = shim_get_tcb();
     disable_preempt(tcb);
 
-    while (!DkSynchronizationObjectWait(l->lock, NO_TIMEOUT))
-        /* nop */;
+    int state = SHIM_LOCK_UNLOCKED;
+    if (!__atomic_compare_exchange_n(&l->state, &state, SHIM_LOCK_LOCKED, /*weak=*/false,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        __lock_slow(l);
 
     l->owner = tcb->tid;
 }
@@ -538,7 +586,7 @@ static inline void unlock(struct shim_lock* l) {
     if (!lock_enabled) {
         return;
     }
-    if (!l->lock) {
+    if (!lock_created(l)) {
 #ifdef DEBUG
         debug("Trying to unlock an uninitialized lock at %s:%d!\n", file, line);
 #endif // DEBUG
@@ -548,7 +596,8 @@ static inline void unlock(struct shim_lock* l) {
     shim_tcb_t* tcb = shim_get_tcb();
 
     l->owner = 0;
-    DkMutexRelease(l->lock);
+    if (__atomic_exchange_n(&l->state, SHIM_LOCK_UNLOCKED, __ATOMIC_RELEASE) == SHIM_LOCK_CONTENDED)
+        __unlock_wake(l);
     enable_preempt(tcb);
 }
 
@@ -556,7 +605,7 @@ static inline bool locked(struct shim_lock* l) {
     if (!lock_enabled) {
         return true;
     }
-    if (!l->lock) {
+    if (!lock_created(l)) {
         return false;
     }
     return get_cur_tid() == l->owner;
@@ -733,6 +782,17 @@ int init_loader (void);
 int init_manifest (PAL_HANDLE manifest_handle);
 int init_rlimit(void);
 
+/* startup tracing ("loader.startup_trace"), see shim_startup_trace.c */
+extern bool startup_trace_enabled;
+int init_startup_trace(uint64_t libos_start);
+void startup_trace_event(const char* name, const char* arg, uint64_t start, uint64_t end);
+void dump_startup_trace(void);
+
+/* returns 0 (and skips the PAL call) if startup tracing is disabled */
+static inline uint64_t startup_trace_time(void) {
+    return startup_trace_enabled ? DkSystemTimeQuery() : 0;
+}
+
 bool test_user_memory (void * addr, size_t size, bool write);
 bool test_user_string (const char * addr);
 
@@ -745,6 +805,9 @@ void release_clear_child_tid(int* clear_child_tid);
 
 void delete_from_epoll_handles(struct shim_handle* handle);
 
+/* pins the calling internal thread to the CPUs given by `sys.helper_cpus`, if any */
+void pin_helper_thread(void);
+
 #ifdef __x86_64__
 #define __SWITCH_STACK(stack_top, func, arg)                    \
     do {                                                        \
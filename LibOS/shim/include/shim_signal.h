@@ -138,6 +138,13 @@ void append_signal(struct shim_thread* thread, int sig, siginfo_t* info, bool ne
 
 void deliver_signal(siginfo_t* info, PAL_CONTEXT* context);
 
+/* Dequeue a pending signal of `thread` which is in `mask`; return its number and store its info
+ * in `info`, or return 0 if there is none. */
+int fetch_pending_signal(struct shim_thread* thread, const __sigset_t* mask, siginfo_t* info);
+
+/* wake up signalfds monitoring `sig` after it was queued as a blocked signal (shim_signalfd.c) */
+void signalfd_notify(int sig);
+
 __sigset_t * get_sig_mask (struct shim_thread * thread);
 __sigset_t * set_sig_mask (struct shim_thread * thread,
                            const __sigset_t * new_set);
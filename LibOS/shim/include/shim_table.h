@@ -314,6 +314,9 @@ long __shim_syncfs(long);
 long __shim_sendmmsg(long, long, long, long);
 long __shim_setns(long, long);
 long __shim_getcpu(long, long, long);
+long __shim_copy_file_range(long, long, long, long, long, long);
+long __shim_preadv2(long, long, long, long, long, long);
+long __shim_pwritev2(long, long, long, long, long, long);
 
 /* libos call entries */
 long __shim_msgpersist(long, long);
@@ -352,6 +355,10 @@ int shim_do_sched_yield(void);
 void* shim_do_mremap(void* addr, size_t old_len, size_t new_len, int flags, void* new_addr);
 int shim_do_msync(void* start, size_t len, int flags);
 int shim_do_mincore(void* start, size_t len, unsigned char* vec);
+int shim_do_madvise(void* start, size_t len, int behavior);
+int shim_do_shmget(key_t key, size_t size, int shmflg);
+void* shim_do_shmat(int shmid, const void* shmaddr, int shmflg);
+int shim_do_shmctl(int shmid, int cmd, struct shmid_ds* buf);
 int shim_do_dup(unsigned int fd);
 int shim_do_dup2(unsigned int oldfd, unsigned int newfd);
 int shim_do_pause(void);
@@ -391,6 +398,7 @@ int shim_do_uname(struct old_utsname* buf);
 int shim_do_semget(key_t key, int nsems, int semflg);
 int shim_do_semop(int semid, struct sembuf* sops, unsigned int nsops);
 int shim_do_semctl(int semid, int semnum, int cmd, unsigned long arg);
+int shim_do_shmdt(const void* shmaddr);
 int shim_do_msgget(key_t key, int msgflg);
 int shim_do_msgsnd(int msqid, const void* msgp, size_t msgsz, int msgflg);
 int shim_do_msgrcv(int msqid, void* msgp, size_t msgsz, long msgtyp, int msgflg);
@@ -447,14 +455,22 @@ void* shim_do_arch_prctl(int code, void* addr);
 int shim_do_setrlimit(int resource, struct __kernel_rlimit* rlim);
 int shim_do_chroot(const char* filename);
 pid_t shim_do_gettid(void);
+int shim_do_readahead(int fd, loff_t offset, size_t count);
 int shim_do_tkill(int pid, int sig);
 time_t shim_do_time(time_t* tloc);
 int shim_do_futex(int* uaddr, int op, int val, void* utime, int* uaddr2, int val3);
 int shim_do_sched_setaffinity(pid_t pid, size_t len, __kernel_cpu_set_t* user_mask_ptr);
 int shim_do_sched_getaffinity(pid_t pid, size_t len, __kernel_cpu_set_t* user_mask_ptr);
+int shim_do_io_setup(unsigned int nr_events, aio_context_t* ctxp);
+int shim_do_io_destroy(aio_context_t ctx_id);
+int shim_do_io_getevents(aio_context_t ctx_id, long min_nr, long nr, struct io_event* events,
+                         struct timespec* timeout);
+int shim_do_io_submit(aio_context_t ctx_id, long nr, struct iocb** iocbpp);
+int shim_do_io_cancel(aio_context_t ctx_id, struct iocb* iocb, struct io_event* result);
 int shim_do_set_tid_address(int* tidptr);
 int shim_do_semtimedop(int semid, struct sembuf* sops, unsigned int nsops,
                        const struct timespec* timeout);
+int shim_do_fadvise64(int fd, loff_t offset, size_t len, int advice);
 int shim_do_epoll_create(int size);
 size_t shim_do_getdents64(int fd, struct linux_dirent64* buf, size_t count);
 int shim_do_epoll_wait(int epfd, struct __kernel_epoll_event* events, int maxevents,
@@ -482,17 +498,37 @@ int shim_do_ppoll(struct pollfd* fds, int nfds, struct timespec* tsp, const __si
                   size_t sigsetsize);
 int shim_do_set_robust_list(struct robust_list_head* head, size_t len);
 int shim_do_get_robust_list(pid_t pid, struct robust_list_head** head, size_t* len);
+int shim_do_sync_file_range(int fd, loff_t offset, loff_t nbytes, int flags);
 int shim_do_epoll_pwait(int epfd, struct __kernel_epoll_event* events, int maxevents,
                         int timeout_ms, const __sigset_t* sigmask, size_t sigsetsize);
+int shim_do_signalfd(int ufd, __sigset_t* user_mask, size_t sizemask);
+int shim_do_timerfd_create(int clockid, int flags);
+int shim_do_fallocate(int fd, int mode, loff_t offset, loff_t len);
+int shim_do_timerfd_settime(int ufd, int flags, const struct __kernel_itimerspec* utmr,
+                            struct __kernel_itimerspec* otmr);
+int shim_do_timerfd_gettime(int ufd, struct __kernel_itimerspec* otmr);
 int shim_do_accept4(int sockfd, struct sockaddr* addr, socklen_t* addrlen, int flags);
+int shim_do_signalfd4(int ufd, __sigset_t* user_mask, size_t sizemask, int flags);
 int shim_do_dup3(unsigned int oldfd, unsigned int newfd, int flags);
 int shim_do_epoll_create1(int flags);
 int shim_do_pipe2(int* fildes, int flags);
+ssize_t shim_do_preadv(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                       unsigned long pos_h);
+ssize_t shim_do_pwritev(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                        unsigned long pos_h);
 ssize_t shim_do_recvmmsg(int sockfd, struct mmsghdr* msg, size_t vlen, int flags,
                          struct __kernel_timespec* timeout);
 int shim_do_prlimit64(pid_t pid, int resource, const struct __kernel_rlimit64* new_rlim,
                       struct __kernel_rlimit64* old_rlim);
 ssize_t shim_do_sendmmsg(int sockfd, struct mmsghdr* msg, size_t vlen, int flags);
+ssize_t shim_do_splice(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out, size_t len,
+                       unsigned int flags);
+ssize_t shim_do_copy_file_range(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out, size_t len,
+                                unsigned int flags);
+ssize_t shim_do_preadv2(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                        unsigned long pos_h, int flags);
+ssize_t shim_do_pwritev2(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                         unsigned long pos_h, int flags);
 int shim_do_eventfd2(unsigned int count, int flags);
 int shim_do_eventfd(unsigned int count);
 
@@ -784,7 +820,8 @@ int shim_ppoll(struct pollfd* fds, int nfds, struct timespec* tsp, const __sigse
 int shim_unshare(int unshare_flags);
 int shim_set_robust_list(struct robust_list_head* head, size_t len);
 int shim_get_robust_list(pid_t pid, struct robust_list_head** head, size_t* len);
-int shim_splice(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out, size_t len, int flags);
+ssize_t shim_splice(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out, size_t len,
+                    unsigned int flags);
 int shim_tee(int fdin, int fdout, size_t len, unsigned int flags);
 int shim_sync_file_range(int fd, loff_t offset, loff_t nbytes, int flags);
 int shim_vmsplice(int fd, const struct iovec* iov, unsigned long nr_segs, int flags);
@@ -807,10 +844,10 @@ int shim_epoll_create1(int flags);
 int shim_dup3(unsigned int oldfd, unsigned int newfd, int flags);
 int shim_pipe2(int* fildes, int flags);
 int shim_inotify_init1(int flags);
-int shim_preadv(unsigned long fd, const struct iovec* vec, unsigned long vlen, unsigned long pos_l,
-                unsigned long pos_h);
-int shim_pwritev(unsigned long fd, const struct iovec* vec, unsigned long vlen, unsigned long pos_l,
-                 unsigned long pos_h);
+ssize_t shim_preadv(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                    unsigned long pos_h);
+ssize_t shim_pwritev(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                     unsigned long pos_h);
 int shim_rt_tgsigqueueinfo(pid_t tgid, pid_t pid, int sig, siginfo_t* uinfo);
 int shim_perf_event_open(struct perf_event_attr* attr_uptr, pid_t pid, int cpu, int group_fd,
                          int flags);
@@ -819,6 +856,12 @@ ssize_t shim_recvmmsg(int sockfd, struct mmsghdr* msg, size_t vlen, int flags,
 int shim_prlimit64(pid_t pid, int resource, const struct __kernel_rlimit64* new_rlim,
                    struct __kernel_rlimit64* old_rlim);
 ssize_t shim_sendmmsg(int sockfd, struct mmsghdr* msg, size_t vlen, int flags);
+ssize_t shim_copy_file_range(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out, size_t len,
+                             unsigned int flags);
+ssize_t shim_preadv2(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                     unsigned long pos_h, int flags);
+ssize_t shim_pwritev2(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                      unsigned long pos_h, int flags);
 
 /* libos call wrappers */
 int shim_msgpersist(int msqid, int cmd);
@@ -489,8 +489,10 @@ typedef struct atomic_int REFTYPE;
 
 #include <pal.h>
 
+/* see lock() in shim_internal.h */
 struct shim_lock {
-    PAL_HANDLE lock;
+    int state;
+    PAL_HANDLE sleep; /* PAL mutex used as a binary semaphore, created on first contention */
     IDTYPE owner;
 };
 
@@ -199,6 +199,9 @@ int free_elf_interp(void);
 noreturn void execute_elf_object(struct shim_handle* exec, int* argcp, const char** argp,
                                  elf_auxv_t* auxp);
 int remove_loaded_libraries(void);
+int rewrite_syscalls(struct shim_handle* file, void* addr, size_t length, off_t offset, int prot,
+                     int flags);
+size_t x86_insn_length(const uint8_t* code, size_t avail);
 
 /* gdb debugging support */
 void remove_r_debug(void* addr);
@@ -218,6 +221,14 @@ int64_t install_async_event(PAL_HANDLE object, unsigned long time,
                             void (*callback)(IDTYPE caller, void* arg), void* arg);
 struct shim_thread* terminate_async_helper(void);
 
+struct async_timer;
+struct async_timer* create_async_timer(PAL_HANDLE notify);
+void destroy_async_timer(struct async_timer* timer);
+int set_async_timer(struct async_timer* timer, uint64_t expire_time, uint64_t interval,
+                    uint64_t* old_expire_time, uint64_t* old_interval);
+void get_async_timer(struct async_timer* timer, uint64_t* expire_time, uint64_t* interval);
+uint64_t read_async_timer(struct async_timer* timer);
+
 extern struct config_store* root_config;
 
 #endif /* _SHIM_UTILS_H */
@@ -77,8 +77,10 @@ static inline void free_vma_val_array(struct shim_vma_val* vmas, size_t count) {
  */
 #define CP_VMA_FLAGS (MAP_PRIVATE | MAP_ANONYMOUS | VMA_INTERNAL | VMA_CP)
 
-#define NEED_MIGRATE_MEMORY(vma) \
-    (((vma)->flags & VMA_TAINTED || !(vma)->file) && !((vma)->flags & VMA_UNMAPPED))
+/* SysV shm segments are mapped again from their host object instead */
+#define NEED_MIGRATE_MEMORY(vma)                                          \
+    (!((vma)->flags & VMA_UNMAPPED) &&                                    \
+     (!(vma)->file || ((vma)->flags & VMA_TAINTED && (vma)->file->type != TYPE_SHM)))
 
 static inline PAL_FLG PAL_PROT(int prot, int flags) {
     PAL_FLG pal_prot = 0;
@@ -105,9 +107,22 @@ int bkeep_mmap(void* addr, size_t length, int prot, int flags, struct shim_handl
 /* Bookkeeping munmap() system call */
 int bkeep_munmap(void* addr, size_t length, int flags);
 
+/*
+ * Bookkeeping munmap() system call in two steps around the PAL calls: reserve the area, checking
+ * that it is mapped and may be unmapped, then drop the reservation once the memory is freed.
+ */
+int bkeep_munmap_reserve(void* addr, size_t length, int flags);
+void bkeep_munmap_commit(void* addr, size_t length, int flags);
+
 /* Bookkeeping mprotect() system call */
 int bkeep_mprotect(void* addr, size_t length, int prot, int flags);
 
+/*
+ * Bookkeeping mremap() system call: grow the VMA ending at "addr + old_length" in place, if the
+ * area up to "addr + new_length" is free. Returns -ENOMEM if the VMA cannot be grown in place.
+ */
+int bkeep_mremap_grow(void* addr, size_t old_length, size_t new_length, int flags);
+
 /* Looking up VMA that contains [addr, length) */
 int lookup_vma(void* addr, struct shim_vma_val* vma);
 
@@ -41,6 +41,16 @@ static struct shim_lock handle_mgr_lock;
 
 static MEM_MGR handle_mgr = NULL;
 
+/* get_fd_handle() may touch the refcount of a handle that was freed to handle_mgr (whose memory
+ * is never released), so the free-list node must not overlap it */
+static_assert(offsetof(struct shim_handle, ref_count) >= sizeof(LIST_TYPE(mem_obj)),
+              "handle refcount overlaps the memmgr free-list node");
+
+struct shim_retired_fd_map {
+    struct shim_fd_handle** map;
+    struct shim_retired_fd_map* next;
+};
+
 #define INIT_HANDLE_MAP_SIZE 32
 
 //#define DEBUG_REF
@@ -221,16 +231,61 @@ struct shim_handle* __get_fd_handle(FDTYPE fd, int* fd_flags, struct shim_handle
     return NULL;
 }
 
+/* Takes a reference unless the refcount already dropped to zero, i.e. the handle is being (or has
+ * been) destroyed. */
+static bool get_handle_if_live(struct shim_handle* hdl) {
+    int64_t ref_count = atomic_read(&hdl->ref_count);
+    while (ref_count > 0) {
+        int64_t old = atomic_cmpxchg(&hdl->ref_count, ref_count, ref_count + 1);
+        if (old == ref_count)
+            return true;
+        ref_count = old;
+    }
+    return false;
+}
+
+/*
+ * Lock-free lookup; only installing, closing and duplicating fds take map->lock. This relies on:
+ *  - __enlarge_handle_map() publishing the new array before the new size and retiring (not
+ *    freeing) the old one, so any array paired with a size we read stays valid;
+ *  - fd slots (struct shim_fd_handle) never being freed while the map is alive;
+ *  - handles being allocated from handle_mgr, so a handle closed concurrently is still readable
+ *    memory and get_handle_if_live() fails on it (or succeeds on a recycled handle, which the
+ *    recheck below catches).
+ */
 struct shim_handle* get_fd_handle(FDTYPE fd, int* fd_flags, struct shim_handle_map* map) {
     if (!map)
         map = get_cur_handle_map(NULL);
 
-    struct shim_handle* hdl = NULL;
-    lock(&map->lock);
-    if ((hdl = __get_fd_handle(fd, fd_flags, map)))
-        get_handle(hdl);
-    unlock(&map->lock);
-    return hdl;
+    if (fd >= __atomic_load_n(&map->fd_size, __ATOMIC_ACQUIRE))
+        return NULL;
+
+    struct shim_fd_handle** array = __atomic_load_n(&map->map, __ATOMIC_ACQUIRE);
+    struct shim_fd_handle* fd_handle = __atomic_load_n(&array[fd], __ATOMIC_ACQUIRE);
+    if (!fd_handle)
+        return NULL;
+
+    while (true) {
+        struct shim_handle* hdl = __atomic_load_n(&fd_handle->handle, __ATOMIC_ACQUIRE);
+        if (!hdl)
+            return NULL;
+
+        if (!get_handle_if_live(hdl)) {
+            /* the fd is being closed; if it was already reused, look at the new handle */
+            if (__atomic_load_n(&fd_handle->handle, __ATOMIC_ACQUIRE) == hdl)
+                return NULL;
+            continue;
+        }
+
+        if (fd_flags)
+            *fd_flags = __atomic_load_n(&fd_handle->flags, __ATOMIC_RELAXED);
+
+        /* the reference only counts if the fd still maps to this handle */
+        if (__atomic_load_n(&fd_handle->handle, __ATOMIC_ACQUIRE) == hdl)
+            return hdl;
+
+        put_handle(hdl);
+    }
 }
 
 struct shim_handle* __detach_fd_handle(struct shim_fd_handle* fd, int* flags,
@@ -245,9 +300,9 @@ struct shim_handle* __detach_fd_handle(struct shim_fd_handle* fd, int* flags,
         if (flags)
             *flags = fd->flags;
 
-        fd->vfd    = FD_NULL;
-        fd->handle = NULL;
-        fd->flags  = 0;
+        fd->vfd = FD_NULL;
+        __atomic_store_n(&fd->handle, NULL, __ATOMIC_RELEASE);
+        fd->flags = 0;
 
         if (vfd == map->fd_top)
             do {
@@ -300,13 +355,15 @@ static int __set_new_fd_handle(struct shim_fd_handle** fdhdl, FDTYPE fd, struct
         new_handle = malloc(sizeof(struct shim_fd_handle));
         if (!new_handle)
             return -ENOMEM;
-        *fdhdl = new_handle;
+        new_handle->handle = NULL;
+        __atomic_store_n(fdhdl, new_handle, __ATOMIC_RELEASE);
     }
 
+    /* publish the handle last, get_fd_handle() does not take map->lock */
     new_handle->vfd   = fd;
     new_handle->flags = fd_flags;
     get_handle(hdl);
-    new_handle->handle = hdl;
+    __atomic_store_n(&new_handle->handle, hdl, __ATOMIC_RELEASE);
     return 0;
 }
 
@@ -393,17 +450,6 @@ int set_new_fd_handle_by_fd(FDTYPE fd, struct shim_handle* hdl, int fd_flags,
     if (handle_map->fd_top == FD_NULL || fd > handle_map->fd_top)
         handle_map->fd_top = fd;
 
-    struct shim_fd_handle* new_handle = handle_map->map[fd];
-
-    if (!new_handle) {
-        new_handle = malloc(sizeof(struct shim_fd_handle));
-        if (!new_handle) {
-            ret = -ENOMEM;
-            goto out;
-        }
-        handle_map->map[fd] = new_handle;
-    }
-
     ret = __set_new_fd_handle(&handle_map->map[fd], fd, hdl, fd_flags);
     if (ret < 0) {
         if (fd == handle_map->fd_top)
@@ -540,8 +586,8 @@ void dup_fd_handle(struct shim_handle_map* map, const struct shim_fd_handle* old
 
     if (old->vfd != FD_NULL) {
         get_handle(old->handle);
-        replaced    = new->handle;
-        new->handle = old->handle;
+        replaced = new->handle;
+        __atomic_store_n(&new->handle, old->handle, __ATOMIC_RELEASE);
     }
 
     unlock(&map->lock);
@@ -586,10 +632,21 @@ static int __enlarge_handle_map(struct shim_handle_map* map, size_t size) {
     if (!new_map)
         return -ENOMEM;
 
+    struct shim_retired_fd_map* retired = malloc(sizeof(*retired));
+    if (!retired) {
+        free(new_map);
+        return -ENOMEM;
+    }
+
     memcpy(new_map, map->map, map->fd_size * sizeof(new_map[0]));
-    free(map->map);
-    map->map     = new_map;
-    map->fd_size = size;
+
+    /* get_fd_handle() reads the size before the array, so publish them in the opposite order;
+     * readers may still be using the old array, keep it until the map goes away */
+    retired->map  = map->map;
+    retired->next = map->retired;
+    map->retired  = retired;
+    __atomic_store_n(&map->map, new_map, __ATOMIC_RELEASE);
+    __atomic_store_n(&map->fd_size, (FDTYPE)size, __ATOMIC_RELEASE);
     return 0;
 }
 
@@ -671,6 +728,12 @@ void put_handle_map(struct shim_handle_map* map) {
         }
 
     done:
+        while (map->retired) {
+            struct shim_retired_fd_map* retired = map->retired;
+            map->retired = retired->next;
+            free(retired->map);
+            free(retired);
+        }
         destroy_lock(&map->lock);
         free(map->map);
         free(map);
@@ -766,8 +829,16 @@ BEGIN_CP_FUNC(handle) {
             entry->phandle = &new_hdl->pal_handle;
         }
 
-        if (hdl->type == TYPE_EPOLL)
+        if (hdl->type == TYPE_EPOLL) {
+            /* the wait set is recreated on first use */
+            new_hdl->info.epoll.wait_set = NULL;
             DO_CP(epoll_item, &hdl->info.epoll.fds, &new_hdl->info.epoll.fds);
+        }
+
+        if (hdl->type == TYPE_SHM) {
+            /* the child does not know the segments of the parent, only its attachments */
+            INIT_LIST_HEAD(&new_hdl->info.shm, list);
+        }
 
         if (hdl->type == TYPE_SOCK) {
             /* no support for multiple processes sharing options/peek buffer of the socket */
@@ -869,6 +940,7 @@ BEGIN_CP_FUNC(handle_map) {
 
         new_handle_map->fd_size = fd_size;
         new_handle_map->map     = fd_size ? ptr_array : NULL;
+        new_handle_map->retired = NULL;
 
         REF_SET(new_handle_map->ref_count, 0);
         clear_lock(&new_handle_map->lock);
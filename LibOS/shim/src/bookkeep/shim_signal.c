@@ -154,6 +154,25 @@ fetch_signal_log (struct shim_thread * thread, int sig)
     return signal;
 }
 
+int fetch_pending_signal(struct shim_thread* thread, const __sigset_t* mask, siginfo_t* info) {
+    if (!thread->signal_logs)
+        return 0;
+
+    for (int sig = 1; sig <= NUM_SIGS; sig++) {
+        /* checkpoint requests are internal and never reported to the user */
+        if (sig == SIGCP || !__sigismember(mask, sig))
+            continue;
+
+        struct shim_signal* signal = fetch_signal_log(thread, sig);
+        if (signal) {
+            memcpy(info, &signal->info, sizeof(*info));
+            free(signal);
+            return sig;
+        }
+    }
+    return 0;
+}
+
 static void
 __handle_one_signal (shim_tcb_t * tcb, int sig, struct shim_signal * signal);
 
@@ -230,6 +249,8 @@ void deliver_signal (siginfo_t * info, PAL_CONTEXT * context)
         if ((signal = malloc_copy(signal,sizeof(struct shim_signal))) &&
             (signal_log = allocate_signal_log(cur_thread, sig))) {
             *signal_log = signal;
+            if (__sigismember(&cur_thread->signal_mask, sig))
+                signalfd_notify(sig);
         }
         if (signal && !signal_log) {
             SYS_PRINTF("signal queue is full (TID = %u, SIG = %d)\n",
@@ -577,6 +598,7 @@ static void illegal_upcall (PAL_PTR event, PAL_NUM arg, PAL_CONTEXT * context)
              *       in rcx. See the syscall_wrapper in syscallas.S
              * TODO: check SIGILL and ILL_ILLOPN
              */
+            __atomic_add_fetch(&syscalls_trapped, 1, __ATOMIC_RELAXED);
             context->rcx = (long)rip + 2;
             context->r11 = context->efl;
             context->rip = (long)&syscall_wrapper;
@@ -838,6 +860,11 @@ void append_signal(struct shim_thread* thread, int sig, siginfo_t* info, bool ne
 
     if (signal_log) {
         *signal_log = signal;
+        if (__sigismember(&thread->signal_mask, sig)) {
+            /* a blocked signal is only reported through signalfds, don't interrupt the thread */
+            signalfd_notify(sig);
+            need_interrupt = false;
+        }
         if (need_interrupt) {
             debug("resuming thread %u\n", thread->tid);
             thread_wakeup(thread);
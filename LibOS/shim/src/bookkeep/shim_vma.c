@@ -720,6 +720,136 @@ int bkeep_munmap (void * addr, size_t length, int flags)
     return ret;
 }
 
+/*
+ * Reserve [addr, addr + length) for munmap(). In one pass under vma_list_lock, this checks that
+ * the area is covered by at least one VMA and that all covered VMAs are of the type in "flags",
+ * and then replaces them with a single placeholder VMA which is not backed by memory. The
+ * placeholder keeps the area from being handed out again while the memory is being freed, and
+ * bkeep_munmap_commit() drops it afterwards. Nothing is changed if the checks fail.
+ *
+ * Bookkeeping convention (must follow):
+ * Call bkeep_munmap_reserve() BEFORE the deallocation PAL calls (DkVirtualMemoryFree() or
+ * DkStreamUnmap()), and bkeep_munmap_commit() AFTER them.
+ */
+int bkeep_munmap_reserve (void * addr, size_t length, int flags)
+{
+    if (!addr || !length)
+        return -EINVAL;
+
+    void * end = addr + length;
+
+    debug("bkeep_munmap_reserve: %p-%p\n", addr, end);
+
+    lock(&vma_list_lock);
+    struct shim_vma * prev = NULL;
+    __lookup_vma(addr, &prev);
+
+    struct shim_vma * cur = prev ? LISTP_NEXT_ENTRY(prev, &vma_list, list) :
+                            LISTP_FIRST_ENTRY(&vma_list, struct shim_vma, list);
+    int ret = -ENOENT;
+
+    for (; cur && test_vma_overlap(cur, addr, end) ;
+         cur = LISTP_NEXT_ENTRY(cur, &vma_list, list)) {
+        if (VMA_TYPE(cur->flags) != VMA_TYPE(flags)) {
+            ret = -EACCES;
+            goto out;
+        }
+        ret = 0;
+    }
+
+    if (!ret)
+        ret = __bkeep_mmap(prev, addr, end, PROT_NONE,
+                           MAP_PRIVATE|MAP_ANONYMOUS|VMA_UNMAPPED|VMA_TYPE(flags),
+                           NULL, 0, NULL);
+    assert_vma_list();
+    __restore_reserved_vmas();
+out:
+    unlock(&vma_list_lock);
+    return ret;
+}
+
+void bkeep_munmap_commit (void * addr, size_t length, int flags)
+{
+    void * end = addr + length;
+
+    debug("bkeep_munmap_commit: %p-%p\n", addr, end);
+
+    lock(&vma_list_lock);
+    struct shim_vma * prev = NULL;
+    __lookup_vma(addr, &prev);
+
+    struct shim_vma * cur = prev ? LISTP_NEXT_ENTRY(prev, &vma_list, list) :
+                            LISTP_FIRST_ENTRY(&vma_list, struct shim_vma, list);
+
+    /*
+     * Other threads may have mapped, protected or reserved parts of the area since
+     * bkeep_munmap_reserve(), so the placeholder may have been split or replaced. Drop only the
+     * pieces of it which are left, like __bkeep_munmap() but leaving the other VMAs alone.
+     */
+    while (cur && test_vma_overlap(cur, addr, end)) {
+        struct shim_vma * next = LISTP_NEXT_ENTRY(cur, &vma_list, list);
+
+        if (!(cur->flags & VMA_UNMAPPED) || VMA_TYPE(cur->flags) != VMA_TYPE(flags)) {
+            prev = cur;
+        } else if (addr <= cur->start && cur->end <= end) {
+            __remove_vma(cur, prev);
+            __drop_vma(cur);
+        } else {
+            struct shim_vma * tail = NULL;
+            __shrink_vma(cur, addr, end, &tail);
+            prev = cur;
+            if (tail) {
+                __insert_vma(tail, cur); /* insert "tail" after "cur" */
+                break;
+            }
+        }
+
+        cur = next;
+    }
+
+    assert_vma_list();
+    __restore_reserved_vmas();
+    /* same as bkeep_munmap(): a removed debugging region must not be checkpointed */
+    remove_r_debug(addr);
+    unlock(&vma_list_lock);
+}
+
+static inline bool __can_merge_vmas (const struct shim_vma * vma,
+                                     const struct shim_vma * next)
+{
+    return vma->end == next->start && vma->prot == next->prot &&
+           vma->flags == next->flags && !vma->file && !next->file &&
+           !(vma->flags & (VMA_INTERNAL|VMA_UNMAPPED|VMA_CP)) &&
+           !memcmp(vma->comment, next->comment, VMA_COMMENT_LEN);
+}
+
+/*
+ * __merge_vmas() merges the VMAs from "prev" (or the beginning of vma_list if "prev" is NULL)
+ * up to the first VMA starting after "end" with their following VMA, if both map the same kind
+ * of anonymous memory back to back. It undoes the splitting done by __bkeep_mprotect() when a
+ * protection is changed back, so that mprotect() churn does not grow vma_list.
+ */
+static void __merge_vmas (struct shim_vma * prev, void * end)
+{
+    assert(locked(&vma_list_lock));
+
+    struct shim_vma * cur = prev ? prev : LISTP_FIRST_ENTRY(&vma_list, struct shim_vma, list);
+
+    while (cur && cur->start <= end) {
+        struct shim_vma * next = LISTP_NEXT_ENTRY(cur, &vma_list, list);
+        if (!next)
+            break;
+
+        if (__can_merge_vmas(cur, next)) {
+            cur->end = next->end;
+            __remove_vma(next, cur);
+            __drop_vma(next);
+        } else {
+            cur = next;
+        }
+    }
+}
+
 /*
  * Update bookkeeping for mprotect(). "prev" must point to the immediately
  * precedent vma of the address to protect, or be NULL if no vma is lower than
@@ -735,6 +865,7 @@ static int __bkeep_mprotect (struct shim_vma * prev,
 {
     assert(locked(&vma_list_lock));
 
+    struct shim_vma * first = prev;
     struct shim_vma * cur, * next;
 
     if (!prev) {
@@ -813,6 +944,7 @@ static int __bkeep_mprotect (struct shim_vma * prev,
         next = cur ? LISTP_NEXT_ENTRY(cur, &vma_list, list) : NULL;
     }
 
+    __merge_vmas(first, end);
     return 0;
 }
 
@@ -833,6 +965,56 @@ int bkeep_mprotect (void * addr, size_t length, int prot, int flags)
     return ret;
 }
 
+/*
+ * Update bookkeeping for growing a VMA in place in mremap(). [addr, addr + old_length) must be
+ * the tail of a single VMA, and [addr + old_length, addr + new_length) must not be covered by any
+ * other VMA. The VMA is extended instead of adding a new VMA next to it, so that a mapping that
+ * grows repeatedly (e.g. by realloc()) stays one VMA and remains movable as a whole.
+ *
+ * Bookkeeping convention (must follow):
+ * Update the bookkeeping BEFORE allocating the new area with PAL calls.
+ */
+int bkeep_mremap_grow (void * addr, size_t old_length, size_t new_length,
+                       int flags)
+{
+    if (!addr || !old_length || new_length <= old_length)
+        return -EINVAL;
+
+    void * old_end = addr + old_length;
+    void * new_end = addr + new_length;
+
+    if (new_end < addr || new_end > PAL_CB(user_address.end))
+        return -ENOMEM;
+
+    debug("bkeep_mremap_grow: %p-%p => %p-%p\n", addr, old_end, addr, new_end);
+
+    lock(&vma_list_lock);
+
+    int ret = 0;
+    struct shim_vma * vma = __lookup_vma(addr, NULL);
+    if (!vma || vma->end < old_end) {
+        ret = -EFAULT;
+        goto out;
+    }
+
+    if (VMA_TYPE(vma->flags) != VMA_TYPE(flags)) {
+        ret = -EACCES;
+        goto out;
+    }
+
+    struct shim_vma * next = LISTP_NEXT_ENTRY(vma, &vma_list, list);
+    if (vma->end != old_end || (next && next->start < new_end)) {
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    vma->end = new_end;
+    assert_vma_list();
+out:
+    unlock(&vma_list_lock);
+    return ret;
+}
+
 /*
  * Search for an unmapped area within [bottom, top) that is big enough
  * to allocate "length" bytes. The search approach is top-down.
@@ -0,0 +1,248 @@
+/* Copyright (C) 2014 Stony Brook University
+   This file is part of Graphene Library OS.
+
+   Graphene Library OS is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   Graphene Library OS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/*
+ * shim_insn.c
+ *
+ * Length decoder for x86-64 instructions, used to walk the code of a function instruction by
+ * instruction when rewriting syscall instructions (see rewrite_syscalls() in shim_rtld.c). It
+ * only determines where instructions end: legacy/REX/VEX/EVEX prefixes, opcode maps 0f, 0f38 and
+ * 0f3a, ModRM/SIB, displacements and immediates. Anything it does not know is reported as invalid,
+ * and callers must stop decoding there instead of guessing.
+ */
+
+#include <shim_internal.h>
+#include <shim_utils.h>
+
+#define X86_MAX_INSN_LEN 15
+
+/* operand encodings of the one-byte opcodes */
+#define OP_NONE   0x00
+#define OP_MODRM  0x01 /* ModRM byte (with SIB and displacement) follows */
+#define OP_IMM8   0x02
+#define OP_IMM16  0x04
+#define OP_IMMZ   0x08 /* 16 or 32 bits, depending on the operand size */
+#define OP_IMMV   0x10 /* 16, 32 or 64 bits (mov $imm, %reg) */
+#define OP_MOFFS  0x20 /* 32 or 64 bits, depending on the address size */
+#define OP_GRP3   0x40 /* f6/f7: an immediate only for test (ModRM.reg 0 and 1) */
+#define OP_REL32  0x80 /* call/jmp/jcc rel32 */
+#define OP_BAD    0x100 /* invalid in 64-bit mode, a prefix, or not supported here */
+
+#define M  OP_MODRM
+#define I1 OP_IMM8
+#define IZ OP_IMMZ
+#define XX OP_BAD
+
+static const uint16_t onebyte_ops[256] = {
+    /*        0       1       2       3       4       5       6       7 */
+    /*        8       9       a       b       c       d       e       f */
+    /* 00 */  M,      M,      M,      M,      I1,     IZ,     XX,     XX,
+              M,      M,      M,      M,      I1,     IZ,     XX,     XX,
+    /* 10 */  M,      M,      M,      M,      I1,     IZ,     XX,     XX,
+              M,      M,      M,      M,      I1,     IZ,     XX,     XX,
+    /* 20 */  M,      M,      M,      M,      I1,     IZ,     XX,     XX,
+              M,      M,      M,      M,      I1,     IZ,     XX,     XX,
+    /* 30 */  M,      M,      M,      M,      I1,     IZ,     XX,     XX,
+              M,      M,      M,      M,      I1,     IZ,     XX,     XX,
+    /* 40 */  XX,     XX,     XX,     XX,     XX,     XX,     XX,     XX,
+              XX,     XX,     XX,     XX,     XX,     XX,     XX,     XX,
+    /* 50 */  0,      0,      0,      0,      0,      0,      0,      0,
+              0,      0,      0,      0,      0,      0,      0,      0,
+    /* 60 */  XX,     XX,     XX,     M,      XX,     XX,     XX,     XX,
+              IZ,     M | IZ, I1,     M | I1, 0,      0,      0,      0,
+    /* 70 */  I1,     I1,     I1,     I1,     I1,     I1,     I1,     I1,
+              I1,     I1,     I1,     I1,     I1,     I1,     I1,     I1,
+    /* 80 */  M | I1, M | IZ, XX,     M | I1, M,      M,      M,      M,
+              M,      M,      M,      M,      M,      M,      M,      M,
+    /* 90 */  0,      0,      0,      0,      0,      0,      0,      0,
+              0,      0,      XX,     0,      0,      0,      0,      0,
+    /* a0 */  OP_MOFFS, OP_MOFFS, OP_MOFFS, OP_MOFFS, 0,  0,      0,      0,
+              I1,     IZ,     0,      0,      0,      0,      0,      0,
+    /* b0 */  I1,     I1,     I1,     I1,     I1,     I1,     I1,     I1,
+              OP_IMMV, OP_IMMV, OP_IMMV, OP_IMMV, OP_IMMV, OP_IMMV, OP_IMMV, OP_IMMV,
+    /* c0 */  M | I1, M | I1, OP_IMM16, 0,    XX,     XX,     M | I1, M | IZ,
+              OP_IMM16 | I1, 0, OP_IMM16, 0,  0,      I1,     XX,     0,
+    /* d0 */  M,      M,      M,      M,      XX,     XX,     XX,     0,
+              M,      M,      M,      M,      M,      M,      M,      M,
+    /* e0 */  I1,     I1,     I1,     I1,     I1,     I1,     I1,     I1,
+              OP_REL32, OP_REL32, XX,   I1,     0,      0,      0,      0,
+    /* f0 */  XX,     0,      XX,     XX,     0,      0,      M | OP_GRP3, M | OP_GRP3,
+              0,      0,      0,      0,      0,      0,      M,      M,
+};
+
+#undef M
+#undef I1
+#undef IZ
+#undef XX
+
+/* Returns the operand encoding of opcode `op` in map 1 (0f), 2 (0f38) or 3 (0f3a); `vex` is set
+ * for VEX/EVEX-encoded instructions, which have no operand-less forms except vzeroupper/all. */
+static int escaped_op(int map, uint8_t op, bool vex) {
+    if (map == 2)
+        return OP_MODRM;
+    if (map == 3)
+        return OP_MODRM | OP_IMM8;
+    if (map != 1)
+        return OP_BAD;
+
+    if (vex)
+        return op == 0x77 ? OP_NONE
+               : (op >= 0x70 && op <= 0x73) || op == 0xc2 || (op >= 0xc4 && op <= 0xc6)
+                   ? OP_MODRM | OP_IMM8
+                   : OP_MODRM;
+
+    switch (op) {
+        case 0x05: /* syscall */
+        case 0x06: /* clts */
+        case 0x07: /* sysret */
+        case 0x08: /* invd */
+        case 0x09: /* wbinvd */
+        case 0x0b: /* ud2 */
+        case 0x0e: /* femms */
+        case 0x30 ... 0x35: /* wrmsr, rdtsc, rdmsr, rdpmc, sysenter, sysexit */
+        case 0x37: /* getsec */
+        case 0x77: /* emms */
+        case 0xa0 ... 0xa2: /* push %fs, pop %fs, cpuid */
+        case 0xa8 ... 0xaa: /* push %gs, pop %gs, rsm */
+        case 0xc8 ... 0xcf: /* bswap */
+            return OP_NONE;
+        case 0x80 ... 0x8f: /* jcc rel32 */
+            return OP_REL32;
+        case 0x0f: /* 3DNow! */
+        case 0x70 ... 0x73:
+        case 0xa4:
+        case 0xac:
+        case 0xba:
+        case 0xc2:
+        case 0xc4 ... 0xc6:
+            return OP_MODRM | OP_IMM8;
+        case 0x00 ... 0x03:
+        case 0x0d:
+        case 0x10 ... 0x23:
+        case 0x28 ... 0x2f:
+        case 0x40 ... 0x6f:
+        case 0x74 ... 0x76:
+        case 0x78 ... 0x7f:
+        case 0x90 ... 0x9f:
+        case 0xa3:
+        case 0xa5:
+        case 0xab:
+        case 0xad ... 0xb9:
+        case 0xbb ... 0xc1:
+        case 0xc3:
+        case 0xc7:
+        case 0xd0 ... 0xff:
+            return OP_MODRM;
+        default:
+            return OP_BAD;
+    }
+}
+
+size_t x86_insn_length(const uint8_t* code, size_t avail) {
+    const uint8_t* p   = code;
+    const uint8_t* end = code + (avail < X86_MAX_INSN_LEN ? avail : X86_MAX_INSN_LEN);
+    bool opsize16 = false, addrsize32 = false, rex_w = false;
+
+#define NEED(n)                        \
+    do {                               \
+        if (end - p < (ptrdiff_t)(n))  \
+            return 0;                  \
+    } while (0)
+
+    /* legacy prefixes, then an optional REX prefix right before the opcode */
+    for (;; p++) {
+        NEED(1);
+        if (*p == 0x66)
+            opsize16 = true;
+        else if (*p == 0x67)
+            addrsize32 = true;
+        else if (*p != 0xf0 && *p != 0xf2 && *p != 0xf3 && *p != 0x26 && *p != 0x2e &&
+                 *p != 0x36 && *p != 0x3e && *p != 0x64 && *p != 0x65)
+            break;
+    }
+    if ((*p & 0xf0) == 0x40) {
+        rex_w = *p & 0x08;
+        p++;
+        NEED(1);
+    }
+
+    int ops;
+    uint8_t op = *p++;
+
+    if (op == 0x0f) {
+        NEED(1);
+        op = *p++;
+        int map = 1;
+        if (op == 0x38 || op == 0x3a) {
+            map = op == 0x38 ? 2 : 3;
+            NEED(1);
+            op = *p++;
+        }
+        ops = escaped_op(map, op, false);
+    } else if (op == 0xc4 || op == 0xc5 || op == 0x62) {
+        /* VEX (c5 xx, c4 xx xx) and EVEX (62 xx xx xx); no other prefix may follow */
+        int len = op == 0xc5 ? 1 : op == 0xc4 ? 2 : 3;
+        NEED(len + 1);
+        int map = op == 0xc5 ? 1 : op == 0xc4 ? (p[0] & 0x1f) : (p[0] & 0x07);
+        p += len;
+        op  = *p++;
+        ops = escaped_op(map, op, true);
+    } else {
+        ops = onebyte_ops[op];
+    }
+
+    if (ops & OP_BAD)
+        return 0;
+
+    if (ops & OP_MODRM) {
+        NEED(1);
+        uint8_t modrm = *p++;
+        int mod = modrm >> 6, reg = (modrm >> 3) & 7, rm = modrm & 7;
+
+        if (mod != 3 && rm == 4) {
+            NEED(1);
+            uint8_t sib = *p++;
+            if (mod == 0 && (sib & 7) == 5)
+                p += 4;
+        } else if (mod == 0 && rm == 5) {
+            p += 4; /* RIP-relative */
+        }
+        if (mod == 1)
+            p += 1;
+        else if (mod == 2)
+            p += 4;
+
+        if ((ops & OP_GRP3) && reg <= 1)
+            ops |= op == 0xf6 ? OP_IMM8 : OP_IMMZ;
+    }
+
+    if (ops & OP_IMM8)
+        p += 1;
+    if (ops & OP_IMM16)
+        p += 2;
+    if (ops & OP_IMMZ)
+        p += opsize16 ? 2 : 4;
+    if (ops & OP_IMMV)
+        p += rex_w ? 8 : opsize16 ? 2 : 4;
+    if (ops & OP_REL32)
+        p += 4;
+    if (ops & OP_MOFFS)
+        p += addrsize32 ? 4 : 8;
+
+    NEED(0);
+    return p - code;
+#undef NEED
+}
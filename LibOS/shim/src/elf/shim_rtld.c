@@ -963,6 +963,372 @@ static void replace_link_map(struct link_map* new, struct link_map* old) {
         loaded_libraries = new;
 }
 
+/*
+ * Binaries not linked against the Graphene glibc (Go programs, static musl binaries) issue raw
+ * syscall instructions, which are emulated in illegal_upcall() at the cost of an exception per
+ * system call (an AEX on SGX). If "sys.rewrite_syscalls" is enabled in the manifest, the code of
+ * ELF files is rewritten when it is mapped, before it can run: when the LibOS loads the executable
+ * or the interpreter, and when ld.so maps a library with a private PROT_EXEC mmap(). The functions
+ * listed in the symbol table of the file (.symtab, or .dynsym if stripped) are decoded instruction
+ * by instruction with x86_insn_length(), and the sequences that compilers and libcs emit for
+ * system calls are rewritten:
+ *
+ *   b8 <imm32> 0f 05           mov $nr, %eax; syscall
+ *   48 c7 c0 <imm32> 0f 05     mov $nr, %rax; syscall
+ *
+ * The mov is replaced by a jump to a trampoline, which repeats the mov, loads the return address
+ * into %rcx and jumps to syscall_trampoline, the same path as an emulated syscall instruction. The
+ * syscall instruction itself is left in place, so that code jumping directly to it still works
+ * through illegal_upcall(). Code outside of known functions, code the decoder does not understand,
+ * other forms of syscall instructions and code generated at runtime (e.g. by JITs, which may
+ * already be running it) are not rewritten.
+ */
+#define SYSCALL_TRAMP_SIZE      32
+#define SYSCALL_TRAMP_REACH     (1UL << 31)
+#define SYSCALL_TRAMP_COMMENT   "[syscall-tramp]"
+#define SYSCALL_SYMS_BATCH      64
+#define SYSCALL_MAX_HDRS        4096
+
+unsigned long syscalls_patched = 0;
+unsigned long syscalls_trapped = 0;
+
+static bool syscall_rewrite_enabled = false;
+
+void __attribute__((weak)) syscall_trampoline(void) {
+    /*
+     * work around for link.
+     * syscalldb.S is excluded for libsysdb_debug.so so it fails to link
+     * due to missing syscall_trampoline.
+     */
+}
+
+static void init_syscall_rewrite(void) {
+    char cfg[2];
+
+    if (!root_config || get_config(root_config, "sys.rewrite_syscalls", cfg, sizeof(cfg)) != 1 ||
+        cfg[0] != '1')
+        return;
+
+    syscall_rewrite_enabled = true;
+}
+
+struct syscall_sites {
+    uint8_t** sites;
+    size_t count, size;
+};
+
+static int add_syscall_site(struct syscall_sites* s, uint8_t* site) {
+    if (s->count == s->size) {
+        size_t size = s->size ? s->size * 2 : 64;
+        uint8_t** sites = malloc(size * sizeof(*sites));
+        if (!sites)
+            return -ENOMEM;
+        if (s->count)
+            memcpy(sites, s->sites, s->count * sizeof(*sites));
+        free(s->sites);
+        s->sites = sites;
+        s->size  = size;
+    }
+    s->sites[s->count++] = site;
+    return 0;
+}
+
+/* Returns the length of the mov instruction if `p` starts a rewritable "mov $nr, %eax/%rax;
+ * syscall" sequence, 0 otherwise. `mov_len` is the decoded length of the instruction at `p`, and
+ * `end` the end of the function. */
+static size_t match_syscall_site(const uint8_t* p, size_t mov_len, const uint8_t* end) {
+    if (!(mov_len == 5 && p[0] == 0xb8) &&
+        !(mov_len == 7 && p[0] == 0x48 && p[1] == 0xc7 && p[2] == 0xc0))
+        return 0;
+
+    if (end - p < (ptrdiff_t)mov_len + 2 || p[mov_len] != 0x0f || p[mov_len + 1] != 0x05)
+        return 0;
+
+    uint32_t nr;
+    memcpy(&nr, p + mov_len - 4, 4);
+    /* anything else fails with ENOSYS anyway */
+    if (nr >= LIBOS_SYSCALL_BOUND)
+        return 0;
+
+    return mov_len;
+}
+
+/* Decodes the function at [code, code + size) and records its syscall sites. Decoding stops at the
+ * first instruction the decoder does not know, since the following boundaries are unknown. */
+static int find_syscall_sites(uint8_t* code, size_t size, struct syscall_sites* sites) {
+    uint8_t* end = code + size;
+    for (uint8_t* p = code; p < end;) {
+        size_t len = x86_insn_length(p, end - p);
+        if (!len)
+            break;
+
+        if (match_syscall_site(p, len, end)) {
+            int ret = add_syscall_site(sites, p);
+            if (ret < 0)
+                return ret;
+        }
+        p += len;
+    }
+    return 0;
+}
+
+/* Reads from an ELF file without moving the file position of the handle */
+static int read_elf_file(struct shim_handle* file, void* buf, size_t count, off_t pos) {
+    struct shim_fs_ops* fs_ops = file->fs ? file->fs->fs_ops : NULL;
+    if (!fs_ops || !fs_ops->pread)
+        return -EACCES;
+
+    ssize_t ret = fs_ops->pread(file, buf, count, pos);
+    if (ret < 0)
+        return ret;
+    return (size_t)ret == count ? 0 : -EINVAL;
+}
+
+/*
+ * Records the syscall sites in the functions of ELF file `file` which is mapped at file offset
+ * `offset` into [addr, addr + length). Only functions in executable segments and entirely inside
+ * the mapping are considered.
+ */
+static int find_elf_syscall_sites(struct shim_handle* file, uint8_t* addr, size_t length,
+                                  off_t offset, struct syscall_sites* sites) {
+    ElfW(Ehdr) ehdr;
+    ElfW(Phdr)* phdrs = NULL;
+    ElfW(Shdr)* shdrs = NULL;
+    int ret;
+
+    if ((ret = read_elf_file(file, &ehdr, sizeof(ehdr), 0)) < 0)
+        return ret;
+
+    if (memcmp(ehdr.e_ident, ELFMAG, SELFMAG) || ehdr.e_ident[EI_CLASS] != ELFW(CLASS) ||
+        !elf_machine_matches_host(&ehdr) || ehdr.e_phentsize != sizeof(ElfW(Phdr)) ||
+        ehdr.e_shentsize != sizeof(ElfW(Shdr)) || !ehdr.e_phnum || !ehdr.e_shnum ||
+        ehdr.e_phnum > SYSCALL_MAX_HDRS || ehdr.e_shnum > SYSCALL_MAX_HDRS)
+        return 0;
+
+    phdrs = malloc(ehdr.e_phnum * sizeof(*phdrs));
+    shdrs = malloc(ehdr.e_shnum * sizeof(*shdrs));
+    if (!phdrs || !shdrs) {
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    if ((ret = read_elf_file(file, phdrs, ehdr.e_phnum * sizeof(*phdrs), ehdr.e_phoff)) < 0 ||
+        (ret = read_elf_file(file, shdrs, ehdr.e_shnum * sizeof(*shdrs), ehdr.e_shoff)) < 0)
+        goto out;
+
+    ElfW(Shdr)* symtab = NULL;
+    for (int i = 0; i < ehdr.e_shnum; i++) {
+        if (shdrs[i].sh_type == SHT_SYMTAB) {
+            symtab = &shdrs[i];
+            break;
+        }
+        if (shdrs[i].sh_type == SHT_DYNSYM)
+            symtab = &shdrs[i];
+    }
+    if (!symtab || symtab->sh_entsize != sizeof(ElfW(Sym)))
+        goto out;
+
+    size_t nsyms = symtab->sh_size / sizeof(ElfW(Sym));
+    for (size_t i = 0; i < nsyms; i += SYSCALL_SYMS_BATCH) {
+        ElfW(Sym) syms[SYSCALL_SYMS_BATCH];
+        size_t n = MIN(nsyms - i, (size_t)SYSCALL_SYMS_BATCH);
+        if ((ret = read_elf_file(file, syms, n * sizeof(*syms),
+                                 symtab->sh_offset + i * sizeof(*syms))) < 0)
+            goto out;
+
+        for (size_t j = 0; j < n; j++) {
+            ElfW(Sym)* sym = &syms[j];
+            if (ELFW(ST_TYPE)(sym->st_info) != STT_FUNC || sym->st_shndx == SHN_UNDEF ||
+                !sym->st_size)
+                continue;
+
+            for (ElfW(Phdr)* ph = phdrs; ph < phdrs + ehdr.e_phnum; ph++) {
+                if (ph->p_type != PT_LOAD || !(ph->p_flags & PF_X) ||
+                    sym->st_value < ph->p_vaddr || sym->st_size > ph->p_filesz ||
+                    sym->st_value - ph->p_vaddr > ph->p_filesz - sym->st_size)
+                    continue;
+
+                uint64_t fileoff = sym->st_value - ph->p_vaddr + ph->p_offset;
+                if (fileoff >= (uint64_t)offset && fileoff - offset <= length &&
+                    sym->st_size <= length - (fileoff - offset) &&
+                    (ret = find_syscall_sites(addr + (fileoff - offset), sym->st_size,
+                                              sites)) < 0)
+                    goto out;
+                break;
+            }
+        }
+    }
+    ret = 0;
+out:
+    free(phdrs);
+    free(shdrs);
+    return ret;
+}
+
+/* Writes the trampoline for the site `site` with a mov of `mov_len` bytes to `tramp` */
+static void write_syscall_tramp(uint8_t* tramp, uint8_t* site, size_t mov_len) {
+    uint8_t* p = tramp;
+    memcpy(p, site, mov_len);
+    p += mov_len;
+
+    /* lea <site + mov_len + 2>(%rip), %rcx */
+    *p++ = 0x48;
+    *p++ = 0x8d;
+    *p++ = 0x0d;
+    int32_t rel = (int32_t)(site + mov_len + 2 - (p + 4));
+    memcpy(p, &rel, 4);
+    p += 4;
+
+    /* jmp *0(%rip); .quad syscall_trampoline */
+    *p++ = 0xff;
+    *p++ = 0x25;
+    memset(p, 0, 4);
+    p += 4;
+    uint64_t target = (uint64_t)&syscall_trampoline;
+    memcpy(p, &target, 8);
+    p += 8;
+    assert(p <= tramp + SYSCALL_TRAMP_SIZE);
+}
+
+static bool tramp_in_reach(uint8_t* from, uint8_t* to) {
+    return (uintptr_t)(to > from ? to - from : from - to) < SYSCALL_TRAMP_REACH / 2;
+}
+
+/* Changes the protection of the pages at [start, end) both in the bookkeeping and in the PAL */
+static int protect_code(uint8_t* start, uint8_t* end, int prot) {
+    int ret = bkeep_mprotect(start, end - start, prot, 0);
+    if (ret < 0)
+        return ret;
+    if (!DkVirtualMemoryProtect(start, end - start, PAL_PROT(prot, 0)))
+        return -PAL_ERRNO;
+    return 0;
+}
+
+/*
+ * Rewrites the syscall sites in `sites`, which all lie in a private mapping with protection
+ * `prot` that no thread can be running yet. The trampolines are written to a new anonymous area
+ * within reach of the sites, which is made read-only and executable once it is complete.
+ */
+static unsigned long patch_syscall_sites(struct syscall_sites* sites, int prot) {
+    uint8_t* lo = sites->sites[0];
+    uint8_t* hi = sites->sites[0];
+    for (size_t i = 1; i < sites->count; i++) {
+        lo = MIN(lo, sites->sites[i]);
+        hi = MAX(hi, sites->sites[i]);
+    }
+
+    /* any area in [bottom, top) is within reach of all sites */
+    uint8_t* top    = PAL_CB(user_address.end);
+    uint8_t* bottom = PAL_CB(user_address.start);
+    if ((uintptr_t)lo + SYSCALL_TRAMP_REACH / 2 < (uintptr_t)top)
+        top = lo + SYSCALL_TRAMP_REACH / 2;
+    if ((uintptr_t)hi > (uintptr_t)bottom + SYSCALL_TRAMP_REACH / 2)
+        bottom = hi - SYSCALL_TRAMP_REACH / 2;
+    if (top <= bottom) {
+        /* the sites are too far apart for one area; patch the ones within reach of the lowest */
+        top    = MIN(lo + SYSCALL_TRAMP_REACH / 4, (uint8_t*)PAL_CB(user_address.end));
+        bottom = (uintptr_t)lo > (uintptr_t)PAL_CB(user_address.start) + SYSCALL_TRAMP_REACH / 4
+                     ? lo - SYSCALL_TRAMP_REACH / 4
+                     : (uint8_t*)PAL_CB(user_address.start);
+    }
+
+    size_t size = ALLOC_ALIGN_UP(sites->count * SYSCALL_TRAMP_SIZE);
+    uint8_t* area = bkeep_unmapped(top, bottom, size, PROT_READ | PROT_WRITE,
+                                   MAP_PRIVATE | MAP_ANONYMOUS, 0, SYSCALL_TRAMP_COMMENT);
+    if (!area)
+        return 0;
+
+    if (!DkVirtualMemoryAlloc(area, size, 0, PAL_PROT_READ | PAL_PROT_WRITE)) {
+        bkeep_munmap(area, size, 0);
+        return 0;
+    }
+
+    uint8_t* code_start = ALLOC_ALIGN_DOWN_PTR(lo);
+    uint8_t* code_end   = ALLOC_ALIGN_UP_PTR(hi + 7 + 2);
+    if (!(prot & PROT_WRITE) && protect_code(code_start, code_end, prot | PROT_WRITE) < 0) {
+        DkVirtualMemoryFree(area, size);
+        bkeep_munmap(area, size, 0);
+        return 0;
+    }
+
+    unsigned long patched = 0;
+    uint8_t* tramp = area;
+    for (size_t i = 0; i < sites->count; i++) {
+        uint8_t* site = sites->sites[i];
+
+        /* a function may be listed under several symbols: verify the site again right before
+         * writing to it, it may have been patched already */
+        size_t mov_len = x86_insn_length(site, 7);
+        if (!match_syscall_site(site, mov_len, site + mov_len + 2) ||
+            !tramp_in_reach(site, area) || !tramp_in_reach(site, area + size))
+            continue;
+
+        write_syscall_tramp(tramp, site, mov_len);
+
+        /* jmp <tramp>, padding the rest of the mov with nops; the syscall instruction is kept.
+         * Nothing can be running this code yet, so the bytes need not be written atomically. */
+        uint8_t patch[7];
+        patch[0] = 0xe9;
+        int32_t rel = (int32_t)(tramp - (site + 5));
+        memcpy(&patch[1], &rel, 4);
+        memset(&patch[5], 0x90, sizeof(patch) - 5);
+        memcpy(site, patch, mov_len);
+
+        tramp += SYSCALL_TRAMP_SIZE;
+        patched++;
+    }
+
+    /* the patched pages differ from the file now; keeping PROT_WRITE in the bookkeeping above
+     * tainted the VMA, so that they are checkpointed */
+    if (!(prot & PROT_WRITE))
+        protect_code(code_start, code_end, prot);
+
+    if (!patched) {
+        DkVirtualMemoryFree(area, size);
+        bkeep_munmap(area, size, 0);
+        return 0;
+    }
+
+    if (bkeep_mprotect(area, size, PROT_READ | PROT_EXEC, 0) < 0 ||
+        !DkVirtualMemoryProtect(area, size, PAL_PROT_READ | PAL_PROT_EXEC))
+        BUG();
+    return patched;
+}
+
+int rewrite_syscalls(struct shim_handle* file, void* addr, size_t length, off_t offset, int prot,
+                     int flags) {
+    if (!syscall_rewrite_enabled || !(prot & PROT_EXEC) || (flags & MAP_SHARED) || !length ||
+        file->type != TYPE_FILE)
+        return 0;
+
+    struct syscall_sites sites = {0};
+    int ret = find_elf_syscall_sites(file, addr, length, offset, &sites);
+    if (ret < 0 || !sites.count)
+        goto out;
+
+    unsigned long patched = patch_syscall_sites(&sites, prot);
+    if (patched) {
+        __atomic_add_fetch(&syscalls_patched, patched, __ATOMIC_RELAXED);
+        debug("rewrote %lu syscall instructions in %p-%p\n", patched, addr, addr + length);
+    }
+out:
+    free(sites.sites);
+    return ret;
+}
+
+static int rewrite_map_syscalls(struct shim_handle* file, struct link_map* l) {
+    for (struct loadcmd* c = l->loadcmds; c < &l->loadcmds[l->nloadcmds]; c++) {
+        if (!(c->prot & PROT_EXEC) || c->dataend <= c->mapstart)
+            continue;
+
+        int ret = rewrite_syscalls(file, (void*)RELOCATE(l, c->mapstart),
+                                   c->dataend - c->mapstart, c->mapoff, c->prot, MAP_PRIVATE);
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
 static int do_relocate_object(struct link_map* l);
 
 static int __load_elf_object(struct shim_handle* file, void* addr, int type,
@@ -976,6 +1342,7 @@ static int __load_elf_object(struct shim_handle* file, void* addr, int type,
             goto out;
     }
 
+    uint64_t map_start = startup_trace_time();
     struct link_map* map = __map_elf_object(file, hdr, len, addr, type, remap);
 
     if (!map) {
@@ -983,8 +1350,18 @@ static int __load_elf_object(struct shim_handle* file, void* addr, int type,
         goto out;
     }
 
-    if (type != OBJECT_INTERNAL && type != OBJECT_VDSO)
+    uint64_t map_end = startup_trace_time();
+    startup_trace_event(type == OBJECT_USER ? "libos: register" : "libos: map", map->l_name,
+                        map_start, map_end);
+
+    if (type != OBJECT_INTERNAL && type != OBJECT_VDSO) {
         do_relocate_object(map);
+        startup_trace_event("libos: relocate", map->l_name, map_end, startup_trace_time());
+    }
+
+    /* best effort: syscall instructions which are not rewritten are still emulated */
+    if (type == OBJECT_LOAD || type == OBJECT_MAPPED)
+        rewrite_map_syscalls(file, map);
 
     if (internal_map) {
         map->l_resolved     = true;
@@ -1497,6 +1874,8 @@ int init_loader(void) {
     if (!exec)
         return 0;
 
+    init_syscall_rewrite();
+
     struct link_map* exec_map = __search_map_by_handle(exec);
 
     if (!exec_map) {
@@ -1606,6 +1985,9 @@ noreturn void execute_elf_object(struct shim_handle* exec, int* argcp, const cha
 
     ElfW(Addr) entry = interp_map ? interp_map->l_entry : exec_map->l_entry;
 
+    uint64_t now = startup_trace_time();
+    startup_trace_event("libos: first user instruction", NULL, now, now);
+
     /* Ready to start execution, re-enable preemption. */
     shim_tcb_t* tcb = shim_get_tcb();
     __enable_preempt(tcb);
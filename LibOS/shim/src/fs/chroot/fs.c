@@ -34,6 +34,8 @@
 
 #include <linux/stat.h>
 #include <linux/fcntl.h>
+#include <linux/falloc.h>
+#include <linux/fadvise.h>
 
 #include <asm/fcntl.h>
 #include <asm/mman.h>
@@ -719,6 +721,191 @@ out:
     return ret;
 }
 
+static ssize_t chroot_pread(struct shim_handle* hdl, void* buf, size_t count, off_t pos) {
+    ssize_t ret;
+
+    if (count == 0)
+        return 0;
+
+    if (NEED_RECREATE(hdl) && (ret = chroot_recreate(hdl)) < 0)
+        return ret;
+
+    if (!(hdl->acc_mode & MAY_READ))
+        return -EBADF;
+
+    if (hdl->info.file.type == FILE_TTY)
+        return -ESPIPE;
+
+    off_t dummy_off_t;
+    if (__builtin_add_overflow(pos, count, &dummy_off_t))
+        return -EFBIG;
+
+    /* the position of the handle is not used, so the read does not need hdl->lock */
+    PAL_NUM pal_ret = DkStreamRead(hdl->pal_handle, pos, count, buf, NULL, 0);
+    if (pal_ret == PAL_STREAM_ERROR)
+        return PAL_NATIVE_ERRNO == PAL_ERROR_ENDOFSTREAM ? 0 : -PAL_ERRNO;
+
+    if (__builtin_add_overflow(pal_ret, 0, &ret))
+        BUG();
+    return ret;
+}
+
+static ssize_t chroot_pwrite(struct shim_handle* hdl, const void* buf, size_t count, off_t pos) {
+    ssize_t ret;
+
+    if (count == 0)
+        return 0;
+
+    if (NEED_RECREATE(hdl) && (ret = chroot_recreate(hdl)) < 0)
+        return ret;
+
+    if (!(hdl->acc_mode & MAY_WRITE))
+        return -EBADF;
+
+    struct shim_file_handle* file = &hdl->info.file;
+    if (file->type == FILE_TTY)
+        return -ESPIPE;
+
+    off_t end;
+    if (__builtin_add_overflow(pos, count, &end))
+        return -EFBIG;
+
+    PAL_NUM pal_ret = DkStreamWrite(hdl->pal_handle, pos, count, (void*)buf, NULL);
+    if (pal_ret == PAL_STREAM_ERROR)
+        return PAL_NATIVE_ERRNO == PAL_ERROR_ENDOFSTREAM ? 0 : -PAL_ERRNO;
+
+    if (__builtin_add_overflow(pal_ret, 0, &ret))
+        BUG();
+
+    /* only the size is shared with other users of the handle */
+    end = pos + pal_ret;
+    lock(&hdl->lock);
+    if (end > file->size) {
+        file->size = end;
+        chroot_update_size(hdl, file, FILE_HANDLE_DATA(hdl));
+    }
+    unlock(&hdl->lock);
+    return ret;
+}
+
+/* PAL_IOVEC is laid out like struct iovec, so the buffers are passed to the PAL as they are */
+static_assert(sizeof(PAL_IOVEC) == sizeof(struct iovec) &&
+                  offsetof(PAL_IOVEC, size) == offsetof(struct iovec, iov_len),
+              "PAL_IOVEC and struct iovec differ");
+
+/* one PAL call per buffer, for devices which do not support vectored PAL calls */
+static ssize_t chroot_rw_each(struct shim_handle* hdl, const struct iovec* vec, size_t vlen,
+                              off_t pos, bool write) {
+    ssize_t bytes = 0;
+
+    for (size_t i = 0; i < vlen; i++) {
+        if (!vec[i].iov_len)
+            continue;
+
+        PAL_NUM pal_ret = write ? DkStreamWrite(hdl->pal_handle, pos + bytes, vec[i].iov_len,
+                                                vec[i].iov_base, NULL)
+                                : DkStreamRead(hdl->pal_handle, pos + bytes, vec[i].iov_len,
+                                               vec[i].iov_base, NULL, 0);
+        if (pal_ret == PAL_STREAM_ERROR) {
+            if (PAL_NATIVE_ERRNO == PAL_ERROR_ENDOFSTREAM)
+                break;
+            return bytes ?: -PAL_ERRNO;
+        }
+
+        bytes += pal_ret;
+        if (pal_ret < vec[i].iov_len)
+            break;
+    }
+    return bytes;
+}
+
+/* Vectored I/O at `pos`, or at the position of the handle (which is then moved) if `pos` is -1.
+ * Like chroot_read() and chroot_write(), I/O at the position holds hdl->lock throughout. */
+static ssize_t chroot_rwv(struct shim_handle* hdl, const struct iovec* vec, size_t vlen,
+                          off_t pos, bool write) {
+    ssize_t ret;
+
+    if (NEED_RECREATE(hdl) && (ret = chroot_recreate(hdl)) < 0)
+        return ret;
+
+    if (!(hdl->acc_mode & (write ? MAY_WRITE : MAY_READ)))
+        return -EBADF;
+
+    size_t count = 0;
+    for (size_t i = 0; i < vlen; i++)
+        if (__builtin_add_overflow(count, vec[i].iov_len, &count) || (ssize_t)count < 0)
+            return -EINVAL;
+
+    if (count == 0)
+        return 0;
+
+    struct shim_file_handle* file = &hdl->info.file;
+    bool at_marker = pos < 0;
+
+    if (!at_marker && file->type == FILE_TTY)
+        return -ESPIPE;
+
+    if (at_marker) {
+        lock(&hdl->lock);
+        pos = file->type == FILE_TTY ? 0 : file->marker;
+    }
+
+    off_t end;
+    if (__builtin_add_overflow(pos, count, &end)) {
+        ret = -EFBIG;
+        goto out;
+    }
+
+    PAL_NUM pal_ret = write ? DkStreamWriteVector(hdl->pal_handle, pos, (PAL_IOVEC*)vec, vlen)
+                            : DkStreamReadVector(hdl->pal_handle, pos, (PAL_IOVEC*)vec, vlen);
+    if (pal_ret != PAL_STREAM_ERROR)
+        ret = pal_ret;
+    else if (PAL_NATIVE_ERRNO == PAL_ERROR_NOTSUPPORT)
+        ret = chroot_rw_each(hdl, vec, vlen, pos, write);
+    else
+        ret = PAL_NATIVE_ERRNO == PAL_ERROR_ENDOFSTREAM ? 0 : -PAL_ERRNO;
+
+    if (ret <= 0 || file->type == FILE_TTY)
+        goto out;
+
+    end = pos + ret;
+    if (at_marker)
+        file->marker = end;
+
+    if (write) {
+        if (!at_marker)
+            lock(&hdl->lock);
+        if (end > file->size) {
+            file->size = end;
+            chroot_update_size(hdl, file, FILE_HANDLE_DATA(hdl));
+        }
+        if (!at_marker)
+            unlock(&hdl->lock);
+    }
+out:
+    if (at_marker)
+        unlock(&hdl->lock);
+    return ret;
+}
+
+static ssize_t chroot_readv(struct shim_handle* hdl, const struct iovec* vec, size_t vlen) {
+    return chroot_rwv(hdl, vec, vlen, -1, /*write=*/false);
+}
+
+static ssize_t chroot_writev(struct shim_handle* hdl, const struct iovec* vec, size_t vlen) {
+    return chroot_rwv(hdl, vec, vlen, -1, /*write=*/true);
+}
+
+static ssize_t chroot_preadv(struct shim_handle* hdl, const struct iovec* vec, size_t vlen,
+                             off_t pos) {
+    return chroot_rwv(hdl, vec, vlen, pos, /*write=*/false);
+}
+
+static ssize_t chroot_pwritev(struct shim_handle* hdl, const struct iovec* vec, size_t vlen,
+                              off_t pos) {
+    return chroot_rwv(hdl, vec, vlen, pos, /*write=*/true);
+}
+
 static int chroot_mmap (struct shim_handle * hdl, void ** addr, size_t size,
                         int prot, int flags, off_t offset)
 {
@@ -789,6 +976,78 @@ out:
     return ret;
 }
 
+/* fallocate(), fadvise64() and sync_file_range() pass their flags to the PAL as they are */
+static_assert(FALLOC_FL_KEEP_SIZE == PAL_ALLOCATE_KEEP_SIZE &&
+                  FALLOC_FL_PUNCH_HOLE == PAL_ALLOCATE_PUNCH_HOLE,
+              "FALLOC_FL_* and PAL_ALLOCATE_* differ");
+static_assert(POSIX_FADV_NORMAL == PAL_ADVICE_NORMAL && POSIX_FADV_RANDOM == PAL_ADVICE_RANDOM &&
+                  POSIX_FADV_SEQUENTIAL == PAL_ADVICE_SEQUENTIAL &&
+                  POSIX_FADV_WILLNEED == PAL_ADVICE_WILLNEED &&
+                  POSIX_FADV_DONTNEED == PAL_ADVICE_DONTNEED &&
+                  POSIX_FADV_NOREUSE == PAL_ADVICE_NOREUSE,
+              "POSIX_FADV_* and PAL_ADVICE_* differ");
+static_assert(SYNC_FILE_RANGE_WAIT_BEFORE == PAL_SYNC_RANGE_WAIT_BEFORE &&
+                  SYNC_FILE_RANGE_WRITE == PAL_SYNC_RANGE_WRITE &&
+                  SYNC_FILE_RANGE_WAIT_AFTER == PAL_SYNC_RANGE_WAIT_AFTER,
+              "SYNC_FILE_RANGE_* and PAL_SYNC_RANGE_* differ");
+
+static int chroot_fallocate(struct shim_handle* hdl, int mode, off_t offset, off_t len) {
+    int ret;
+
+    if (NEED_RECREATE(hdl) && (ret = chroot_recreate(hdl)) < 0)
+        return ret;
+
+    if (!(hdl->acc_mode & MAY_WRITE))
+        return -EBADF;
+
+    struct shim_file_handle* file = &hdl->info.file;
+    if (file->type != FILE_REGULAR)
+        return -ENODEV;
+
+    if (!DkStreamAllocate(hdl->pal_handle, offset, len, mode))
+        return PAL_NATIVE_ERRNO == PAL_ERROR_NOTSUPPORT ? -EOPNOTSUPP : -PAL_ERRNO;
+
+    if (!(mode & FALLOC_FL_KEEP_SIZE)) {
+        lock(&hdl->lock);
+        if (offset + len > file->size) {
+            file->size = offset + len;
+            chroot_update_size(hdl, file, FILE_HANDLE_DATA(hdl));
+        }
+        unlock(&hdl->lock);
+    }
+    return 0;
+}
+
+/* LibOS does not cache the contents of files, so the hints only reach the host */
+static int chroot_fadvise(struct shim_handle* hdl, off_t offset, off_t len, int advice) {
+    int ret;
+
+    if (NEED_RECREATE(hdl) && (ret = chroot_recreate(hdl)) < 0)
+        return ret;
+
+    /* like Linux, ignore hints for devices */
+    if (hdl->info.file.type != FILE_REGULAR)
+        return 0;
+
+    if (!DkStreamAdvise(hdl->pal_handle, offset, len, advice))
+        return -PAL_ERRNO;
+    return 0;
+}
+
+static int chroot_sync_range(struct shim_handle* hdl, off_t offset, off_t nbytes, int flags) {
+    int ret;
+
+    if (NEED_RECREATE(hdl) && (ret = chroot_recreate(hdl)) < 0)
+        return ret;
+
+    if (hdl->info.file.type != FILE_REGULAR)
+        return 0;
+
+    if (!DkStreamSyncRange(hdl->pal_handle, offset, nbytes, flags))
+        return -PAL_ERRNO;
+    return 0;
+}
+
 static int chroot_truncate (struct shim_handle * hdl, off_t len)
 {
     int ret = 0;
@@ -1153,10 +1412,19 @@ struct shim_fs_ops chroot_fs_ops = {
         .close       = &chroot_close,
         .read        = &chroot_read,
         .write       = &chroot_write,
+        .pread       = &chroot_pread,
+        .pwrite      = &chroot_pwrite,
+        .readv       = &chroot_readv,
+        .writev      = &chroot_writev,
+        .preadv      = &chroot_preadv,
+        .pwritev     = &chroot_pwritev,
         .mmap        = &chroot_mmap,
         .seek        = &chroot_seek,
         .hstat       = &chroot_hstat,
         .truncate    = &chroot_truncate,
+        .fallocate   = &chroot_fallocate,
+        .fadvise     = &chroot_fadvise,
+        .sync_range  = &chroot_sync_range,
         .checkout    = &chroot_checkout,
         .checkpoint  = &chroot_checkpoint,
         .migrate     = &chroot_migrate,
@@ -34,8 +34,10 @@ extern const struct pseudo_fs_ops fs_meminfo;
 
 extern const struct pseudo_fs_ops fs_cpuinfo;
 
+extern const struct pseudo_fs_ops fs_syscall_stats;
+
 static const struct pseudo_dir proc_root_dir = {
-    .size = 5,
+    .size = 6,
     .ent  = {
               { .name   = "self",
                 .fs_ops = &fs_thread,
@@ -52,6 +54,9 @@ static const struct pseudo_dir proc_root_dir = {
               { .name   = "cpuinfo",
                 .fs_ops = &fs_cpuinfo,
                 .type   = LINUX_DT_REG },
+              { .name   = "syscall_stats",
+                .fs_ops = &fs_syscall_stats,
+                .type   = LINUX_DT_REG },
             }
 };
 
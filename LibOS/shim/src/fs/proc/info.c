@@ -17,7 +17,8 @@
 /*!
  * \file
  *
- * This file contains the implementation of `/proc/meminfo` and `/proc/cpuinfo`.
+ * This file contains the implementation of `/proc/meminfo`, `/proc/cpuinfo` and
+ * `/proc/syscall_stats`.
  */
 
 #include "shim_fs.h"
@@ -155,17 +156,25 @@ static int proc_cpuinfo_open(struct shim_handle* hdl, const char* name, int flag
         len += ret;                                                     \
     } while (0)
 
+    /* packages are assumed to be identical, as they are on all multi-socket x86 machines */
+    PAL_CPU_TOPO* topo = pal_control.cpu_info.cpu_topology;
+    size_t sockets     = pal_control.cpu_info.cpu_sockets ?: 1;
+    size_t siblings    = pal_control.cpu_info.cpu_num / sockets;
+    size_t cores       = pal_control.cpu_info.cpu_cores / sockets;
+
     for (size_t n = 0; n < pal_control.cpu_info.cpu_num; n++) {
         /* Below strings must match exactly the strings retrieved from /proc/cpuinfo
          * (see Linux's arch/x86/kernel/cpu/proc.c) */
-        ADD_INFO("processor\t: %lu\n", n);
+        ADD_INFO("processor\t: %lu\n", topo ? topo[n].id : n);
         ADD_INFO("vendor_id\t: %s\n", pal_control.cpu_info.cpu_vendor);
         ADD_INFO("cpu family\t: %lu\n", pal_control.cpu_info.cpu_family);
         ADD_INFO("model\t\t: %lu\n", pal_control.cpu_info.cpu_model);
         ADD_INFO("model name\t: %s\n", pal_control.cpu_info.cpu_brand);
         ADD_INFO("stepping\t: %lu\n", pal_control.cpu_info.cpu_stepping);
-        ADD_INFO("core id\t\t: %lu\n", n);
-        ADD_INFO("cpu cores\t: %lu\n", pal_control.cpu_info.cpu_num);
+        ADD_INFO("physical id\t: %lu\n", topo ? topo[n].socket : 0);
+        ADD_INFO("siblings\t: %lu\n", siblings);
+        ADD_INFO("core id\t\t: %lu\n", topo ? topo[n].core : n);
+        ADD_INFO("cpu cores\t: %lu\n", cores);
         double bogomips = pal_control.cpu_info.cpu_bogomips;
         // Apparently graphene snprintf cannot into floats.
         ADD_INFO("bogomips\t: %lu.%02lu\n",
@@ -190,6 +199,32 @@ static int proc_cpuinfo_open(struct shim_handle* hdl, const char* name, int flag
     return 0;
 }
 
+static int proc_syscall_stats_open(struct shim_handle* hdl, const char* name, int flags) {
+    __UNUSED(name);
+    if (flags & (O_WRONLY | O_RDWR))
+        return -EACCES;
+
+    char* str;
+    size_t len;
+    int ret = format_syscall_stats(&str, &len);
+    if (ret < 0)
+        return ret;
+
+    struct shim_str_data* data = calloc(1, sizeof(struct shim_str_data));
+    if (!data) {
+        free(str);
+        return -ENOMEM;
+    }
+
+    data->str          = str;
+    data->len          = len;
+    hdl->type          = TYPE_STR;
+    hdl->flags         = flags & ~O_RDONLY;
+    hdl->acc_mode      = MAY_READ;
+    hdl->info.str.data = data;
+    return 0;
+}
+
 struct pseudo_fs_ops fs_meminfo = {
     .mode = &proc_info_mode,
     .stat = &proc_info_stat,
@@ -201,3 +236,9 @@ struct pseudo_fs_ops fs_cpuinfo = {
     .stat = &proc_info_stat,
     .open = &proc_cpuinfo_open,
 };
+
+struct pseudo_fs_ops fs_syscall_stats = {
+    .mode = &proc_info_mode,
+    .stat = &proc_info_stat,
+    .open = &proc_syscall_stats_open,
+};
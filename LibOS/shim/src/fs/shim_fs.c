@@ -37,7 +37,7 @@ struct shim_fs {
     struct shim_d_ops* d_ops;
 };
 
-#define NUM_MOUNTABLE_FS 3
+#define NUM_MOUNTABLE_FS 4
 
 struct shim_fs mountable_fs[NUM_MOUNTABLE_FS] = {
     {
@@ -55,9 +55,14 @@ struct shim_fs mountable_fs[NUM_MOUNTABLE_FS] = {
         .fs_ops = &dev_fs_ops,
         .d_ops  = &dev_d_ops,
     },
+    {
+        .name   = "sys",
+        .fs_ops = &sys_fs_ops,
+        .d_ops  = &sys_d_ops,
+    },
 };
 
-#define NUM_BUILTIN_FS 5
+#define NUM_BUILTIN_FS 8
 
 struct shim_mount* builtin_fs[NUM_BUILTIN_FS] = {
     &chroot_builtin_fs,
@@ -65,6 +70,9 @@ struct shim_mount* builtin_fs[NUM_BUILTIN_FS] = {
     &socket_builtin_fs,
     &epoll_builtin_fs,
     &eventfd_builtin_fs,
+    &shm_builtin_fs,
+    &timerfd_builtin_fs,
+    &signalfd_builtin_fs,
 };
 
 static struct shim_lock mount_mgr_lock;
@@ -134,6 +142,13 @@ static int __mount_sys(struct shim_dentry* root) {
         return ret;
     }
 
+    /* the emulated CPU topology is optional, so do not fail if the host has no /sys to mount on */
+    debug("mounting as sys filesystem: /sys/devices/system\n");
+
+    if ((ret = mount_fs("sys", NULL, "/sys/devices/system", NULL, NULL, 1)) < 0) {
+        debug("mounting sys filesystem failed (%d)\n", ret);
+    }
+
     debug("mounting as dev filesystem: /dev\n");
 
     struct shim_dentry* dev_dent = NULL;
@@ -0,0 +1,516 @@
+/* Copyright (C) 2014 Stony Brook University
+   This file is part of Graphene Library OS.
+
+   Graphene Library OS is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   Graphene Library OS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/*!
+ * \file
+ *
+ * This file contains the implementation of the `/sys/devices/system` pseudo-filesystem, which
+ * exposes the CPU and NUMA topology reported by the PAL (the `cpu` and `node` subtrees, as far as
+ * libnuma, hwloc and glibc's get_nprocs() read them).
+ */
+
+#include "shim_fs.h"
+
+/* Returns the n-th online CPU; hosts without topology information get one socket and node */
+static PAL_CPU_TOPO get_cpu(size_t n) {
+    PAL_CPU_TOPO* topo = pal_control.cpu_info.cpu_topology;
+    if (topo)
+        return topo[n];
+    return (PAL_CPU_TOPO){ .id = n, .socket = 0, .core = n, .node = 0 };
+}
+
+static bool find_cpu(unsigned long id, PAL_CPU_TOPO* cpu) {
+    for (size_t n = 0; n < pal_control.cpu_info.cpu_num; n++) {
+        *cpu = get_cpu(n);
+        if (cpu->id == id)
+            return true;
+    }
+    return false;
+}
+
+static bool find_node(unsigned long node) {
+    for (size_t n = 0; n < pal_control.cpu_info.cpu_num; n++)
+        if (get_cpu(n).node == node)
+            return true;
+    return false;
+}
+
+/* Parses a "<prefix><number>" path component (e.g. "cpu3") at the start of `name` */
+static int parse_index(const char* name, const char* prefix, unsigned long* idx) {
+    for (; *prefix; prefix++, name++)
+        if (*name != *prefix)
+            return -ENOENT;
+
+    if (*name < '0' || *name > '9')
+        return -ENOENT;
+
+    unsigned long val = 0;
+    for (; *name && *name != '/'; name++) {
+        if (*name < '0' || *name > '9')
+            return -ENOENT;
+        val = val * 10 + *name - '0';
+    }
+    *idx = val;
+    return 0;
+}
+
+/* Finds the "<prefix><number>" component following `dir` in a path like "cpu/cpu3/topology" */
+static int parse_path_index(const char* name, const char* dir, const char* prefix,
+                            unsigned long* idx) {
+    for (; *dir; dir++, name++)
+        if (*name != *dir)
+            return -ENOENT;
+    if (*name != '/')
+        return -ENOENT;
+    return parse_index(name + 1, prefix, idx);
+}
+
+static const char* last_component(const char* name) {
+    const char* last = name;
+    for (; *name; name++)
+        if (*name == '/')
+            last = name + 1;
+    return last;
+}
+
+/* Formats sorted, distinct `ids` as a sysfs list, e.g. "0-3,8\n" */
+static int print_list(const unsigned long* ids, size_t num, char** str, size_t* len) {
+    size_t max = num * 2 * 21 + 2; /* two 20-digit numbers and a separator per range */
+    char* buf = malloc(max);
+    if (!buf)
+        return -ENOMEM;
+
+    size_t off = 0;
+    for (size_t i = 0; i < num;) {
+        size_t j = i;
+        while (j + 1 < num && ids[j + 1] == ids[j] + 1)
+            j++;
+        if (j == i)
+            off += snprintf(buf + off, max - off, "%s%lu", off ? "," : "", ids[i]);
+        else
+            off += snprintf(buf + off, max - off, "%s%lu-%lu", off ? "," : "", ids[i], ids[j]);
+        i = j + 1;
+    }
+    buf[off++] = '\n';
+    buf[off]   = '\0';
+
+    *str = buf;
+    *len = off;
+    return 0;
+}
+
+/* Formats the CPUs for which `match(cpu, ref)` holds (all CPUs if `match` is NULL) */
+static int print_cpu_list(bool (*match)(const PAL_CPU_TOPO*, const PAL_CPU_TOPO*),
+                          const PAL_CPU_TOPO* ref, char** str, size_t* len) {
+    size_t num_cpus = pal_control.cpu_info.cpu_num;
+    unsigned long* ids = malloc(num_cpus * sizeof(*ids));
+    if (!ids)
+        return -ENOMEM;
+
+    size_t num = 0;
+    for (size_t n = 0; n < num_cpus; n++) {
+        PAL_CPU_TOPO cpu = get_cpu(n);
+        if (!match || match(&cpu, ref))
+            ids[num++] = cpu.id;
+    }
+
+    int ret = print_list(ids, num, str, len);
+    free(ids);
+    return ret;
+}
+
+static bool same_core(const PAL_CPU_TOPO* a, const PAL_CPU_TOPO* b) {
+    return a->socket == b->socket && a->core == b->core;
+}
+
+static bool same_socket(const PAL_CPU_TOPO* a, const PAL_CPU_TOPO* b) {
+    return a->socket == b->socket;
+}
+
+static bool same_node(const PAL_CPU_TOPO* a, const PAL_CPU_TOPO* b) {
+    return a->node == b->node;
+}
+
+/* Returns the sorted, distinct NUMA nodes which have CPUs (there are only a few of them) */
+static int collect_nodes(unsigned long** out, size_t* out_num) {
+    size_t num_cpus = pal_control.cpu_info.cpu_num;
+    unsigned long* nodes = malloc(num_cpus * sizeof(*nodes));
+    if (!nodes)
+        return -ENOMEM;
+
+    size_t num = 0;
+    for (size_t n = 0; n < num_cpus; n++) {
+        unsigned long node = get_cpu(n).node;
+        size_t i = 0;
+        while (i < num && nodes[i] < node)
+            i++;
+        if (i < num && nodes[i] == node)
+            continue;
+        memmove(&nodes[i + 1], &nodes[i], (num - i) * sizeof(*nodes));
+        nodes[i] = node;
+        num++;
+    }
+
+    *out     = nodes;
+    *out_num = num;
+    return 0;
+}
+
+static int print_node_list(char** str, size_t* len) {
+    unsigned long* nodes;
+    size_t num;
+    int ret = collect_nodes(&nodes, &num);
+    if (ret < 0)
+        return ret;
+
+    ret = print_list(nodes, num, str, len);
+    free(nodes);
+    return ret;
+}
+
+static int sys_open_str(struct shim_handle* hdl, int flags, char* str, size_t len) {
+    struct shim_str_data* data = calloc(1, sizeof(struct shim_str_data));
+    if (!data) {
+        free(str);
+        return -ENOMEM;
+    }
+
+    data->str          = str;
+    data->len          = len;
+    hdl->type          = TYPE_STR;
+    hdl->flags         = flags & ~O_RDONLY;
+    hdl->acc_mode      = MAY_READ;
+    hdl->info.str.data = data;
+    return 0;
+}
+
+static int sys_info_mode(const char* name, mode_t* mode) {
+    __UNUSED(name);
+    *mode = FILE_R_MODE | S_IFREG;
+    return 0;
+}
+
+static int sys_info_stat(const char* name, struct stat* buf) {
+    __UNUSED(name);
+    memset(buf, 0, sizeof(struct stat));
+    buf->st_dev  = 1;    /* dummy ID of device containing file */
+    buf->st_ino  = 1;    /* dummy inode number */
+    buf->st_mode = FILE_R_MODE | S_IFREG;
+    return 0;
+}
+
+/* cpu/online, cpu/possible */
+static int sys_cpu_list_open(struct shim_handle* hdl, const char* name, int flags) {
+    __UNUSED(name);
+    if (flags & (O_WRONLY | O_RDWR))
+        return -EACCES;
+
+    char* str;
+    size_t len;
+    int ret = print_cpu_list(/*match=*/NULL, /*ref=*/NULL, &str, &len);
+    if (ret < 0)
+        return ret;
+    return sys_open_str(hdl, flags, str, len);
+}
+
+/* cpu/cpuN/topology/{physical_package_id,core_id,thread_siblings_list,core_siblings_list} */
+static int sys_cpu_topology_open(struct shim_handle* hdl, const char* name, int flags) {
+    if (flags & (O_WRONLY | O_RDWR))
+        return -EACCES;
+
+    unsigned long id;
+    PAL_CPU_TOPO cpu;
+    if (parse_path_index(name, "cpu", "cpu", &id) < 0 || !find_cpu(id, &cpu))
+        return -ENOENT;
+
+    char* str;
+    size_t len;
+    int ret;
+    const char* file = last_component(name);
+
+    if (!strcmp_static(file, "physical_package_id") || !strcmp_static(file, "core_id")) {
+        str = malloc(24);
+        if (!str)
+            return -ENOMEM;
+        len = snprintf(str, 24, "%lu\n", file[0] == 'p' ? cpu.socket : cpu.core);
+        ret = 0;
+    } else if (!strcmp_static(file, "thread_siblings_list")) {
+        ret = print_cpu_list(same_core, &cpu, &str, &len);
+    } else {
+        ret = print_cpu_list(same_socket, &cpu, &str, &len);
+    }
+    if (ret < 0)
+        return ret;
+    return sys_open_str(hdl, flags, str, len);
+}
+
+/* node/online, node/has_cpu */
+static int sys_node_list_open(struct shim_handle* hdl, const char* name, int flags) {
+    __UNUSED(name);
+    if (flags & (O_WRONLY | O_RDWR))
+        return -EACCES;
+
+    char* str;
+    size_t len;
+    int ret = print_node_list(&str, &len);
+    if (ret < 0)
+        return ret;
+    return sys_open_str(hdl, flags, str, len);
+}
+
+/* node/nodeN/cpulist */
+static int sys_node_cpulist_open(struct shim_handle* hdl, const char* name, int flags) {
+    if (flags & (O_WRONLY | O_RDWR))
+        return -EACCES;
+
+    unsigned long node;
+    if (parse_path_index(name, "node", "node", &node) < 0 || !find_node(node))
+        return -ENOENT;
+
+    PAL_CPU_TOPO ref = { .node = node };
+    char* str;
+    size_t len;
+    int ret = print_cpu_list(same_node, &ref, &str, &len);
+    if (ret < 0)
+        return ret;
+    return sys_open_str(hdl, flags, str, len);
+}
+
+static int sys_match_cpu(const char* name) {
+    unsigned long id;
+    PAL_CPU_TOPO cpu;
+    return parse_index(name, "cpu", &id) == 0 && find_cpu(id, &cpu);
+}
+
+static int sys_match_node(const char* name) {
+    unsigned long node;
+    return parse_index(name, "node", &node) == 0 && find_node(node);
+}
+
+/* Appends a directory entry "<prefix><idx>" to the buffer of a list_name callback */
+static int add_dirent(struct shim_dirent** buf, void* buf_end, const char* prefix,
+                      unsigned long idx) {
+    char name[32];
+    size_t name_size = snprintf(name, sizeof(name), "%s%lu", prefix, idx) + 1;
+
+    struct shim_dirent* dirent = *buf;
+    if ((void*)(dirent + 1) + name_size > buf_end)
+        return -ENOMEM;
+
+    memcpy(dirent->name, name, name_size);
+    dirent->next = (void*)(dirent + 1) + name_size;
+    dirent->ino  = 1;
+    dirent->type = LINUX_DT_DIR;
+    *buf = dirent->next;
+    return 0;
+}
+
+static int sys_list_cpu(const char* name, struct shim_dirent** buf, int len) {
+    __UNUSED(name);
+    void* buf_end = (void*)*buf + len;
+    for (size_t n = 0; n < pal_control.cpu_info.cpu_num; n++) {
+        int ret = add_dirent(buf, buf_end, "cpu", get_cpu(n).id);
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
+static int sys_list_node(const char* name, struct shim_dirent** buf, int len) {
+    __UNUSED(name);
+    void* buf_end = (void*)*buf + len;
+
+    unsigned long* nodes;
+    size_t num;
+    int ret = collect_nodes(&nodes, &num);
+    if (ret < 0)
+        return ret;
+
+    for (size_t i = 0; i < num; i++) {
+        ret = add_dirent(buf, buf_end, "node", nodes[i]);
+        if (ret < 0)
+            break;
+    }
+    free(nodes);
+    return ret;
+}
+
+static const struct pseudo_fs_ops fs_dir = {
+    .open = &pseudo_dir_open,
+    .mode = &pseudo_dir_mode,
+    .stat = &pseudo_dir_stat,
+};
+
+static const struct pseudo_fs_ops fs_cpu_list = {
+    .mode = &sys_info_mode,
+    .stat = &sys_info_stat,
+    .open = &sys_cpu_list_open,
+};
+
+static const struct pseudo_fs_ops fs_cpu_topology = {
+    .mode = &sys_info_mode,
+    .stat = &sys_info_stat,
+    .open = &sys_cpu_topology_open,
+};
+
+static const struct pseudo_fs_ops fs_node_list = {
+    .mode = &sys_info_mode,
+    .stat = &sys_info_stat,
+    .open = &sys_node_list_open,
+};
+
+static const struct pseudo_fs_ops fs_node_cpulist = {
+    .mode = &sys_info_mode,
+    .stat = &sys_info_stat,
+    .open = &sys_node_cpulist_open,
+};
+
+static const struct pseudo_name_ops nm_cpu = {
+    .match_name = &sys_match_cpu,
+    .list_name  = &sys_list_cpu,
+};
+
+static const struct pseudo_name_ops nm_node = {
+    .match_name = &sys_match_node,
+    .list_name  = &sys_list_node,
+};
+
+static const struct pseudo_dir dir_cpu_topology = {
+    .size = 4,
+    .ent  = {
+              { .name   = "physical_package_id",
+                .fs_ops = &fs_cpu_topology,
+                .type   = LINUX_DT_REG },
+              { .name   = "core_id",
+                .fs_ops = &fs_cpu_topology,
+                .type   = LINUX_DT_REG },
+              { .name   = "thread_siblings_list",
+                .fs_ops = &fs_cpu_topology,
+                .type   = LINUX_DT_REG },
+              { .name   = "core_siblings_list",
+                .fs_ops = &fs_cpu_topology,
+                .type   = LINUX_DT_REG },
+            }
+};
+
+static const struct pseudo_dir dir_cpu_each = {
+    .size = 1,
+    .ent  = {
+              { .name   = "topology",
+                .fs_ops = &fs_dir,
+                .dir    = &dir_cpu_topology },
+            }
+};
+
+static const struct pseudo_dir dir_cpu = {
+    .size = 3,
+    .ent  = {
+              { .name   = "online",
+                .fs_ops = &fs_cpu_list,
+                .type   = LINUX_DT_REG },
+              { .name   = "possible",
+                .fs_ops = &fs_cpu_list,
+                .type   = LINUX_DT_REG },
+              { .name_ops = &nm_cpu,
+                .fs_ops   = &fs_dir,
+                .dir      = &dir_cpu_each },
+            }
+};
+
+static const struct pseudo_dir dir_node_each = {
+    .size = 1,
+    .ent  = {
+              { .name   = "cpulist",
+                .fs_ops = &fs_node_cpulist,
+                .type   = LINUX_DT_REG },
+            }
+};
+
+static const struct pseudo_dir dir_node = {
+    .size = 3,
+    .ent  = {
+              { .name   = "online",
+                .fs_ops = &fs_node_list,
+                .type   = LINUX_DT_REG },
+              { .name   = "has_cpu",
+                .fs_ops = &fs_node_list,
+                .type   = LINUX_DT_REG },
+              { .name_ops = &nm_node,
+                .fs_ops   = &fs_dir,
+                .dir      = &dir_node_each },
+            }
+};
+
+static const struct pseudo_dir sys_root_dir = {
+    .size = 2,
+    .ent  = {
+              { .name   = "cpu",
+                .fs_ops = &fs_dir,
+                .dir    = &dir_cpu },
+              { .name   = "node",
+                .fs_ops = &fs_dir,
+                .dir    = &dir_node },
+            }
+};
+
+static const struct pseudo_ent sys_root_ent = {
+    .name   = "",
+    .fs_ops = &fs_dir,
+    .dir    = &sys_root_dir,
+};
+
+static int sys_mode(struct shim_dentry* dent, mode_t* mode) {
+    return pseudo_mode(dent, mode, &sys_root_ent);
+}
+
+static int sys_lookup(struct shim_dentry* dent) {
+    return pseudo_lookup(dent, &sys_root_ent);
+}
+
+static int sys_open(struct shim_handle* hdl, struct shim_dentry* dent, int flags) {
+    return pseudo_open(hdl, dent, flags, &sys_root_ent);
+}
+
+static int sys_readdir(struct shim_dentry* dent, struct shim_dirent** dirent) {
+    return pseudo_readdir(dent, dirent, &sys_root_ent);
+}
+
+static int sys_stat(struct shim_dentry* dent, struct stat* buf) {
+    return pseudo_stat(dent, buf, &sys_root_ent);
+}
+
+static int sys_hstat(struct shim_handle* hdl, struct stat* buf) {
+    return pseudo_hstat(hdl, buf, &sys_root_ent);
+}
+
+struct shim_fs_ops sys_fs_ops = {
+    .mount   = &pseudo_mount,
+    .unmount = &pseudo_unmount,
+    .close   = &str_close,
+    .read    = &str_read,
+    .write   = &str_write,
+    .seek    = &str_seek,
+    .flush   = &str_flush,
+    .hstat   = &sys_hstat,
+};
+
+struct shim_d_ops sys_d_ops = {
+    .open    = &sys_open,
+    .stat    = &sys_stat,
+    .mode    = &sys_mode,
+    .lookup  = &sys_lookup,
+    .readdir = &sys_readdir,
+};
@@ -858,6 +858,7 @@ static void shim_ipc_helper_prepare(void* arg) {
     }
 
     debug("IPC helper thread started\n");
+    pin_helper_thread();
 
     /* swap stack to be sure we don't drain the small stack PAL provides */
     self->stack_top = stack + IPC_HELPER_STACK_SIZE;
@@ -1600,7 +1600,7 @@ int NS_SEND(findkey)(NS_KEY* key) {
     int ret = 0;
 
     ret = CONCAT2(NS, get_key)(key, false);
-    if (!ret)
+    if (ret >= 0)
         goto out;
 
     IDTYPE dest;
@@ -29,6 +29,16 @@
 #define IDLE_SLEEP_TIME 1000
 #define MAX_IDLE_CYCLES 100
 
+/* maximum number of async IO objects reported by a single wait of the helper */
+#define ASYNC_WAIT_BATCH 64
+
+#define TIMER_HEAP_INIT_SIZE 16
+
+/* heap_idx of an event which is not in timer_heap */
+#define TIMER_NOT_QUEUED ((size_t)-1)
+
+struct async_timer;
+
 DEFINE_LIST(async_event);
 struct async_event {
     IDTYPE caller;  /* thread installing this event */
@@ -37,9 +47,35 @@ struct async_event {
     void* arg;
     PAL_HANDLE object;     /* handle (async IO) to wait on */
     uint64_t expire_time;  /* alarm/timer to wait on */
+    size_t heap_idx;       /* position in timer_heap */
+    struct async_timer* timer; /* owning timer for async_timer events, NULL otherwise */
 };
 DEFINE_LISTP(async_event);
+
+/* Timers owned by their user (timerfd). Unlike alarm()/setitimer() events, they do not cancel each
+ * other and the helper does not call back into their user: it only counts expirations, re-arms
+ * periodic timers in place and makes `notify` readable when the count becomes non-zero. All their
+ * fields are protected by async_helper_lock. */
+struct async_timer {
+    struct async_event event; /* queued in timer_heap while the timer is armed */
+    uint64_t interval;
+    uint64_t expirations;
+    AEVENTTYPE notify;
+};
+
+/* async IO events; their objects are kept registered in async_wait_set */
 static LISTP_TYPE(async_event) async_list;
+/* one-off events without an object or a timeout (exit-child cleanups) */
+static LISTP_TYPE(async_event) pending_list;
+
+/* Alarm/timer events, kept in a binary min-heap ordered by expiration time, so that installing a
+ * timer and expiring the next one are O(log n) and finding the next deadline is O(1). All timers
+ * that have expired by the time the helper wakes up are fired in that one wakeup. */
+static struct async_event** timer_heap;
+static size_t timer_heap_cnt;
+static size_t timer_heap_size;
+
+static PAL_HANDLE async_wait_set;
 
 /* Should be accessed with async_helper_lock held. */
 static enum { HELPER_NOTALIVE, HELPER_ALIVE } async_helper_state;
@@ -51,12 +87,92 @@ static AEVENTTYPE install_new_event;
 
 static int create_async_helper(void);
 
+static void timer_heap_swap(size_t i, size_t j) {
+    struct async_event* tmp = timer_heap[i];
+    timer_heap[i] = timer_heap[j];
+    timer_heap[j] = tmp;
+    timer_heap[i]->heap_idx = i;
+    timer_heap[j]->heap_idx = j;
+}
+
+static void timer_heap_sift_up(size_t i) {
+    while (i && timer_heap[(i - 1) / 2]->expire_time > timer_heap[i]->expire_time) {
+        timer_heap_swap(i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void timer_heap_sift_down(size_t i) {
+    while (true) {
+        size_t min = i;
+        size_t l = 2 * i + 1;
+        size_t r = 2 * i + 2;
+        if (l < timer_heap_cnt && timer_heap[l]->expire_time < timer_heap[min]->expire_time)
+            min = l;
+        if (r < timer_heap_cnt && timer_heap[r]->expire_time < timer_heap[min]->expire_time)
+            min = r;
+        if (min == i)
+            break;
+        timer_heap_swap(i, min);
+        i = min;
+    }
+}
+
+/* this should be called with the async_helper_lock held */
+static int timer_heap_push(struct async_event* event) {
+    assert(locked(&async_helper_lock));
+
+    if (timer_heap_cnt == timer_heap_size) {
+        size_t new_size = timer_heap_size ? timer_heap_size * 2 : TIMER_HEAP_INIT_SIZE;
+        struct async_event** new_heap = malloc(sizeof(*new_heap) * new_size);
+        if (!new_heap)
+            return -ENOMEM;
+        if (timer_heap_cnt)
+            memcpy(new_heap, timer_heap, sizeof(*new_heap) * timer_heap_cnt);
+        free(timer_heap);
+        timer_heap      = new_heap;
+        timer_heap_size = new_size;
+    }
+
+    size_t i = timer_heap_cnt++;
+    timer_heap[i] = event;
+    event->heap_idx = i;
+    timer_heap_sift_up(i);
+    return 0;
+}
+
+/* this should be called with the async_helper_lock held */
+static void timer_heap_remove(size_t i) {
+    assert(locked(&async_helper_lock));
+    assert(i < timer_heap_cnt);
+
+    timer_heap[i]->heap_idx = TIMER_NOT_QUEUED;
+    if (i == --timer_heap_cnt)
+        return;
+
+    timer_heap[i] = timer_heap[timer_heap_cnt];
+    timer_heap[i]->heap_idx = i;
+    timer_heap_sift_down(i);
+    timer_heap_sift_up(i);
+}
+
+/* this should be called with the async_helper_lock held */
+static struct async_event* timer_heap_pop(void) {
+    assert(locked(&async_helper_lock));
+    assert(timer_heap_cnt);
+
+    struct async_event* top = timer_heap[0];
+    timer_heap_remove(0);
+    return top;
+}
+
 /* Threads register async events like alarm(), setitimer(), ioctl(FIOASYNC)
- * using this function. These events are enqueued in async_list and delivered
- * to Async Helper thread by triggering install_new_event. When event is
- * triggered in Async Helper thread, the corresponding event's callback with
- * arguments `arg` is called. This callback typically sends a signal to the
- * thread which registered the event (saved in `event->caller`).
+ * using this function. These events are enqueued in async_list, timer_heap or
+ * pending_list and delivered to Async Helper thread by triggering
+ * install_new_event. When event is triggered in Async Helper thread, the
+ * corresponding event's callback with arguments `arg` is called. This callback
+ * typically sends a signal to the thread which registered the event (saved in
+ * `event->caller`).
  *
  * We distinguish between alarm/timer events and async IO events:
  *   - alarm/timer events set object = NULL and time = seconds
@@ -88,24 +204,31 @@ int64_t install_async_event(PAL_HANDLE object, uint64_t time,
     event->caller             = get_cur_tid();
     event->object             = object;
     event->expire_time        = time ? now + time : 0;
+    event->heap_idx           = TIMER_NOT_QUEUED;
+    event->timer              = NULL;
 
     lock(&async_helper_lock);
 
     if (callback != &cleanup_thread && !object) {
         /* This is alarm() or setitimer() emulation, treat both according to
-         * alarm() syscall semantics: cancel any pending alarm/timer. */
-        struct async_event* tmp;
-        struct async_event* n;
-        LISTP_FOR_EACH_ENTRY_SAFE(tmp, n, &async_list, list) {
-            if (tmp->expire_time) {
-                /* this is a pending alarm/timer, cancel it and save its expiration time */
-                if (max_prev_expire_time < tmp->expire_time)
-                    max_prev_expire_time = tmp->expire_time;
-
-                LISTP_DEL(tmp, &async_list, list);
-                free(tmp);
+         * alarm() syscall semantics: cancel any pending alarm/timer (but keep
+         * the timers of timerfds). */
+        size_t kept = 0;
+        for (size_t i = 0; i < timer_heap_cnt; i++) {
+            if (timer_heap[i]->timer) {
+                timer_heap[kept] = timer_heap[i];
+                timer_heap[kept]->heap_idx = kept;
+                kept++;
+                continue;
             }
+            /* this is a pending alarm/timer, cancel it and save its expiration time */
+            if (max_prev_expire_time < timer_heap[i]->expire_time)
+                max_prev_expire_time = timer_heap[i]->expire_time;
+            free(timer_heap[i]);
         }
+        timer_heap_cnt = kept;
+        for (size_t i = kept / 2; i-- > 0;)
+            timer_heap_sift_down(i);
 
         if (!time) {
             /* This is alarm(0), we cancelled all pending alarms/timers
@@ -116,11 +239,29 @@ int64_t install_async_event(PAL_HANDLE object, uint64_t time,
         }
     }
 
-    INIT_LIST_HEAD(event, list);
-    LISTP_ADD_TAIL(event, &async_list, list);
+    int ret = 0;
+    if (object) {
+        if (!DkWaitSetUpdate(async_wait_set, object, PAL_WAIT_READ))
+            ret = -PAL_ERRNO;
+    } else if (event->expire_time) {
+        ret = timer_heap_push(event);
+    }
+    if (ret < 0) {
+        free(event);
+        unlock(&async_helper_lock);
+        return ret;
+    }
+
+    if (object) {
+        INIT_LIST_HEAD(event, list);
+        LISTP_ADD_TAIL(event, &async_list, list);
+    } else if (!event->expire_time) {
+        INIT_LIST_HEAD(event, list);
+        LISTP_ADD_TAIL(event, &pending_list, list);
+    }
 
     if (async_helper_state == HELPER_NOTALIVE) {
-        int ret = create_async_helper();
+        ret = create_async_helper();
         if (ret < 0) {
             unlock(&async_helper_lock);
             return ret;
@@ -134,6 +275,110 @@ int64_t install_async_event(PAL_HANDLE object, uint64_t time,
     return max_prev_expire_time - now;
 }
 
+struct async_timer* create_async_timer(PAL_HANDLE notify) {
+    struct async_timer* timer = malloc(sizeof(*timer));
+    if (!timer)
+        return NULL;
+
+    memset(timer, 0, sizeof(*timer));
+    timer->event.heap_idx = TIMER_NOT_QUEUED;
+    timer->event.timer    = timer;
+    timer->notify.event   = notify;
+    return timer;
+}
+
+void destroy_async_timer(struct async_timer* timer) {
+    lock(&async_helper_lock);
+    if (timer->event.heap_idx != TIMER_NOT_QUEUED)
+        timer_heap_remove(timer->event.heap_idx);
+    unlock(&async_helper_lock);
+    free(timer);
+}
+
+/* Arm `timer` to expire at `expire_time` (absolute, as returned by DkSystemTimeQuery()) and then
+ * every `interval` usecs if it is non-zero, or disarm it if `expire_time` is zero. Expirations
+ * which were not read yet are discarded. The previous setting is returned in `old_expire_time` and
+ * `old_interval` if they are not NULL. */
+int set_async_timer(struct async_timer* timer, uint64_t expire_time, uint64_t interval,
+                    uint64_t* old_expire_time, uint64_t* old_interval) {
+    int ret = 0;
+
+    lock(&async_helper_lock);
+
+    if (old_expire_time)
+        *old_expire_time = timer->event.heap_idx != TIMER_NOT_QUEUED ? timer->event.expire_time : 0;
+    if (old_interval)
+        *old_interval = timer->interval;
+
+    if (timer->event.heap_idx != TIMER_NOT_QUEUED)
+        timer_heap_remove(timer->event.heap_idx);
+    if (timer->expirations) {
+        timer->expirations = 0;
+        clear_event(&timer->notify);
+    }
+
+    timer->event.expire_time = expire_time;
+    timer->interval          = expire_time ? interval : 0;
+    if (!expire_time)
+        goto out;
+
+    ret = timer_heap_push(&timer->event);
+    if (ret < 0)
+        goto out;
+
+    if (async_helper_state == HELPER_NOTALIVE) {
+        ret = create_async_helper();
+        if (ret < 0) {
+            timer_heap_remove(timer->event.heap_idx);
+            goto out;
+        }
+    }
+
+    /* wake up the helper only if its next deadline has changed */
+    if (timer->event.heap_idx == 0)
+        set_event(&install_new_event, 1);
+out:
+    unlock(&async_helper_lock);
+    return ret;
+}
+
+void get_async_timer(struct async_timer* timer, uint64_t* expire_time, uint64_t* interval) {
+    lock(&async_helper_lock);
+    *expire_time = timer->event.heap_idx != TIMER_NOT_QUEUED ? timer->event.expire_time : 0;
+    *interval    = timer->interval;
+    unlock(&async_helper_lock);
+}
+
+/* return the number of expirations of `timer` since the last call and reset it */
+uint64_t read_async_timer(struct async_timer* timer) {
+    lock(&async_helper_lock);
+    uint64_t expirations = timer->expirations;
+    if (expirations) {
+        timer->expirations = 0;
+        clear_event(&timer->notify);
+    }
+    unlock(&async_helper_lock);
+    return expirations;
+}
+
+/* this should be called with the async_helper_lock held */
+static void expire_async_timer(struct async_timer* timer, uint64_t now) {
+    assert(locked(&async_helper_lock));
+
+    uint64_t count = 1;
+    if (timer->interval) {
+        /* count the periods the helper has missed, then re-arm in place; this cannot fail since
+         * the event was just popped from the heap */
+        count += (now - timer->event.expire_time) / timer->interval;
+        timer->event.expire_time += count * timer->interval;
+        timer_heap_push(&timer->event);
+    }
+
+    if (!timer->expirations)
+        set_event(&timer->notify, 1);
+    timer->expirations += count;
+}
+
 int init_async(void) {
     /* early enough in init, can write global vars without the lock */
     async_helper_state = HELPER_NOTALIVE;
@@ -142,12 +387,24 @@ int init_async(void) {
     }
     create_event(&install_new_event);
 
+    async_wait_set = DkWaitSetCreate();
+    if (!async_wait_set)
+        return -PAL_ERRNO;
+    if (!DkWaitSetUpdate(async_wait_set, event_handle(&install_new_event), PAL_WAIT_READ))
+        return -PAL_ERRNO;
+
     /* enable locking mechanisms since we are going in multi-threaded mode */
     enable_locking();
 
     return 0;
 }
 
+struct async_callback {
+    void (*callback)(IDTYPE caller, void* arg);
+    IDTYPE caller;
+    void* arg;
+};
+
 static void shim_async_helper(void* arg) {
     struct shim_thread* self = (struct shim_thread*)arg;
     if (!arg)
@@ -171,6 +428,7 @@ static void shim_async_helper(void* arg) {
     /* Assume async helper thread will not drain the stack that PAL provides,
      * so for efficiency we don't swap the stack. */
     debug("Async helper thread started\n");
+    pin_helper_thread();
 
     /* Simple heuristic to not burn cycles when no async events are installed:
      * async helper thread sleeps IDLE_SLEEP_TIME for MAX_IDLE_CYCLES and
@@ -178,26 +436,10 @@ static void shim_async_helper(void* arg) {
      * to install a new event. */
     uint64_t idle_cycles = 0;
 
-    /* init `pals` so that it always contains at least install_new_event */
-    size_t pals_max_cnt = 32;
-    PAL_HANDLE* pals = malloc(sizeof(*pals) * (1 + pals_max_cnt));
-    if (!pals) {
-        debug("Allocation of pals failed\n");
-        goto out_err;
-    }
-
-    /* allocate one memory region to hold two PAL_FLG arrays: events and revents */
-    PAL_FLG* pal_events = malloc(sizeof(*pal_events) * (1 + pals_max_cnt) * 2);
-    if (!pal_events) {
-        debug("Allocation of pal_events failed\n");
-        goto out_err;
-    }
-    PAL_FLG* ret_events = pal_events + 1 + pals_max_cnt;
-
     PAL_HANDLE install_new_event_pal = event_handle(&install_new_event);
-    pals[0]       = install_new_event_pal;
-    pal_events[0] = PAL_WAIT_READ;
-    ret_events[0] = 0;
+    PAL_HANDLE pals[ASYNC_WAIT_BATCH];
+    PAL_FLG ret_events[ASYNC_WAIT_BATCH];
+    struct async_callback io_callbacks[ASYNC_WAIT_BATCH];
 
     while (true) {
         uint64_t now = DkSystemTimeQuery();
@@ -206,6 +448,9 @@ static void shim_async_helper(void* arg) {
             goto out_err;
         }
 
+        LISTP_TYPE(async_event) triggered;
+        INIT_LISTP(&triggered);
+
         lock(&async_helper_lock);
         if (async_helper_state != HELPER_ALIVE) {
             async_helper_thread = NULL;
@@ -213,64 +458,32 @@ static void shim_async_helper(void* arg) {
             break;
         }
 
-        uint64_t next_expire_time = 0;
-        size_t pals_cnt            = 0;
-
+        /* collect exit-child events and all expired alarm/timer events */
         struct async_event* tmp;
         struct async_event* n;
-        bool other_event = false;
-        LISTP_FOR_EACH_ENTRY_SAFE(tmp, n, &async_list, list) {
-            /* repopulate `pals` with IO events and find the next expiring alarm/timer */
-            if (tmp->object) {
-                if (pals_cnt == pals_max_cnt) {
-                    /* grow `pals` to accommodate more objects */
-                    PAL_HANDLE* tmp_pals = malloc(sizeof(*tmp_pals) * (1 + pals_max_cnt * 2));
-                    if (!tmp_pals) {
-                        debug("tmp_pals allocation failed\n");
-                        goto out_err_unlock;
-                    }
-                    PAL_FLG* tmp_pal_events = malloc(sizeof(*tmp_pal_events) * (2 + pals_max_cnt * 4));
-                    if (!tmp_pal_events) {
-                        debug("tmp_pal_events allocation failed\n");
-                        goto out_err_unlock;
-                    }
-                    PAL_FLG* tmp_ret_events = tmp_pal_events + 1 + pals_max_cnt * 2;
-
-                    memcpy(tmp_pals, pals, sizeof(*tmp_pals) * (1 + pals_max_cnt));
-                    memcpy(tmp_pal_events, pal_events, sizeof(*tmp_pal_events) * (1 + pals_max_cnt));
-                    memcpy(tmp_ret_events, ret_events, sizeof(*tmp_ret_events) * (1 + pals_max_cnt));
-
-                    pals_max_cnt *= 2;
-
-                    free(pals);
-                    free(pal_events);
-
-                    pals = tmp_pals;
-                    pal_events = tmp_pal_events;
-                    ret_events = tmp_ret_events;
-                }
+        LISTP_FOR_EACH_ENTRY_SAFE(tmp, n, &pending_list, list) {
+            debug("Thread exited, cleaning up\n");
+            LISTP_DEL(tmp, &pending_list, list);
+            LISTP_ADD_TAIL(tmp, &triggered, list);
+        }
 
-                pals[pals_cnt + 1]       = tmp->object;
-                pal_events[pals_cnt + 1] = PAL_WAIT_READ;
-                ret_events[pals_cnt + 1] = 0;
-                pals_cnt++;
-            } else if (tmp->expire_time && tmp->expire_time > now) {
-                if (!next_expire_time || next_expire_time > tmp->expire_time) {
-                    /* use time of the next expiring alarm/timer */
-                    next_expire_time = tmp->expire_time;
-                }
-            } else {
-                /* cleanup events do not have an object nor a timeout */
-                other_event = true;
+        while (timer_heap_cnt && timer_heap[0]->expire_time <= now) {
+            tmp = timer_heap_pop();
+            if (tmp->timer) {
+                expire_async_timer(tmp->timer, now);
+                continue;
             }
+            debug("Alarm/timer triggered at %lu (expired at %lu)\n", now, tmp->expire_time);
+            INIT_LIST_HEAD(tmp, list);
+            LISTP_ADD_TAIL(tmp, &triggered, list);
         }
 
         uint64_t sleep_time;
-        if (next_expire_time) {
-            sleep_time  = next_expire_time - now;
+        if (timer_heap_cnt) {
+            sleep_time  = timer_heap[0]->expire_time - now;
             idle_cycles = 0;
-        } else if (pals_cnt || other_event) {
-            sleep_time = NO_TIMEOUT;
+        } else if (!LISTP_EMPTY(&async_list) || !LISTP_EMPTY(&triggered)) {
+            sleep_time  = NO_TIMEOUT;
             idle_cycles = 0;
         } else {
             /* no async IO events and no timers/alarms: thread is idling */
@@ -287,81 +500,57 @@ static void shim_async_helper(void* arg) {
         }
         unlock(&async_helper_lock);
 
-        /* wait on async IO events + install_new_event + next expiring alarm/timer */
-        PAL_BOL polled = DkStreamsWaitEvents(pals_cnt + 1, pals, pal_events, ret_events, sleep_time);
-
-        now = DkSystemTimeQuery();
-        if ((int64_t)now < 0) {
-            debug("DkSystemTimeQuery failed with: %ld\n", (int64_t)now);
-            goto out_err;
+        if (!LISTP_EMPTY(&triggered)) {
+            /* call callbacks for all triggered one-off events; they may install new events, so
+             * recompute the next deadline before waiting */
+            LISTP_FOR_EACH_ENTRY_SAFE(tmp, n, &triggered, list) {
+                LISTP_DEL(tmp, &triggered, list);
+                tmp->callback(tmp->caller, tmp->arg);
+                free(tmp);
+            }
+            continue;
         }
 
-        LISTP_TYPE(async_event) triggered;
-        INIT_LISTP(&triggered);
+        /* wait on async IO events + install_new_event + next expiring alarm/timer; the objects
+         * stay registered in the wait set, so this does not depend on their number */
+        PAL_NUM polled = DkWaitSetWait(async_wait_set, ASYNC_WAIT_BATCH, pals, ret_events,
+                                       sleep_time);
 
-        /* acquire lock because we read/modify async_list below */
+        size_t io_cnt = 0;
         lock(&async_helper_lock);
-
-        for (size_t i = 0; polled && i < pals_cnt + 1; i++) {
-            if (ret_events[i]) {
-                if (pals[i] == install_new_event_pal) {
-                    /* some thread wants to install new event; this event is found in async_list,
-                     * so just re-init install_new_event */
-                    clear_event(&install_new_event);
-                    continue;
-                }
-
-                /* check if this event is an IO event found in async_list */
-                LISTP_FOR_EACH_ENTRY_SAFE(tmp, n, &async_list, list) {
-                    if (tmp->object == pals[i]) {
-                        debug("Async IO event triggered at %lu\n", now);
-                        LISTP_ADD_TAIL(tmp, &triggered, list);
-                        break;
-                    }
-                }
+        for (PAL_NUM i = 0; i < polled; i++) {
+            if (pals[i] == install_new_event_pal) {
+                /* some thread wants to install new event; this event is already in async_list
+                 * or timer_heap, so just re-init install_new_event */
+                clear_event(&install_new_event);
+                continue;
             }
-        }
 
-        /* check if exit-child or alarm/timer events were triggered */
-        LISTP_FOR_EACH_ENTRY_SAFE(tmp, n, &async_list, list) {
-            if (tmp->callback == &cleanup_thread) {
-                debug("Thread exited, cleaning up\n");
-                LISTP_DEL(tmp, &async_list, list);
-                LISTP_ADD_TAIL(tmp, &triggered, list);
-            } else if (tmp->expire_time && tmp->expire_time <= now) {
-                debug("Alarm/timer triggered at %lu (expired at %lu)\n", now, tmp->expire_time);
-                LISTP_DEL(tmp, &async_list, list);
-                LISTP_ADD_TAIL(tmp, &triggered, list);
+            /* check if this event is an IO event found in async_list */
+            LISTP_FOR_EACH_ENTRY(tmp, &async_list, list) {
+                if (tmp->object == pals[i] && io_cnt < ASYNC_WAIT_BATCH) {
+                    debug("Async IO event triggered\n");
+                    io_callbacks[io_cnt].callback = tmp->callback;
+                    io_callbacks[io_cnt].caller   = tmp->caller;
+                    io_callbacks[io_cnt].arg      = tmp->arg;
+                    io_cnt++;
+                }
             }
         }
-
         unlock(&async_helper_lock);
 
-        /* call callbacks for all triggered events */
-        if (!LISTP_EMPTY(&triggered)) {
-            LISTP_FOR_EACH_ENTRY_SAFE(tmp, n, &triggered, list) {
-                LISTP_DEL(tmp, &triggered, list);
-                tmp->callback(tmp->caller, tmp->arg);
-                if (!tmp->object) {
-                    /* this is a one-off exit-child or alarm/timer event */
-                    free(tmp);
-                }
-            }
-        }
+        /* async IO events stay installed, only their callbacks are called */
+        for (size_t i = 0; i < io_cnt; i++)
+            io_callbacks[i].callback(io_callbacks[i].caller, io_callbacks[i].arg);
     }
 
     __disable_preempt(self->shim_tcb);
     put_thread(self);
     debug("Async helper thread terminated\n");
 
-    free(pals);
-    free(pal_events);
-
     DkThreadExit(/*clear_child_tid=*/NULL);
     return;
 
-out_err_unlock:
-    unlock(&async_helper_lock);
 out_err:
     debug("Terminating the process due to a fatal error in async helper\n");
     put_thread(self);
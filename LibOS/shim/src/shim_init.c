@@ -109,6 +109,7 @@ static int pal_errno_to_unix_errno [PAL_ERROR_NATIVE_COUNT + 1] = {
         /* PAL_ERROR_CONNFAILED     */  ECONNRESET,
         /* PAL_ERROR_ADDRNOTEXIST   */  EADDRNOTAVAIL,
         /* PAL_ERROR_AFNOSUPPORT    */  EAFNOSUPPORT,
+        /* PAL_ERROR_NOSPACE        */  ENOSPC,
     };
 
 long convert_pal_errno (long err)
@@ -498,17 +499,21 @@ static int init_newproc (struct newproc_header * hdr)
 
 #define RUN_INIT(func, ...)                                             \
     do {                                                                \
+        uint64_t _start = startup_trace_time();                         \
         int _err = CALL_INIT(func, ##__VA_ARGS__);                      \
         if (_err < 0) {                                                 \
             SYS_PRINTF("shim_init() in " #func " (%d)\n", _err);        \
             shim_clean_and_exit(_err);                                  \
         }                                                               \
+        startup_trace_event("libos: " #func, NULL, _start,             \
+                            startup_trace_time());                      \
     } while (0)
 
 extern PAL_HANDLE thread_start_event;
 
 noreturn void* shim_init(int argc, void* args)
 {
+    uint64_t libos_start = DkSystemTimeQuery();
     debug_handle = PAL_CB(debug_stream);
     cur_process.vmid = (IDTYPE) PAL_CB(process_id);
 
@@ -572,6 +577,9 @@ noreturn void* shim_init(int argc, void* args)
     if (PAL_CB(manifest_handle))
         RUN_INIT(init_manifest, PAL_CB(manifest_handle));
 
+    RUN_INIT(init_startup_trace, libos_start);
+    RUN_INIT(init_syscall_stats);
+
     RUN_INIT(init_mount_root);
     RUN_INIT(init_ipc);
     RUN_INIT(init_thread);
@@ -902,6 +910,8 @@ noreturn void shim_clean_and_exit(int exit_code) {
     }
 
     cur_process.exit_code = exit_code;
+    dump_startup_trace();
+    dump_syscall_stats();
     store_all_msg_persist();
     del_all_ipc_ports();
 
@@ -909,6 +919,9 @@ noreturn void shim_clean_and_exit(int exit_code) {
         DkObjectClose(shim_stdio);
 
     shim_stdio = NULL;
+    if (syscalls_patched || syscalls_trapped)
+        debug("syscall instructions: %lu rewritten, %lu emulated on trap\n", syscalls_patched,
+              syscalls_trapped);
     debug("process %u exited with status %d\n", cur_process.vmid & 0xFFFF, cur_process.exit_code);
     MASTER_LOCK();
 
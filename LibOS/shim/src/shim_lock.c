@@ -0,0 +1,78 @@
+/* Copyright (C) 2014 Stony Brook University
+   This file is part of Graphene Library OS.
+
+   Graphene Library OS is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   Graphene Library OS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/*
+ * shim_lock.c
+ *
+ * Contended paths of the LibOS locks (see lock() and unlock() in shim_internal.h). Only these
+ * paths call into the PAL.
+ */
+
+#include <atomic.h>
+#include <pal.h>
+#include <shim_internal.h>
+
+#define LOCK_SPIN_TIMES 100
+
+/* Returns the PAL mutex to sleep on, creating it if this is the first contention of `l`. Returns
+ * NULL if it cannot be created; the waiters then fall back to yielding. */
+static PAL_HANDLE get_lock_sleep(struct shim_lock* l) {
+    PAL_HANDLE sleep = __atomic_load_n(&l->sleep, __ATOMIC_ACQUIRE);
+    if (sleep)
+        return sleep;
+
+    /* created locked: the first waiter blocks until an unlock() releases it */
+    PAL_HANDLE new_sleep = DkMutexCreate(1);
+    if (!new_sleep)
+        return NULL;
+
+    if (!__atomic_compare_exchange_n(&l->sleep, &sleep, new_sleep, /*weak=*/false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        /* another waiter was faster */
+        DkObjectClose(new_sleep);
+        return sleep;
+    }
+    return new_sleep;
+}
+
+void __lock_slow(struct shim_lock* l) {
+    for (int i = 0; i < LOCK_SPIN_TIMES; i++) {
+        CPU_RELAX();
+        int state = SHIM_LOCK_UNLOCKED;
+        if (__atomic_load_n(&l->state, __ATOMIC_RELAXED) == SHIM_LOCK_UNLOCKED &&
+                __atomic_compare_exchange_n(&l->state, &state, SHIM_LOCK_LOCKED, /*weak=*/false,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            return;
+    }
+
+    /* the sleep handle must exist before the lock is marked as contended, so that the unlocking
+     * thread always finds it */
+    PAL_HANDLE sleep = get_lock_sleep(l);
+
+    while (__atomic_exchange_n(&l->state, SHIM_LOCK_CONTENDED, __ATOMIC_ACQUIRE)
+            != SHIM_LOCK_UNLOCKED) {
+        if (sleep)
+            DkSynchronizationObjectWait(sleep, NO_TIMEOUT);
+        else
+            DkThreadYieldExecution();
+    }
+}
+
+void __unlock_wake(struct shim_lock* l) {
+    PAL_HANDLE sleep = __atomic_load_n(&l->sleep, __ATOMIC_ACQUIRE);
+    if (sleep)
+        DkMutexRelease(sleep);
+}
@@ -384,6 +384,10 @@ struct parser_table {
         {.slow = 0, .parser = {NULL}}, /* perf_event_open */
         {.slow = 0, .parser = {NULL}}, /* recvmmsg */
 
+        [__NR_copy_file_range] = {.slow = 0, .parser = {NULL}}, /* copy_file_range */
+        [__NR_preadv2]         = {.slow = 0, .parser = {NULL}}, /* preadv2 */
+        [__NR_pwritev2]        = {.slow = 0, .parser = {NULL}}, /* pwritev2 */
+
         [LIBOS_SYSCALL_BASE] = {.slow = 0, .parser = {NULL}},
 
         {.slow = 1, .parser = {NULL}}, /* checkpoint */
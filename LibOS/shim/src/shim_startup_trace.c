@@ -0,0 +1,198 @@
+/* Copyright (C) 2014 Stony Brook University
+   This file is part of Graphene Library OS.
+
+   Graphene Library OS is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   Graphene Library OS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/*
+ * shim_startup_trace.c
+ *
+ * Startup tracing. If "loader.startup_trace" is set in the manifest, the phases of the PAL
+ * startup (PAL_CONTROL::startup_events, including the enclave build on SGX) and of the LibOS
+ * startup (initialization steps, loading and relocation of each ELF object, libraries
+ * registered by ld.so, first user instruction) are written to the given file when the process
+ * exits. The file is a Chrome trace (for chrome://tracing or Perfetto), or CSV if its name ends
+ * with ".csv". Child processes append their vmid to the file name.
+ */
+
+#include <pal.h>
+#include <shim_internal.h>
+#include <shim_ipc.h>
+#include <shim_utils.h>
+
+#define STARTUP_TRACE_MAX_EVENTS 256UL
+#define STARTUP_TRACE_NAME_MAX   96
+
+struct startup_trace_event {
+    char name[STARTUP_TRACE_NAME_MAX];
+    uint64_t start;
+    uint64_t end; /* equal to `start` for instant events */
+};
+
+bool startup_trace_enabled = false;
+
+static char startup_trace_uri[CONFIG_MAX];
+static bool startup_trace_csv;
+static struct startup_trace_event* startup_trace_events;
+static size_t startup_trace_num = 0;
+
+/* `start` is 0 if it was taken by startup_trace_time() before tracing was enabled */
+void startup_trace_event(const char* name, const char* arg, uint64_t start, uint64_t end) {
+    if (!startup_trace_enabled || !start)
+        return;
+
+    size_t i = __atomic_fetch_add(&startup_trace_num, 1, __ATOMIC_RELAXED);
+    if (i >= STARTUP_TRACE_MAX_EVENTS)
+        return;
+
+    struct startup_trace_event* event = &startup_trace_events[i];
+    if (arg)
+        snprintf(event->name, sizeof(event->name), "%s %s", name, arg);
+    else
+        snprintf(event->name, sizeof(event->name), "%s", name);
+    event->start = start;
+    event->end   = end;
+}
+
+int init_startup_trace(uint64_t libos_start) {
+    if (!root_config)
+        return 0;
+
+    char uri[CONFIG_MAX];
+    ssize_t len = get_config(root_config, "loader.startup_trace", uri, sizeof(uri));
+    if (len <= 0)
+        return 0;
+
+    if (!strstartswith_static(uri, URI_PREFIX_FILE)) {
+        SYS_PRINTF("loader.startup_trace must be a file: URI (%s)\n", uri);
+        return -EINVAL;
+    }
+
+    if (PAL_CB(parent_process))
+        snprintf(startup_trace_uri, sizeof(startup_trace_uri), "%s.%u", uri, cur_process.vmid);
+    else
+        memcpy(startup_trace_uri, uri, len + 1);
+    startup_trace_csv = strendswith(uri, ".csv");
+
+    startup_trace_events = malloc(sizeof(*startup_trace_events) * STARTUP_TRACE_MAX_EVENTS);
+    if (!startup_trace_events)
+        return -ENOMEM;
+
+    startup_trace_enabled = true;
+    startup_trace_event("libos: initialize up to manifest", NULL, libos_start,
+                        DkSystemTimeQuery());
+    return 0;
+}
+
+static int write_all(PAL_HANDLE handle, uint64_t* offset, const char* buf, size_t size) {
+    while (size) {
+        PAL_NUM bytes = DkStreamWrite(handle, *offset, size, (void*)buf, NULL);
+        if (bytes == PAL_STREAM_ERROR)
+            return -PAL_ERRNO;
+        buf     += bytes;
+        size    -= bytes;
+        *offset += bytes;
+    }
+    return 0;
+}
+
+/* Event names are either static strings or file names; keep them valid inside JSON strings and
+ * CSV fields. */
+static void sanitize_name(char* name) {
+    for (char* c = name; *c; c++)
+        if (*c == '"' || *c == '\\' || *c == ',' || (unsigned char)*c < ' ')
+            *c = '_';
+}
+
+static int write_event(PAL_HANDLE handle, uint64_t* offset, const char* name, uint64_t start,
+                       uint64_t end, uint64_t base, bool first) {
+    char line[STARTUP_TRACE_NAME_MAX + 128];
+    char clean_name[STARTUP_TRACE_NAME_MAX];
+    int len;
+
+    snprintf(clean_name, sizeof(clean_name), "%s", name);
+    sanitize_name(clean_name);
+
+    /* timestamps of the untrusted host may be off, never print negative values */
+    start = start > base ? start - base : 0;
+    end   = end > base ? end - base : 0;
+    if (end < start)
+        end = start;
+
+    if (startup_trace_csv) {
+        len = snprintf(line, sizeof(line), "%s,%lu,%lu\n", clean_name, start, end - start);
+    } else if (end == start) {
+        len = snprintf(line, sizeof(line),
+                       "%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"p\",\"ts\":%lu,\"pid\":%u,"
+                       "\"tid\":1}",
+                       first ? "\n" : ",\n", clean_name, start, cur_process.vmid);
+    } else {
+        len = snprintf(line, sizeof(line),
+                       "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%lu,\"dur\":%lu,\"pid\":%u,"
+                       "\"tid\":1}",
+                       first ? "\n" : ",\n", clean_name, start, end - start, cur_process.vmid);
+    }
+
+    return write_all(handle, offset, line, MIN((size_t)len, sizeof(line) - 1));
+}
+
+void dump_startup_trace(void) {
+    if (!startup_trace_enabled)
+        return;
+    startup_trace_enabled = false;
+
+    PAL_HANDLE handle = DkStreamOpen(startup_trace_uri, PAL_ACCESS_RDWR,
+                                     PAL_SHARE_OWNER_R | PAL_SHARE_OWNER_W, PAL_CREATE_TRY, 0);
+    if (!handle) {
+        debug("Cannot open startup trace %s: %ld\n", startup_trace_uri, PAL_ERRNO);
+        return;
+    }
+
+    PAL_STARTUP_EVENT* pal_events = PAL_CB(startup_events);
+    size_t pal_num = PAL_CB(startup_events_num);
+    size_t libos_num = MIN(startup_trace_num, STARTUP_TRACE_MAX_EVENTS);
+
+    /* all timestamps are relative to the earliest recorded one */
+    uint64_t base = (uint64_t)-1;
+    for (size_t i = 0; i < pal_num; i++)
+        if (pal_events[i].start && pal_events[i].start < base)
+            base = pal_events[i].start;
+    for (size_t i = 0; i < libos_num; i++)
+        if (startup_trace_events[i].start < base)
+            base = startup_trace_events[i].start;
+
+    uint64_t offset = 0;
+    int ret = write_all(handle, &offset,
+                        startup_trace_csv ? "phase,start_us,duration_us\n" : "{\"traceEvents\":[",
+                        startup_trace_csv ? static_strlen("phase,start_us,duration_us\n")
+                                          : static_strlen("{\"traceEvents\":["));
+    bool first = true;
+
+    for (size_t i = 0; !ret && i < pal_num; i++, first = false)
+        ret = write_event(handle, &offset, pal_events[i].name, pal_events[i].start,
+                          pal_events[i].end, base, first);
+
+    for (size_t i = 0; !ret && i < libos_num; i++, first = false)
+        ret = write_event(handle, &offset, startup_trace_events[i].name,
+                          startup_trace_events[i].start, startup_trace_events[i].end, base, first);
+
+    if (!ret && !startup_trace_csv)
+        ret = write_all(handle, &offset, "\n]}\n", static_strlen("\n]}\n"));
+
+    if (!ret)
+        DkStreamSetLength(handle, offset);
+    else
+        debug("Cannot write startup trace %s: %d\n", startup_trace_uri, ret);
+
+    DkObjectClose(handle);
+}
@@ -0,0 +1,197 @@
+/* Copyright (C) 2014 Stony Brook University
+   This file is part of Graphene Library OS.
+
+   Graphene Library OS is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   Graphene Library OS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/*
+ * shim_syscall_stats.c
+ *
+ * Per-syscall statistics. If "sys.syscall_stats" is set in the manifest, every system call that
+ * goes through BEGIN_SHIM/END_SHIM records its latency, and the calls to the host (OCALLs) and
+ * enclave exits made by the PAL on its behalf. The statistics can be read from
+ * /proc/syscall_stats at any time and are written to the given file when the process exits.
+ * Child processes append their vmid to the file name.
+ */
+
+#include <pal.h>
+#include <shim_internal.h>
+#include <shim_ipc.h>
+#include <shim_unistd_defs.h>
+#include <shim_utils.h>
+
+/* bucket 0 counts calls that took less than 1 us, bucket i > 0 those that took [2^(i-1), 2^i) us;
+ * the last bucket also counts all slower calls */
+#define SYSCALL_STATS_BUCKETS 24
+
+#define SYSCALL_STATS_LINE_MAX (32 + 21 * (5 + SYSCALL_STATS_BUCKETS))
+
+struct syscall_stats {
+    const char* name;
+    uint64_t calls;
+    uint64_t total_us;
+    uint64_t max_us;
+    uint64_t host_calls;
+    uint64_t host_exits;
+    uint64_t hist[SYSCALL_STATS_BUCKETS];
+};
+
+bool syscall_stats_enabled = false;
+
+static char syscall_stats_uri[CONFIG_MAX];
+static struct syscall_stats* syscall_stats;
+
+int init_syscall_stats(void) {
+    if (!root_config)
+        return 0;
+
+    char uri[CONFIG_MAX];
+    ssize_t len = get_config(root_config, "sys.syscall_stats", uri, sizeof(uri));
+    if (len <= 0)
+        return 0;
+
+    if (!strstartswith_static(uri, URI_PREFIX_FILE)) {
+        SYS_PRINTF("sys.syscall_stats must be a file: URI (%s)\n", uri);
+        return -EINVAL;
+    }
+
+    if (PAL_CB(parent_process))
+        snprintf(syscall_stats_uri, sizeof(syscall_stats_uri), "%s.%u", uri, cur_process.vmid);
+    else
+        memcpy(syscall_stats_uri, uri, len + 1);
+
+    syscall_stats = calloc(LIBOS_SYSCALL_BOUND, sizeof(*syscall_stats));
+    if (!syscall_stats)
+        return -ENOMEM;
+
+    syscall_stats_enabled = true;
+    return 0;
+}
+
+/* The host counters are read after taking the start time and before taking the end time, so that
+ * the OCALLs of DkSystemTimeQuery() on SGX are not attributed to the system call. */
+void syscall_stats_begin(struct syscall_stats_start* start) {
+    start->time = DkSystemTimeQuery();
+    PAL_TCB* tcb = pal_get_tcb();
+    start->host_calls = tcb->host_calls;
+    start->host_exits = tcb->host_exits;
+}
+
+void syscall_stats_end(int sysno, const char* name, struct syscall_stats_start* start) {
+    PAL_TCB* tcb = pal_get_tcb();
+    uint64_t host_calls = tcb->host_calls - start->host_calls;
+    uint64_t host_exits = tcb->host_exits - start->host_exits;
+    uint64_t end = DkSystemTimeQuery();
+
+    if (sysno < 0 || sysno >= LIBOS_SYSCALL_BOUND)
+        return;
+
+    uint64_t us = end > start->time ? end - start->time : 0;
+    size_t bucket = us ? 64 - __builtin_clzl(us) : 0;
+    if (bucket >= SYSCALL_STATS_BUCKETS)
+        bucket = SYSCALL_STATS_BUCKETS - 1;
+
+    struct syscall_stats* stats = &syscall_stats[sysno];
+    __atomic_store_n(&stats->name, name, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->calls, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->total_us, us, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->host_calls, host_calls, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->host_exits, host_exits, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->hist[bucket], 1, __ATOMIC_RELAXED);
+
+    uint64_t max = __atomic_load_n(&stats->max_us, __ATOMIC_RELAXED);
+    while (us > max && !__atomic_compare_exchange_n(&stats->max_us, &max, us, /*weak=*/true,
+                                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+static const char syscall_stats_header[] =
+    "# syscall calls total_us max_us host_calls host_exits "
+    "latency_histogram(<1us <2us <4us ...)\n";
+
+int format_syscall_stats(char** strp, size_t* lenp) {
+    size_t nsyscalls = 0;
+    for (int i = 0; syscall_stats_enabled && i < LIBOS_SYSCALL_BOUND; i++)
+        if (__atomic_load_n(&syscall_stats[i].calls, __ATOMIC_RELAXED))
+            nsyscalls++;
+
+    size_t size = sizeof(syscall_stats_header) + nsyscalls * SYSCALL_STATS_LINE_MAX;
+    char* str = malloc(size);
+    if (!str)
+        return -ENOMEM;
+
+    memcpy(str, syscall_stats_header, sizeof(syscall_stats_header));
+    size_t len = sizeof(syscall_stats_header) - 1;
+
+    /* syscalls may be counted concurrently, never print more than the lines allocated above */
+    for (int i = 0; nsyscalls && i < LIBOS_SYSCALL_BOUND; i++) {
+        struct syscall_stats* stats = &syscall_stats[i];
+        if (!__atomic_load_n(&stats->calls, __ATOMIC_RELAXED))
+            continue;
+
+        size_t line_end = len + SYSCALL_STATS_LINE_MAX;
+        len += snprintf(str + len, line_end - len, "%s %lu %lu %lu %lu %lu",
+                        stats->name, stats->calls, stats->total_us, stats->max_us,
+                        stats->host_calls, stats->host_exits);
+
+        size_t nbuckets = SYSCALL_STATS_BUCKETS;
+        while (nbuckets > 1 && !stats->hist[nbuckets - 1])
+            nbuckets--;
+        for (size_t j = 0; j < nbuckets && len < line_end - 1; j++)
+            len += snprintf(str + len, line_end - len, " %lu", stats->hist[j]);
+
+        len = MIN(len, line_end - 2);
+        str[len++] = '\n';
+        str[len] = '\0';
+        nsyscalls--;
+    }
+
+    *strp = str;
+    *lenp = len;
+    return 0;
+}
+
+void dump_syscall_stats(void) {
+    if (!syscall_stats_enabled)
+        return;
+
+    char* str;
+    size_t len;
+    int ret = format_syscall_stats(&str, &len);
+    if (ret < 0)
+        return;
+    syscall_stats_enabled = false;
+
+    PAL_HANDLE handle = DkStreamOpen(syscall_stats_uri, PAL_ACCESS_RDWR,
+                                     PAL_SHARE_OWNER_R | PAL_SHARE_OWNER_W, PAL_CREATE_TRY, 0);
+    if (!handle) {
+        debug("Cannot open syscall statistics %s: %ld\n", syscall_stats_uri, PAL_ERRNO);
+        free(str);
+        return;
+    }
+
+    uint64_t offset = 0;
+    while (offset < len) {
+        PAL_NUM bytes = DkStreamWrite(handle, offset, len - offset, str + offset, NULL);
+        if (bytes == PAL_STREAM_ERROR) {
+            debug("Cannot write syscall statistics %s: %ld\n", syscall_stats_uri, PAL_ERRNO);
+            break;
+        }
+        offset += bytes;
+    }
+    if (offset == len)
+        DkStreamSetLength(handle, len);
+
+    DkObjectClose(handle);
+    free(str);
+}
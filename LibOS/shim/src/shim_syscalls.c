@@ -203,8 +203,9 @@ DEFINE_SHIM_SYSCALL(select, 5, shim_do_select, int, int, nfds, fd_set*, readfds,
 /* sched_yield: sys/shim_sched.c */
 DEFINE_SHIM_SYSCALL(sched_yield, 0, shim_do_sched_yield, int)
 
-SHIM_SYSCALL_PASSTHROUGH(mremap, 5, void*, void*, addr, size_t, old_len, size_t, new_len, int,
-                         flags, void*, new_addr)
+/* mremap: sys/shim_mmap.c */
+DEFINE_SHIM_SYSCALL(mremap, 5, shim_do_mremap, void*, void*, addr, size_t, old_len, size_t, new_len,
+                    int, flags, void*, new_addr)
 
 SHIM_SYSCALL_PASSTHROUGH(msync, 3, int, void*, start, size_t, len, int, flags)
 
@@ -212,13 +213,17 @@ SHIM_SYSCALL_PASSTHROUGH(msync, 3, int, void*, start, size_t, len, int, flags)
 DEFINE_SHIM_SYSCALL(mincore, 3, shim_do_mincore, int, void*, start, size_t, len, unsigned char*,
                     vec)
 
-SHIM_SYSCALL_PASSTHROUGH(madvise, 3, int, void*, start, size_t, len, int, behavior)
+/* madvise: sys/shim_mmap.c */
+DEFINE_SHIM_SYSCALL(madvise, 3, shim_do_madvise, int, void*, start, size_t, len, int, behavior)
 
-SHIM_SYSCALL_PASSTHROUGH(shmget, 3, int, key_t, key, size_t, size, int, shmflg)
+/* shmget: sys/shim_shmget.c */
+DEFINE_SHIM_SYSCALL(shmget, 3, shim_do_shmget, int, key_t, key, size_t, size, int, shmflg)
 
-SHIM_SYSCALL_PASSTHROUGH(shmat, 3, void*, int, shmid, const void*, shmaddr, int, shmflg)
+/* shmat: sys/shim_shmget.c */
+DEFINE_SHIM_SYSCALL(shmat, 3, shim_do_shmat, void*, int, shmid, const void*, shmaddr, int, shmflg)
 
-SHIM_SYSCALL_PASSTHROUGH(shmctl, 3, int, int, shmid, int, cmd, struct shmid_ds*, buf)
+/* shmctl: sys/shim_shmget.c */
+DEFINE_SHIM_SYSCALL(shmctl, 3, shim_do_shmctl, int, int, shmid, int, cmd, struct shmid_ds*, buf)
 
 /* dup: sys/shim_dup.c */
 DEFINE_SHIM_SYSCALL(dup, 1, shim_do_dup, int, unsigned int, fd)
@@ -344,7 +349,8 @@ DEFINE_SHIM_SYSCALL(semop, 3, shim_do_semop, int, int, semid, struct sembuf*, so
 DEFINE_SHIM_SYSCALL(semctl, 4, shim_do_semctl, int, int, semid, int, semnum, int, cmd,
                     unsigned long, arg)
 
-SHIM_SYSCALL_PASSTHROUGH(shmdt, 1, int, const void*, shmaddr)
+/* shmdt: sys/shim_shmget.c */
+DEFINE_SHIM_SYSCALL(shmdt, 1, shim_do_shmdt, int, const void*, shmaddr)
 
 /* msgget: sys/shim_msgget.c */
 DEFINE_SHIM_SYSCALL(msgget, 2, shim_do_msgget, int, key_t, key, int, msgflg)
@@ -676,7 +682,8 @@ SHIM_SYSCALL_PASSTHROUGH (nfsservctl, 3, int, int, cmd, struct nfsctl_arg *,
 /* gettid: sys/shim_getpid.c */
 DEFINE_SHIM_SYSCALL(gettid, 0, shim_do_gettid, pid_t)
 
-SHIM_SYSCALL_PASSTHROUGH(readahead, 3, int, int, fd, loff_t, offset, size_t, count)
+/* readahead: sys/shim_open.c */
+DEFINE_SHIM_SYSCALL(readahead, 3, shim_do_readahead, int, int, fd, loff_t, offset, size_t, count)
 
 SHIM_SYSCALL_PASSTHROUGH(setxattr, 5, int, const char*, path, const char*, name, const void*, value,
                          size_t, size, int, flags)
@@ -725,17 +732,23 @@ SHIM_SYSCALL_PASSTHROUGH(set_thread_area, 1, int, struct user_desc*, u_info)
 
 /* no glibc wrapper */
 
-SHIM_SYSCALL_PASSTHROUGH(io_setup, 2, int, unsigned, nr_reqs, aio_context_t*, ctx)
+/* io_setup: sys/shim_aio.c */
+DEFINE_SHIM_SYSCALL(io_setup, 2, shim_do_io_setup, int, unsigned, nr_reqs, aio_context_t*, ctx)
 
-SHIM_SYSCALL_PASSTHROUGH(io_destroy, 1, int, aio_context_t, ctx)
+/* io_destroy: sys/shim_aio.c */
+DEFINE_SHIM_SYSCALL(io_destroy, 1, shim_do_io_destroy, int, aio_context_t, ctx)
 
-SHIM_SYSCALL_PASSTHROUGH(io_getevents, 5, int, aio_context_t, ctx_id, long, min_nr, long, nr,
-                         struct io_event*, events, struct timespec*, timeout)
+/* io_getevents: sys/shim_aio.c */
+DEFINE_SHIM_SYSCALL(io_getevents, 5, shim_do_io_getevents, int, aio_context_t, ctx_id, long, min_nr,
+                    long, nr, struct io_event*, events, struct timespec*, timeout)
 
-SHIM_SYSCALL_PASSTHROUGH(io_submit, 3, int, aio_context_t, ctx_id, long, nr, struct iocb**, iocbpp)
+/* io_submit: sys/shim_aio.c */
+DEFINE_SHIM_SYSCALL(io_submit, 3, shim_do_io_submit, int, aio_context_t, ctx_id, long, nr,
+                    struct iocb**, iocbpp)
 
-SHIM_SYSCALL_PASSTHROUGH(io_cancel, 3, int, aio_context_t, ctx_id, struct iocb*, iocb,
-                         struct io_event*, result)
+/* io_cancel: sys/shim_aio.c */
+DEFINE_SHIM_SYSCALL(io_cancel, 3, shim_do_io_cancel, int, aio_context_t, ctx_id, struct iocb*, iocb,
+                    struct io_event*, result)
 
 SHIM_SYSCALL_PASSTHROUGH(get_thread_area, 1, int, struct user_desc*, u_info)
 
@@ -767,7 +780,9 @@ SHIM_SYSCALL_PASSTHROUGH(restart_syscall, 0, int)
 DEFINE_SHIM_SYSCALL(semtimedop, 4, shim_do_semtimedop, int, int, semid, struct sembuf*, sops,
                     unsigned int, nsops, const struct timespec*, timeout)
 
-SHIM_SYSCALL_PASSTHROUGH(fadvise64, 4, int, int, fd, loff_t, offset, size_t, len, int, advice)
+/* fadvise64: sys/shim_open.c */
+DEFINE_SHIM_SYSCALL(fadvise64, 4, shim_do_fadvise64, int, int, fd, loff_t, offset, size_t, len, int,
+                    advice)
 
 SHIM_SYSCALL_PASSTHROUGH(timer_create, 3, int, clockid_t, which_clock, struct sigevent*,
                          timer_event_spec, timer_t*, created_timer_id)
@@ -939,13 +954,15 @@ DEFINE_SHIM_SYSCALL(set_robust_list, 2, shim_do_set_robust_list, int, struct rob
 DEFINE_SHIM_SYSCALL(get_robust_list, 3, shim_do_get_robust_list, int, pid_t, pid,
                     struct robust_list_head**, head, size_t*, len)
 
-SHIM_SYSCALL_PASSTHROUGH(splice, 6, int, int, fd_in, loff_t*, off_in, int, fd_out, loff_t*, off_out,
-                         size_t, len, int, flags)
+/* splice: sys/shim_fs.c */
+DEFINE_SHIM_SYSCALL(splice, 6, shim_do_splice, ssize_t, int, fd_in, loff_t*, off_in, int, fd_out,
+                    loff_t*, off_out, size_t, len, unsigned int, flags)
 
 SHIM_SYSCALL_PASSTHROUGH(tee, 4, int, int, fdin, int, fdout, size_t, len, unsigned int, flags)
 
-SHIM_SYSCALL_PASSTHROUGH(sync_file_range, 4, int, int, fd, loff_t, offset, loff_t, nbytes, int,
-                         flags)
+/* sync_file_range: sys/shim_open.c */
+DEFINE_SHIM_SYSCALL(sync_file_range, 4, shim_do_sync_file_range, int, int, fd, loff_t, offset,
+                    loff_t, nbytes, int, flags)
 
 SHIM_SYSCALL_PASSTHROUGH(vmsplice, 4, int, int, fd, const struct iovec*, iov, unsigned long,
                          nr_segs, int, flags)
@@ -960,23 +977,32 @@ DEFINE_SHIM_SYSCALL(epoll_pwait, 6, shim_do_epoll_pwait, int, int, epfd,
                     struct __kernel_epoll_event*, events, int, maxevents, int, timeout_ms,
                     const __sigset_t*, sigmask, size_t, sigsetsize)
 
-SHIM_SYSCALL_PASSTHROUGH(signalfd, 3, int, int, ufd, __sigset_t*, user_mask, size_t, sizemask)
+/* signalfd: sys/shim_signalfd.c */
+DEFINE_SHIM_SYSCALL(signalfd, 3, shim_do_signalfd, int, int, ufd, __sigset_t*, user_mask, size_t,
+                    sizemask)
 
-SHIM_SYSCALL_PASSTHROUGH(timerfd_create, 2, int, int, clockid, int, flags)
+/* timerfd_create: sys/shim_timerfd.c */
+DEFINE_SHIM_SYSCALL(timerfd_create, 2, shim_do_timerfd_create, int, int, clockid, int, flags)
 
-SHIM_SYSCALL_PASSTHROUGH(fallocate, 4, int, int, fd, int, mode, loff_t, offset, loff_t, len)
+/* fallocate: sys/shim_open.c */
+DEFINE_SHIM_SYSCALL(fallocate, 4, shim_do_fallocate, int, int, fd, int, mode, loff_t, offset, loff_t,
+                    len)
 
-SHIM_SYSCALL_PASSTHROUGH(timerfd_settime, 4, int, int, ufd, int, flags,
-                         const struct __kernel_itimerspec*, utmr, struct __kernel_itimerspec*, otmr)
+/* timerfd_settime: sys/shim_timerfd.c */
+DEFINE_SHIM_SYSCALL(timerfd_settime, 4, shim_do_timerfd_settime, int, int, ufd, int, flags,
+                    const struct __kernel_itimerspec*, utmr, struct __kernel_itimerspec*, otmr)
 
-SHIM_SYSCALL_PASSTHROUGH(timerfd_gettime, 2, int, int, ufd, struct __kernel_itimerspec*, otmr)
+/* timerfd_gettime: sys/shim_timerfd.c */
+DEFINE_SHIM_SYSCALL(timerfd_gettime, 2, shim_do_timerfd_gettime, int, int, ufd,
+                    struct __kernel_itimerspec*, otmr)
 
 /* accept4: sys/shim_socket.c */
 DEFINE_SHIM_SYSCALL(accept4, 4, shim_do_accept4, int, int, sockfd, struct sockaddr*, addr,
                     socklen_t*, addrlen, int, flags)
 
-SHIM_SYSCALL_PASSTHROUGH(signalfd4, 4, int, int, ufd, __sigset_t*, user_mask, size_t, sizemask, int,
-                         flags)
+/* signalfd4: sys/shim_signalfd.c */
+DEFINE_SHIM_SYSCALL(signalfd4, 4, shim_do_signalfd4, int, int, ufd, __sigset_t*, user_mask, size_t,
+                    sizemask, int, flags)
 
 DEFINE_SHIM_SYSCALL(eventfd, 1, shim_do_eventfd, int, unsigned int, count)
 
@@ -994,11 +1020,13 @@ DEFINE_SHIM_SYSCALL(pipe2, 2, shim_do_pipe2, int, int*, fildes, int, flags)
 
 SHIM_SYSCALL_PASSTHROUGH(inotify_init1, 1, int, int, flags)
 
-SHIM_SYSCALL_PASSTHROUGH(preadv, 5, int, unsigned long, fd, const struct iovec*, vec, unsigned long,
-                         vlen, unsigned long, pos_l, unsigned long, pos_h)
+/* preadv: sys/shim_wrappers.c */
+DEFINE_SHIM_SYSCALL(preadv, 5, shim_do_preadv, ssize_t, int, fd, const struct iovec*, vec, int,
+                    vlen, unsigned long, pos_l, unsigned long, pos_h)
 
-SHIM_SYSCALL_PASSTHROUGH(pwritev, 5, int, unsigned long, fd, const struct iovec*, vec,
-                         unsigned long, vlen, unsigned long, pos_l, unsigned long, pos_h)
+/* pwritev: sys/shim_wrappers.c */
+DEFINE_SHIM_SYSCALL(pwritev, 5, shim_do_pwritev, ssize_t, int, fd, const struct iovec*, vec, int,
+                    vlen, unsigned long, pos_l, unsigned long, pos_h)
 
 SHIM_SYSCALL_PASSTHROUGH(rt_tgsigqueueinfo, 4, int, pid_t, tgid, pid_t, pid, int, sig, siginfo_t*,
                          uinfo)
@@ -1035,6 +1063,18 @@ SHIM_SYSCALL_PASSTHROUGH(setns, 2, int, int, fd, int, nstype)
 SHIM_SYSCALL_PASSTHROUGH(getcpu, 3, int, unsigned*, cpu, unsigned*, node, struct getcpu_cache*,
                          cache)
 
+/* copy_file_range: sys/shim_fs.c */
+DEFINE_SHIM_SYSCALL(copy_file_range, 6, shim_do_copy_file_range, ssize_t, int, fd_in, loff_t*,
+                    off_in, int, fd_out, loff_t*, off_out, size_t, len, unsigned int, flags)
+
+/* preadv2: sys/shim_wrappers.c */
+DEFINE_SHIM_SYSCALL(preadv2, 6, shim_do_preadv2, ssize_t, int, fd, const struct iovec*, vec, int,
+                    vlen, unsigned long, pos_l, unsigned long, pos_h, int, flags)
+
+/* pwritev2: sys/shim_wrappers.c */
+DEFINE_SHIM_SYSCALL(pwritev2, 6, shim_do_pwritev2, ssize_t, int, fd, const struct iovec*, vec, int,
+                    vlen, unsigned long, pos_l, unsigned long, pos_h, int, flags)
+
 /* libos calls */
 
 DEFINE_SHIM_SYSCALL(msgpersist, 2, shim_do_msgpersist, int, int, msqid, int, cmd)
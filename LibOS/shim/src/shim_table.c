@@ -20,6 +20,8 @@
  * This file contains the system call table used by application libraries.
  */
 
+#include <asm/unistd.h>
+
 #include <shim_internal.h>
 #include <shim_table.h>
 
@@ -339,6 +341,10 @@ shim_fp shim_table[LIBOS_SYSCALL_BOUND] = {
     (shim_fp)__shim_setns,
     (shim_fp)__shim_getcpu,
 
+    [__NR_copy_file_range] = (shim_fp)__shim_copy_file_range,
+    [__NR_preadv2]         = (shim_fp)__shim_preadv2,
+    [__NR_pwritev2]        = (shim_fp)__shim_pwritev2,
+
     [LIBOS_SYSCALL_BASE] = (shim_fp)NULL,
 
     (shim_fp)__shim_msgpersist,
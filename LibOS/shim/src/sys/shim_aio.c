@@ -0,0 +1,682 @@
+/* Copyright (C) 2014 Stony Brook University
+   This file is part of Graphene Library OS.
+
+   Graphene Library OS is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   Graphene Library OS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/*
+ * shim_aio.c
+ *
+ * Implementation of system calls "io_setup", "io_destroy", "io_submit", "io_getevents" and
+ * "io_cancel" (Linux native AIO) for files.
+ *
+ * Submitted requests are queued and executed by a pool of internal worker threads, which use the
+ * positional pread/pwrite operations of the file system, so that many requests of a context are in
+ * flight on the host at the same time. Workers are created on demand (up to AIO_MAX_WORKERS) and
+ * exit after being idle for AIO_WORKER_IDLE_TIME. Completions are kept in the context until they
+ * are reaped by io_getevents(). AIO contexts are not inherited by child processes.
+ */
+
+#include <errno.h>
+#include <linux/aio_abi.h>
+
+#include <pal.h>
+#include <pal_error.h>
+#include <shim_fs.h>
+#include <shim_handle.h>
+#include <shim_internal.h>
+#include <shim_table.h>
+#include <shim_thread.h>
+#include <shim_utils.h>
+
+#ifndef IOCB_FLAG_IOPRIO
+#define IOCB_FLAG_IOPRIO (1 << 1)
+#endif
+
+/* every worker is a host thread; on SGX it also takes one of the sgx.thread_num slots */
+#define AIO_MAX_WORKERS      8
+#define AIO_WORKER_IDLE_TIME 1000000 /* us */
+
+/* same as the default of /proc/sys/fs/aio-max-nr */
+#define AIO_MAX_EVENTS       65536
+
+/* same as UIO_MAXIOV of Linux */
+#define AIO_MAX_IOVEC        1024
+
+/* Linux maps a ring of completions at the address of each context and libaio reaps completions
+ * from it directly if its magic number is valid. The context id here is the address of this
+ * header, with a zero magic number, so libaio always falls back to io_getevents(). */
+struct aio_ring {
+    unsigned int id;
+    unsigned int nr;
+    unsigned int head;
+    unsigned int tail;
+    unsigned int magic;
+    unsigned int compat_features;
+    unsigned int incompat_features;
+    unsigned int header_length;
+};
+
+/* a thread in io_getevents() or io_destroy() */
+DEFINE_LIST(aio_waiter);
+struct aio_waiter {
+    LIST_TYPE(aio_waiter) list;
+    PAL_HANDLE event;
+    unsigned long min_nr; /* completions the thread waits for */
+    bool drain;           /* io_destroy() waits for the requests in flight instead */
+};
+DEFINE_LISTP(aio_waiter);
+
+DEFINE_LIST(shim_aio_context);
+struct shim_aio_context {
+    struct aio_ring ring; /* must be the first member, see above */
+    LIST_TYPE(shim_aio_context) list;
+    REFTYPE ref_count;
+    struct shim_lock lock;
+    LISTP_TYPE(aio_waiter) waiters;
+    bool destroyed;
+    unsigned int inflight;  /* requests which are queued or being executed */
+    unsigned int reserved;  /* requests which are submitted and not reaped yet */
+    unsigned int max_events;
+    unsigned int head;      /* the first completion which is not reaped yet */
+    unsigned int count;     /* number of completions which are not reaped yet */
+    struct io_event events[];
+};
+
+DEFINE_LIST(aio_request);
+struct aio_request {
+    LIST_TYPE(aio_request) list;
+    struct shim_aio_context* ctx;
+    struct shim_handle* hdl;
+    struct shim_handle* resfd; /* eventfd notified on completion (IOCB_FLAG_RESFD) */
+    struct iocb* user_iocb;    /* reported to the user as io_event.obj */
+    struct iocb iocb;
+    struct iovec vec[];        /* copy of the buffers of IOCB_CMD_PREADV/PWRITEV */
+};
+
+DEFINE_LIST(aio_worker);
+struct aio_worker {
+    LIST_TYPE(aio_worker) list;
+    PAL_HANDLE event; /* set when the worker is handed new requests */
+    bool idle;
+};
+
+/* aio_lock protects the list of contexts, the request queue and the worker pool */
+DEFINE_LISTP(shim_aio_context);
+DEFINE_LISTP(aio_request);
+DEFINE_LISTP(aio_worker);
+static struct shim_lock aio_lock;
+static LISTP_TYPE(shim_aio_context) aio_context_list = LISTP_INIT;
+static LISTP_TYPE(aio_request) aio_queue = LISTP_INIT;
+static LISTP_TYPE(aio_worker) aio_idle_workers = LISTP_INIT;
+static unsigned int aio_nworkers;
+
+static struct shim_aio_context* get_aio_context(aio_context_t ctx_id) {
+    if (!lock_created(&aio_lock))
+        return NULL;
+
+    struct shim_aio_context* ret = NULL;
+    struct shim_aio_context* ctx;
+    lock(&aio_lock);
+    /* the id is only compared, it is never dereferenced before it is found in the list */
+    LISTP_FOR_EACH_ENTRY(ctx, &aio_context_list, list) {
+        if ((aio_context_t)ctx == ctx_id) {
+            REF_INC(ctx->ref_count);
+            ret = ctx;
+            break;
+        }
+    }
+    unlock(&aio_lock);
+    return ret;
+}
+
+static void put_aio_context(struct shim_aio_context* ctx) {
+    if (REF_DEC(ctx->ref_count))
+        return;
+
+    destroy_lock(&ctx->lock);
+    free(ctx);
+}
+
+static bool aio_waiter_ready(struct shim_aio_context* ctx, struct aio_waiter* waiter) {
+    if (waiter->drain)
+        return !ctx->inflight;
+    return ctx->destroyed || ctx->count >= waiter->min_nr;
+}
+
+/* this should be called with the ctx->lock held */
+static void wake_aio_waiters(struct shim_aio_context* ctx) {
+    assert(locked(&ctx->lock));
+
+    struct aio_waiter* waiter;
+    LISTP_FOR_EACH_ENTRY(waiter, &ctx->waiters, list) {
+        if (aio_waiter_ready(ctx, waiter))
+            DkEventSet(waiter->event);
+    }
+}
+
+/* Wait until `ctx` has at least `min_nr` completions or is destroyed (or, if `drain` is set, until
+ * it has no requests in flight), or the deadline passes. The ctx->lock is held on entry and is
+ * held again on return, also on errors. */
+static int wait_aio_context(struct shim_aio_context* ctx, unsigned long min_nr, bool drain,
+                            uint64_t deadline) {
+    assert(locked(&ctx->lock));
+
+    struct aio_waiter waiter = {.event = NULL, .min_nr = min_nr, .drain = drain};
+    int ret = 0;
+
+    while (!aio_waiter_ready(ctx, &waiter)) {
+        uint64_t wait_time = NO_TIMEOUT;
+        if (deadline != NO_TIMEOUT) {
+            uint64_t now = DkSystemTimeQuery();
+            if ((int64_t)now < 0) {
+                ret = (int64_t)now;
+                break;
+            }
+            if (deadline <= now)
+                break;
+            wait_time = deadline - now;
+        }
+
+        if (!waiter.event) {
+            waiter.event = DkSynchronizationEventCreate(PAL_FALSE);
+            if (!waiter.event) {
+                ret = -PAL_ERRNO;
+                break;
+            }
+        }
+
+        INIT_LIST_HEAD(&waiter, list);
+        LISTP_ADD_TAIL(&waiter, &ctx->waiters, list);
+        unlock(&ctx->lock);
+
+        bool woken = DkSynchronizationObjectWait(waiter.event, wait_time);
+        if (!woken && PAL_NATIVE_ERRNO != PAL_ERROR_TRYAGAIN)
+            ret = PAL_NATIVE_ERRNO == PAL_ERROR_INTERRUPTED ? -EINTR : -PAL_ERRNO;
+
+        lock(&ctx->lock);
+        LISTP_DEL(&waiter, &ctx->waiters, list);
+        if (ret < 0)
+            break;
+    }
+
+    if (waiter.event)
+        DkObjectClose(waiter.event);
+    return ret;
+}
+
+static long aio_readwrite_vec(struct shim_handle* hdl, const struct iovec* vec, size_t vlen,
+                              off_t pos, bool write) {
+    struct shim_fs_ops* fs_ops = hdl->fs->fs_ops;
+    long bytes = 0;
+
+    for (size_t i = 0; i < vlen; i++) {
+        if (!vec[i].iov_len)
+            continue;
+
+        ssize_t ret = write ? fs_ops->pwrite(hdl, vec[i].iov_base, vec[i].iov_len, pos + bytes)
+                            : fs_ops->pread(hdl, vec[i].iov_base, vec[i].iov_len, pos + bytes);
+        if (ret < 0)
+            return bytes ?: ret;
+
+        bytes += ret;
+        if ((size_t)ret < vec[i].iov_len)
+            break;
+    }
+    return bytes;
+}
+
+static long execute_aio_request(struct aio_request* req) {
+    struct iocb* cb = &req->iocb;
+    struct shim_handle* hdl = req->hdl;
+    struct shim_fs_ops* fs_ops = hdl->fs->fs_ops;
+
+    switch (cb->aio_lio_opcode) {
+        case IOCB_CMD_PREAD:
+            return fs_ops->pread(hdl, (void*)cb->aio_buf, cb->aio_nbytes, cb->aio_offset);
+        case IOCB_CMD_PWRITE:
+            return fs_ops->pwrite(hdl, (void*)cb->aio_buf, cb->aio_nbytes, cb->aio_offset);
+        case IOCB_CMD_PREADV:
+        case IOCB_CMD_PWRITEV:
+            return aio_readwrite_vec(hdl, req->vec, cb->aio_nbytes, cb->aio_offset,
+                                     cb->aio_lio_opcode == IOCB_CMD_PWRITEV);
+        case IOCB_CMD_FSYNC:
+        case IOCB_CMD_FDSYNC:
+            return fs_ops->flush(hdl);
+        default:
+            return -EINVAL;
+    }
+}
+
+static void complete_aio_request(struct aio_request* req, long res) {
+    struct shim_aio_context* ctx = req->ctx;
+
+    lock(&ctx->lock);
+    /* io_submit() reserves a slot for each request, so the completion always fits */
+    assert(ctx->count < ctx->max_events);
+    struct io_event* ev = &ctx->events[(ctx->head + ctx->count) % ctx->max_events];
+    ev->data = req->iocb.aio_data;
+    ev->obj  = (uint64_t)req->user_iocb;
+    ev->res  = res;
+    ev->res2 = 0;
+    ctx->count++;
+    ctx->inflight--;
+    wake_aio_waiters(ctx);
+    unlock(&ctx->lock);
+
+    if (req->resfd) {
+        uint64_t one = 1;
+        req->resfd->fs->fs_ops->write(req->resfd, &one, sizeof(one));
+        put_handle(req->resfd);
+    }
+
+    put_handle(req->hdl);
+    put_aio_context(ctx);
+    free(req);
+}
+
+static void aio_worker_thread(void* arg) {
+    struct shim_thread* self = (struct shim_thread*)arg;
+    if (!arg)
+        return;
+
+    shim_tcb_init();
+    set_cur_thread(self);
+    update_fs_base(0);
+    debug_setbuf(shim_get_tcb(), true);
+
+    struct aio_worker worker;
+    INIT_LIST_HEAD(&worker, list);
+    worker.idle  = false;
+    /* without an event, the worker only drains the queue once */
+    worker.event = DkSynchronizationEventCreate(PAL_FALSE);
+
+    debug("AIO worker thread started\n");
+
+    lock(&aio_lock);
+    while (true) {
+        if (!LISTP_EMPTY(&aio_queue)) {
+            struct aio_request* req = LISTP_FIRST_ENTRY(&aio_queue, struct aio_request, list);
+            LISTP_DEL(req, &aio_queue, list);
+            unlock(&aio_lock);
+
+            complete_aio_request(req, execute_aio_request(req));
+
+            lock(&aio_lock);
+            continue;
+        }
+
+        if (!worker.event)
+            break;
+
+        worker.idle = true;
+        LISTP_ADD(&worker, &aio_idle_workers, list);
+        unlock(&aio_lock);
+
+        bool woken = DkSynchronizationObjectWait(worker.event, AIO_WORKER_IDLE_TIME);
+
+        lock(&aio_lock);
+        if (worker.idle) {
+            /* nobody handed this worker new requests */
+            LISTP_DEL(&worker, &aio_idle_workers, list);
+            worker.idle = false;
+            if (!woken && LISTP_EMPTY(&aio_queue))
+                break;
+        }
+    }
+    aio_nworkers--;
+    unlock(&aio_lock);
+
+    if (worker.event)
+        DkObjectClose(worker.event);
+
+    debug("AIO worker thread terminated\n");
+
+    __disable_preempt(self->shim_tcb);
+    put_thread(self);
+    DkThreadExit(/*clear_child_tid=*/NULL);
+}
+
+/* this should be called with the aio_lock held */
+static int create_aio_worker(void) {
+    assert(locked(&aio_lock));
+
+    struct shim_thread* new = get_new_internal_thread();
+    if (!new)
+        return -ENOMEM;
+
+    PAL_HANDLE handle = thread_create(aio_worker_thread, new);
+    if (!handle) {
+        put_thread(new);
+        return -PAL_ERRNO;
+    }
+
+    new->pal_handle = handle;
+    aio_nworkers++;
+    return 0;
+}
+
+static int queue_aio_request(struct aio_request* req) {
+    int ret = 0;
+
+    lock(&aio_lock);
+    if (!LISTP_EMPTY(&aio_idle_workers)) {
+        struct aio_worker* worker = LISTP_FIRST_ENTRY(&aio_idle_workers, struct aio_worker, list);
+        LISTP_DEL(worker, &aio_idle_workers, list);
+        worker->idle = false;
+        DkEventSet(worker->event);
+    } else if (aio_nworkers < AIO_MAX_WORKERS) {
+        /* running workers pick the request up if no more workers can be created */
+        ret = create_aio_worker();
+        if (ret < 0 && aio_nworkers)
+            ret = 0;
+    }
+
+    if (!ret)
+        LISTP_ADD_TAIL(req, &aio_queue, list);
+    unlock(&aio_lock);
+    return ret;
+}
+
+int shim_do_io_setup(unsigned int nr_events, aio_context_t* ctxp) {
+    if (!ctxp || test_user_memory(ctxp, sizeof(*ctxp), true))
+        return -EFAULT;
+
+    if (!nr_events || *ctxp)
+        return -EINVAL;
+
+    if (nr_events > AIO_MAX_EVENTS)
+        return -EAGAIN;
+
+    if (!create_lock_runtime(&aio_lock))
+        return -ENOMEM;
+
+    struct shim_aio_context* ctx = malloc(sizeof(*ctx) + sizeof(struct io_event) * nr_events);
+    if (!ctx)
+        return -ENOMEM;
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->ring.nr            = nr_events;
+    ctx->ring.header_length = sizeof(ctx->ring);
+    ctx->max_events         = nr_events;
+    INIT_LIST_HEAD(ctx, list);
+    INIT_LISTP(&ctx->waiters);
+    REF_SET(ctx->ref_count, 1);
+
+    if (!create_lock(&ctx->lock)) {
+        free(ctx);
+        return -ENOMEM;
+    }
+
+    lock(&aio_lock);
+    LISTP_ADD_TAIL(ctx, &aio_context_list, list);
+    unlock(&aio_lock);
+
+    *ctxp = (aio_context_t)ctx;
+    return 0;
+}
+
+int shim_do_io_destroy(aio_context_t ctx_id) {
+    struct shim_aio_context* ctx = get_aio_context(ctx_id);
+    if (!ctx)
+        return -EINVAL;
+
+    lock(&aio_lock);
+    lock(&ctx->lock);
+    bool destroyed = ctx->destroyed;
+    if (!destroyed) {
+        ctx->destroyed = true;
+        LISTP_DEL(ctx, &aio_context_list, list);
+        /* threads waiting in io_getevents() return */
+        wake_aio_waiters(ctx);
+    }
+    unlock(&aio_lock);
+
+    /* like Linux, wait for the requests in flight; their completions are discarded. The requests
+     * keep a reference to the context, so it is freed after them even if the wait fails. */
+    if (!destroyed)
+        wait_aio_context(ctx, 0, /*drain=*/true, NO_TIMEOUT);
+    unlock(&ctx->lock);
+
+    put_aio_context(ctx); /* the reference of get_aio_context() */
+    if (destroyed)
+        return -EINVAL;
+
+    put_aio_context(ctx); /* the reference of io_setup() */
+    return 0;
+}
+
+static int check_iovec(const struct iovec* vec, size_t vlen, bool write) {
+    if (test_user_memory((void*)vec, sizeof(*vec) * vlen, false))
+        return -EFAULT;
+
+    for (size_t i = 0; i < vlen; i++) {
+        if (!vec[i].iov_len)
+            continue;
+        if (vec[i].iov_base + vec[i].iov_len <= vec[i].iov_base)
+            return -EINVAL;
+        if (test_user_memory(vec[i].iov_base, vec[i].iov_len, !write))
+            return -EFAULT;
+    }
+    return 0;
+}
+
+/* check one request and queue it; returns 0 or the error io_submit() reports for it */
+static int submit_aio_request(struct shim_aio_context* ctx, struct iocb* user_iocb) {
+    if (!user_iocb || test_user_memory(user_iocb, sizeof(*user_iocb), false))
+        return -EFAULT;
+
+    struct iocb cb = *user_iocb;
+    if (cb.aio_reserved2 || (cb.aio_flags & ~(IOCB_FLAG_RESFD | IOCB_FLAG_IOPRIO)))
+        return -EINVAL;
+
+    bool write  = false;
+    size_t nvec = 0;
+    int ret     = 0;
+    switch (cb.aio_lio_opcode) {
+        case IOCB_CMD_PWRITE:
+            write = true;
+            /* fall through */
+        case IOCB_CMD_PREAD:
+            if ((ssize_t)cb.aio_nbytes < 0)
+                return -EINVAL;
+            if (test_user_memory((void*)cb.aio_buf, cb.aio_nbytes, !write))
+                return -EFAULT;
+            break;
+        case IOCB_CMD_PWRITEV:
+            write = true;
+            /* fall through */
+        case IOCB_CMD_PREADV:
+            if (cb.aio_nbytes > AIO_MAX_IOVEC)
+                return -EINVAL;
+            if ((ret = check_iovec((const struct iovec*)cb.aio_buf, cb.aio_nbytes, write)) < 0)
+                return ret;
+            nvec = cb.aio_nbytes;
+            break;
+        case IOCB_CMD_FSYNC:
+        case IOCB_CMD_FDSYNC:
+            break;
+        default:
+            return -EINVAL;
+    }
+
+    if (cb.aio_lio_opcode != IOCB_CMD_FSYNC && cb.aio_lio_opcode != IOCB_CMD_FDSYNC &&
+            (off_t)cb.aio_offset < 0)
+        return -EINVAL;
+
+    struct shim_handle* hdl = get_fd_handle(cb.aio_fildes, NULL, NULL);
+    if (!hdl)
+        return -EBADF;
+
+    struct shim_handle* resfd = NULL;
+    struct aio_request* req   = NULL;
+
+    /* only files with positional I/O are supported, like only some file systems on Linux */
+    struct shim_fs_ops* fs_ops = hdl->fs ? hdl->fs->fs_ops : NULL;
+    if (hdl->type != TYPE_FILE || !fs_ops || !fs_ops->pread || !fs_ops->pwrite) {
+        ret = -EINVAL;
+        goto err;
+    }
+
+    if (cb.aio_lio_opcode == IOCB_CMD_FSYNC || cb.aio_lio_opcode == IOCB_CMD_FDSYNC) {
+        if (!fs_ops->flush) {
+            ret = -EINVAL;
+            goto err;
+        }
+    } else if (!(hdl->acc_mode & (write ? MAY_WRITE : MAY_READ))) {
+        ret = -EBADF;
+        goto err;
+    }
+
+    if (cb.aio_flags & IOCB_FLAG_RESFD) {
+        resfd = get_fd_handle(cb.aio_resfd, NULL, NULL);
+        if (!resfd) {
+            ret = -EBADF;
+            goto err;
+        }
+        if (resfd->type != TYPE_EVENTFD) {
+            ret = -EINVAL;
+            goto err;
+        }
+    }
+
+    req = malloc(sizeof(*req) + sizeof(struct iovec) * nvec);
+    if (!req) {
+        ret = -ENOMEM;
+        goto err;
+    }
+
+    lock(&ctx->lock);
+    if (ctx->reserved == ctx->max_events) {
+        unlock(&ctx->lock);
+        ret = -EAGAIN;
+        goto err;
+    }
+    ctx->reserved++;
+    ctx->inflight++;
+    unlock(&ctx->lock);
+
+    INIT_LIST_HEAD(req, list);
+    REF_INC(ctx->ref_count);
+    req->ctx       = ctx;
+    req->hdl       = hdl;
+    req->resfd     = resfd;
+    req->user_iocb = user_iocb;
+    req->iocb      = cb;
+    if (nvec)
+        memcpy(req->vec, (const struct iovec*)cb.aio_buf, sizeof(struct iovec) * nvec);
+
+    ret = queue_aio_request(req);
+    if (ret < 0) {
+        lock(&ctx->lock);
+        ctx->reserved--;
+        ctx->inflight--;
+        unlock(&ctx->lock);
+        put_aio_context(ctx);
+        goto err;
+    }
+    return 0;
+
+err:
+    free(req);
+    if (resfd)
+        put_handle(resfd);
+    put_handle(hdl);
+    return ret;
+}
+
+int shim_do_io_submit(aio_context_t ctx_id, long nr, struct iocb** iocbpp) {
+    if (nr < 0)
+        return -EINVAL;
+
+    if (!nr)
+        return 0;
+
+    if (!iocbpp || test_user_memory(iocbpp, sizeof(*iocbpp) * nr, false))
+        return -EFAULT;
+
+    struct shim_aio_context* ctx = get_aio_context(ctx_id);
+    if (!ctx)
+        return -EINVAL;
+
+    long i;
+    int ret = 0;
+    for (i = 0; i < nr; i++) {
+        ret = submit_aio_request(ctx, iocbpp[i]);
+        if (ret < 0)
+            break;
+    }
+
+    put_aio_context(ctx);
+    return i ?: ret;
+}
+
+int shim_do_io_getevents(aio_context_t ctx_id, long min_nr, long nr, struct io_event* events,
+                         struct timespec* timeout) {
+    if (min_nr < 0 || nr < 0 || min_nr > nr)
+        return -EINVAL;
+
+    if (nr && (!events || test_user_memory(events, sizeof(*events) * nr, true)))
+        return -EFAULT;
+
+    uint64_t deadline = NO_TIMEOUT;
+    if (timeout) {
+        if (test_user_memory(timeout, sizeof(*timeout), false))
+            return -EFAULT;
+        if (timeout->tv_sec < 0 || timeout->tv_nsec < 0 || timeout->tv_nsec >= 1000000000)
+            return -EINVAL;
+
+        uint64_t now = DkSystemTimeQuery();
+        if ((int64_t)now < 0)
+            return (int64_t)now;
+        deadline = now + timeout->tv_sec * 1000000ULL + timeout->tv_nsec / 1000;
+    }
+
+    struct shim_aio_context* ctx = get_aio_context(ctx_id);
+    if (!ctx)
+        return -EINVAL;
+
+    lock(&ctx->lock);
+    /* a context with fewer events than min_nr would never satisfy it */
+    if ((unsigned long)min_nr > ctx->max_events)
+        min_nr = ctx->max_events;
+
+    /* the completions stay in the context if the wait is interrupted */
+    int ret = wait_aio_context(ctx, min_nr, /*drain=*/false, deadline);
+    if (ret < 0)
+        goto out;
+
+    while (ret < nr && ctx->count) {
+        events[ret++] = ctx->events[ctx->head];
+        ctx->head = (ctx->head + 1) % ctx->max_events;
+        ctx->count--;
+        ctx->reserved--;
+    }
+out:
+    unlock(&ctx->lock);
+    put_aio_context(ctx);
+    return ret;
+}
+
+int shim_do_io_cancel(aio_context_t ctx_id, struct iocb* iocb, struct io_event* result) {
+    __UNUSED(iocb);
+    __UNUSED(result);
+
+    struct shim_aio_context* ctx = get_aio_context(ctx_id);
+    if (!ctx)
+        return -EINVAL;
+
+    /* like file requests on Linux, the requests cannot be cancelled once they are submitted */
+    put_aio_context(ctx);
+    return -EINVAL;
+}
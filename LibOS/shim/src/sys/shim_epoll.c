@@ -43,8 +43,12 @@
 #define EPOLLRDHUP  0x2000
 #endif
 
-/* TODO: 1024 handles/FDs is a small number for high-load servers (e.g., Linux has ~3M) */
-#define MAX_EPOLL_HANDLES 1024
+/* the monitored PAL handles are kept in a PAL wait set (backed by host epoll), so waiting does not
+ * depend on the number of handles; this only bounds the memory used by a single epoll */
+#define MAX_EPOLL_HANDLES 65536
+
+/* maximum number of PAL handles reported by a single wait */
+#define EPOLL_WAIT_BATCH 64
 
 struct shim_mount epoll_builtin_fs;
 
@@ -54,6 +58,8 @@ struct shim_epoll_item {
     unsigned int events;
     unsigned int revents;
     bool connected;
+    PAL_HANDLE pal_handle;           /* PAL handle registered in epoll's wait set (or NULL) */
+    PAL_FLG pal_events;              /* events under which pal_handle is registered */
     struct shim_handle* handle;      /* reference to monitored object (socket, pipe, file, etc) */
     struct shim_handle* epoll;       /* reference to epoll object that monitors handle object */
     LIST_TYPE(shim_epoll_item) list; /* list of shim_epoll_items, used by epoll object (via `fds`) */
@@ -68,21 +74,13 @@ int shim_do_epoll_create1(int flags) {
     if (!hdl)
         return -ENOMEM;
 
-    PAL_HANDLE* pal_handles = malloc(sizeof(*pal_handles) * MAX_EPOLL_HANDLES);
-    if (!pal_handles) {
-        put_handle(hdl);
-        return -ENOMEM;
-    }
-
     struct shim_epoll_handle* epoll = &hdl->info.epoll;
 
     hdl->type = TYPE_EPOLL;
     set_handle_fs(hdl, &epoll_builtin_fs);
-    epoll->maxfds      = MAX_EPOLL_HANDLES;
-    epoll->pal_cnt     = 0;
-    epoll->waiter_cnt  = 0;
-    epoll->pal_handles = pal_handles;
-    create_event(&epoll->event);
+    epoll->maxfds   = MAX_EPOLL_HANDLES;
+    epoll->pal_cnt  = 0;
+    epoll->wait_set = NULL;
     INIT_LISTP(&epoll->fds);
 
     int vfd = set_new_fd_handle(hdl, (flags & EPOLL_CLOEXEC) ? FD_CLOEXEC : 0, NULL);
@@ -98,25 +96,118 @@ int shim_do_epoll_create(int size) {
     return shim_do_epoll_create1(0);
 }
 
+/* PAL handle (and its events) under which an epoll item should be registered in the wait set,
+ * or NULL if it should not be registered */
+static PAL_HANDLE epoll_item_pal_handle(struct shim_epoll_item* epoll_item, PAL_FLG* pal_events) {
+    if (!epoll_item->connected || !epoll_item->handle || !epoll_item->handle->pal_handle)
+        return NULL;
+
+    *pal_events  = (epoll_item->events & (EPOLLIN | EPOLLRDNORM)) ? PAL_WAIT_READ  : 0;
+    *pal_events |= (epoll_item->events & (EPOLLOUT | EPOLLWRNORM)) ? PAL_WAIT_WRITE : 0;
+    return *pal_events ? epoll_item->handle->pal_handle : NULL;
+}
+
+/* The wait set has a single slot per PAL handle, which is shared by the items of dup'd FDs: the
+ * slot is registered under the union of the events of all items registered under its PAL handle.
+ * Returns the union over the items other than `skip` which still use `pal_handle` (the others are
+ * about to be unregistered, and their PAL handle may be closed already), and sets `*shared` if any
+ * item other than `skip` is registered under `pal_handle`. */
+static PAL_FLG epoll_slot_events(struct shim_epoll_handle* epoll, PAL_HANDLE pal_handle,
+                                 struct shim_epoll_item* skip, bool* shared) {
+    struct shim_epoll_item* tmp;
+    PAL_FLG events = 0;
+    PAL_FLG unused;
+
+    *shared = false;
+    LISTP_FOR_EACH_ENTRY(tmp, &epoll->fds, list) {
+        if (tmp == skip || tmp->pal_handle != pal_handle)
+            continue;
+        *shared = true;
+        if (epoll_item_pal_handle(tmp, &unused) == pal_handle)
+            events |= tmp->pal_events;
+    }
+    return events;
+}
+
 /* lock of shim_handle enclosing this epoll should be held while calling this function */
-static void update_epoll(struct shim_epoll_handle* epoll) {
+static void epoll_item_unregister(struct shim_epoll_handle* epoll,
+                                  struct shim_epoll_item* epoll_item) {
     assert(locked(&container_of(epoll, struct shim_handle, info.epoll)->lock));
 
+    PAL_HANDLE pal_handle = epoll_item->pal_handle;
+    if (!pal_handle)
+        return;
+
+    bool shared;
+    PAL_FLG events = epoll_slot_events(epoll, pal_handle, epoll_item, &shared);
+    epoll_item->pal_handle = NULL;
+    epoll_item->pal_events = 0;
+
+    if (!shared) {
+        DkWaitSetUpdate(epoll->wait_set, pal_handle, 0);
+        epoll->pal_cnt--;
+    } else if (events) {
+        /* the slot stays for the other items, only the events of this one are dropped */
+        DkWaitSetUpdate(epoll->wait_set, pal_handle, events);
+    }
+}
+
+/* Bring the wait set in line with the epoll items: their PAL handles may have been replaced or
+ * created since the last update (e.g. on connect()), or they may have been disconnected.
+ * Lock of shim_handle enclosing this epoll should be held while calling this function. */
+static int update_epoll(struct shim_epoll_handle* epoll) {
+    assert(locked(&container_of(epoll, struct shim_handle, info.epoll)->lock));
+
+    if (!epoll->wait_set) {
+        epoll->wait_set = DkWaitSetCreate();
+        if (!epoll->wait_set)
+            return -PAL_ERRNO;
+    }
+
     struct shim_epoll_item* tmp;
-    epoll->pal_cnt = 0;
+    PAL_FLG pal_events;
+
+    /* remove stale registrations first: the host FD of a closed PAL handle may already be reused
+     * by the PAL handle of another item */
+    LISTP_FOR_EACH_ENTRY(tmp, &epoll->fds, list) {
+        PAL_HANDLE pal_handle = epoll_item_pal_handle(tmp, &pal_events);
+        if (tmp->pal_handle != pal_handle)
+            epoll_item_unregister(epoll, tmp);
+    }
 
     LISTP_FOR_EACH_ENTRY(tmp, &epoll->fds, list) {
-        if (!tmp->connected || !tmp->handle || !tmp->handle->pal_handle)
+        PAL_HANDLE pal_handle = epoll_item_pal_handle(tmp, &pal_events);
+        if (!pal_handle || (tmp->pal_handle == pal_handle && tmp->pal_events == pal_events))
             continue;
 
-        assert(epoll->pal_cnt < MAX_EPOLL_HANDLES);
-        epoll->pal_handles[epoll->pal_cnt++] = tmp->handle->pal_handle;
+        /* after the loop above, the item is either unregistered or registered under pal_handle */
+        bool shared;
+        PAL_FLG events = epoll_slot_events(epoll, pal_handle, tmp, &shared);
+        bool new_slot  = !shared && !tmp->pal_handle;
+
+        if (!DkWaitSetUpdate(epoll->wait_set, pal_handle, events | pal_events)) {
+            /* the PAL does not leave a handle half-registered, so an existing slot is gone; its
+             * items are registered again on the next update */
+            if (!new_slot) {
+                struct shim_epoll_item* item;
+                LISTP_FOR_EACH_ENTRY(item, &epoll->fds, list) {
+                    if (item->pal_handle == pal_handle) {
+                        item->pal_handle = NULL;
+                        item->pal_events = 0;
+                    }
+                }
+                epoll->pal_cnt--;
+            }
+            continue;
+        }
+
+        if (new_slot)
+            epoll->pal_cnt++;
+        tmp->pal_handle = pal_handle;
+        tmp->pal_events = pal_events;
     }
 
-    /* if other threads are currently waiting on epoll_wait(), send a signal to update their
-     * epoll items (note that we send waiter_cnt number of signals -- to each waiting thread) */
-    if (epoll->waiter_cnt)
-        set_event(&epoll->event, epoll->waiter_cnt);
+    return 0;
 }
 
 void delete_from_epoll_handles(struct shim_handle* handle) {
@@ -136,13 +227,13 @@ void delete_from_epoll_handles(struct shim_handle* handle) {
         unlock(&handle->lock);
 
         /* second, get epoll to which this epoll-item belongs to, and remove epoll-item from
-         * epoll's `fds` list, and trigger update_epoll() to re-populate pal_handles */
+         * epoll's `fds` list, and remove its PAL handle from epoll's wait set */
         struct shim_handle* hdl         = epoll_item->epoll;
         struct shim_epoll_handle* epoll = &hdl->info.epoll;
 
         lock(&hdl->lock);
+        epoll_item_unregister(epoll, epoll_item);
         LISTP_DEL(epoll_item, &epoll->fds, list);
-        update_epoll(epoll);
         unlock(&hdl->lock);
 
         /* finally, free this epoll-item and put reference to epoll it belonged to
@@ -195,7 +286,8 @@ int shim_do_epoll_ctl(int epfd, int op, int fd, struct __kernel_epoll_event* eve
                 goto out;
             }
             /* note that pipe and socket may not have pal_handle yet (e.g. before bind()) */
-            if (hdl->type != TYPE_PIPE && hdl->type != TYPE_SOCK && hdl->type != TYPE_EVENTFD) {
+            if (hdl->type != TYPE_PIPE && hdl->type != TYPE_SOCK && hdl->type != TYPE_EVENTFD &&
+                    hdl->type != TYPE_TIMERFD && hdl->type != TYPE_SIGNALFD) {
                 ret = -EPERM;
                 put_handle(hdl);
                 goto out;
@@ -218,10 +310,12 @@ int shim_do_epoll_ctl(int epfd, int op, int fd, struct __kernel_epoll_event* eve
             epoll_item->fd        = fd;
             epoll_item->events    = event->events;
             epoll_item->data      = event->data;
-            epoll_item->revents   = 0;
-            epoll_item->handle    = hdl;
-            epoll_item->epoll     = epoll_hdl;
-            epoll_item->connected = true;
+            epoll_item->revents    = 0;
+            epoll_item->pal_handle = NULL;
+            epoll_item->pal_events = 0;
+            epoll_item->handle     = hdl;
+            epoll_item->epoll      = epoll_hdl;
+            epoll_item->connected  = true;
             get_handle(epoll_hdl);
 
             /* register hdl (corresponding to FD) in epoll (corresponding to EPFD):
@@ -238,7 +332,7 @@ int shim_do_epoll_ctl(int epfd, int op, int fd, struct __kernel_epoll_event* eve
 
             put_handle(hdl);
 
-            update_epoll(epoll);
+            ret = update_epoll(epoll);
             break;
         }
 
@@ -249,7 +343,7 @@ int shim_do_epoll_ctl(int epfd, int op, int fd, struct __kernel_epoll_event* eve
                     epoll_item->data   = event->data;
 
                     debug("modified fd %d at epoll handle %p\n", fd, epoll);
-                    update_epoll(epoll);
+                    ret = update_epoll(epoll);
                     goto out;
                 }
             }
@@ -272,12 +366,11 @@ int shim_do_epoll_ctl(int epfd, int op, int fd, struct __kernel_epoll_event* eve
                     unlock(&hdl->lock);
 
                     /* note that we already grabbed epoll_hdl->lock so we can safely update epoll */
+                    epoll_item_unregister(epoll, epoll_item);
                     LISTP_DEL(epoll_item, &epoll->fds, list);
 
                     put_handle(epoll_hdl);
                     free(epoll_item);
-
-                    update_epoll(epoll);
                     goto out;
                 }
             }
@@ -314,122 +407,98 @@ int shim_do_epoll_wait(int epfd, struct __kernel_epoll_event* events, int maxeve
     }
 
     struct shim_epoll_handle* epoll = &epoll_hdl->info.epoll;
-    bool need_update = false;
+    PAL_HANDLE pal_handles[EPOLL_WAIT_BATCH];
+    PAL_FLG ret_events[EPOLL_WAIT_BATCH];
+    int batch = maxevents < EPOLL_WAIT_BATCH ? maxevents : EPOLL_WAIT_BATCH;
+    PAL_NUM timeout_us = timeout_ms < 0 ? NO_TIMEOUT : (PAL_NUM)timeout_ms * 1000;
+    uint64_t deadline  = timeout_ms < 0 ? 0 : DkSystemTimeQuery() + timeout_us;
+    int nevents = 0;
+    int ret;
 
-    lock(&epoll_hdl->lock);
+    /* wakeups which bring no events (all ready handles were removed from epoll during the wait)
+     * do not end the wait; only the timeout, an interruption or an error do */
+    while (true) {
+        bool need_update = false;
 
-    /* loop to retry on interrupted epoll waits (due to epoll being concurrently updated) */
-    while (1) {
-        /* wait on epoll's PAL handles + one "event" handle that signals epoll updates */
-        PAL_HANDLE* pal_handles = malloc((epoll->pal_cnt + 1) * sizeof(PAL_HANDLE));
-        if (!pal_handles) {
-            unlock(&epoll_hdl->lock);
-            put_handle(epoll_hdl);
-            return -ENOMEM;
-        }
+        lock(&epoll_hdl->lock);
 
-        /* allocate one memory region to hold two PAL_FLG arrays: events and revents */
-        PAL_FLG* pal_events = malloc((epoll->pal_cnt + 1) * sizeof(PAL_FLG) * 2);
-        if (!pal_events) {
-            free(pal_handles);
+        /* PAL handles of sockets may have been created or replaced since the last update */
+        ret = update_epoll(epoll);
+        if (ret < 0) {
             unlock(&epoll_hdl->lock);
-            put_handle(epoll_hdl);
-            return -ENOMEM;
-        }
-        PAL_FLG* ret_events = pal_events + (epoll->pal_cnt + 1);
-
-        /* populate pal_events with read/write events from user-supplied epoll items */
-        int pal_cnt = 0;
-        struct shim_epoll_item* epoll_item;
-        LISTP_FOR_EACH_ENTRY(epoll_item, &epoll->fds, list) {
-            if (!epoll_item->handle || !epoll_item->handle->pal_handle)
-                continue;
-
-            pal_handles[pal_cnt] = epoll_item->handle->pal_handle;
-            pal_events[pal_cnt]  = (epoll_item->events & (EPOLLIN | EPOLLRDNORM)) ? PAL_WAIT_READ  : 0;
-            pal_events[pal_cnt] |= (epoll_item->events & (EPOLLOUT | EPOLLWRNORM)) ? PAL_WAIT_WRITE : 0;
-            ret_events[pal_cnt]  = 0;
-            pal_cnt++;
+            break;
         }
+        PAL_HANDLE wait_set = epoll->wait_set;
 
-        /* populate "event" handle so it waits on read (meaning epoll-update signal arrived);
-         * note that we don't increment pal_cnt because this is a special not-user-supplied item */
-        pal_handles[pal_cnt] = epoll->event.event;
-        pal_events[pal_cnt]  = PAL_WAIT_READ;
-        ret_events[pal_cnt]  = 0;
-
-        epoll->waiter_cnt++;  /* mark epoll as being waited on (so epoll-update signal is sent) */
+        /* the wait set is not modified by waiting, so concurrent epoll_ctl() calls and waits in
+         * other threads take effect immediately */
         unlock(&epoll_hdl->lock);
 
-        /* TODO: Timeout must be updated in case of retries; otherwise, we may wait for too long */
-        PAL_BOL polled = DkStreamsWaitEvents(pal_cnt + 1, pal_handles, pal_events, ret_events, timeout_ms * 1000);
+        PAL_NUM polled = DkWaitSetWait(wait_set, batch, pal_handles, ret_events, timeout_us);
+        if (!polled && PAL_NATIVE_ERRNO != PAL_ERROR_TRYAGAIN) {
+            ret = PAL_NATIVE_ERRNO == PAL_ERROR_INTERRUPTED ? -EINTR : -PAL_ERRNO;
+            break;
+        }
 
         lock(&epoll_hdl->lock);
-        epoll->waiter_cnt--;
-
-        /* update user-supplied epoll items' revents with ret_events of polled PAL handles */
-        if (!ret_events[pal_cnt] && polled) {
-            /* only if epoll was not updated concurrently and something was actually polled */
-            for (int i = 0; i < pal_cnt; i++) {
-                LISTP_FOR_EACH_ENTRY(epoll_item, &epoll->fds, list) {
-                    if (!epoll_item->handle || !epoll_item->handle->pal_handle)
-                        continue;
-                    if (epoll_item->handle->pal_handle != pal_handles[i])
-                        continue;
-
-                    if (ret_events[i] & PAL_WAIT_ERROR) {
-                        epoll_item->revents  |= EPOLLERR | EPOLLHUP | EPOLLRDHUP;
-                        epoll_item->connected = false;
-                        /* handle disconnected, must remove it from epoll list */
-                        need_update = true;
-                    }
-                    if (ret_events[i] & PAL_WAIT_READ)
-                        epoll_item->revents |= EPOLLIN | EPOLLRDNORM;
-                    if (ret_events[i] & PAL_WAIT_WRITE)
-                        epoll_item->revents |= EPOLLOUT | EPOLLWRNORM;
-                    break;
+
+        /* update user-supplied epoll items' revents with ret_events of polled PAL handles
+         * (handles removed from epoll during the wait are simply not found); the items of dup'd
+         * FDs share a PAL handle, and each of them only gets the events it is registered for */
+        for (PAL_NUM i = 0; i < polled; i++) {
+            struct shim_epoll_item* epoll_item;
+            LISTP_FOR_EACH_ENTRY(epoll_item, &epoll->fds, list) {
+                if (!epoll_item->pal_handle || epoll_item->pal_handle != pal_handles[i])
+                    continue;
+
+                if (ret_events[i] & PAL_WAIT_ERROR) {
+                    epoll_item->revents  |= EPOLLERR | EPOLLHUP | EPOLLRDHUP;
+                    epoll_item->connected = false;
+                    /* handle disconnected, must remove it from the wait set */
+                    need_update = true;
                 }
+                if (ret_events[i] & epoll_item->pal_events & PAL_WAIT_READ)
+                    epoll_item->revents |= EPOLLIN | EPOLLRDNORM;
+                if (ret_events[i] & epoll_item->pal_events & PAL_WAIT_WRITE)
+                    epoll_item->revents |= EPOLLOUT | EPOLLWRNORM;
             }
         }
 
-        PAL_FLG event_handle_update = ret_events[pal_cnt];
-        free(pal_handles);
-        free(pal_events);
-
-        if (event_handle_update) {
-            /* retry if epoll was updated concurrently (similar to Linux semantics) */
-            unlock(&epoll_hdl->lock);
-            wait_event(&epoll->event);
-            lock(&epoll_hdl->lock);
-        } else {
-            /* no need to retry, exit the while loop */
-            break;
+        /* update user-supplied events array with all events detected till now on epoll */
+        struct shim_epoll_item* epoll_item;
+        LISTP_FOR_EACH_ENTRY(epoll_item, &epoll->fds, list) {
+            if (nevents == maxevents)
+                break;
+
+            unsigned int monitored_events = epoll_item->events | EPOLLERR | EPOLLHUP | EPOLLRDHUP;
+            if (epoll_item->revents & monitored_events) {
+                events[nevents].events = epoll_item->revents & monitored_events;
+                events[nevents].data   = epoll_item->data;
+                /* informed user about revents, may clear */
+                epoll_item->revents &= ~epoll_item->events;
+                nevents++;
+            }
         }
-    }
 
-    /* update user-supplied events array with all events detected till now on epoll */
-    int nevents = 0;
-    struct shim_epoll_item* epoll_item;
-    LISTP_FOR_EACH_ENTRY(epoll_item, &epoll->fds, list) {
-        if (nevents == maxevents)
+        /* some handles were disconnected and thus must be removed from the wait set */
+        if (need_update)
+            update_epoll(epoll);
+
+        unlock(&epoll_hdl->lock);
+
+        if (nevents)
             break;
 
-        unsigned int monitored_events = epoll_item->events | EPOLLERR | EPOLLHUP | EPOLLRDHUP;
-        if (epoll_item->revents & monitored_events) {
-            events[nevents].events = epoll_item->revents & monitored_events;
-            events[nevents].data   = epoll_item->data;
-            epoll_item->revents &= ~epoll_item->events; /* informed user about revents, may clear */
-            nevents++;
+        if (timeout_ms >= 0) {
+            uint64_t now = DkSystemTimeQuery();
+            if (now >= deadline)
+                break;
+            timeout_us = deadline - now;
         }
     }
 
-    /* some handles were disconnected and thus must be removed from the epoll list */
-    if (need_update)
-        update_epoll(epoll);
-
-    unlock(&epoll_hdl->lock);
     put_handle(epoll_hdl);
-    return nevents;
+    return ret < 0 ? ret : nevents;
 }
 
 int shim_do_epoll_pwait(int epfd, struct __kernel_epoll_event* events, int maxevents,
@@ -443,8 +512,8 @@ int shim_do_epoll_pwait(int epfd, struct __kernel_epoll_event* events, int maxev
 static int epoll_close(struct shim_handle* hdl) {
     struct shim_epoll_handle* epoll = &hdl->info.epoll;
 
-    free(epoll->pal_handles);
-    destroy_event(&epoll->event);
+    if (epoll->wait_set)
+        DkObjectClose(epoll->wait_set);
 
     /* epoll is finally closed only after all FDs referring to it have been closed */
     assert(LISTP_EMPTY(&epoll->fds));
@@ -481,6 +550,9 @@ BEGIN_CP_FUNC(epoll_item) {
         new_epoll_item->events     = epoll_item->events;
         new_epoll_item->data       = epoll_item->data;
         new_epoll_item->revents    = epoll_item->revents;
+        new_epoll_item->connected  = epoll_item->connected;
+        new_epoll_item->pal_handle = NULL;
+        new_epoll_item->pal_events = 0;
 
         LISTP_ADD(new_epoll_item, new_list, list);
 
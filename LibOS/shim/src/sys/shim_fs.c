@@ -18,8 +18,8 @@
  * shim_fs.c
  *
  * Implementation of system call "unlink", "unlinkat", "mkdir", "mkdirat",
- * "rmdir", "umask", "chmod", "fchmod", "fchmodat", "rename", "renameat" and
- * "sendfile".
+ * "rmdir", "umask", "chmod", "fchmod", "fchmodat", "rename", "renameat",
+ * "sendfile", "splice" and "copy_file_range".
  */
 
 #define __KERNEL__
@@ -327,226 +327,477 @@ int shim_do_fchown(int fd, uid_t uid, gid_t gid) {
     return 0;
 }
 
-#define MAP_SIZE (g_pal_alloc_align * 4)
-#define BUF_SIZE 2048
+/* Chunk sizes of the streaming copy: big enough to amortize the host calls (OCALLs on SGX) for
+ * each chunk, but not bigger than what the handle type takes at once. */
+#define COPY_CHUNK_FILE  (1024 * 1024)
+#define COPY_CHUNK_SOCK  (256 * 1024)
+#define COPY_CHUNK_PIPE  (64 * 1024) /* default capacity of a Linux pipe */
+#define COPY_CHUNK_OTHER (16 * 1024)
 
-static ssize_t handle_copy(struct shim_handle* hdli, off_t* offseti, struct shim_handle* hdlo,
-                           off_t* offseto, ssize_t count) {
-    struct shim_mount* fsi = hdli->fs;
-    struct shim_mount* fso = hdlo->fs;
+/* all copy buffers have the same size, so that they can be reused by any copy */
+#define COPY_BUF_SIZE    COPY_CHUNK_FILE
+#define COPY_BUF_CACHE   2
 
-    if (!count)
-        return 0;
+/* the writer thread is only started for copies of at least this many chunks */
+#define COPY_OVERLAP_MIN_CHUNKS 4
 
-    if (!fsi || !fsi->fs_ops || !fso || !fso->fs_ops)
-        return -EACCES;
+/* buffers kept for the next copy, so that a loop of sendfile() calls does not allocate per call */
+static struct shim_lock copy_buf_lock;
+static void* copy_buf_cache[COPY_BUF_CACHE];
+static int copy_buf_cnt;
 
-    bool do_mapi  = fsi->fs_ops->mmap != NULL;
-    bool do_mapo  = fso->fs_ops->mmap != NULL;
-    bool do_marki = false;
-    bool do_marko = false;
-    int offi = 0, offo = 0;
+static void* get_copy_buf(void) {
+    void* buf = NULL;
 
-    if (offseti) {
-        if (!fsi->fs_ops->seek)
-            return -EACCES;
-        offi = *offseti;
-        fsi->fs_ops->seek(hdli, offi, SEEK_SET);
-    } else {
-        if (!fsi->fs_ops->seek || (offi = fsi->fs_ops->seek(hdli, 0, SEEK_CUR)) < 0)
-            do_mapi = false;
+    if (create_lock_runtime(&copy_buf_lock)) {
+        lock(&copy_buf_lock);
+        if (copy_buf_cnt)
+            buf = copy_buf_cache[--copy_buf_cnt];
+        unlock(&copy_buf_lock);
     }
 
-    if (offseto) {
-        if (!fso->fs_ops->seek)
+    return buf ?: malloc(COPY_BUF_SIZE);
+}
+
+static void put_copy_buf(void* buf) {
+    if (!buf)
+        return;
+
+    if (lock_created(&copy_buf_lock)) {
+        lock(&copy_buf_lock);
+        if (copy_buf_cnt < COPY_BUF_CACHE) {
+            copy_buf_cache[copy_buf_cnt++] = buf;
+            buf = NULL;
+        }
+        unlock(&copy_buf_lock);
+    }
+
+    free(buf);
+}
+
+static size_t copy_chunk_size(struct shim_handle* hdl) {
+    switch (hdl->type) {
+        case TYPE_FILE:
+            return hdl->info.file.type == FILE_REGULAR ? COPY_CHUNK_FILE : COPY_CHUNK_OTHER;
+        case TYPE_SOCK:
+            return COPY_CHUNK_SOCK;
+        case TYPE_PIPE:
+            return COPY_CHUNK_PIPE;
+        default:
+            return COPY_CHUNK_OTHER;
+    }
+}
+
+/* One end of a copy. Files with pread/pwrite are accessed at `off` without moving the position of
+ * the handle; other handles are read or written sequentially, after seeking to the offset given
+ * by the caller if any. */
+struct copy_end {
+    struct shim_handle* hdl;
+    bool positional;
+    bool marked;   /* O_NONBLOCK was cleared for the duration of the copy */
+    off_t off;
+};
+
+static int init_copy_end(struct copy_end* end, struct shim_handle* hdl, off_t* offset,
+                         bool write) {
+    struct shim_fs_ops* fs_ops = hdl->fs->fs_ops;
+
+    end->hdl        = hdl;
+    end->positional = hdl->type == TYPE_FILE && fs_ops->seek &&
+                      (write ? fs_ops->pwrite != NULL : fs_ops->pread != NULL);
+    end->marked     = false;
+    end->off        = offset ? *offset : 0;
+
+    if (end->positional) {
+        if (!offset && (end->off = fs_ops->seek(hdl, 0, SEEK_CUR)) < 0)
+            return end->off;
+        return 0;
+    }
+
+    if (offset) {
+        if (!fs_ops->seek)
             return -EACCES;
-        offo = *offseto;
-        fso->fs_ops->seek(hdlo, offo, SEEK_SET);
-    } else {
-        if (!fso->fs_ops->seek || (offo = fso->fs_ops->seek(hdlo, 0, SEEK_CUR)) < 0)
-            do_mapo = false;
+        off_t ret = fs_ops->seek(hdl, *offset, SEEK_SET);
+        if (ret < 0)
+            return ret;
     }
 
-    if (do_mapi) {
-        int size;
-        if (fsi->fs_ops->poll && (size = fsi->fs_ops->poll(hdli, FS_POLL_SZ)) >= 0) {
-            if (count == -1 || count > size - offi)
-                count = size - offi;
+    /* sendfile() et al. block on the handles which LibOS cannot map or access at an offset */
+    if ((hdl->flags & O_NONBLOCK) && fs_ops->setflags && !fs_ops->setflags(hdl, 0)) {
+        debug("mark handle %s as blocking\n", qstrgetstr(&hdl->uri));
+        end->marked = true;
+    }
+    return 0;
+}
 
-            if (!count)
-                return 0;
-        } else {
-            do_mapi = false;
-        }
+static void fini_copy_end(struct copy_end* end, off_t* offset) {
+    struct shim_fs_ops* fs_ops = end->hdl->fs->fs_ops;
+
+    if (offset)
+        *offset = end->off;
+    else if (end->positional)
+        fs_ops->seek(end->hdl, end->off, SEEK_SET);
+
+    if (end->marked && (end->hdl->flags & O_NONBLOCK)) {
+        debug("mark handle %s as nonblocking\n", qstrgetstr(&end->hdl->uri));
+        fs_ops->setflags(end->hdl, O_NONBLOCK);
     }
+}
 
-    if (do_mapo && count > 0)
-        do {
-            int size;
-            if (!fso->fs_ops->poll || (size = fso->fs_ops->poll(hdlo, FS_POLL_SZ)) < 0) {
-                do_mapo = false;
-                break;
-            }
+static ssize_t copy_read(struct copy_end* in, char* buf, size_t size) {
+    struct shim_fs_ops* fs_ops = in->hdl->fs->fs_ops;
+    ssize_t ret = in->positional ? fs_ops->pread(in->hdl, buf, size, in->off)
+                                 : fs_ops->read(in->hdl, buf, size);
+    if (ret > 0)
+        in->off += ret;
+    return ret;
+}
 
-            if (offo + count < size)
-                break;
+/* writes the whole chunk unless the handle fails or stops taking data */
+static ssize_t copy_write(struct copy_end* out, const char* buf, size_t size) {
+    struct shim_fs_ops* fs_ops = out->hdl->fs->fs_ops;
+    size_t bytes = 0;
 
-            if (!fso->fs_ops->truncate || fso->fs_ops->truncate(hdlo, offo + count) < 0) {
-                do_mapo = false;
-                break;
-            }
-        } while (0);
-
-    void* bufi = NULL;
-    void* bufo = NULL;
-    int bytes    = 0;
-    int bufsize  = MAP_SIZE;
-    int copysize = 0;
-
-    if (!do_mapi && (hdli->flags & O_NONBLOCK) && fsi->fs_ops->setflags) {
-        int ret = fsi->fs_ops->setflags(hdli, 0);
-        if (!ret) {
-            debug("mark handle %s as blocking\n", qstrgetstr(&hdli->uri));
-            do_marki = true;
-        }
+    while (bytes < size) {
+        ssize_t ret = out->positional
+                          ? fs_ops->pwrite(out->hdl, buf + bytes, size - bytes, out->off)
+                          : fs_ops->write(out->hdl, (void*)buf + bytes, size - bytes);
+        if (ret <= 0)
+            return bytes ? (ssize_t)bytes : ret;
+        bytes    += ret;
+        out->off += ret;
     }
+    return bytes;
+}
 
-    if (!do_mapo && (hdlo->flags & O_NONBLOCK) && fso->fs_ops->setflags) {
-        int ret = fso->fs_ops->setflags(hdlo, 0);
-        if (!ret) {
-            debug("mark handle %s as blocking\n", qstrgetstr(&hdlo->uri));
-            do_marko = true;
-        }
+/* A thread which writes a chunk of a copy while the copying thread reads the next one. The two
+ * threads hand the chunks to each other with `ready` and `done`. */
+struct copy_writer {
+    struct copy_end* out;
+    struct shim_thread* thread;
+    struct shim_lock lock; /* held by the writer while it sets `done` */
+    PAL_HANDLE ready;      /* `buf` is ready to be written, or the writer should `stop` */
+    PAL_HANDLE done;       /* `ret` is the result of writing `buf` */
+    const char* buf;
+    size_t size;
+    ssize_t ret;
+    bool stop;
+};
+
+static void copy_writer_thread(void* arg) {
+    struct copy_writer* writer = (struct copy_writer*)arg;
+    struct shim_thread* self   = writer->thread;
+
+    shim_tcb_init();
+    set_cur_thread(self);
+    update_fs_base(0);
+    debug_setbuf(shim_get_tcb(), true);
+
+    bool stop = false;
+    while (!stop) {
+        while (!DkSynchronizationObjectWait(writer->ready, NO_TIMEOUT))
+            ;
+
+        stop = writer->stop;
+        if (!stop)
+            writer->ret = copy_write(writer->out, writer->buf, writer->size);
+
+        /* the copying thread frees `writer` as soon as it gets the lock after `done` */
+        lock(&writer->lock);
+        DkEventSet(writer->done);
+        unlock(&writer->lock);
+    }
+
+    __disable_preempt(self->shim_tcb);
+    put_thread(self);
+    DkThreadExit(/*clear_child_tid=*/NULL);
+}
+
+static int start_copy_writer(struct copy_writer* writer, struct copy_end* out) {
+    memset(writer, 0, sizeof(*writer));
+    writer->out = out;
+
+    if (!create_lock(&writer->lock))
+        return -ENOMEM;
+
+    writer->ready = DkSynchronizationEventCreate(PAL_FALSE);
+    writer->done  = DkSynchronizationEventCreate(PAL_FALSE);
+    if (!writer->ready || !writer->done)
+        goto err;
+
+    writer->thread = get_new_internal_thread();
+    if (!writer->thread)
+        goto err;
+
+    PAL_HANDLE handle = thread_create(copy_writer_thread, writer);
+    if (!handle) {
+        put_thread(writer->thread);
+        goto err;
     }
+    writer->thread->pal_handle = handle;
+    return 0;
 
-    assert(count);
-    do {
-        int boffi = 0, boffo = 0;
-        int expectsize = bufsize;
+err:
+    if (writer->ready)
+        DkObjectClose(writer->ready);
+    if (writer->done)
+        DkObjectClose(writer->done);
+    destroy_lock(&writer->lock);
+    return -ENOMEM;
+}
 
-        if (count > 0 && bufsize > count - bytes)
-            expectsize = bufsize = count - bytes;
+static void hand_copy_writer(struct copy_writer* writer, const char* buf, size_t size) {
+    writer->buf  = buf;
+    writer->size = size;
+    DkEventSet(writer->ready);
+}
 
-        if (do_mapi && !bufi) {
-            boffi = offi - ALLOC_ALIGN_DOWN(offi);
+static ssize_t wait_copy_writer(struct copy_writer* writer) {
+    while (!DkSynchronizationObjectWait(writer->done, NO_TIMEOUT))
+        ;
+    return writer->ret;
+}
 
-            if (fsi->fs_ops->mmap(hdli, &bufi, ALLOC_ALIGN_UP(bufsize + boffi), PROT_READ, MAP_FILE,
-                                  offi - boffi) < 0) {
-                do_mapi = false;
-                boffi = 0;
-                if ((hdli->flags & O_NONBLOCK) && fsi->fs_ops->setflags) {
-                    int ret = fsi->fs_ops->setflags(hdli, 0);
-                    if (!ret) {
-                        debug("mark handle %s as blocking\n", qstrgetstr(&hdli->uri));
-                        do_marki = true;
-                    }
-                }
-                if (fsi->fs_ops->seek)
-                    offi = fsi->fs_ops->seek(hdli, offi, SEEK_SET);
-            }
-        }
+static void stop_copy_writer(struct copy_writer* writer) {
+    writer->stop = true;
+    DkEventSet(writer->ready);
+    wait_copy_writer(writer);
 
-        if (do_mapo && !bufo) {
-            boffo = offo - ALLOC_ALIGN_DOWN(offo);
-
-            if (fso->fs_ops->mmap(hdlo, &bufo, ALLOC_ALIGN_UP(bufsize + boffo), PROT_WRITE,
-                                  MAP_FILE, offo - boffo) < 0) {
-                do_mapo = false;
-                boffo = 0;
-                if ((hdlo->flags & O_NONBLOCK) && fso->fs_ops->setflags) {
-                    int ret = fso->fs_ops->setflags(hdlo, 0);
-                    if (!ret) {
-                        debug("mark handle %s as blocking\n", qstrgetstr(&hdlo->uri));
-                        do_marko = true;
-                    }
-                }
-                if (fso->fs_ops->seek)
-                    offo = fso->fs_ops->seek(hdlo, offo, SEEK_SET);
-            }
-        }
+    lock(&writer->lock);
+    unlock(&writer->lock);
+    DkObjectClose(writer->ready);
+    DkObjectClose(writer->done);
+    destroy_lock(&writer->lock);
+}
 
-        if (do_mapi && do_mapo) {
-            copysize = count - bytes > bufsize ? bufsize : count - bytes;
-            memcpy(bufo + boffo, bufi + boffi, copysize);
-            DkVirtualMemoryFree(bufi, ALLOC_ALIGN_UP(bufsize + boffi));
-            bufi = NULL;
-            DkVirtualMemoryFree(bufo, ALLOC_ALIGN_UP(bufsize + boffo));
-            bufo = NULL;
-        } else if (do_mapo) {
-            copysize = fsi->fs_ops->read(hdli, bufo + boffo, bufsize);
-            DkVirtualMemoryFree(bufo, ALLOC_ALIGN_UP(bufsize + boffo));
-            bufo = NULL;
-            if (copysize < 0)
-                break;
-        } else if (do_mapi) {
-            copysize = fso->fs_ops->write(hdlo, bufi + boffi, bufsize);
-            DkVirtualMemoryFree(bufi, ALLOC_ALIGN_UP(bufsize + boffi));
-            bufi = NULL;
-            if (copysize < 0)
-                break;
-        } else {
-            if (!bufi)
-                bufi = __alloca((bufsize = (bufsize > BUF_SIZE) ? BUF_SIZE : bufsize));
+/*
+ * Copies up to `count` bytes from `hdli` to `hdlo` through LibOS, in chunks of a size which suits
+ * both handles. Files which can be read at an offset are read ahead: from the fourth chunk on, a
+ * writer thread writes a chunk while the next one is read into the other buffer. If `offseti`/
+ * `offseto` is given, it is used and updated; handles without positional I/O are then moved to it.
+ */
+static ssize_t handle_copy(struct shim_handle* hdli, off_t* offseti, struct shim_handle* hdlo,
+                           off_t* offseto, size_t count) {
+    struct shim_mount* fsi = hdli->fs;
+    struct shim_mount* fso = hdlo->fs;
 
-            copysize = fsi->fs_ops->read(hdli, bufi, bufsize);
+    if (!count)
+        return 0;
 
-            if (copysize <= 0)
-                break;
+    if (!fsi || !fsi->fs_ops || !fsi->fs_ops->read || !fso || !fso->fs_ops ||
+        !fso->fs_ops->write)
+        return -EACCES;
+
+    struct copy_end in;
+    struct copy_end out;
+    ssize_t ret;
+
+    if ((ret = init_copy_end(&in, hdli, offseti, /*write=*/false)) < 0)
+        return ret;
+    if ((ret = init_copy_end(&out, hdlo, offseto, /*write=*/true)) < 0) {
+        fini_copy_end(&in, NULL);
+        return ret;
+    }
+
+    off_t starti = in.off;
+    size_t chunk = MIN(copy_chunk_size(hdli), copy_chunk_size(hdlo));
+    char* bufs[2] = {get_copy_buf(), NULL};
+    if (!bufs[0]) {
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    struct copy_writer writer;
+    bool overlap  = false;
+    size_t bytes  = 0; /* written */
+    size_t queued = 0; /* handed to the writer and not written yet */
+    int cur = 0;
 
-            expectsize = copysize;
-            copysize = fso->fs_ops->write(hdlo, bufi, expectsize);
-            if (copysize < 0)
+    while (bytes + queued < count) {
+        size_t size = MIN(chunk, count - bytes - queued);
+        ret = copy_read(&in, bufs[cur], size);
+        if (ret <= 0)
+            break;
+
+        /* only input at an offset can be read ahead: what is not written is then not lost */
+        if (!overlap && in.positional && bytes >= (COPY_OVERLAP_MIN_CHUNKS - 1) * chunk &&
+            count - bytes > chunk) {
+            bufs[1] = get_copy_buf();
+            overlap = bufs[1] && start_copy_writer(&writer, &out) == 0;
+        }
+
+        if (!overlap) {
+            ssize_t written = copy_write(&out, bufs[cur], ret);
+            if (written > 0)
+                bytes += written;
+            if (written < ret) {
+                ret = written;
                 break;
+            }
+        } else {
+            if (queued) {
+                ssize_t written = wait_copy_writer(&writer);
+                if (written > 0)
+                    bytes += written;
+                if (written < (ssize_t)queued) {
+                    queued = 0;
+                    ret = written;
+                    break;
+                }
+            }
+            hand_copy_writer(&writer, bufs[cur], ret);
+            queued = ret;
+            cur ^= 1;
         }
 
-        debug("copy %d bytes\n", copysize);
-        bytes += copysize;
-        offi += copysize;
-        offo += copysize;
-        if (copysize < expectsize)
+        debug("copy %ld bytes\n", ret);
+        if ((size_t)ret < size)
             break;
-    } while (bytes < count);
+    }
 
-    if (copysize < 0 || (count > 0 && bytes < count)) {
-        int ret = copysize < 0 ? copysize : -EAGAIN;
+    if (queued) {
+        ssize_t written = wait_copy_writer(&writer);
+        if (written > 0)
+            bytes += written;
+        if (written < (ssize_t)queued)
+            ret = written;
+    }
+    if (overlap)
+        stop_copy_writer(&writer);
 
-        if (bytes) {
-            if (fsi->fs_ops->seek)
-                fsi->fs_ops->seek(hdli, offi - bytes, SEEK_SET);
-            if (fso->fs_ops->seek)
-                fso->fs_ops->seek(hdlo, offo - bytes, SEEK_SET);
-        }
+    /* the input may have been read further than the output was written */
+    if (in.positional)
+        in.off = starti + bytes;
 
-        return ret;
+    if (bytes)
+        ret = bytes;
+    else if (ret > 0)
+        ret = 0;
+
+out:
+    put_copy_buf(bufs[0]);
+    put_copy_buf(bufs[1]);
+    fini_copy_end(&in, offseti);
+    fini_copy_end(&out, offseto);
+    return ret;
+}
+
+/* Regular files (whose position LibOS keeps itself), pipes and connected stream sockets can be
+ * transferred between on the host with DkStreamTransfer(). */
+static bool handle_transferable(struct shim_handle* hdl, int acc_mode) {
+    if (!hdl->pal_handle || !hdl->fs || !hdl->fs->fs_ops)
+        return false;
+
+    switch (hdl->type) {
+        case TYPE_FILE:
+            return hdl->info.file.type == FILE_REGULAR && (hdl->acc_mode & acc_mode) &&
+                   hdl->fs->fs_ops->seek && hdl->fs->fs_ops->poll && hdl->fs->fs_ops->truncate;
+        case TYPE_PIPE:
+            return true;
+        case TYPE_SOCK:
+            return hdl->info.sock.sock_type == SOCK_STREAM &&
+                   (hdl->info.sock.sock_state == SOCK_CONNECTED ||
+                    hdl->info.sock.sock_state == SOCK_BOUNDCONNECTED ||
+                    hdl->info.sock.sock_state == SOCK_ACCEPTED);
+        default:
+            return false;
     }
+}
 
-    if (do_marki && (hdli->flags & O_NONBLOCK)) {
-        debug("mark handle %s as nonblocking\n", qstrgetstr(&hdli->uri));
-        fsi->fs_ops->setflags(hdli, O_NONBLOCK);
+/*
+ * Moves up to `count` bytes from `hdli` to `hdlo` on the host, so that the data never enters
+ * LibOS (nor the enclave on SGX). If `offseti`/`offseto` is given, it is used and updated instead
+ * of the file position of the handle. Returns -EOPNOTSUPP if the PAL cannot transfer between
+ * these handles (e.g. a trusted file on SGX), in which case nothing was transferred.
+ */
+static ssize_t handle_transfer(struct shim_handle* hdli, off_t* offseti, struct shim_handle* hdlo,
+                               off_t* offseto, size_t count) {
+    if (!handle_transferable(hdli, MAY_READ) || !handle_transferable(hdlo, MAY_WRITE))
+        return -EOPNOTSUPP;
+
+    bool filei = hdli->type == TYPE_FILE;
+    bool fileo = hdlo->type == TYPE_FILE;
+    off_t offi = 0;
+    off_t offo = 0;
+
+    if (filei && (offi = offseti ? *offseti : hdli->fs->fs_ops->seek(hdli, 0, SEEK_CUR)) < 0)
+        return offi;
+    if (fileo && (offo = offseto ? *offseto : hdlo->fs->fs_ops->seek(hdlo, 0, SEEK_CUR)) < 0)
+        return offo;
+
+    /* like sendfile() on Linux, keep going until the end of a file; pipes and sockets return
+     * whatever is available */
+    size_t bytes = 0;
+    while (bytes < count) {
+        PAL_NUM ret = DkStreamTransfer(hdli->pal_handle, offi + bytes, hdlo->pal_handle,
+                                       offo + bytes, count - bytes);
+        if (ret == PAL_STREAM_ERROR) {
+            if (bytes)
+                break;
+            return PAL_NATIVE_ERRNO == PAL_ERROR_NOTSUPPORT ? -EOPNOTSUPP : -PAL_ERRNO;
+        }
+        bytes += ret;
+        if (!ret || !filei)
+            break;
     }
 
-    if (do_marko && (hdlo->flags & O_NONBLOCK)) {
-        debug("mark handle %s as nonblocking\n", qstrgetstr(&hdlo->uri));
-        fso->fs_ops->setflags(hdlo, O_NONBLOCK);
+    if (filei) {
+        if (offseti)
+            *offseti = offi + bytes;
+        else
+            hdli->fs->fs_ops->seek(hdli, offi + bytes, SEEK_SET);
     }
 
-    if (do_mapi) {
-        if (fsi->fs_ops->seek)
-            fsi->fs_ops->seek(hdli, offi, SEEK_SET);
+    if (fileo) {
+        if (offseto)
+            *offseto = offo + bytes;
+        else
+            hdlo->fs->fs_ops->seek(hdlo, offo + bytes, SEEK_SET);
+
+        /* the host file grew behind LibOS' back, let it know the new size */
+        off_t size = hdlo->fs->fs_ops->poll(hdlo, FS_POLL_SZ);
+        if (size >= 0 && offo + (off_t)bytes > size)
+            hdlo->fs->fs_ops->truncate(hdlo, offo + bytes);
     }
 
-    if (offseti)
-        *offseti = offi;
+    return bytes;
+}
+
+/* Copies data between two handles: on the host if the PAL supports it, through LibOS otherwise.
+ * If `offseti`/`offseto` is given, it is used and updated, and the file position of the handle is
+ * left untouched. */
+static ssize_t do_handle_copy(struct shim_handle* hdli, off_t* offseti, struct shim_handle* hdlo,
+                              off_t* offseto, size_t count) {
+    ssize_t ret = handle_transfer(hdli, offseti, hdlo, offseto, count);
+    if (ret != -EOPNOTSUPP)
+        return ret;
+
+    /* handle_copy() may move the file positions to the given offsets, restore them afterwards */
+    off_t old_offi = 0;
+    off_t old_offo = 0;
+
+    if (offseti) {
+        if (!hdli->fs || !hdli->fs->fs_ops || !hdli->fs->fs_ops->seek)
+            return -EACCES;
+        if ((old_offi = hdli->fs->fs_ops->seek(hdli, 0, SEEK_CUR)) < 0)
+            return old_offi;
+    }
 
-    if (do_mapo) {
-        if (fso->fs_ops->seek)
-            fso->fs_ops->seek(hdlo, offo, SEEK_SET);
+    if (offseto) {
+        if (!hdlo->fs || !hdlo->fs->fs_ops || !hdlo->fs->fs_ops->seek)
+            return -EACCES;
+        if ((old_offo = hdlo->fs->fs_ops->seek(hdlo, 0, SEEK_CUR)) < 0)
+            return old_offo;
     }
 
-    if (offseto)
-        *offseto = offo;
+    ret = handle_copy(hdli, offseti, hdlo, offseto, count);
 
-    return bytes;
+    if (ret >= 0 && offseti)
+        hdli->fs->fs_ops->seek(hdli, old_offi, SEEK_SET);
+    if (ret >= 0 && offseto)
+        hdlo->fs->fs_ops->seek(hdlo, old_offo, SEEK_SET);
+
+    return ret;
 }
 
 static int do_rename(struct shim_dentry* old_dent, struct shim_dentry* new_dent) {
@@ -657,34 +908,93 @@ out:
 }
 
 ssize_t shim_do_sendfile(int ofd, int ifd, off_t* offset, size_t count) {
+    if (offset && test_user_memory(offset, sizeof(*offset), true))
+        return -EFAULT;
+
     struct shim_handle* hdli = get_fd_handle(ifd, NULL, NULL);
     struct shim_handle* hdlo = get_fd_handle(ofd, NULL, NULL);
+    ssize_t ret = -EBADF;
 
     if (!hdli || !hdlo)
-        return -EBADF;
+        goto out;
 
-    off_t old_offset = 0;
-    int ret = -EACCES;
+    ret = do_handle_copy(hdli, offset, hdlo, NULL, count);
 
-    if (offset) {
-        if (!hdli->fs || !hdli->fs->fs_ops || !hdli->fs->fs_ops->seek)
-            goto out;
+out:
+    if (hdli)
+        put_handle(hdli);
+    if (hdlo)
+        put_handle(hdlo);
+    return ret;
+}
 
-        old_offset = hdli->fs->fs_ops->seek(hdli, 0, SEEK_CUR);
-        if (old_offset < 0) {
-            ret = old_offset;
-            goto out;
-        }
-    }
+ssize_t shim_do_splice(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out, size_t len,
+                       unsigned int flags) {
+    __UNUSED(flags); /* SPLICE_F_* are only hints */
+    static_assert(sizeof(loff_t) == sizeof(off_t), "loff_t and off_t differ");
+
+    if ((off_in && test_user_memory(off_in, sizeof(*off_in), true)) ||
+        (off_out && test_user_memory(off_out, sizeof(*off_out), true)))
+        return -EFAULT;
+
+    struct shim_handle* hdli = get_fd_handle(fd_in, NULL, NULL);
+    struct shim_handle* hdlo = get_fd_handle(fd_out, NULL, NULL);
+    ssize_t ret = -EBADF;
+
+    if (!hdli || !hdlo)
+        goto out;
 
-    ret = handle_copy(hdli, offset, hdlo, NULL, count);
+    /* one of the ends must be a pipe, which cannot be given an offset */
+    ret = -EINVAL;
+    if (hdli->type != TYPE_PIPE && hdlo->type != TYPE_PIPE)
+        goto out;
+
+    ret = -ESPIPE;
+    if ((off_in && hdli->type == TYPE_PIPE) || (off_out && hdlo->type == TYPE_PIPE))
+        goto out;
+
+    ret = len ? do_handle_copy(hdli, (off_t*)off_in, hdlo, (off_t*)off_out, len) : 0;
+
+out:
+    if (hdli)
+        put_handle(hdli);
+    if (hdlo)
+        put_handle(hdlo);
+    return ret;
+}
+
+ssize_t shim_do_copy_file_range(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out, size_t len,
+                                unsigned int flags) {
+    if (flags)
+        return -EINVAL;
+
+    if ((off_in && test_user_memory(off_in, sizeof(*off_in), true)) ||
+        (off_out && test_user_memory(off_out, sizeof(*off_out), true)))
+        return -EFAULT;
+
+    struct shim_handle* hdli = get_fd_handle(fd_in, NULL, NULL);
+    struct shim_handle* hdlo = get_fd_handle(fd_out, NULL, NULL);
+    ssize_t ret = -EBADF;
+
+    if (!hdli || !hdlo)
+        goto out;
+
+    if (!(hdli->acc_mode & MAY_READ) || !(hdlo->acc_mode & MAY_WRITE) ||
+        (hdlo->flags & O_APPEND))
+        goto out;
+
+    ret = -EINVAL;
+    if (hdli->type != TYPE_FILE || hdlo->type != TYPE_FILE ||
+        hdli->info.file.type != FILE_REGULAR || hdlo->info.file.type != FILE_REGULAR)
+        goto out;
 
-    if (ret >= 0 && offset)
-        hdli->fs->fs_ops->seek(hdli, old_offset, SEEK_SET);
+    ret = len ? do_handle_copy(hdli, (off_t*)off_in, hdlo, (off_t*)off_out, len) : 0;
 
 out:
-    put_handle(hdli);
-    put_handle(hdlo);
+    if (hdli)
+        put_handle(hdli);
+    if (hdlo)
+        put_handle(hdlo);
     return ret;
 }
 
@@ -17,7 +17,7 @@
 /*
  * shim_mmap.c
  *
- * Implementation of system call "mmap", "munmap" and "mprotect".
+ * Implementation of system call "mmap", "munmap", "mprotect", "mremap" and "madvise".
  */
 
 #include <errno.h>
@@ -27,10 +27,15 @@
 #include <shim_handle.h>
 #include <shim_internal.h>
 #include <shim_table.h>
+#include <shim_utils.h>
 #include <shim_vma.h>
 #include <stdatomic.h>
 #include <sys/mman.h>
 
+#ifndef MADV_FREE
+#define MADV_FREE 8
+#endif
+
 void* shim_do_mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset) {
     struct shim_handle* hdl = NULL;
     long ret                = 0;
@@ -128,14 +133,19 @@ void* shim_do_mmap(void* addr, size_t length, int prot, int flags, int fd, off_t
         ret = hdl->fs->fs_ops->mmap(hdl, &ret_addr, length, PAL_PROT(prot, flags), flags, offset);
     }
 
-    if (hdl)
-        put_handle(hdl);
-
     if (ret < 0) {
+        if (hdl)
+            put_handle(hdl);
         bkeep_munmap(addr, length, flags);
         return (void*)ret;
     }
 
+    /* code mapped by ld.so; anonymous memory has no code in it yet */
+    if (hdl) {
+        rewrite_syscalls(hdl, ret_addr, length, offset, prot, flags);
+        put_handle(hdl);
+    }
+
     return ret_addr;
 }
 
@@ -173,30 +183,260 @@ int shim_do_munmap(void* addr, size_t length) {
     if (!IS_ALLOC_ALIGNED(length))
         length = ALLOC_ALIGN_UP(length);
 
-    struct shim_vma_val vma;
-
-    if (lookup_overlap_vma(addr, length, &vma) < 0) {
+    /* reserving the area also makes sure it does not overlap with internal mappings */
+    int ret = bkeep_munmap_reserve(addr, length, 0);
+    if (ret == -ENOENT) {
         debug("can't find addr %p - %p in map, quit unmapping\n", addr, addr + length);
 
         /* Really not an error */
         return -EFAULT;
     }
+    if (ret < 0)
+        return -EPERM;
 
-    /* lookup_overlap_vma() calls __dump_vma() which adds a reference to file */
-    if (vma.file)
-        put_handle(vma.file);
+    DkVirtualMemoryFree(addr, length);
 
-    /* Protect first to make sure no overlapping with internal
-     * mappings */
-    if (bkeep_mprotect(addr, length, PROT_NONE, 0) < 0)
-        return -EPERM;
+    bkeep_munmap_commit(addr, length, 0);
+    return 0;
+}
+
+/*
+ * Allocates [addr, addr + length) for the mapping described by "vma", as the continuation of the
+ * mapping at file offset "offset". The bookkeeping must already cover the area.
+ */
+static int mremap_map_area(const struct shim_vma_val* vma, void* addr, size_t length,
+                           off_t offset) {
+    if (!vma->file) {
+        if (!DkVirtualMemoryAlloc(addr, length, 0, PAL_PROT(vma->prot, 0)))
+            return -PAL_ERRNO;
+        return 0;
+    }
+
+    struct shim_handle* hdl = vma->file;
+    if (!hdl->fs || !hdl->fs->fs_ops || !hdl->fs->fs_ops->mmap)
+        return -ENODEV;
+
+    int flags = vma->flags & ~VMA_TAINTED;
+    return hdl->fs->fs_ops->mmap(hdl, &addr, length, PAL_PROT(vma->prot, flags), flags, offset);
+}
 
+/*
+ * Moves the pages of [addr, addr + length) to "new_addr". The PAL moves them without copying where
+ * the host allows it; if it fails, e.g. because the host mapping is split underneath a single VMA,
+ * plain anonymous read-write memory (the realloc() case) is copied instead.
+ */
+static int mremap_move_pages(const struct shim_vma_val* vma, void* addr, void* new_addr,
+                             size_t length) {
+    if (DkVirtualMemoryRemap(addr, new_addr, length))
+        return 0;
+
+    int ret = -PAL_ERRNO;
+    if (vma->file || (vma->prot & (PROT_READ | PROT_WRITE)) != (PROT_READ | PROT_WRITE))
+        return ret;
+
+    if (!DkVirtualMemoryAlloc(new_addr, length, 0, PAL_PROT(vma->prot, 0)))
+        return -PAL_ERRNO;
+
+    memcpy(new_addr, addr, length);
     DkVirtualMemoryFree(addr, length);
+    return 0;
+}
+
+void* shim_do_mremap(void* addr, size_t old_len, size_t new_len, int flags, void* new_addr) {
+    if (!addr || !IS_ALLOC_ALIGNED_PTR(addr))
+        return (void*)-EINVAL;
+
+    if (flags & ~(MREMAP_MAYMOVE | MREMAP_FIXED))
+        return (void*)-EINVAL;
+
+    if ((flags & MREMAP_FIXED) && !(flags & MREMAP_MAYMOVE))
+        return (void*)-EINVAL;
+
+    /* duplicating a shared mapping (old_len == 0) is not supported */
+    if (!old_len || !new_len)
+        return (void*)-EINVAL;
+
+    old_len = ALLOC_ALIGN_UP(old_len);
+    new_len = ALLOC_ALIGN_UP(new_len);
+    if (!old_len || !new_len)
+        return (void*)-EINVAL;
+
+    if (!access_ok(addr, old_len))
+        return (void*)-EFAULT;
+
+    if (flags & MREMAP_FIXED) {
+        if (!IS_ALLOC_ALIGNED_PTR(new_addr) || new_addr < PAL_CB(user_address.start) ||
+            PAL_CB(user_address.end) <= new_addr ||
+            (uintptr_t)PAL_CB(user_address.end) - (uintptr_t)new_addr < new_len)
+            return (void*)-EINVAL;
+
+        /* the old and the new ranges must not overlap */
+        if (new_addr < addr + old_len && addr < new_addr + new_len)
+            return (void*)-EINVAL;
+    }
+
+    struct shim_vma_val vma;
+    if (lookup_vma(addr, &vma) < 0)
+        return (void*)-EFAULT;
+
+    /* lookup_vma() calls __dump_vma() which adds a reference to file; it is kept until the end of
+     * the call since the file may have to be mapped again */
+    void* ret_addr = NULL;
+    long ret = 0;
+
+    if ((vma.flags & (VMA_INTERNAL | VMA_UNMAPPED)) || addr + old_len > vma.addr + vma.length) {
+        ret = -EFAULT;
+        goto out;
+    }
+
+    off_t offset = vma.file ? vma.offset + (addr - vma.addr) : 0;
+
+    if (!(flags & MREMAP_FIXED)) {
+        if (new_len <= old_len) {
+            /* shrinking (or keeping) the mapping never moves it */
+            if (new_len < old_len && (ret = shim_do_munmap(addr + new_len, old_len - new_len)) < 0)
+                goto out;
+            ret_addr = addr;
+            goto out;
+        }
 
-    if (bkeep_munmap(addr, length, 0) < 0)
+        /* try to grow the mapping in place first, which needs no moving at all */
+        ret = bkeep_mremap_grow(addr, old_len, new_len, 0);
+        if (!ret) {
+            ret = mremap_map_area(&vma, addr + old_len, new_len - old_len, offset + old_len);
+            if (ret < 0) {
+                bkeep_munmap(addr + old_len, new_len - old_len, 0);
+                goto out;
+            }
+            ret_addr = addr;
+            goto out;
+        }
+
+        if (ret != -ENOMEM)
+            goto out;
+
+        if (!(flags & MREMAP_MAYMOVE))
+            goto out;
+
+        new_addr = bkeep_unmapped_heap(new_len, vma.prot, vma.flags, vma.file, offset,
+                                       vma.comment);
+        if (!new_addr) {
+            ret = -ENOMEM;
+            goto out;
+        }
+    } else {
+        ret = bkeep_mmap(new_addr, new_len, vma.prot, vma.flags, vma.file, offset, vma.comment);
+        if (ret < 0)
+            goto out;
+    }
+
+    /* the bookkeeping of the new range is in place; allocate the part that grows first, so that
+     * nothing has been moved yet if it fails */
+    size_t move_len = old_len < new_len ? old_len : new_len;
+    if (new_len > old_len) {
+        ret = mremap_map_area(&vma, new_addr + old_len, new_len - old_len, offset + old_len);
+        if (ret < 0) {
+            bkeep_munmap(new_addr, new_len, 0);
+            goto out;
+        }
+    }
+
+    ret = mremap_move_pages(&vma, addr, new_addr, move_len);
+    if (ret < 0) {
+        if (new_len > old_len)
+            DkVirtualMemoryFree(new_addr + old_len, new_len - old_len);
+        bkeep_munmap(new_addr, new_len, 0);
+        goto out;
+    }
+
+    if (old_len > move_len)
+        DkVirtualMemoryFree(addr + move_len, old_len - move_len);
+
+    if (bkeep_munmap(addr, old_len, 0) < 0)
         BUG();
 
-    return 0;
+    ret_addr = new_addr;
+out:
+    if (vma.file)
+        put_handle(vma.file);
+    return ret < 0 ? (void*)ret : ret_addr;
+}
+
+/*
+ * MADV_DONTNEED and MADV_FREE let allocators give memory back without unmapping it. Both discard
+ * the contents of private anonymous memory, which reads as zeros afterwards (for MADV_FREE, zeros
+ * are one of the allowed outcomes). Shared and file-backed mappings keep their contents, since
+ * their pages are not owned by this process alone. The other advice values are hints only.
+ */
+int shim_do_madvise(void* start, size_t len, int behavior) {
+    if (!IS_ALLOC_ALIGNED_PTR(start))
+        return -EINVAL;
+
+    if (!len)
+        return 0;
+
+    len = ALLOC_ALIGN_UP(len);
+    if (!len || !access_ok(start, len))
+        return -EINVAL;
+
+    switch (behavior) {
+        case MADV_NORMAL:
+        case MADV_RANDOM:
+        case MADV_SEQUENTIAL:
+        case MADV_WILLNEED:
+        case MADV_DONTFORK:
+        case MADV_DOFORK:
+        case MADV_MERGEABLE:
+        case MADV_UNMERGEABLE:
+        case MADV_HUGEPAGE:
+        case MADV_NOHUGEPAGE:
+        case MADV_DONTDUMP:
+        case MADV_DODUMP:
+        case MADV_DONTNEED:
+        case MADV_FREE:
+            break;
+        default:
+            return -EINVAL;
+    }
+
+    /* walk the VMAs overlapping [start, start + len); holes make the call fail with -ENOMEM, but
+     * like on Linux the mapped parts are still advised */
+    bool discard = behavior == MADV_DONTNEED || behavior == MADV_FREE;
+    void* cur = start;
+    void* end = start + len;
+    int ret = 0;
+
+    while (cur < end) {
+        struct shim_vma_val vma;
+        if (lookup_overlap_vma(cur, end - cur, &vma) < 0) {
+            ret = -ENOMEM;
+            break;
+        }
+
+        /* lookup_overlap_vma() calls __dump_vma() which adds a reference to file */
+        if (vma.file)
+            put_handle(vma.file);
+
+        if (vma.addr > cur)
+            ret = -ENOMEM;
+
+        void* vma_start = vma.addr > cur ? vma.addr : cur;
+        void* vma_end = vma.addr + vma.length < end ? vma.addr + vma.length : end;
+
+        if (vma.flags & VMA_UNMAPPED) {
+            ret = -ENOMEM;
+        } else if (vma.flags & VMA_INTERNAL) {
+            ret = -EINVAL;
+            break;
+        } else if (discard && !vma.file && !(vma.flags & MAP_SHARED)) {
+            if (!DkVirtualMemoryDiscard(vma_start, vma_end - vma_start))
+                return -PAL_ERRNO;
+        }
+
+        cur = vma_end;
+    }
+
+    return ret;
 }
 
 /* This emulation of mincore() always tells that pages are _NOT_ in RAM
@@ -19,7 +19,8 @@
  *
  * Implementation of system call "read", "write", "open", "creat", "openat",
  * "close", "lseek", "pread64", "pwrite64", "getdents", "getdents64",
- * "fsync", "truncate" and "ftruncate".
+ * "fsync", "truncate", "ftruncate", "fallocate", "fadvise64", "readahead" and
+ * "sync_file_range".
  */
 
 #include <shim_internal.h>
@@ -37,6 +38,8 @@
 
 #include <linux/stat.h>
 #include <linux/fcntl.h>
+#include <linux/falloc.h>
+#include <linux/fadvise.h>
 
 int do_handle_read (struct shim_handle * hdl, void * buf, int count)
 {
@@ -228,10 +231,16 @@ ssize_t shim_do_pread64 (int fd, char * buf, size_t count, loff_t pos)
         goto out;
     }
 
-    if (!fs->fs_ops->read)
+    if (hdl->type == TYPE_DIR)
         goto out;
 
-    if (hdl->type == TYPE_DIR)
+    /* positional I/O does not race with other users of the file position */
+    if (fs->fs_ops->pread) {
+        ret = fs->fs_ops->pread(hdl, buf, count, pos);
+        goto out;
+    }
+
+    if (!fs->fs_ops->read)
         goto out;
 
     int offset = fs->fs_ops->seek(hdl, 0, SEEK_CUR);
@@ -279,10 +288,16 @@ ssize_t shim_do_pwrite64 (int fd, char * buf, size_t count, loff_t pos)
         goto out;
     }
 
-    if (!fs->fs_ops->write)
+    if (hdl->type == TYPE_DIR)
         goto out;
 
-    if (hdl->type == TYPE_DIR)
+    /* positional I/O does not race with other users of the file position */
+    if (fs->fs_ops->pwrite) {
+        ret = fs->fs_ops->pwrite(hdl, buf, count, pos);
+        goto out;
+    }
+
+    if (!fs->fs_ops->write)
         goto out;
 
     int offset = fs->fs_ops->seek(hdl, 0, SEEK_CUR);
@@ -632,3 +647,139 @@ out:
     put_handle(hdl);
     return ret;
 }
+
+int shim_do_fallocate(int fd, int mode, loff_t offset, loff_t len) {
+    if (offset < 0 || len <= 0)
+        return -EINVAL;
+
+    /* only plain preallocation and punching holes are supported; like Linux, a hole must be
+     * punched without changing the file size */
+    if (mode & ~(FALLOC_FL_KEEP_SIZE | FALLOC_FL_PUNCH_HOLE))
+        return -EOPNOTSUPP;
+    if ((mode & FALLOC_FL_PUNCH_HOLE) && !(mode & FALLOC_FL_KEEP_SIZE))
+        return -EOPNOTSUPP;
+
+    if (offset > INT64_MAX - len)
+        return -EFBIG;
+
+    struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
+    if (!hdl)
+        return -EBADF;
+
+    struct shim_mount* fs = hdl->fs;
+    int ret;
+
+    if (!(hdl->acc_mode & MAY_WRITE)) {
+        ret = -EBADF;
+        goto out;
+    }
+
+    if (hdl->type == TYPE_DIR) {
+        ret = -EISDIR;
+        goto out;
+    }
+
+    if (hdl->type == TYPE_PIPE || hdl->type == TYPE_SOCK) {
+        ret = -ESPIPE;
+        goto out;
+    }
+
+    if (!fs || !fs->fs_ops || !fs->fs_ops->fallocate) {
+        ret = hdl->type == TYPE_FILE ? -EOPNOTSUPP : -ENODEV;
+        goto out;
+    }
+
+    ret = fs->fs_ops->fallocate(hdl, mode, offset, len);
+out:
+    put_handle(hdl);
+    return ret;
+}
+
+int shim_do_fadvise64(int fd, loff_t offset, size_t len, int advice) {
+    struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
+    if (!hdl)
+        return -EBADF;
+
+    struct shim_mount* fs = hdl->fs;
+    int ret = 0;
+
+    if (hdl->type == TYPE_PIPE || hdl->type == TYPE_SOCK) {
+        ret = -ESPIPE;
+        goto out;
+    }
+
+    if (advice < POSIX_FADV_NORMAL || advice > POSIX_FADV_NOREUSE ||
+        offset < 0 || (loff_t)len < 0) {
+        ret = -EINVAL;
+        goto out;
+    }
+
+    /* the advice is only a hint: file systems which cannot use it ignore it */
+    if (fs && fs->fs_ops && fs->fs_ops->fadvise)
+        ret = fs->fs_ops->fadvise(hdl, offset, len, advice);
+out:
+    put_handle(hdl);
+    return ret;
+}
+
+int shim_do_readahead(int fd, loff_t offset, size_t count) {
+    struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
+    if (!hdl)
+        return -EBADF;
+
+    struct shim_mount* fs = hdl->fs;
+    int ret;
+
+    if (!(hdl->acc_mode & MAY_READ)) {
+        ret = -EBADF;
+        goto out;
+    }
+
+    if (hdl->type != TYPE_FILE || !fs || !fs->fs_ops || !fs->fs_ops->fadvise) {
+        ret = -EINVAL;
+        goto out;
+    }
+
+    if (offset < 0) {
+        ret = -EINVAL;
+        goto out;
+    }
+
+    ret = count ? fs->fs_ops->fadvise(hdl, offset, count, POSIX_FADV_WILLNEED) : 0;
+out:
+    put_handle(hdl);
+    return ret;
+}
+
+int shim_do_sync_file_range(int fd, loff_t offset, loff_t nbytes, int flags) {
+    if (flags & ~(SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                  SYNC_FILE_RANGE_WAIT_AFTER))
+        return -EINVAL;
+
+    if (offset < 0 || nbytes < 0 || offset > INT64_MAX - nbytes)
+        return -EINVAL;
+
+    struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
+    if (!hdl)
+        return -EBADF;
+
+    struct shim_mount* fs = hdl->fs;
+    int ret = 0;
+
+    if (hdl->type != TYPE_FILE && hdl->type != TYPE_DIR && hdl->type != TYPE_DEV) {
+        ret = -ESPIPE;
+        goto out;
+    }
+
+    if (!flags || !fs || !fs->fs_ops)
+        goto out;
+
+    /* file systems without a ranged writeback fall back to flushing the whole file */
+    if (fs->fs_ops->sync_range)
+        ret = fs->fs_ops->sync_range(hdl, offset, nbytes, flags);
+    else if (fs->fs_ops->flush && hdl->type != TYPE_DIR)
+        ret = fs->fs_ops->flush(hdl);
+out:
+    put_handle(hdl);
+    return ret;
+}
@@ -96,8 +96,6 @@ int shim_do_poll(struct pollfd* fds, nfds_t nfds, int timeout_ms) {
     nfds_t pal_cnt  = 0;
     nfds_t nrevents = 0;
 
-    lock(&map->lock);
-
     /* collect PAL handles that correspond to user-supplied FDs (only those that can be polled) */
     for (nfds_t i = 0; i < nfds; i++) {
         fds[i].revents = 0;
@@ -108,10 +106,14 @@ int shim_do_poll(struct pollfd* fds, nfds_t nfds, int timeout_ms) {
             continue;
         }
 
-        struct shim_handle* hdl = __get_fd_handle(fds[i].fd, NULL, map);
+        /* lock-free lookup, so that polling many FDs does not serialize against other threads
+         * opening and closing FDs */
+        struct shim_handle* hdl = get_fd_handle(fds[i].fd, NULL, map);
         if (!hdl || !hdl->fs || !hdl->fs->fs_ops) {
             /* The corresponding handle doesn't exist or doesn't provide FS-like semantics; do not
              * include it in handles-to-poll array but notify user about invalid request. */
+            if (hdl)
+                put_handle(hdl);
             fds[i].revents = POLLNVAL;
             nrevents++;
             continue;
@@ -134,6 +136,7 @@ int shim_do_poll(struct pollfd* fds, nfds_t nfds, int timeout_ms) {
             if (shim_revents & FS_POLL_WR)
                 fds[i].revents |= fds[i].events & (POLLOUT | POLLWRNORM);
 
+            put_handle(hdl);
             nrevents++;
             continue;
         }
@@ -148,10 +151,10 @@ int shim_do_poll(struct pollfd* fds, nfds_t nfds, int timeout_ms) {
             /* If user requested read/write events but they are not allowed on this handle, ignore
              * this handle (but note that user may only be interested in errors, and this is a valid
              * request). */
+            put_handle(hdl);
             continue;
         }
 
-        get_handle(hdl);
         fds_mapping[i].hdl = hdl;
         fds_mapping[i].idx = pal_cnt;
         pals[pal_cnt] = hdl->pal_handle;
@@ -160,16 +163,14 @@ int shim_do_poll(struct pollfd* fds, nfds_t nfds, int timeout_ms) {
         pal_cnt++;
     }
 
-    unlock(&map->lock);
-
     PAL_BOL polled = DkStreamsWaitEvents(pal_cnt, pals, pal_events, ret_events, timeout_us);
 
     /* update fds.revents, but only if something was actually polled */
-    if (polled) {
-        for (nfds_t i = 0; i < nfds; i++) {
-            if (!fds_mapping[i].hdl)
-                continue;
+    for (nfds_t i = 0; i < nfds; i++) {
+        if (!fds_mapping[i].hdl)
+            continue;
 
+        if (polled) {
             fds[i].revents = 0;
             if (ret_events[fds_mapping[i].idx] & PAL_WAIT_ERROR)
                 fds[i].revents |= POLLERR | POLLHUP;
@@ -180,9 +181,9 @@ int shim_do_poll(struct pollfd* fds, nfds_t nfds, int timeout_ms) {
 
             if (fds[i].revents)
                 nrevents++;
-
-            put_handle(fds_mapping[i].hdl);
         }
+
+        put_handle(fds_mapping[i].hdl);
     }
 
     free(pals);
@@ -251,17 +252,17 @@ int shim_do_select(int nfds, fd_set* readfds, fd_set* writefds, fd_set* errorfds
     /* select()/pselect() return -EBADF if invalid FD was given by user in readfds/writefds;
      * note that poll()/ppoll() don't have this error code, so we return this code only here */
     struct shim_handle_map* map = get_cur_thread()->handle_map;
-    lock(&map->lock);
     for (nfds_t i = 0; i < nfds_poll; i++) {
-        struct shim_handle* hdl = __get_fd_handle(fds_poll[i].fd, NULL, map);
-        if (!hdl || !hdl->fs || !hdl->fs->fs_ops) {
+        struct shim_handle* hdl = get_fd_handle(fds_poll[i].fd, NULL, map);
+        bool valid = hdl && hdl->fs && hdl->fs->fs_ops;
+        if (hdl)
+            put_handle(hdl);
+        if (!valid) {
             /* the corresponding handle doesn't exist or doesn't provide FS-like semantics */
             free(fds_poll);
-            unlock(&map->lock);
             return -EBADF;
         }
     }
-    unlock(&map->lock);
 
     uint64_t timeout_ms = tsv ? tsv->tv_sec * 1000ULL + tsv->tv_usec / 1000 : POLL_NOTIMEOUT;
     int ret = shim_do_poll(fds_poll, nfds_poll, timeout_ms);
@@ -30,6 +30,8 @@
 #include <pal.h>
 #include <shim_internal.h>
 #include <shim_table.h>
+#include <shim_thread.h>
+#include <shim_utils.h>
 
 int shim_do_sched_yield(void) {
     DkThreadYieldExecution();
@@ -150,6 +152,13 @@ int shim_do_sched_rr_get_interval(pid_t pid, struct timespec* interval) {
     return 0;
 }
 
+/* Online CPUs may be numbered sparsely, so masks must cover the highest CPU number */
+static int get_cpu_mask_bits(void) {
+    PAL_CPU_TOPO* topo = PAL_CB(cpu_info.cpu_topology);
+    int ncpus = PAL_CB(cpu_info.cpu_num);
+    return topo ? (int)topo[ncpus - 1].id + 1 : ncpus;
+}
+
 static int check_affinity_params(int ncpus, size_t len, __kernel_cpu_set_t* user_mask_ptr) {
     /* Check that user_mask_ptr is valid; if not, should return -EFAULT */
     if (test_user_memory(user_mask_ptr, len, true))
@@ -168,32 +177,117 @@ static int check_affinity_params(int ncpus, size_t len, __kernel_cpu_set_t* user
     return bitmask_size_in_bytes;
 }
 
-/* dummy implementation: ignore user-supplied mask and return success */
+/* Host kernels reject masks smaller than their number of possible CPUs, which may exceed the
+ * number of online ones; getaffinity goes through a buffer of at least this size */
+#define HOST_CPUMASK_MIN_SIZE 128UL
+
+/* Finds the PAL thread of `pid` (0 is the caller, represented by NULL). Only threads of the
+ * current process can be pinned. */
+static int get_affinity_thread(pid_t pid, struct shim_thread** out) {
+    *out = NULL;
+    if (pid < 0)
+        return -ESRCH;
+    if (!pid || pid == (pid_t)get_cur_thread()->tid)
+        return 0;
+
+    struct shim_thread* thread = lookup_thread(pid);
+    if (!thread)
+        return -ESRCH;
+    if (!thread->in_vm || !thread->pal_handle) {
+        put_thread(thread);
+        return -EPERM;
+    }
+    *out = thread;
+    return 0;
+}
+
 int shim_do_sched_setaffinity(pid_t pid, size_t len, __kernel_cpu_set_t* user_mask_ptr) {
-    __UNUSED(pid);
-    int ncpus = PAL_CB(cpu_info.cpu_num);
+    int ncpus = get_cpu_mask_bits();
 
     int bitmask_size_in_bytes = check_affinity_params(ncpus, len, user_mask_ptr);
     if (bitmask_size_in_bytes < 0)
         return bitmask_size_in_bytes;
 
-    return 0;
+    struct shim_thread* thread;
+    int ret = get_affinity_thread(pid, &thread);
+    if (ret < 0)
+        return ret;
+
+    /* bits beyond the online CPUs are ignored by the host, as by Linux */
+    if (!DkThreadSetCpuAffinity(thread ? thread->pal_handle : NULL, bitmask_size_in_bytes,
+                                user_mask_ptr))
+        ret = -PAL_ERRNO;
+
+    if (thread)
+        put_thread(thread);
+    return ret;
 }
 
-/* dummy implementation: always return all-ones (as many as there are host CPUs)  */
 int shim_do_sched_getaffinity(pid_t pid, size_t len, __kernel_cpu_set_t* user_mask_ptr) {
-    __UNUSED(pid);
-    int ncpus = PAL_CB(cpu_info.cpu_num);
+    int ncpus = get_cpu_mask_bits();
 
     int bitmask_size_in_bytes = check_affinity_params(ncpus, len, user_mask_ptr);
     if (bitmask_size_in_bytes < 0)
         return bitmask_size_in_bytes;
 
-    memset(user_mask_ptr, 0, len);
-    for (int i = 0; i < ncpus; i++) {
-        ((uint8_t*)user_mask_ptr)[i / 8] |= 1 << (i % 8);
+    struct shim_thread* thread;
+    int ret = get_affinity_thread(pid, &thread);
+    if (ret < 0)
+        return ret;
+
+    size_t mask_size = MAX((size_t)bitmask_size_in_bytes, HOST_CPUMASK_MIN_SIZE);
+    unsigned long* mask = __alloca(mask_size);
+    memset(mask, 0, mask_size);
+
+    if (!DkThreadGetCpuAffinity(thread ? thread->pal_handle : NULL, mask_size, mask)) {
+        ret = -PAL_ERRNO;
+        goto out;
     }
+
+    memset(user_mask_ptr, 0, len);
+    memcpy(user_mask_ptr, mask, bitmask_size_in_bytes);
     /* imitate the Linux kernel implementation
      * See SYSCALL_DEFINE3(sched_getaffinity) */
-    return bitmask_size_in_bytes;
+    ret = bitmask_size_in_bytes;
+out:
+    if (thread)
+        put_thread(thread);
+    return ret;
+}
+
+/* "auto" keeps helpers on the hyper-threads of the last physical core, away from the cores that
+ * applications and the host usually fill first */
+static void get_auto_helper_cpus(unsigned long* mask, size_t bits) {
+    PAL_CPU_TOPO* topo = PAL_CB(cpu_info.cpu_topology);
+    size_t ncpus = PAL_CB(cpu_info.cpu_num);
+
+    if (!topo) {
+        if (ncpus - 1 < bits)
+            mask[(ncpus - 1) / (sizeof(long) * 8)] |= 1UL << ((ncpus - 1) % (sizeof(long) * 8));
+        return;
+    }
+
+    PAL_CPU_TOPO* last = &topo[ncpus - 1];
+    for (size_t i = 0; i < ncpus; i++)
+        if (topo[i].socket == last->socket && topo[i].core == last->core && topo[i].id < bits)
+            mask[topo[i].id / (sizeof(long) * 8)] |= 1UL << (topo[i].id % (sizeof(long) * 8));
+}
+
+void pin_helper_thread(void) {
+    char cfg[CONFIG_MAX];
+    if (!root_config || get_config(root_config, "sys.helper_cpus", cfg, sizeof(cfg)) <= 0)
+        return;
+
+    unsigned long mask[HOST_CPUMASK_MIN_SIZE / sizeof(long)] = {0};
+    size_t bits = HOST_CPUMASK_MIN_SIZE * 8;
+
+    if (!strcmp_static(cfg, "auto")) {
+        get_auto_helper_cpus(mask, bits);
+    } else if (parse_cpu_mask(cfg, mask, bits) < 0) {
+        debug("invalid sys.helper_cpus \"%s\", helper threads are not pinned\n", cfg);
+        return;
+    }
+
+    if (!DkThreadSetCpuAffinity(NULL, sizeof(mask), mask))
+        debug("pinning helper thread to sys.helper_cpus failed (%ld)\n", -PAL_ERRNO);
 }
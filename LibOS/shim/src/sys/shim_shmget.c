@@ -0,0 +1,464 @@
+/* Copyright (C) 2014 Stony Brook University
+   This file is part of Graphene Library OS.
+
+   Graphene Library OS is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   Graphene Library OS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/*
+ * shim_shmget.c
+ *
+ * Implementation of system call "shmget", "shmat", "shmdt" and "shmctl".
+ *
+ * Keys and identifiers of segments are managed by the SysV namespace, like for message queues
+ * and semaphores. The data of segment <id> lives in the PAL shared memory object "shm:sysv-<id>",
+ * which every process of the instance can open by itself: each attachment opens the object and
+ * maps it shared. The VMA of an attachment refers to a TYPE_SHM handle, so fork() maps the object
+ * again in the child instead of copying the memory.
+ *
+ * IPC_RMID deletes the host object right away: attachments keep the memory, and the host frees
+ * it with the last of them. Objects which are never removed are deleted by the PAL when the last
+ * process of the instance exits. Hosts which cannot share memory between processes (Linux-SGX:
+ * memory outside the enclave is not protected) refuse "shm:" objects, and shmget() fails with
+ * -ENOSYS there.
+ */
+
+#include <errno.h>
+#include <linux/ipc.h>
+#include <linux/shm.h>
+#include <list.h>
+#include <pal.h>
+#include <pal_error.h>
+#include <shim_fs.h>
+#include <shim_handle.h>
+#include <shim_internal.h>
+#include <shim_ipc.h>
+#include <shim_sysv.h>
+#include <shim_table.h>
+#include <shim_utils.h>
+#include <shim_vma.h>
+#include <sys/mman.h>
+
+#define SHM_URI_SIZE (static_strlen(URI_PREFIX_SHM) + 16)
+
+struct shim_mount shm_builtin_fs;
+
+/* Attachments of this process, used to answer IPC_STAT (the number of attachments is only known
+ * for the current process). */
+DEFINE_LISTP(shim_shm_handle);
+static LISTP_TYPE(shim_shm_handle) shm_list = LISTP_INIT;
+static struct shim_lock shm_list_lock;
+
+static void shm_object_uri(IDTYPE shmid, char* uri) {
+    snprintf(uri, SHM_URI_SIZE, URI_PREFIX_SHM "sysv-%u", shmid);
+}
+
+/* Opens the host object of segment `shmid`; returns -ENOENT if it does not exist and `create` is
+ * not set, -EEXIST if it exists and `excl` is set and -ENOSYS if the host has no shared memory. */
+static int open_shm_object(IDTYPE shmid, bool create, bool excl, int perm, PAL_HANDLE* pal_hdl) {
+    char uri[SHM_URI_SIZE];
+    shm_object_uri(shmid, uri);
+
+    int pal_create = create ? (PAL_CREATE_TRY | (excl ? PAL_CREATE_ALWAYS : 0)) : 0;
+    PAL_HANDLE hdl = DkStreamOpen(uri, PAL_ACCESS_RDWR,
+                                  (perm & PAL_SHARE_MASK) | PAL_SHARE_OWNER_R | PAL_SHARE_OWNER_W,
+                                  pal_create, 0);
+    if (!hdl) {
+        if (PAL_NATIVE_ERRNO == PAL_ERROR_NOTSUPPORT) {
+            debug("host has no shared memory, SysV shm is not supported\n");
+            return -ENOSYS;
+        }
+        return -PAL_ERRNO;
+    }
+
+    *pal_hdl = hdl;
+    return 0;
+}
+
+static int query_shm_object(PAL_HANDLE pal_hdl, size_t* size, int* perm) {
+    PAL_STREAM_ATTR attr;
+    bool ok = DkStreamAttributesQueryByHandle(pal_hdl, &attr);
+
+    /* set on failure, too: the compiler cannot tell that -PAL_ERRNO is negative */
+    *size = ok ? attr.pending_size : 0;
+    if (perm)
+        *perm = ok ? attr.share_flags & PAL_SHARE_MASK : 0;
+    return ok ? 0 : -PAL_ERRNO;
+}
+
+/* Creates the host object of a new segment, or checks an existing one. */
+static int create_shm_object(IDTYPE shmid, size_t size, int shmflg) {
+    bool create = !!(shmflg & IPC_CREAT);
+    bool excl   = (shmflg & (IPC_CREAT | IPC_EXCL)) == (IPC_CREAT | IPC_EXCL);
+
+    PAL_HANDLE pal_hdl;
+    int ret = open_shm_object(shmid, create, excl, shmflg & 0777, &pal_hdl);
+    if (ret < 0)
+        return ret;
+
+    size_t cur_size;
+    if ((ret = query_shm_object(pal_hdl, &cur_size, NULL)) < 0)
+        goto out;
+
+    if (!cur_size) {
+        /* freshly created by us (or by a racing shmget() which sets the same size) */
+        if (size < SHMMIN) {
+            ret = -EINVAL;
+            DkStreamDelete(pal_hdl, 0);
+            goto out;
+        }
+        if (DkStreamSetLength(pal_hdl, size) != size) {
+            ret = -PAL_ERRNO;
+            DkStreamDelete(pal_hdl, 0);
+            goto out;
+        }
+    } else if (size > cur_size) {
+        ret = -EINVAL;
+    }
+
+out:
+    DkObjectClose(pal_hdl);
+    return ret;
+}
+
+static struct shim_handle* new_shm_handle(IDTYPE shmid, unsigned long key, size_t size,
+                                          int perm) {
+    struct shim_handle* hdl = get_new_handle();
+    if (!hdl)
+        return NULL;
+
+    hdl->type     = TYPE_SHM;
+    hdl->flags    = O_RDWR;
+    hdl->acc_mode = MAY_READ | MAY_WRITE;
+    set_handle_fs(hdl, &shm_builtin_fs);
+
+    char uri[SHM_URI_SIZE];
+    shm_object_uri(shmid, uri);
+    qstrsetstr(&hdl->uri, uri, strlen(uri));
+
+    struct shim_shm_handle* shm = &hdl->info.shm;
+    shm->shmkey  = key;
+    shm->shmid   = shmid;
+    shm->size    = ALLOC_ALIGN_UP(size);
+    shm->perm    = perm;
+    shm->nattch  = 0;
+    INIT_LIST_HEAD(shm, list);
+    return hdl;
+}
+
+int shim_do_shmget(key_t key, size_t size, int shmflg) {
+    IDTYPE shmid = 0;
+    int ret;
+
+    if (!create_lock_runtime(&shm_list_lock)) {
+        return -ENOMEM;
+    }
+
+    struct sysv_key k;
+    k.key  = key;
+    k.type = SYSV_SHM;
+
+    while (true) {
+        if (key != IPC_PRIVATE) {
+            ret = ipc_sysv_findkey_send(&k);
+            if (ret >= 0) {
+                /* the key is known; its segment may have been removed since, in which case
+                 * IPC_CREAT creates a new one under the same ID */
+                shmid = ret;
+                ret   = create_shm_object(shmid, size, shmflg);
+                return ret < 0 ? ret : (int)shmid;
+            }
+
+            if (ret != -ENOENT)
+                return ret;
+            if (!(shmflg & IPC_CREAT))
+                return -ENOENT;
+        }
+
+        do {
+            shmid = allocate_sysv(0, 0);
+            if (!shmid)
+                shmid = ipc_sysv_lease_send(NULL);
+        } while (!shmid);
+
+        if (key != IPC_PRIVATE) {
+            if ((ret = ipc_sysv_tellkey_send(NULL, 0, &k, shmid, 0)) < 0) {
+                release_sysv(shmid);
+                /* another process registered the key first, use its segment */
+                if (ret == -EEXIST)
+                    continue;
+                return ret;
+            }
+        }
+
+        ret = create_shm_object(shmid, size, shmflg | IPC_CREAT | IPC_EXCL);
+        return ret < 0 ? ret : (int)shmid;
+    }
+}
+
+/* Returns a new reference to the handle to attach segment `shmid` with. */
+static int get_attach_handle(IDTYPE shmid, struct shim_handle** hdlp) {
+    PAL_HANDLE pal_hdl;
+    int ret = open_shm_object(shmid, /*create=*/false, /*excl=*/false, 0, &pal_hdl);
+    if (ret < 0)
+        return ret == -ENOENT ? -EINVAL : ret;
+
+    size_t size;
+    int perm;
+    if ((ret = query_shm_object(pal_hdl, &size, &perm)) < 0) {
+        DkObjectClose(pal_hdl);
+        return ret;
+    }
+
+    struct shim_handle* hdl = new_shm_handle(shmid, IPC_PRIVATE, size, perm);
+    if (!hdl) {
+        DkObjectClose(pal_hdl);
+        return -ENOMEM;
+    }
+
+    hdl->pal_handle = pal_hdl;
+    *hdlp = hdl;
+    return 0;
+}
+
+void* shim_do_shmat(int shmid, const void* shmaddr, int shmflg) {
+    void* addr = (void*)shmaddr;
+    int ret;
+
+    if (shmid < 0)
+        return (void*)-EINVAL;
+
+    if (addr && !IS_ALLOC_ALIGNED_PTR(addr)) {
+        if (!(shmflg & SHM_RND))
+            return (void*)-EINVAL;
+        addr = ALLOC_ALIGN_DOWN_PTR(addr);
+    }
+
+    if ((shmflg & SHM_REMAP) && !addr)
+        return (void*)-EINVAL;
+
+    if (!create_lock_runtime(&shm_list_lock)) {
+        return (void*)-ENOMEM;
+    }
+
+    int prot = (shmflg & SHM_RDONLY) ? PROT_READ : PROT_READ | PROT_WRITE;
+    if (shmflg & SHM_EXEC)
+        prot |= PROT_EXEC;
+
+    struct shim_handle* hdl;
+    if ((ret = get_attach_handle(shmid, &hdl)) < 0)
+        return (void*)(long)ret;
+
+    struct shim_shm_handle* shm = &hdl->info.shm;
+    size_t size = shm->size;
+
+    if (addr) {
+        struct shim_vma_val tmp;
+        if (addr < PAL_CB(user_address.start) || PAL_CB(user_address.end) <= addr ||
+            (uintptr_t)PAL_CB(user_address.end) - (uintptr_t)addr < size) {
+            ret = -EINVAL;
+            goto out;
+        }
+        if (!(shmflg & SHM_REMAP) && !lookup_overlap_vma(addr, size, &tmp)) {
+            if (tmp.file)
+                put_handle(tmp.file);
+            ret = -EINVAL;
+            goto out;
+        }
+        if ((ret = bkeep_mmap(addr, size, prot, MAP_SHARED, hdl, 0, "shm")) < 0)
+            goto out;
+    } else {
+        addr = bkeep_unmapped_heap(size, prot, MAP_SHARED, hdl, 0, "shm");
+        if (!addr) {
+            ret = -ENOMEM;
+            goto out;
+        }
+    }
+
+    void* ret_addr = addr;
+    ret = shm_builtin_fs.fs_ops->mmap(hdl, &ret_addr, size, PAL_PROT(prot, MAP_SHARED), MAP_SHARED,
+                                      0);
+    if (ret < 0) {
+        bkeep_munmap(addr, size, 0);
+        goto out;
+    }
+
+    lock(&shm_list_lock);
+    shm->nattch++;
+    get_handle(hdl);
+    LISTP_ADD_TAIL(shm, &shm_list, list);
+    unlock(&shm_list_lock);
+out:
+    put_handle(hdl);
+    return ret < 0 ? (void*)(long)ret : addr;
+}
+
+int shim_do_shmdt(const void* shmaddr) {
+    void* addr = (void*)shmaddr;
+
+    if (!addr || !IS_ALLOC_ALIGNED_PTR(addr))
+        return -EINVAL;
+
+    struct shim_vma_val vma;
+    if (lookup_vma(addr, &vma) < 0)
+        return -EINVAL;
+
+    struct shim_handle* hdl = vma.file;
+    if (!hdl || hdl->type != TYPE_SHM || vma.addr != addr || vma.offset) {
+        if (hdl)
+            put_handle(hdl);
+        return -EINVAL;
+    }
+
+    struct shim_shm_handle* shm = &hdl->info.shm;
+
+    lock(&shm_list_lock);
+    DkVirtualMemoryFree(addr, shm->size);
+    bkeep_munmap(addr, shm->size, 0);
+    if (!LIST_EMPTY(shm, list)) {
+        LISTP_DEL_INIT(shm, &shm_list, list);
+        put_handle(hdl);
+    }
+    shm->nattch--;
+    unlock(&shm_list_lock);
+
+    put_handle(hdl);
+    return 0;
+}
+
+static int stat_shm(IDTYPE shmid, struct shmid64_ds* ds) {
+    size_t size          = 0;
+    int perm             = 0;
+    unsigned long key    = IPC_PRIVATE;
+    unsigned long nattch = 0;
+
+    PAL_HANDLE pal_hdl;
+    int ret = open_shm_object(shmid, /*create=*/false, /*excl=*/false, 0, &pal_hdl);
+    if (ret < 0)
+        return ret == -ENOENT ? -EINVAL : ret;
+
+    ret = query_shm_object(pal_hdl, &size, &perm);
+    DkObjectClose(pal_hdl);
+    if (ret < 0)
+        return ret;
+
+    struct shim_shm_handle* shm;
+    lock(&shm_list_lock);
+    LISTP_FOR_EACH_ENTRY(shm, &shm_list, list) {
+        if (shm->shmid != shmid)
+            continue;
+        nattch += shm->nattch;
+        if (shm->shmkey != IPC_PRIVATE)
+            key = shm->shmkey;
+    }
+    unlock(&shm_list_lock);
+
+    memset(ds, 0, sizeof(*ds));
+    ds->shm_perm.key  = key;
+    ds->shm_perm.mode = perm;
+    ds->shm_segsz     = size;
+    ds->shm_nattch    = nattch;
+    return 0;
+}
+
+static int remove_shm(IDTYPE shmid) {
+    PAL_HANDLE pal_hdl;
+    int ret = open_shm_object(shmid, /*create=*/false, /*excl=*/false, 0, &pal_hdl);
+    if (ret < 0)
+        return ret == -ENOENT ? -EINVAL : ret;
+
+    /* existing attachments keep the memory, new shmat() calls fail */
+    DkStreamDelete(pal_hdl, 0);
+    DkObjectClose(pal_hdl);
+    return 0;
+}
+
+int shim_do_shmctl(int shmid, int cmd, struct shmid_ds* buf) {
+    int ret;
+
+    if (shmid < 0)
+        return -EINVAL;
+
+    if (!create_lock_runtime(&shm_list_lock)) {
+        return -ENOMEM;
+    }
+
+    /* the 64-bit layout (struct shmid64_ds) is the only one on x86-64 */
+    switch (cmd & ~IPC_64) {
+        case IPC_RMID:
+            return remove_shm(shmid);
+
+        case IPC_STAT:
+        case SHM_STAT:
+        case SHM_STAT_ANY: {
+            if (!buf || test_user_memory(buf, sizeof(struct shmid64_ds), /*write=*/true))
+                return -EFAULT;
+
+            struct shmid64_ds ds;
+            if ((ret = stat_shm(shmid, &ds)) < 0)
+                return ret;
+
+            memcpy(buf, &ds, sizeof(ds));
+            return (cmd & ~IPC_64) == IPC_STAT ? 0 : shmid;
+        }
+
+        case IPC_SET: {
+            if (!buf || test_user_memory(buf, sizeof(struct shmid64_ds), /*write=*/false))
+                return -EFAULT;
+
+            struct shmid64_ds ds;
+            if ((ret = stat_shm(shmid, &ds)) < 0)
+                return ret;
+
+            /* only the permissions can be changed; they are not enforced between processes of
+             * one instance anyway */
+            return 0;
+        }
+
+        case SHM_LOCK:
+        case SHM_UNLOCK:
+            /* the host decides what is resident, there is no swap to lock against */
+            return 0;
+
+        default:
+            return -EINVAL;
+    }
+}
+
+static int shm_mmap(struct shim_handle* hdl, void** addr, size_t size, int prot, int flags,
+                    off_t offset) {
+    void* alloc_addr =
+        (void*)DkStreamMap(hdl->pal_handle, *addr, PAL_PROT(prot, flags), offset, size);
+    if (!alloc_addr)
+        return -PAL_ERRNO;
+
+    *addr = alloc_addr;
+    return 0;
+}
+
+static int shm_hstat(struct shim_handle* hdl, struct stat* stat) {
+    memset(stat, 0, sizeof(*stat));
+    stat->st_mode    = S_IFREG | hdl->info.shm.perm;
+    stat->st_size    = hdl->info.shm.size;
+    stat->st_blksize = ALLOC_ALIGNMENT;
+    return 0;
+}
+
+struct shim_fs_ops shm_fs_ops = {
+    .mmap  = &shm_mmap,
+    .hstat = &shm_hstat,
+};
+
+struct shim_mount shm_builtin_fs = {
+    .type   = URI_TYPE_SHM,
+    .fs_ops = &shm_fs_ops,
+};
@@ -0,0 +1,285 @@
+/* Copyright (C) 2014 Stony Brook University
+   This file is part of Graphene Library OS.
+
+   Graphene Library OS is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   Graphene Library OS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/*
+ * shim_signalfd.c
+ *
+ * Implementation of system calls "signalfd" and "signalfd4".
+ *
+ * A signalfd reads the blocked signals queued for the threads of the current process (signals
+ * sent to the process are queued for one of its threads, see do_kill_proc()). The PAL handle of a
+ * signalfd is an event which is made readable by signalfd_notify() whenever a signal of its mask
+ * is queued as blocked, so signalfds can be waited on with poll(), select() and epoll.
+ */
+
+#include <asm/fcntl.h>
+#include <errno.h>
+#include <linux/signalfd.h>
+
+#include <pal.h>
+#include <pal_error.h>
+#include <shim_fs.h>
+#include <shim_handle.h>
+#include <shim_internal.h>
+#include <shim_signal.h>
+#include <shim_table.h>
+#include <shim_thread.h>
+#include <shim_utils.h>
+
+struct shim_mount signalfd_builtin_fs;
+
+/* signalfds of this process; the lock is a leaf lock, see signalfd_notify() */
+DEFINE_LISTP(shim_signalfd_handle);
+static LISTP_TYPE(shim_signalfd_handle) signalfd_list = LISTP_INIT;
+static struct shim_lock signalfd_list_lock;
+
+void signalfd_notify(int sig) {
+    if (!lock_created(&signalfd_list_lock))
+        return;
+
+    /* A host signal may interrupt this thread while it holds the lock; drop the notification
+     * rather than deadlock. This only delays readers which are already being woken up. */
+    if (lock_enabled && locked(&signalfd_list_lock))
+        return;
+
+    lock(&signalfd_list_lock);
+    struct shim_signalfd_handle* sfd;
+    LISTP_FOR_EACH_ENTRY(sfd, &signalfd_list, list) {
+        if (__sigismember(&sfd->mask, sig))
+            set_event(&sfd->event, 1);
+    }
+    unlock(&signalfd_list_lock);
+}
+
+static void add_signalfd(struct shim_signalfd_handle* sfd) {
+    create_lock_runtime(&signalfd_list_lock);
+    lock(&signalfd_list_lock);
+    INIT_LIST_HEAD(sfd, list);
+    LISTP_ADD_TAIL(sfd, &signalfd_list, list);
+    unlock(&signalfd_list_lock);
+}
+
+struct fetch_signal_arg {
+    struct shim_thread* current;
+    const __sigset_t* mask;
+    siginfo_t* info;
+    int sig;
+};
+
+static int __fetch_signal(struct shim_thread* thread, void* arg, bool* unlocked) {
+    __UNUSED(unlocked);
+    struct fetch_signal_arg* farg = (struct fetch_signal_arg*)arg;
+
+    if (farg->sig || thread == farg->current || thread->tgid != farg->current->tgid ||
+            !thread->in_vm || !thread->is_alive)
+        return 0;
+
+    farg->sig = fetch_pending_signal(thread, farg->mask, farg->info);
+    return farg->sig ? 1 : 0;
+}
+
+/* dequeue a signal of `mask` queued for the current thread or, failing that, for another thread of
+ * the process */
+static int fetch_signal(const __sigset_t* mask, siginfo_t* info) {
+    struct shim_thread* cur = get_cur_thread();
+
+    int sig = fetch_pending_signal(cur, mask, info);
+    if (sig)
+        return sig;
+
+    struct fetch_signal_arg arg = {.current = cur, .mask = mask, .info = info, .sig = 0};
+    walk_thread_list(__fetch_signal, &arg);
+    return arg.sig;
+}
+
+static int __signal_pending(struct shim_thread* thread, void* arg, bool* unlocked) {
+    __UNUSED(unlocked);
+    struct fetch_signal_arg* farg = (struct fetch_signal_arg*)arg;
+
+    if (farg->sig || thread->tgid != farg->current->tgid || !thread->in_vm || !thread->signal_logs)
+        return 0;
+
+    for (int sig = 1; sig <= NUM_SIGS; sig++) {
+        if (sig != SIGCP && __sigismember(farg->mask, sig) &&
+                signal_logs_pending(thread->signal_logs, sig)) {
+            farg->sig = sig;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Make the event of `sfd` readable iff a signal of its mask is pending. The event is drained
+ * first, so a signal queued concurrently either is seen here or notifies the event afterwards. */
+static void update_signalfd_event(struct shim_signalfd_handle* sfd) {
+    clear_event(&sfd->event);
+
+    struct fetch_signal_arg arg = {.current = get_cur_thread(), .mask = &sfd->mask, .sig = 0};
+    walk_thread_list(__signal_pending, &arg);
+    if (arg.sig)
+        set_event(&sfd->event, 1);
+}
+
+static void copy_siginfo(struct signalfd_siginfo* ssi, const siginfo_t* info) {
+    memset(ssi, 0, sizeof(*ssi));
+    ssi->ssi_signo   = info->si_signo;
+    ssi->ssi_errno   = info->si_errno;
+    ssi->ssi_code    = info->si_code;
+    ssi->ssi_pid     = info->si_pid;
+    ssi->ssi_uid     = info->si_uid;
+    ssi->ssi_status  = info->si_status;
+    ssi->ssi_int     = info->si_int;
+    ssi->ssi_ptr     = (uint64_t)info->si_ptr;
+    ssi->ssi_addr    = (uint64_t)info->si_addr;
+}
+
+int shim_do_signalfd4(int ufd, __sigset_t* user_mask, size_t sizemask, int flags) {
+    if (sizemask != sizeof(__sigset_t) || (flags & ~(SFD_CLOEXEC | SFD_NONBLOCK)))
+        return -EINVAL;
+
+    if (!user_mask || test_user_memory(user_mask, sizeof(*user_mask), false))
+        return -EFAULT;
+
+    /* SIGKILL and SIGSTOP cannot be read from a signalfd; they are silently ignored */
+    __sigset_t mask = *user_mask;
+    __sigdelset(&mask, SIGKILL);
+    __sigdelset(&mask, SIGSTOP);
+
+    if (ufd != -1) {
+        struct shim_handle* hdl = get_fd_handle(ufd, NULL, NULL);
+        if (!hdl)
+            return -EBADF;
+        if (hdl->type != TYPE_SIGNALFD) {
+            put_handle(hdl);
+            return -EINVAL;
+        }
+
+        lock(&signalfd_list_lock);
+        hdl->info.signalfd.mask = mask;
+        unlock(&signalfd_list_lock);
+        update_signalfd_event(&hdl->info.signalfd);
+        put_handle(hdl);
+        return ufd;
+    }
+
+    struct shim_handle* hdl = get_new_handle();
+    if (!hdl)
+        return -ENOMEM;
+
+    struct shim_signalfd_handle* sfd = &hdl->info.signalfd;
+
+    hdl->type = TYPE_SIGNALFD;
+    set_handle_fs(hdl, &signalfd_builtin_fs);
+    hdl->flags    = O_RDONLY | (flags & SFD_NONBLOCK ? O_NONBLOCK : 0);
+    hdl->acc_mode = MAY_READ;
+    sfd->mask        = mask;
+    sfd->event.event = NULL;
+
+    /* signalfd_close() expects the signalfd in the list */
+    add_signalfd(sfd);
+
+    create_event(&sfd->event);
+    if (!event_created(&sfd->event)) {
+        put_handle(hdl);
+        return -PAL_ERRNO;
+    }
+    hdl->pal_handle = event_handle(&sfd->event);
+    update_signalfd_event(sfd);
+
+    int vfd = set_new_fd_handle(hdl, flags & SFD_CLOEXEC ? FD_CLOEXEC : 0, NULL);
+    put_handle(hdl);
+    return vfd;
+}
+
+int shim_do_signalfd(int ufd, __sigset_t* user_mask, size_t sizemask) {
+    return shim_do_signalfd4(ufd, user_mask, sizemask, 0);
+}
+
+static ssize_t signalfd_read(struct shim_handle* hdl, void* buf, size_t count) {
+    struct shim_signalfd_handle* sfd = &hdl->info.signalfd;
+    struct signalfd_siginfo* ssi     = (struct signalfd_siginfo*)buf;
+    size_t max = count / sizeof(*ssi);
+
+    if (!max)
+        return -EINVAL;
+
+    while (true) {
+        lock(&signalfd_list_lock);
+        __sigset_t mask = sfd->mask;
+        unlock(&signalfd_list_lock);
+
+        size_t n = 0;
+        siginfo_t info;
+        while (n < max && fetch_signal(&mask, &info)) {
+            copy_siginfo(&ssi[n], &info);
+            n++;
+        }
+
+        update_signalfd_event(sfd);
+        if (n)
+            return n * sizeof(*ssi);
+
+        if (hdl->flags & O_NONBLOCK)
+            return -EAGAIN;
+
+        PAL_HANDLE event = event_handle(&sfd->event);
+        PAL_FLG events   = PAL_WAIT_READ;
+        PAL_FLG ret_events;
+        if (!DkStreamsWaitEvents(1, &event, &events, &ret_events, NO_TIMEOUT))
+            return -PAL_ERRNO;
+    }
+}
+
+static int signalfd_close(struct shim_handle* hdl) {
+    /* the event itself is closed with the PAL handle */
+    lock(&signalfd_list_lock);
+    LISTP_DEL(&hdl->info.signalfd, &signalfd_list, list);
+    unlock(&signalfd_list_lock);
+    return 0;
+}
+
+static int signalfd_checkout(struct shim_handle* hdl) {
+    /* the child creates its own event and joins its own list of signalfds */
+    hdl->pal_handle = NULL;
+    hdl->info.signalfd.event.event = NULL;
+    INIT_LIST_HEAD(&hdl->info.signalfd, list);
+    return 0;
+}
+
+static int signalfd_checkin(struct shim_handle* hdl) {
+    struct shim_signalfd_handle* sfd = &hdl->info.signalfd;
+
+    add_signalfd(sfd);
+
+    create_event(&sfd->event);
+    if (!event_created(&sfd->event))
+        return -PAL_ERRNO;
+    hdl->pal_handle = event_handle(&sfd->event);
+    return 0;
+}
+
+struct shim_fs_ops signalfd_fs_ops = {
+    .read     = &signalfd_read,
+    .close    = &signalfd_close,
+    .checkout = &signalfd_checkout,
+    .checkin  = &signalfd_checkin,
+};
+
+/* the type is limited to 7 characters by shim_handle.fs_type */
+struct shim_mount signalfd_builtin_fs = {
+    .type   = "sigfd",
+    .fs_ops = &signalfd_fs_ops,
+};
@@ -0,0 +1,293 @@
+/* Copyright (C) 2014 Stony Brook University
+   This file is part of Graphene Library OS.
+
+   Graphene Library OS is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   Graphene Library OS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/*
+ * shim_timerfd.c
+ *
+ * Implementation of system calls "timerfd_create", "timerfd_settime" and "timerfd_gettime".
+ *
+ * Timers are kept by the async helper (see async_timer in shim_async.c), which counts their
+ * expirations without waking up the owner of the timerfd. The PAL handle of a timerfd is an event
+ * which the helper makes readable when the count becomes non-zero, so timerfds can be waited on
+ * with poll(), select() and epoll like any other handle.
+ */
+
+#include <asm/fcntl.h>
+#include <errno.h>
+#include <linux/time.h>
+
+#include <pal.h>
+#include <pal_error.h>
+#include <shim_fs.h>
+#include <shim_handle.h>
+#include <shim_internal.h>
+#include <shim_table.h>
+#include <shim_utils.h>
+
+#ifndef TFD_TIMER_ABSTIME
+#define TFD_TIMER_ABSTIME       (1 << 0)
+#define TFD_TIMER_CANCEL_ON_SET (1 << 1)
+#define TFD_CLOEXEC             O_CLOEXEC
+#define TFD_NONBLOCK            O_NONBLOCK
+#endif
+
+#ifndef CLOCK_BOOTTIME_ALARM
+#define CLOCK_REALTIME_ALARM 8
+#define CLOCK_BOOTTIME_ALARM 9
+#endif
+
+struct shim_mount timerfd_builtin_fs;
+
+int shim_do_timerfd_create(int clockid, int flags) {
+    if (flags & ~(TFD_CLOEXEC | TFD_NONBLOCK))
+        return -EINVAL;
+
+    /* all clocks are the same (see shim_do_clock_gettime()) */
+    if (clockid != CLOCK_REALTIME && clockid != CLOCK_MONOTONIC && clockid != CLOCK_BOOTTIME &&
+            clockid != CLOCK_REALTIME_ALARM && clockid != CLOCK_BOOTTIME_ALARM)
+        return -EINVAL;
+
+    struct shim_handle* hdl = get_new_handle();
+    if (!hdl)
+        return -ENOMEM;
+
+    hdl->type = TYPE_TIMERFD;
+    set_handle_fs(hdl, &timerfd_builtin_fs);
+    hdl->flags    = O_RDONLY | (flags & TFD_NONBLOCK ? O_NONBLOCK : 0);
+    hdl->acc_mode = MAY_READ;
+    hdl->info.timerfd.clockid = clockid;
+    hdl->info.timerfd.timer   = NULL;
+
+    AEVENTTYPE event = {.event = NULL};
+    create_event(&event);
+    if (!event_created(&event)) {
+        put_handle(hdl);
+        return -PAL_ERRNO;
+    }
+    hdl->pal_handle = event_handle(&event);
+
+    int vfd = set_new_fd_handle(hdl, flags & TFD_CLOEXEC ? FD_CLOEXEC : 0, NULL);
+    put_handle(hdl);
+    return vfd;
+}
+
+static int get_timerfd_handle(int ufd, struct shim_handle** hdl) {
+    *hdl = get_fd_handle(ufd, NULL, NULL);
+    if (!*hdl)
+        return -EBADF;
+    if ((*hdl)->type != TYPE_TIMERFD) {
+        put_handle(*hdl);
+        return -EINVAL;
+    }
+    return 0;
+}
+
+static void usec_to_timespec(uint64_t usec, struct __kernel_timespec* ts) {
+    ts->tv_sec  = usec / 1000000;
+    ts->tv_nsec = (usec % 1000000) * 1000;
+}
+
+/* convert the absolute expiration time of a timer to the time left until it expires */
+static void fill_itimerspec(uint64_t expire_time, uint64_t interval, uint64_t now,
+                            struct __kernel_itimerspec* value) {
+    uint64_t left = 0;
+    if (expire_time) {
+        /* an expired timer which the helper has not processed yet is about to fire */
+        left = expire_time > now ? expire_time - now : 1;
+    }
+    usec_to_timespec(left, &value->it_value);
+    usec_to_timespec(interval, &value->it_interval);
+}
+
+static bool timespec_valid(const struct __kernel_timespec* ts) {
+    return ts->tv_sec >= 0 && ts->tv_nsec >= 0 && ts->tv_nsec < 1000000000;
+}
+
+/* round up, so that timers never expire early */
+static uint64_t timespec_to_usec(const struct __kernel_timespec* ts) {
+    return ts->tv_sec * 1000000ULL + (ts->tv_nsec + 999) / 1000;
+}
+
+int shim_do_timerfd_settime(int ufd, int flags, const struct __kernel_itimerspec* utmr,
+                            struct __kernel_itimerspec* otmr) {
+    if (flags & ~(TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET))
+        return -EINVAL;
+
+    if (!utmr || test_user_memory((void*)utmr, sizeof(*utmr), false))
+        return -EFAULT;
+
+    if (otmr && test_user_memory(otmr, sizeof(*otmr), true))
+        return -EFAULT;
+
+    if (!timespec_valid(&utmr->it_value) || !timespec_valid(&utmr->it_interval))
+        return -EINVAL;
+
+    struct shim_handle* hdl;
+    int ret = get_timerfd_handle(ufd, &hdl);
+    if (ret < 0)
+        return ret;
+
+    uint64_t now = DkSystemTimeQuery();
+    if ((int64_t)now < 0) {
+        ret = (int64_t)now;
+        goto out;
+    }
+
+    /* the clock is never set, so TFD_TIMER_CANCEL_ON_SET has nothing to report */
+    uint64_t value       = timespec_to_usec(&utmr->it_value);
+    uint64_t interval    = timespec_to_usec(&utmr->it_interval);
+    uint64_t expire_time = 0;
+    if (value) {
+        if (flags & TFD_TIMER_ABSTIME)
+            expire_time = value > now ? value : now;
+        else
+            expire_time = now + value;
+    }
+
+    lock(&hdl->lock);
+    struct async_timer* timer = hdl->info.timerfd.timer;
+    if (!timer) {
+        timer = create_async_timer(hdl->pal_handle);
+        if (!timer) {
+            unlock(&hdl->lock);
+            ret = -ENOMEM;
+            goto out;
+        }
+        hdl->info.timerfd.timer = timer;
+    }
+
+    uint64_t old_expire_time;
+    uint64_t old_interval;
+    ret = set_async_timer(timer, expire_time, interval, &old_expire_time, &old_interval);
+    unlock(&hdl->lock);
+    if (ret < 0)
+        goto out;
+
+    if (otmr)
+        fill_itimerspec(old_expire_time, old_interval, now, otmr);
+out:
+    put_handle(hdl);
+    return ret;
+}
+
+int shim_do_timerfd_gettime(int ufd, struct __kernel_itimerspec* otmr) {
+    if (!otmr || test_user_memory(otmr, sizeof(*otmr), true))
+        return -EFAULT;
+
+    struct shim_handle* hdl;
+    int ret = get_timerfd_handle(ufd, &hdl);
+    if (ret < 0)
+        return ret;
+
+    uint64_t now = DkSystemTimeQuery();
+    if ((int64_t)now < 0) {
+        ret = (int64_t)now;
+        goto out;
+    }
+
+    uint64_t expire_time = 0;
+    uint64_t interval    = 0;
+    lock(&hdl->lock);
+    if (hdl->info.timerfd.timer)
+        get_async_timer(hdl->info.timerfd.timer, &expire_time, &interval);
+    unlock(&hdl->lock);
+
+    fill_itimerspec(expire_time, interval, now, otmr);
+out:
+    put_handle(hdl);
+    return ret;
+}
+
+static ssize_t timerfd_read(struct shim_handle* hdl, void* buf, size_t count) {
+    if (count < sizeof(uint64_t))
+        return -EINVAL;
+
+    while (true) {
+        lock(&hdl->lock);
+        uint64_t expirations = 0;
+        if (hdl->info.timerfd.timer)
+            expirations = read_async_timer(hdl->info.timerfd.timer);
+        bool nonblocking = hdl->flags & O_NONBLOCK;
+        PAL_HANDLE event = hdl->pal_handle;
+        unlock(&hdl->lock);
+
+        if (expirations) {
+            memcpy(buf, &expirations, sizeof(expirations));
+            return sizeof(expirations);
+        }
+
+        if (nonblocking)
+            return -EAGAIN;
+
+        PAL_FLG events = PAL_WAIT_READ;
+        PAL_FLG ret_events;
+        if (!DkStreamsWaitEvents(1, &event, &events, &ret_events, NO_TIMEOUT))
+            return -PAL_ERRNO;
+    }
+}
+
+static off_t timerfd_poll(struct shim_handle* hdl, int poll_type) {
+    if (poll_type == FS_POLL_SZ)
+        return 0;
+
+    off_t ret = 0;
+    lock(&hdl->lock);
+    PAL_STREAM_ATTR attr;
+    if (!DkStreamAttributesQueryByHandle(hdl->pal_handle, &attr))
+        ret = -PAL_ERRNO;
+    else if ((poll_type & FS_POLL_RD) && attr.readable)
+        ret = FS_POLL_RD;
+    unlock(&hdl->lock);
+    return ret;
+}
+
+static int timerfd_close(struct shim_handle* hdl) {
+    /* the event itself is closed with the PAL handle */
+    if (hdl->info.timerfd.timer) {
+        destroy_async_timer(hdl->info.timerfd.timer);
+        hdl->info.timerfd.timer = NULL;
+    }
+    return 0;
+}
+
+static int timerfd_checkout(struct shim_handle* hdl) {
+    /* timers are not shared with child processes: the child gets a disarmed timerfd */
+    hdl->pal_handle         = NULL;
+    hdl->info.timerfd.timer = NULL;
+    return 0;
+}
+
+static int timerfd_checkin(struct shim_handle* hdl) {
+    AEVENTTYPE event = {.event = NULL};
+    create_event(&event);
+    if (!event_created(&event))
+        return -PAL_ERRNO;
+    hdl->pal_handle = event_handle(&event);
+    return 0;
+}
+
+struct shim_fs_ops timerfd_fs_ops = {
+    .read     = &timerfd_read,
+    .close    = &timerfd_close,
+    .checkout = &timerfd_checkout,
+    .checkin  = &timerfd_checkin,
+    .poll     = &timerfd_poll,
+};
+
+struct shim_mount timerfd_builtin_fs = {
+    .type   = "timerfd",
+    .fs_ops = &timerfd_fs_ops,
+};
@@ -17,7 +17,8 @@
 /*
  * shim_wrapper.c
  *
- * Implementation of system call "readv" and "writev".
+ * Implementation of system calls "readv", "writev", "preadv", "pwritev", "preadv2" and
+ * "pwritev2".
  */
 
 #include <errno.h>
@@ -29,30 +30,49 @@
 #include <shim_table.h>
 #include <shim_utils.h>
 
-ssize_t shim_do_readv(int fd, const struct iovec* vec, int vlen) {
+/* same limit as UIO_MAXIOV of Linux */
+#define MAX_IOVEC 1024
+
+static int check_iovec(const struct iovec* vec, int vlen, bool write) {
+    if (vlen < 0 || vlen > MAX_IOVEC)
+        return -EINVAL;
+
     if (!vec || test_user_memory((void*)vec, sizeof(*vec) * vlen, false))
         return -EINVAL;
 
     for (int i = 0; i < vlen; i++) {
-        if (vec[i].iov_base) {
-            if (vec[i].iov_base + vec[i].iov_len <= vec[i].iov_base)
-                return -EINVAL;
-            if (test_user_memory(vec[i].iov_base, vec[i].iov_len, true))
-                return -EFAULT;
-        }
+        if (!vec[i].iov_len)
+            continue;
+        if (!vec[i].iov_base)
+            return -EFAULT;
+        if (vec[i].iov_base + vec[i].iov_len <= vec[i].iov_base)
+            return -EINVAL;
+        /* readv() writes into the buffers, writev() reads from them */
+        if (test_user_memory(vec[i].iov_base, vec[i].iov_len, !write))
+            return -EFAULT;
     }
+    return 0;
+}
+
+ssize_t shim_do_readv(int fd, const struct iovec* vec, int vlen) {
+    int ret = check_iovec(vec, vlen, /*write=*/false);
+    if (ret < 0)
+        return ret;
 
     struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
     if (!hdl)
         return -EBADF;
 
-    int ret = 0;
-
     if (!(hdl->acc_mode & MAY_READ) || !hdl->fs || !hdl->fs->fs_ops || !hdl->fs->fs_ops->read) {
         ret = -EACCES;
         goto out;
     }
 
+    if (hdl->fs->fs_ops->readv) {
+        ret = hdl->fs->fs_ops->readv(hdl, vec, vlen);
+        goto out;
+    }
+
     ssize_t bytes = 0;
 
     for (int i = 0; i < vlen; i++) {
@@ -92,29 +112,25 @@ out:
  * shall remain unchanged, and errno shall be set to indicate an error
  */
 ssize_t shim_do_writev(int fd, const struct iovec* vec, int vlen) {
-    if (!vec || test_user_memory((void*)vec, sizeof(*vec) * vlen, false))
-        return -EINVAL;
-
-    for (int i = 0; i < vlen; i++) {
-        if (vec[i].iov_base) {
-            if (vec[i].iov_base + vec[i].iov_len < vec[i].iov_base)
-                return -EINVAL;
-            if (test_user_memory(vec[i].iov_base, vec[i].iov_len, false))
-                return -EFAULT;
-        }
-    }
+    int ret = check_iovec(vec, vlen, /*write=*/true);
+    if (ret < 0)
+        return ret;
 
     struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
     if (!hdl)
         return -EBADF;
 
-    int ret = 0;
-
     if (!(hdl->acc_mode & MAY_WRITE) || !hdl->fs || !hdl->fs->fs_ops || !hdl->fs->fs_ops->write) {
         ret = -EACCES;
         goto out;
     }
 
+    /* file systems with a writev() hand the whole vector to the host at once */
+    if (hdl->fs->fs_ops->writev) {
+        ret = hdl->fs->fs_ops->writev(hdl, vec, vlen);
+        goto out;
+    }
+
     ssize_t bytes = 0;
 
     for (int i = 0; i < vlen; i++) {
@@ -137,3 +153,90 @@ out:
     put_handle(hdl);
     return ret;
 }
+
+/* Positional vectored I/O. File systems without preadv()/pwritev() get one pread64()/pwrite64()
+ * per buffer, which also returns -ESPIPE for unseekable handles. */
+static ssize_t do_rwv_at(int fd, const struct iovec* vec, int vlen, loff_t pos, bool write) {
+    int ret = check_iovec(vec, vlen, write);
+    if (ret < 0)
+        return ret;
+
+    if (pos < 0)
+        return -EINVAL;
+
+    struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
+    if (!hdl)
+        return -EBADF;
+
+    struct shim_fs_ops* fs_ops = hdl->fs ? hdl->fs->fs_ops : NULL;
+    if (hdl->type != TYPE_DIR && fs_ops && (write ? fs_ops->pwritev : fs_ops->preadv)) {
+        ssize_t bytes = write ? fs_ops->pwritev(hdl, vec, vlen, pos)
+                              : fs_ops->preadv(hdl, vec, vlen, pos);
+        put_handle(hdl);
+        return bytes;
+    }
+    put_handle(hdl);
+
+    ssize_t bytes = 0;
+
+    for (int i = 0; i < vlen; i++) {
+        if (!vec[i].iov_len)
+            continue;
+
+        ssize_t b_vec = write ? shim_do_pwrite64(fd, vec[i].iov_base, vec[i].iov_len, pos + bytes)
+                              : shim_do_pread64(fd, vec[i].iov_base, vec[i].iov_len, pos + bytes);
+        if (b_vec < 0)
+            return bytes ?: b_vec;
+
+        bytes += b_vec;
+        if ((size_t)b_vec < vec[i].iov_len)
+            break;
+    }
+    return bytes;
+}
+
+ssize_t shim_do_preadv(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                       unsigned long pos_h) {
+    /* on x86-64, pos_l holds the whole offset */
+    __UNUSED(pos_h);
+    return do_rwv_at(fd, vec, vlen, (loff_t)pos_l, /*write=*/false);
+}
+
+ssize_t shim_do_pwritev(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                        unsigned long pos_h) {
+    __UNUSED(pos_h);
+    return do_rwv_at(fd, vec, vlen, (loff_t)pos_l, /*write=*/true);
+}
+
+/* RWF_HIPRI is only a hint and RWF_DSYNC/RWF_SYNC are honored by flushing after the write.
+ * RWF_NOWAIT and RWF_APPEND cannot be done through the PAL, so they are reported as not supported,
+ * like Linux does for file systems which lack them. */
+ssize_t shim_do_preadv2(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                        unsigned long pos_h, int flags) {
+    __UNUSED(pos_h);
+    if (flags & ~(RWF_HIPRI | RWF_DSYNC | RWF_SYNC))
+        return -EOPNOTSUPP;
+
+    loff_t pos = pos_l;
+    if (pos == -1)
+        return shim_do_readv(fd, vec, vlen);
+    return do_rwv_at(fd, vec, vlen, pos, /*write=*/false);
+}
+
+ssize_t shim_do_pwritev2(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                         unsigned long pos_h, int flags) {
+    __UNUSED(pos_h);
+    if (flags & ~(RWF_HIPRI | RWF_DSYNC | RWF_SYNC))
+        return -EOPNOTSUPP;
+
+    loff_t pos = pos_l;
+    ssize_t bytes = pos == -1 ? shim_do_writev(fd, vec, vlen)
+                              : do_rwv_at(fd, vec, vlen, pos, /*write=*/true);
+
+    if (bytes > 0 && (flags & (RWF_DSYNC | RWF_SYNC))) {
+        int ret = shim_do_fsync(fd);
+        if (ret < 0)
+            return ret;
+    }
+    return bytes;
+}
@@ -0,0 +1,136 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <fcntl.h>
+#include <linux/aio_abi.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define FILE_NAME     "aio_randread.tmp"
+#define FILE_SIZE     (64UL * 1024 * 1024)
+#define READ_SIZE     4096
+#define DEFAULT_DEPTH 32
+#define DURATION_SEC  3
+
+/* Measures random 4KB reads per second on a file, first with pread() one at a time and then
+ * with Linux AIO keeping [depth] reads in flight (default 32), submitted and reaped in batches.
+ * Usage: aio_randread [depth]. The file is created on the first run and reused afterwards. */
+
+static unsigned long long now_usec(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+static off_t random_offset(void) {
+    return (off_t)(random() % (FILE_SIZE / READ_SIZE)) * READ_SIZE;
+}
+
+static void prepare_file(void) {
+    int fd = open(FILE_NAME, O_RDWR | O_CREAT, 0600);
+    if (fd < 0)
+        err(1, "open");
+
+    off_t size = lseek(fd, 0, SEEK_END);
+    if (size < 0)
+        err(1, "lseek");
+    if ((unsigned long)size >= FILE_SIZE) {
+        close(fd);
+        return;
+    }
+
+    static char buf[1024 * 1024];
+    memset(buf, 'a', sizeof(buf));
+    for (unsigned long done = 0; done < FILE_SIZE; done += sizeof(buf))
+        if (pwrite(fd, buf, sizeof(buf), done) != sizeof(buf))
+            err(1, "pwrite");
+    close(fd);
+}
+
+static void report(const char* what, unsigned long reads, unsigned long long usec) {
+    printf("%-16s %10.0f reads/s\n", what, reads * 1000000.0 / usec);
+}
+
+int main(int argc, char** argv) {
+    int depth = argc > 1 ? atoi(argv[1]) : DEFAULT_DEPTH;
+    if (depth <= 0)
+        errx(1, "usage: %s [depth]", argv[0]);
+
+    prepare_file();
+
+    int fd = open(FILE_NAME, O_RDONLY);
+    if (fd < 0)
+        err(1, "open");
+
+    char* bufs = malloc((size_t)depth * READ_SIZE);
+    struct iocb* iocbs = calloc(depth, sizeof(*iocbs));
+    struct iocb** iocbps = calloc(depth, sizeof(*iocbps));
+    struct io_event* events = calloc(depth, sizeof(*events));
+    if (!bufs || !iocbs || !iocbps || !events)
+        errx(1, "out of memory");
+
+    unsigned long reads = 0;
+    unsigned long long start = now_usec();
+    unsigned long long end = start + DURATION_SEC * 1000000ULL;
+    while (now_usec() < end) {
+        for (int i = 0; i < 64; i++, reads++)
+            if (pread(fd, bufs, READ_SIZE, random_offset()) != READ_SIZE)
+                err(1, "pread");
+    }
+    report("pread", reads, now_usec() - start);
+
+    aio_context_t ctx = 0;
+    if (syscall(SYS_io_setup, depth, &ctx) < 0)
+        err(1, "io_setup");
+
+    for (int i = 0; i < depth; i++) {
+        iocbs[i].aio_lio_opcode = IOCB_CMD_PREAD;
+        iocbs[i].aio_fildes     = fd;
+        iocbs[i].aio_buf        = (uint64_t)(bufs + (size_t)i * READ_SIZE);
+        iocbs[i].aio_nbytes     = READ_SIZE;
+        iocbs[i].aio_offset     = random_offset();
+        iocbs[i].aio_data       = i;
+        iocbps[i] = &iocbs[i];
+    }
+
+    reads = 0;
+    start = now_usec();
+    end   = start + DURATION_SEC * 1000000ULL;
+    if (syscall(SYS_io_submit, ctx, depth, iocbps) != depth)
+        err(1, "io_submit");
+    int inflight = depth;
+
+    while (inflight) {
+        long n = syscall(SYS_io_getevents, ctx, 1, depth, events, NULL);
+        if (n < 0)
+            err(1, "io_getevents");
+        inflight -= n;
+
+        /* resubmit the completed reads at new offsets, as one batch */
+        bool more = now_usec() < end;
+        for (long i = 0; i < n; i++) {
+            if (events[i].res != READ_SIZE)
+                errx(1, "AIO read returned %lld", (long long)events[i].res);
+            reads++;
+            struct iocb* cb = &iocbs[events[i].data];
+            cb->aio_offset = random_offset();
+            iocbps[i] = cb;
+        }
+        if (more && n) {
+            if (syscall(SYS_io_submit, ctx, n, iocbps) != n)
+                err(1, "io_submit");
+            inflight += n;
+        }
+    }
+    report("aio", reads, now_usec() - start);
+    printf("(queue depth %d)\n", depth);
+
+    syscall(SYS_io_destroy, ctx);
+    close(fd);
+    return 0;
+}
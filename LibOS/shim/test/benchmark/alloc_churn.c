@@ -0,0 +1,102 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define ARENA_SIZE (128UL * 1024 * 1024)
+#define NBLOCKS    (32 * 1024)
+#define BLOCK_SIZE (4 * 1024)
+#define ROUNDS     10
+
+/* Measures how much memory an allocator gets back from the system after churn. Two workloads:
+ * an arena that is touched and then released with madvise(MADV_DONTNEED) (what jemalloc and
+ * tcmalloc do), and glibc malloc()/free() of small blocks followed by malloc_trim(). The footprint
+ * is the growth of the resident set from /proc/self/statm or, where that is not available (e.g.
+ * inside Graphene), of the used memory from /proc/meminfo. */
+
+static unsigned long long now_usec(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+/* resident set size if the (host) kernel reports it, otherwise memory in use system-wide */
+static long used_kb(void) {
+    long pages;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (f) {
+        int ok = fscanf(f, "%*s %ld", &pages) == 1;
+        fclose(f);
+        if (ok)
+            return pages * (sysconf(_SC_PAGESIZE) / 1024);
+    }
+
+    f = fopen("/proc/meminfo", "r");
+    if (!f)
+        err(1, "/proc/meminfo");
+    char line[128];
+    long total = -1, avail = -1;
+    while (fgets(line, sizeof(line), f)) {
+        sscanf(line, "MemTotal: %ld kB", &total);
+        sscanf(line, "MemFree: %ld kB", &avail);
+    }
+    fclose(f);
+    if (total < 0 || avail < 0)
+        errx(1, "no MemTotal/MemFree in /proc/meminfo");
+    return total - avail;
+}
+
+static void* blocks[NBLOCKS];
+
+int main(void) {
+    long base = used_kb();
+
+    char* arena = mmap(NULL, ARENA_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                       -1, 0);
+    if (arena == MAP_FAILED)
+        err(1, "mmap");
+    long touched_kb = 0;
+    unsigned long long madvise_usec = 0;
+    for (int r = 0; r < ROUNDS; r++) {
+        memset(arena, r + 1, ARENA_SIZE);
+        touched_kb = used_kb() - base;
+        unsigned long long start = now_usec();
+        if (madvise(arena, ARENA_SIZE, MADV_DONTNEED) < 0)
+            err(1, "madvise");
+        madvise_usec += now_usec() - start;
+    }
+    long released_kb = used_kb() - base;
+    printf("arena of %lu MB: footprint %ld kB touched, %ld kB after MADV_DONTNEED "
+           "(%.1f us per madvise)\n", ARENA_SIZE >> 20, touched_kb, released_kb,
+           (double)madvise_usec / ROUNDS);
+    munmap(arena, ARENA_SIZE);
+
+    base = used_kb();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < NBLOCKS; i++) {
+            blocks[i] = malloc(BLOCK_SIZE);
+            if (!blocks[i])
+                err(1, "malloc");
+            memset(blocks[i], r + 1, BLOCK_SIZE);
+        }
+        touched_kb = used_kb() - base;
+        /* keep every 64th block so that the heap cannot simply shrink from the top */
+        for (int i = 0; i < NBLOCKS; i++)
+            if (i % 64) {
+                free(blocks[i]);
+                blocks[i] = NULL;
+            }
+        malloc_trim(0);
+        for (int i = 0; i < NBLOCKS; i++)
+            free(blocks[i]);
+    }
+    released_kb = used_kb() - base;
+    printf("malloc churn of %lu MB: footprint %ld kB touched, %ld kB after malloc_trim\n",
+           (unsigned long)NBLOCKS * BLOCK_SIZE >> 20, touched_kb, released_kb);
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define ITERATIONS 10000
+
+/* Measures the latency of an epoll wakeup (signal one eventfd, epoll_wait() on the whole set,
+ * consume the event) for 10, 1k and 10k watched eventfds. The wakeup should not get slower with
+ * the number of watched handles. The 10k case needs a host limit of open files above 10k (e.g.
+ * run with "ulimit -n 65536"). */
+
+static const int g_set_sizes[] = {10, 1000, 10000};
+
+static unsigned long long now_usec(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+static int run(int nfds) {
+    int* fds = malloc(nfds * sizeof(*fds));
+    if (!fds) {
+        perror("malloc");
+        return -1;
+    }
+
+    int epfd = epoll_create1(0);
+    if (epfd < 0) {
+        perror("epoll_create1");
+        return -1;
+    }
+
+    for (int i = 0; i < nfds; i++) {
+        fds[i] = eventfd(0, EFD_NONBLOCK);
+        if (fds[i] < 0) {
+            perror("eventfd");
+            return -1;
+        }
+        struct epoll_event ev = {.events = EPOLLIN, .data.u32 = i};
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, fds[i], &ev) < 0) {
+            perror("epoll_ctl");
+            return -1;
+        }
+    }
+
+    unsigned long long start = now_usec();
+    for (int i = 0; i < ITERATIONS; i++) {
+        int fd = fds[(i * 7919) % nfds];
+        uint64_t val = 1;
+        if (write(fd, &val, sizeof(val)) != sizeof(val)) {
+            perror("write");
+            return -1;
+        }
+
+        struct epoll_event ev;
+        if (epoll_wait(epfd, &ev, 1, -1) != 1 || fds[ev.data.u32] != fd) {
+            fprintf(stderr, "epoll_wait returned a wrong event\n");
+            return -1;
+        }
+
+        if (read(fd, &val, sizeof(val)) != sizeof(val)) {
+            perror("read");
+            return -1;
+        }
+    }
+    unsigned long long end = now_usec();
+
+    printf("%6d handles: %8.2f us per wakeup\n", nfds, (double)(end - start) / ITERATIONS);
+
+    for (int i = 0; i < nfds; i++)
+        close(fds[i]);
+    close(epfd);
+    free(fds);
+    return 0;
+}
+
+int main(void) {
+    struct rlimit rlim;
+    if (getrlimit(RLIMIT_NOFILE, &rlim) == 0) {
+        rlim.rlim_cur = rlim.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rlim);
+    }
+
+    for (size_t i = 0; i < sizeof(g_set_sizes) / sizeof(g_set_sizes[0]); i++)
+        if (run(g_set_sizes[i]) < 0)
+            return 1;
+
+    return 0;
+}
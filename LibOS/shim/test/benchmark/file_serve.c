@@ -0,0 +1,149 @@
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define FILE_NAME  "file_serve.tmp"
+#define FILE_SIZE  (16UL * 1024 * 1024)
+#define ITERATIONS 32
+#define CHUNK_SIZE (64UL * 1024)
+#define PORT       8000
+
+/* Measures serving a static file over a TCP loopback connection, as a web server would: once
+ * with read()/write() through a user buffer and once with sendfile(). On SGX, sendfile() of an
+ * allowed file to a TCP socket is done by the host without copying the data into the enclave. */
+
+static char buf[CHUNK_SIZE];
+
+static unsigned long long now_usec(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+static void report(const char* what, unsigned long bytes, unsigned long long usec) {
+    printf("%-12s %8.1f MB/s\n", what, (double)bytes / usec * 1000000.0 / (1024 * 1024));
+}
+
+static void* client(void* arg) {
+    (void)arg;
+    static char rbuf[CHUNK_SIZE];
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        exit(1);
+    }
+
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(PORT)};
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("connect");
+        exit(1);
+    }
+
+    unsigned long total = 2UL * ITERATIONS * FILE_SIZE;
+    while (total) {
+        ssize_t ret = read(fd, rbuf, CHUNK_SIZE);
+        if (ret <= 0) {
+            perror("read");
+            exit(1);
+        }
+        total -= ret;
+    }
+    close(fd);
+    return NULL;
+}
+
+static int serve_copy(int fd, int sock) {
+    if (lseek(fd, 0, SEEK_SET) < 0)
+        return -1;
+    for (unsigned long done = 0; done < FILE_SIZE;) {
+        ssize_t ret = read(fd, buf, CHUNK_SIZE);
+        if (ret <= 0)
+            return -1;
+        for (ssize_t written = 0; written < ret;) {
+            ssize_t w = write(sock, buf + written, ret - written);
+            if (w <= 0)
+                return -1;
+            written += w;
+        }
+        done += ret;
+    }
+    return 0;
+}
+
+static int serve_sendfile(int fd, int sock) {
+    off_t offset = 0;
+    while (offset < (off_t)FILE_SIZE) {
+        ssize_t ret = sendfile(sock, fd, &offset, FILE_SIZE - offset);
+        if (ret <= 0)
+            return -1;
+    }
+    return 0;
+}
+
+int main(void) {
+    int fd = open(FILE_NAME, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        perror("open");
+        return 1;
+    }
+    memset(buf, 'a', CHUNK_SIZE);
+    for (unsigned long done = 0; done < FILE_SIZE; done += CHUNK_SIZE)
+        if (write(fd, buf, CHUNK_SIZE) != (ssize_t)CHUNK_SIZE) {
+            perror("write");
+            return 1;
+        }
+
+    int lfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (lfd < 0) {
+        perror("socket");
+        return 1;
+    }
+    int one = 1;
+    setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(PORT)};
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(lfd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(lfd, 1) < 0) {
+        perror("bind/listen");
+        return 1;
+    }
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, client, NULL);
+    int sock = accept(lfd, NULL, NULL);
+    if (sock < 0) {
+        perror("accept");
+        return 1;
+    }
+
+    unsigned long long start = now_usec();
+    for (int i = 0; i < ITERATIONS; i++)
+        if (serve_copy(fd, sock) < 0) {
+            perror("read/write");
+            return 1;
+        }
+    report("read/write", ITERATIONS * FILE_SIZE, now_usec() - start);
+
+    start = now_usec();
+    for (int i = 0; i < ITERATIONS; i++)
+        if (serve_sendfile(fd, sock) < 0) {
+            perror("sendfile");
+            return 1;
+        }
+    report("sendfile", ITERATIONS * FILE_SIZE, now_usec() - start);
+
+    pthread_join(thread, NULL);
+    close(sock);
+    close(lfd);
+    close(fd);
+    unlink(FILE_NAME);
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define NTRIES      100000
+#define MAX_THREADS 64
+
+/* Measures the latency of system calls whose emulation is dominated by LibOS lock acquisitions:
+ * dup()+close() takes the handle-map lock and mmap()+munmap() takes the VMA list lock. Running it
+ * with one thread shows the uncontended cost of the locks, with more threads the contended one. */
+
+static int nthreads = 1;
+static pthread_barrier_t barrier;
+
+static unsigned long long now_usec(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+static void* dup_close(void* arg) {
+    (void)arg;
+    pthread_barrier_wait(&barrier);
+    for (int i = 0; i < NTRIES; i++) {
+        int fd = dup(1);
+        if (fd < 0) {
+            perror("dup");
+            exit(1);
+        }
+        close(fd);
+    }
+    return NULL;
+}
+
+static void* mmap_munmap(void* arg) {
+    (void)arg;
+    pthread_barrier_wait(&barrier);
+    for (int i = 0; i < NTRIES; i++) {
+        void* addr = mmap(NULL, 4096, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED) {
+            perror("mmap");
+            exit(1);
+        }
+        munmap(addr, 4096);
+    }
+    return NULL;
+}
+
+static void run(const char* name, void* (*func)(void*)) {
+    pthread_t threads[MAX_THREADS];
+
+    pthread_barrier_init(&barrier, NULL, nthreads + 1);
+    for (int i = 0; i < nthreads; i++) {
+        if (pthread_create(&threads[i], NULL, func, NULL)) {
+            perror("pthread_create");
+            exit(1);
+        }
+    }
+
+    unsigned long long start = now_usec();
+    pthread_barrier_wait(&barrier);
+    for (int i = 0; i < nthreads; i++)
+        pthread_join(threads[i], NULL);
+    unsigned long long end = now_usec();
+    pthread_barrier_destroy(&barrier);
+
+    printf("%s (%d threads): %.3f usec\n", name, nthreads,
+           (double)(end - start) / NTRIES);
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2) {
+        nthreads = atoi(argv[1]);
+        if (nthreads < 1 || nthreads > MAX_THREADS) {
+            fprintf(stderr, "usage: %s [nthreads (1-%d)]\n", argv[0], MAX_THREADS);
+            return 1;
+        }
+    }
+
+    run("dup+close", dup_close);
+    run("mmap+munmap", mmap_munmap);
+    return 0;
+}
@@ -0,0 +1,87 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define DEFAULT_MAPPINGS 1000
+#define CHUNK_SIZE       (64 * 1024)
+#define ITERATIONS       100000
+
+/* Measures the cost per call of the mmap()/munmap()/mprotect() churn of allocator-heavy apps:
+ * mapping and unmapping a 64KB chunk, unmapping and remapping a page in the middle of a mapping
+ * (splitting it), and protecting a page of a mapping and then unprotecting it again. [mappings]
+ * other mappings (default 1000), separated by holes so that none of them can be merged, are kept
+ * around to make the bookkeeping realistic. Usage: mmap_churn [mappings]. */
+
+static unsigned long long now_usec(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+static void report(const char* what, unsigned long calls, unsigned long long usec) {
+    printf("%-24s %8.0f ns/call\n", what, usec * 1000.0 / calls);
+}
+
+static void* map(void* addr, size_t length, int flags) {
+    void* ret = mmap(addr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags,
+                     -1, 0);
+    if (ret == MAP_FAILED)
+        err(1, "mmap");
+    return ret;
+}
+
+int main(int argc, char** argv) {
+    int nmappings = argc > 1 ? atoi(argv[1]) : DEFAULT_MAPPINGS;
+    if (nmappings < 0)
+        errx(1, "usage: %s [mappings]", argv[0]);
+
+    long page = sysconf(_SC_PAGESIZE);
+
+    /* every other page of one area stays mapped */
+    if (nmappings) {
+        char* others = map(NULL, 2 * (size_t)nmappings * page, 0);
+        for (int i = 0; i < nmappings; i++)
+            if (munmap(others + (2 * i + 1) * page, page) < 0)
+                err(1, "munmap");
+    }
+
+    unsigned long long start = now_usec();
+    for (int i = 0; i < ITERATIONS; i++) {
+        void* chunk = map(NULL, CHUNK_SIZE, 0);
+        if (munmap(chunk, CHUNK_SIZE) < 0)
+            err(1, "munmap");
+    }
+    report("mmap+munmap", 2 * ITERATIONS, now_usec() - start);
+
+    char* area = map(NULL, CHUNK_SIZE, 0);
+    char* middle = area + CHUNK_SIZE / 2;
+
+    start = now_usec();
+    for (int i = 0; i < ITERATIONS; i++) {
+        if (munmap(middle, page) < 0)
+            err(1, "munmap");
+        map(middle, page, MAP_FIXED);
+    }
+    report("munmap+mmap (split)", 2 * ITERATIONS, now_usec() - start);
+
+    start = now_usec();
+    for (int i = 0; i < ITERATIONS; i++) {
+        if (mprotect(middle, page, PROT_NONE) < 0)
+            err(1, "mprotect");
+        if (mprotect(middle, page, PROT_READ | PROT_WRITE) < 0)
+            err(1, "mprotect");
+    }
+    report("mprotect (split+merge)", 2 * ITERATIONS, now_usec() - start);
+
+    /* the area must still be usable as a whole */
+    for (size_t i = 0; i < CHUNK_SIZE; i += page)
+        area[i] = 1;
+
+    printf("(%d other mappings)\n", nmappings);
+    munmap(area, CHUNK_SIZE);
+    return 0;
+}
@@ -0,0 +1,45 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define NTRIES 10000
+
+/* Measures the latency of open()+close() on each file given on the command line. Under
+ * Linux-SGX, the cost of checking a file against the manifest grows with the number of
+ * trusted/allowed files; see OPEN_LATENCY_NFILES in the Makefile. */
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <file>...\n", argv[0]);
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        /* warm up: the first open of a trusted file hashes its whole contents */
+        int fd = open(argv[i], O_RDONLY);
+        if (fd < 0) {
+            perror("open");
+            return 1;
+        }
+        close(fd);
+
+        struct timeval tv1, tv2;
+        gettimeofday(&tv1, NULL);
+        for (int j = 0; j < NTRIES; j++) {
+            fd = open(argv[i], O_RDONLY);
+            if (fd < 0) {
+                perror("open");
+                return 1;
+            }
+            close(fd);
+        }
+        gettimeofday(&tv2, NULL);
+
+        unsigned long long usec1 = tv1.tv_sec * 1000000ULL + tv1.tv_usec;
+        unsigned long long usec2 = tv2.tv_sec * 1000000ULL + tv2.tv_usec;
+        printf("open+close %s: %.3f usec\n", argv[i], (double)(usec2 - usec1) / NTRIES);
+    }
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+
+#define MAX_SIZE  (256UL * 1024 * 1024)
+#define STEP_SIZE (1024UL * 1024)
+#define ROUNDS    10
+
+/* Measures growing a buffer the way realloc-heavy runtimes do: realloc() in 1MB steps (glibc
+ * serves such large chunks with mmap() and grows them with mremap()) and mremap() doubling a
+ * mapping. Each step touches the new tail so that the grown memory is really used. The cost per
+ * step stays flat when mremap() grows in place or moves pages, and grows with the buffer size when
+ * it copies. */
+
+static unsigned long long now_usec(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+int main(void) {
+    unsigned long long start = now_usec();
+    unsigned long steps = 0;
+    for (int r = 0; r < ROUNDS; r++) {
+        char* buf = NULL;
+        for (size_t size = STEP_SIZE; size <= MAX_SIZE; size += STEP_SIZE) {
+            buf = realloc(buf, size);
+            if (!buf)
+                err(1, "realloc");
+            memset(buf + size - STEP_SIZE, r, STEP_SIZE);
+            steps++;
+        }
+        free(buf);
+    }
+    unsigned long long realloc_usec = now_usec() - start;
+    printf("realloc growth to %lu MB in 1 MB steps: %.2f us per step\n", MAX_SIZE >> 20,
+           (double)realloc_usec / steps);
+
+    start = now_usec();
+    steps = 0;
+    for (int r = 0; r < ROUNDS; r++) {
+        size_t size = STEP_SIZE;
+        char* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (map == MAP_FAILED)
+            err(1, "mmap");
+        memset(map, r, size);
+        while (size < MAX_SIZE) {
+            map = mremap(map, size, size * 2, MREMAP_MAYMOVE);
+            if (map == MAP_FAILED)
+                err(1, "mremap");
+            memset(map + size, r, size);
+            size *= 2;
+            steps++;
+        }
+        if (munmap(map, size) < 0)
+            err(1, "munmap");
+    }
+    unsigned long long mremap_usec = now_usec() - start;
+    printf("mremap doubling to %lu MB: %.2f us per step\n", MAX_SIZE >> 20,
+           (double)mremap_usec / steps);
+    return 0;
+}
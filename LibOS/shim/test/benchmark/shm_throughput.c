@@ -0,0 +1,188 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define DEFAULT_WRITERS 4
+#define MSG_SIZE        4096
+#define RING_SLOTS      64
+#define MSGS_PER_WRITER 16384 /* 64MB per writer */
+#define READY_TIMEOUT   2000000
+
+/* Measures how fast several processes move data to one reader through a SysV shm segment (one
+ * single-producer ring per writer), compared to one pipe per writer. Usage: shm_throughput
+ * [writers]. On hosts where SysV shm is not shared between processes (Graphene on SGX), the shm
+ * part is skipped. */
+
+struct ring {
+    _Atomic uint64_t head; /* written by the writer */
+    char pad1[56];
+    _Atomic uint64_t tail; /* written by the reader */
+    char pad2[56];
+    char slots[RING_SLOTS][MSG_SIZE];
+};
+
+static unsigned long long now_usec(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+static void ring_writer(struct ring* ring) {
+    for (uint64_t i = 0; i < MSGS_PER_WRITER; i++) {
+        while (i - atomic_load_explicit(&ring->tail, memory_order_acquire) == RING_SLOTS)
+            sched_yield();
+        memset(ring->slots[i % RING_SLOTS], (char)i, MSG_SIZE);
+        atomic_store_explicit(&ring->head, i + 1, memory_order_release);
+    }
+}
+
+static double run_shm(int writers) {
+    int id = shmget(IPC_PRIVATE, writers * sizeof(struct ring), IPC_CREAT | 0600);
+    if (id < 0)
+        err(1, "shmget");
+    struct ring* rings = shmat(id, NULL, 0);
+    if (rings == (void*)-1)
+        err(1, "shmat");
+    if (shmctl(id, IPC_RMID, NULL) < 0)
+        err(1, "shmctl(IPC_RMID)");
+
+    pid_t* pids = calloc(writers, sizeof(*pids));
+    if (!pids)
+        err(1, "calloc");
+
+    for (int w = 0; w < writers; w++) {
+        pids[w] = fork();
+        if (pids[w] < 0)
+            err(1, "fork");
+        if (pids[w] == 0) {
+            ring_writer(&rings[w]);
+            _exit(0);
+        }
+    }
+
+    /* wait for the first message of every writer to find out whether the segment is shared */
+    unsigned long long start = now_usec();
+    for (int w = 0; w < writers; w++) {
+        while (!atomic_load_explicit(&rings[w].head, memory_order_acquire)) {
+            if (now_usec() - start > READY_TIMEOUT) {
+                for (int k = 0; k < writers; k++)
+                    kill(pids[k], SIGKILL);
+                for (int k = 0; k < writers; k++)
+                    waitpid(pids[k], NULL, 0);
+                return -1;
+            }
+            sched_yield();
+        }
+    }
+
+    int done = 0;
+    while (done < writers) {
+        bool progress = false;
+        done = 0;
+        for (int w = 0; w < writers; w++) {
+            struct ring* ring = &rings[w];
+            uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+            if (tail == MSGS_PER_WRITER) {
+                done++;
+                continue;
+            }
+            if (tail == atomic_load_explicit(&ring->head, memory_order_acquire))
+                continue;
+            const char* msg = ring->slots[tail % RING_SLOTS];
+            if (msg[0] != (char)tail || msg[MSG_SIZE - 1] != (char)tail)
+                errx(1, "corrupted message %lu from writer %d", (unsigned long)tail, w);
+            atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+            progress = true;
+        }
+        if (!progress)
+            sched_yield();
+    }
+    unsigned long long elapsed = now_usec() - start;
+
+    for (int w = 0; w < writers; w++)
+        waitpid(pids[w], NULL, 0);
+    free(pids);
+    shmdt(rings);
+    return (double)writers * MSGS_PER_WRITER * MSG_SIZE / elapsed;
+}
+
+static double run_pipes(int writers) {
+    int* fds = calloc(writers, sizeof(*fds));
+    if (!fds)
+        err(1, "calloc");
+
+    for (int w = 0; w < writers; w++) {
+        int p[2];
+        if (pipe(p) < 0)
+            err(1, "pipe");
+        pid_t pid = fork();
+        if (pid < 0)
+            err(1, "fork");
+        if (pid == 0) {
+            close(p[0]);
+            char msg[MSG_SIZE];
+            for (uint64_t i = 0; i < MSGS_PER_WRITER; i++) {
+                memset(msg, (char)i, MSG_SIZE);
+                for (size_t off = 0; off < MSG_SIZE;) {
+                    ssize_t n = write(p[1], msg + off, MSG_SIZE - off);
+                    if (n < 0)
+                        err(1, "write");
+                    off += n;
+                }
+            }
+            _exit(0);
+        }
+        close(p[1]);
+        fds[w] = p[0];
+    }
+
+    unsigned long long start = now_usec();
+    char msg[MSG_SIZE];
+    for (uint64_t i = 0; i < MSGS_PER_WRITER; i++) {
+        for (int w = 0; w < writers; w++) {
+            for (size_t off = 0; off < MSG_SIZE;) {
+                ssize_t n = read(fds[w], msg + off, MSG_SIZE - off);
+                if (n <= 0)
+                    err(1, "read");
+                off += n;
+            }
+            if (msg[0] != (char)i || msg[MSG_SIZE - 1] != (char)i)
+                errx(1, "corrupted message %lu from writer %d", (unsigned long)i, w);
+        }
+    }
+    unsigned long long elapsed = now_usec() - start;
+
+    for (int w = 0; w < writers; w++) {
+        close(fds[w]);
+        wait(NULL);
+    }
+    free(fds);
+    return (double)writers * MSGS_PER_WRITER * MSG_SIZE / elapsed;
+}
+
+int main(int argc, char** argv) {
+    int writers = argc > 1 ? atoi(argv[1]) : DEFAULT_WRITERS;
+    if (writers <= 0)
+        errx(1, "usage: %s [writers]", argv[0]);
+
+    double shm = run_shm(writers);
+    if (shm < 0)
+        printf("shm:   segment is not shared between processes, skipped\n");
+    else
+        printf("shm:   %d writers, %.1f MB/s\n", writers, shm);
+
+    printf("pipes: %d writers, %.1f MB/s\n", writers, run_pipes(writers));
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <linux/futex.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define NTHREADS  2000
+#define NSWITCHES 100000
+
+/* Measures the rate of thread creation (pthread_create()+pthread_join() of a thread that exits
+ * immediately) and the latency of a context switch between two threads that hand a futex back
+ * and forth. On SGX, compare runs with and without "sgx.thread_pool" in the manifest. */
+
+static int turn = 0;
+
+static unsigned long long now_usec(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+static void* do_nothing(void* arg) {
+    return arg;
+}
+
+/* waits until `turn` is `me`, then passes the turn to the other thread */
+static void ping_pong(int me) {
+    for (int i = 0; i < NSWITCHES; i++) {
+        int cur;
+        while ((cur = __atomic_load_n(&turn, __ATOMIC_ACQUIRE)) != me)
+            syscall(SYS_futex, &turn, FUTEX_WAIT, cur, NULL, NULL, 0);
+        __atomic_store_n(&turn, !me, __ATOMIC_RELEASE);
+        syscall(SYS_futex, &turn, FUTEX_WAKE, 1, NULL, NULL, 0);
+    }
+}
+
+static void* pong(void* arg) {
+    (void)arg;
+    ping_pong(1);
+    return NULL;
+}
+
+int main(void) {
+    pthread_t thread;
+
+    unsigned long long start = now_usec();
+    for (int i = 0; i < NTHREADS; i++) {
+        if (pthread_create(&thread, NULL, do_nothing, NULL)) {
+            perror("pthread_create");
+            return 1;
+        }
+        pthread_join(thread, NULL);
+    }
+    unsigned long long end = now_usec();
+    printf("thread create+join: %.3f usec (%.0f threads/sec)\n",
+           (double)(end - start) / NTHREADS, NTHREADS * 1000000.0 / (end - start));
+
+    if (pthread_create(&thread, NULL, pong, NULL)) {
+        perror("pthread_create");
+        return 1;
+    }
+    start = now_usec();
+    ping_pong(0);
+    pthread_join(thread, NULL);
+    end = now_usec();
+    printf("context switch: %.3f usec\n", (double)(end - start) / (2 * NSWITCHES));
+    return 0;
+}
@@ -0,0 +1,99 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#define DEFAULT_TIMERS 10000
+#define INTERVAL_MS    100
+#define DURATION_SEC   3
+#define EVENTS_BATCH   256
+
+/* Runs an event loop over N periodic timerfds (default 10k) in one epoll, the way libuv or a
+ * daemon with many connection timeouts would, and reports how many expirations were delivered
+ * compared to the expected number, and the CPU time the loop took. Usage: timerfd_loop [timers].
+ * Many timers need a host limit of open files above 2*N (e.g. run with "ulimit -n 65536"). */
+
+static unsigned long long now_usec(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+static unsigned long long cpu_usec(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000ULL + ru.ru_utime.tv_usec +
+           ru.ru_stime.tv_usec;
+}
+
+int main(int argc, char** argv) {
+    int timers = argc > 1 ? atoi(argv[1]) : DEFAULT_TIMERS;
+    if (timers <= 0)
+        errx(1, "usage: %s [timers]", argv[0]);
+
+    struct rlimit rlim;
+    if (getrlimit(RLIMIT_NOFILE, &rlim) == 0) {
+        rlim.rlim_cur = rlim.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rlim);
+    }
+
+    int epfd = epoll_create1(0);
+    if (epfd < 0)
+        err(1, "epoll_create1");
+
+    unsigned long long start = now_usec();
+    for (int i = 0; i < timers; i++) {
+        int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+        if (fd < 0)
+            err(1, "timerfd_create (timer %d)", i);
+
+        /* spread the first expirations over one interval, as independent timeouts would be */
+        long first_ns = INTERVAL_MS * 1000000L / timers * i + 1;
+        struct itimerspec its = {
+            .it_value    = {.tv_sec = first_ns / 1000000000L, .tv_nsec = first_ns % 1000000000L},
+            .it_interval = {.tv_sec = 0, .tv_nsec = INTERVAL_MS * 1000000L},
+        };
+        if (timerfd_settime(fd, 0, &its, NULL) < 0)
+            err(1, "timerfd_settime");
+
+        struct epoll_event ev = {.events = EPOLLIN, .data.fd = fd};
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+            err(1, "epoll_ctl");
+    }
+    printf("armed %d timers in %llu us\n", timers, now_usec() - start);
+
+    struct epoll_event events[EVENTS_BATCH];
+    uint64_t expirations = 0;
+    unsigned long long waits = 0;
+    unsigned long long cpu_start = cpu_usec();
+    start = now_usec();
+    unsigned long long end = start + DURATION_SEC * 1000000ULL;
+
+    while (now_usec() < end) {
+        int n = epoll_wait(epfd, events, EVENTS_BATCH, INTERVAL_MS);
+        if (n < 0)
+            err(1, "epoll_wait");
+        waits++;
+
+        for (int i = 0; i < n; i++) {
+            uint64_t count;
+            if (read(events[i].data.fd, &count, sizeof(count)) == sizeof(count))
+                expirations += count;
+        }
+    }
+
+    unsigned long long elapsed = now_usec() - start;
+    unsigned long long cpu     = cpu_usec() - cpu_start;
+    double expected = (double)timers * elapsed / (INTERVAL_MS * 1000.0);
+
+    printf("%d timers, %d ms period: %lu expirations in %llu us (%.1f%% of expected), "
+           "%llu waits, %.1f%% CPU\n", timers, INTERVAL_MS, (unsigned long)expirations, elapsed,
+           100.0 * expirations / expected, waits, 100.0 * cpu / elapsed);
+    return 0;
+}
@@ -0,0 +1,156 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/aio_abi.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TEST_FILE "tmp/aio_test"
+#define NREQS     16
+#define REQ_SIZE  4096
+
+static char data[NREQS][REQ_SIZE];
+static char buf[NREQS][REQ_SIZE];
+
+static long io_setup(unsigned nr, aio_context_t* ctx) {
+    return syscall(SYS_io_setup, nr, ctx);
+}
+
+static long io_destroy(aio_context_t ctx) {
+    return syscall(SYS_io_destroy, ctx);
+}
+
+static long io_submit(aio_context_t ctx, long nr, struct iocb** iocbpp) {
+    return syscall(SYS_io_submit, ctx, nr, iocbpp);
+}
+
+static long io_getevents(aio_context_t ctx, long min_nr, long nr, struct io_event* events,
+                         struct timespec* timeout) {
+    return syscall(SYS_io_getevents, ctx, min_nr, nr, events, timeout);
+}
+
+static void prep(struct iocb* cb, int opcode, int fd, void* ptr, size_t size, off_t offset,
+                 uint64_t data) {
+    memset(cb, 0, sizeof(*cb));
+    cb->aio_lio_opcode = opcode;
+    cb->aio_fildes     = fd;
+    cb->aio_buf        = (uint64_t)ptr;
+    cb->aio_nbytes     = size;
+    cb->aio_offset     = offset;
+    cb->aio_data       = data;
+}
+
+/* reap exactly `nr` completions and check that each one transferred `size` bytes */
+static void reap(aio_context_t ctx, long nr, long long size, struct iocb* iocbs) {
+    struct io_event events[NREQS];
+    long done = 0;
+    while (done < nr) {
+        long n = io_getevents(ctx, 1, nr - done, events, NULL);
+        if (n < 0)
+            err(1, "io_getevents");
+        for (long i = 0; i < n; i++) {
+            if (events[i].res != size)
+                errx(1, "request %lu returned %lld", (unsigned long)events[i].data,
+                     (long long)events[i].res);
+            if (events[i].obj != (uint64_t)&iocbs[events[i].data])
+                errx(1, "request %lu has a wrong iocb", (unsigned long)events[i].data);
+        }
+        done += n;
+    }
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    for (int i = 0; i < NREQS; i++)
+        memset(data[i], 'a' + i, REQ_SIZE);
+
+    int fd = open(TEST_FILE, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+        err(1, "open");
+
+    aio_context_t ctx = 0;
+    if (io_setup(NREQS, &ctx) < 0)
+        err(1, "io_setup");
+
+    aio_context_t bad_ctx = ctx;
+    if (io_setup(NREQS, &bad_ctx) >= 0 || errno != EINVAL)
+        errx(1, "io_setup with a non-zero context did not fail with EINVAL");
+
+    /* write the blocks in reverse order, then read them back in one batch */
+    struct iocb iocbs[NREQS];
+    struct iocb* iocbps[NREQS];
+    for (int i = 0; i < NREQS; i++) {
+        int block = NREQS - 1 - i;
+        prep(&iocbs[i], IOCB_CMD_PWRITE, fd, data[block], REQ_SIZE, (off_t)block * REQ_SIZE, i);
+        iocbps[i] = &iocbs[i];
+    }
+    if (io_submit(ctx, NREQS, iocbps) != NREQS)
+        err(1, "io_submit(PWRITE)");
+    reap(ctx, NREQS, REQ_SIZE, iocbs);
+
+    if (lseek(fd, 0, SEEK_CUR) != 0)
+        errx(1, "AIO moved the file position");
+    if (lseek(fd, 0, SEEK_END) != NREQS * REQ_SIZE)
+        errx(1, "AIO writes did not extend the file");
+
+    for (int i = 0; i < NREQS; i++)
+        prep(&iocbs[i], IOCB_CMD_PREAD, fd, buf[i], REQ_SIZE, (off_t)i * REQ_SIZE, i);
+    if (io_submit(ctx, NREQS, iocbps) != NREQS)
+        err(1, "io_submit(PREAD)");
+    reap(ctx, NREQS, REQ_SIZE, iocbs);
+    if (memcmp(buf, data, sizeof(data)))
+        errx(1, "AIO read back wrong data");
+    printf("aio read/write OK\n");
+
+    /* vectored read of two blocks, completion notified through an eventfd */
+    int efd = eventfd(0, EFD_NONBLOCK);
+    if (efd < 0)
+        err(1, "eventfd");
+    memset(buf, 0, sizeof(buf));
+    struct iovec iov[2] = {{buf[0], REQ_SIZE}, {buf[1], REQ_SIZE}};
+    prep(&iocbs[0], IOCB_CMD_PREADV, fd, iov, 2, 2 * REQ_SIZE, 0);
+    iocbs[0].aio_flags = IOCB_FLAG_RESFD;
+    iocbs[0].aio_resfd = efd;
+    prep(&iocbs[1], IOCB_CMD_FSYNC, fd, NULL, 0, 0, 1);
+    if (io_submit(ctx, 1, iocbps) != 1)
+        err(1, "io_submit(PREADV)");
+    reap(ctx, 1, 2 * REQ_SIZE, iocbs);
+    if (memcmp(buf, data[2], 2 * REQ_SIZE))
+        errx(1, "AIO vectored read returned wrong data");
+    uint64_t count;
+    if (read(efd, &count, sizeof(count)) != sizeof(count) || count != 1)
+        errx(1, "AIO completion did not notify the eventfd");
+    if (io_submit(ctx, 1, &iocbps[1]) != 1)
+        err(1, "io_submit(FSYNC)");
+    reap(ctx, 1, 0, iocbs);
+    printf("aio vector/eventfd OK\n");
+
+    /* errors: a timeout without completions, a bad file descriptor and a destroyed context */
+    struct io_event event;
+    struct timespec timeout = {.tv_nsec = 10000000};
+    if (io_getevents(ctx, 1, 1, &event, &timeout) != 0)
+        errx(1, "io_getevents without requests did not time out");
+
+    prep(&iocbs[0], IOCB_CMD_PREAD, -1, buf[0], REQ_SIZE, 0, 0);
+    if (io_submit(ctx, 1, iocbps) >= 0 || errno != EBADF)
+        errx(1, "io_submit with a bad file descriptor did not fail with EBADF");
+
+    if (io_destroy(ctx) < 0)
+        err(1, "io_destroy");
+    if (io_getevents(ctx, 0, 1, &event, &timeout) >= 0 || errno != EINVAL)
+        errx(1, "destroyed context is still valid");
+    printf("aio errors OK\n");
+
+    close(efd);
+    close(fd);
+    unlink(TEST_FILE);
+    return 0;
+}
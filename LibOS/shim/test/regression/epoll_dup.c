@@ -0,0 +1,83 @@
+#include <err.h>
+#include <stdio.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/* Two FDs which refer to the same socket (via dup()) must be monitored independently by epoll,
+ * with their own events, and removing one of them must not affect the other. */
+
+#define MAXEVENTS 4
+
+static void add(int efd, int fd, unsigned int events) {
+    struct epoll_event event = {.events = events, .data.fd = fd};
+    if (epoll_ctl(efd, EPOLL_CTL_ADD, fd, &event) < 0)
+        err(1, "epoll_ctl(EPOLL_CTL_ADD)");
+}
+
+static void del(int efd, int fd) {
+    if (epoll_ctl(efd, EPOLL_CTL_DEL, fd, NULL) < 0)
+        err(1, "epoll_ctl(EPOLL_CTL_DEL)");
+}
+
+/* expects exactly the events `events_a` on `a` and `events_b` on `b` (0 meaning no event) */
+static void expect(int efd, int a, unsigned int events_a, int b, unsigned int events_b,
+                   const char* what) {
+    struct epoll_event events[MAXEVENTS];
+    int n = epoll_wait(efd, events, MAXEVENTS, 1000);
+    if (n < 0)
+        err(1, "epoll_wait");
+
+    unsigned int got_a = 0, got_b = 0;
+    for (int i = 0; i < n; i++) {
+        if (events[i].data.fd == a)
+            got_a |= events[i].events;
+        else if (events[i].data.fd == b)
+            got_b |= events[i].events;
+        else
+            errx(1, "%s: event on unexpected fd %d", what, events[i].data.fd);
+    }
+    if (got_a != events_a || got_b != events_b)
+        errx(1, "%s: got events 0x%x and 0x%x, expected 0x%x and 0x%x", what, got_a, got_b,
+             events_a, events_b);
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0)
+        err(1, "socketpair");
+
+    int a = sv[0];
+    int b = dup(a);
+    if (b < 0)
+        err(1, "dup");
+
+    int efd = epoll_create1(0);
+    if (efd < 0)
+        err(1, "epoll_create1");
+
+    add(efd, a, EPOLLIN);
+    add(efd, b, EPOLLOUT);
+    expect(efd, a, 0, b, EPOLLOUT, "before write");
+
+    if (write(sv[1], "x", 1) != 1)
+        err(1, "write");
+    expect(efd, a, EPOLLIN, b, EPOLLOUT, "after write");
+
+    del(efd, b);
+    expect(efd, a, EPOLLIN, b, 0, "after deleting the dup'd fd");
+
+    add(efd, b, EPOLLOUT);
+    del(efd, a);
+    expect(efd, a, 0, b, EPOLLOUT, "after deleting the original fd");
+
+    printf("epoll with dup'd fds OK\n");
+
+    close(efd);
+    close(b);
+    close(sv[0]);
+    close(sv[1]);
+    return 0;
+}
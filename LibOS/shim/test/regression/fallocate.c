@@ -0,0 +1,104 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_FILE  "tmp/fallocate_test"
+#define BLOCK_SIZE 4096
+
+static off_t file_size(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+        err(1, "fstat");
+    return st.st_size;
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    int fd = open(TEST_FILE, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+        err(1, "open");
+
+    /* preallocation extends the file, unless asked to keep the size */
+    if (fallocate(fd, 0, 0, 4 * BLOCK_SIZE) < 0)
+        err(1, "fallocate");
+    if (file_size(fd) != 4 * BLOCK_SIZE)
+        errx(1, "fallocate did not extend the file");
+    if (lseek(fd, 0, SEEK_END) != 4 * BLOCK_SIZE)
+        errx(1, "lseek(SEEK_END) does not see the preallocated size");
+
+    if (fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, 8 * BLOCK_SIZE) < 0)
+        err(1, "fallocate(FALLOC_FL_KEEP_SIZE)");
+    if (file_size(fd) != 4 * BLOCK_SIZE)
+        errx(1, "fallocate(FALLOC_FL_KEEP_SIZE) changed the file size");
+    printf("fallocate OK\n");
+
+    /* punching a hole zeroes the range in the middle of the data */
+    static char buf[4 * BLOCK_SIZE];
+    memset(buf, 'a', sizeof(buf));
+    if (pwrite(fd, buf, sizeof(buf), 0) != sizeof(buf))
+        err(1, "pwrite");
+    int ret = fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, BLOCK_SIZE, BLOCK_SIZE);
+    if (ret < 0 && errno != EOPNOTSUPP)
+        err(1, "fallocate(FALLOC_FL_PUNCH_HOLE)");
+    if (ret == 0) {
+        if (pread(fd, buf, sizeof(buf), 0) != sizeof(buf))
+            err(1, "pread");
+        for (int i = 0; i < 4 * BLOCK_SIZE; i++)
+            if (buf[i] != (i >= BLOCK_SIZE && i < 2 * BLOCK_SIZE ? 0 : 'a'))
+                errx(1, "wrong byte at offset %d after punching a hole", i);
+        if (file_size(fd) != 4 * BLOCK_SIZE)
+            errx(1, "punching a hole changed the file size");
+    }
+    if (fallocate(fd, FALLOC_FL_PUNCH_HOLE, 0, BLOCK_SIZE) >= 0 || errno != EOPNOTSUPP)
+        errx(1, "FALLOC_FL_PUNCH_HOLE without FALLOC_FL_KEEP_SIZE did not fail with EOPNOTSUPP");
+    printf("fallocate punch hole OK\n");
+
+    /* hints and ranged writeback */
+    if ((errno = posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL)))
+        err(1, "posix_fadvise(POSIX_FADV_SEQUENTIAL)");
+    if ((errno = posix_fadvise(fd, 0, BLOCK_SIZE, POSIX_FADV_DONTNEED)))
+        err(1, "posix_fadvise(POSIX_FADV_DONTNEED)");
+    if (readahead(fd, 0, 4 * BLOCK_SIZE) < 0)
+        err(1, "readahead");
+    if (sync_file_range(fd, 0, 2 * BLOCK_SIZE,
+                        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                            SYNC_FILE_RANGE_WAIT_AFTER) < 0)
+        err(1, "sync_file_range");
+    printf("fadvise/readahead/sync_file_range OK\n");
+
+    /* errors */
+    if (fallocate(fd, 0, 0, 0) >= 0 || errno != EINVAL)
+        errx(1, "fallocate with zero length did not fail with EINVAL");
+    if (posix_fadvise(fd, 0, 0, 100) != EINVAL)
+        errx(1, "posix_fadvise with bad advice did not fail with EINVAL");
+    if (sync_file_range(fd, -1, 0, 0) >= 0 || errno != EINVAL)
+        errx(1, "sync_file_range with a negative offset did not fail with EINVAL");
+
+    int pipefds[2];
+    if (pipe(pipefds) < 0)
+        err(1, "pipe");
+    if (posix_fadvise(pipefds[0], 0, 0, POSIX_FADV_NORMAL) != ESPIPE)
+        errx(1, "posix_fadvise on a pipe did not fail with ESPIPE");
+    if (readahead(pipefds[0], 0, BLOCK_SIZE) >= 0 || errno != EINVAL)
+        errx(1, "readahead on a pipe did not fail with EINVAL");
+    close(pipefds[0]);
+    close(pipefds[1]);
+
+    int rdfd = open(TEST_FILE, O_RDONLY);
+    if (rdfd < 0)
+        err(1, "open(O_RDONLY)");
+    if (fallocate(rdfd, 0, 0, BLOCK_SIZE) >= 0 || errno != EBADF)
+        errx(1, "fallocate on a read-only file did not fail with EBADF");
+    close(rdfd);
+    printf("fallocate errors OK\n");
+
+    close(fd);
+    unlink(TEST_FILE);
+    return 0;
+}
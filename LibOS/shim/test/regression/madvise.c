@@ -0,0 +1,74 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifndef MADV_FREE
+#define MADV_FREE 8
+#endif
+
+#define PAGES 16
+
+static void check_bytes(const char* ptr, size_t size, char expected, const char* what) {
+    for (size_t i = 0; i < size; i++)
+        if (ptr[i] != expected)
+            errx(1, "%s: unexpected byte %d at offset %zu", what, ptr[i], i);
+}
+
+int main(void) {
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t size = PAGES * page;
+
+    char* priv = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (priv == MAP_FAILED)
+        err(1, "mmap");
+    memset(priv, 'a', size);
+
+    /* discard the middle of the mapping only */
+    if (madvise(priv + 4 * page, 8 * page, MADV_DONTNEED) < 0)
+        err(1, "madvise(MADV_DONTNEED)");
+    check_bytes(priv, 4 * page, 'a', "MADV_DONTNEED head");
+    check_bytes(priv + 4 * page, 8 * page, 0, "MADV_DONTNEED");
+    check_bytes(priv + 12 * page, 4 * page, 'a', "MADV_DONTNEED tail");
+    memset(priv, 'b', size);
+    check_bytes(priv, size, 'b', "MADV_DONTNEED rewrite");
+    printf("madvise MADV_DONTNEED OK\n");
+
+    /* after MADV_FREE, each page holds either its old contents or zeros */
+    if (madvise(priv, size, MADV_FREE) < 0)
+        err(1, "madvise(MADV_FREE)");
+    for (size_t i = 0; i < PAGES; i++)
+        if (priv[i * page] != 0)
+            check_bytes(priv + i * page, page, 'b', "MADV_FREE");
+        else
+            check_bytes(priv + i * page, page, 0, "MADV_FREE");
+    printf("madvise MADV_FREE OK\n");
+
+    /* shared memory keeps its contents */
+    char* shared = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED)
+        err(1, "mmap shared");
+    memset(shared, 'c', size);
+    if (madvise(shared, size, MADV_DONTNEED) < 0)
+        err(1, "madvise(MADV_DONTNEED) shared");
+    check_bytes(shared, size, 'c', "MADV_DONTNEED shared");
+    printf("madvise shared OK\n");
+
+    /* a hole in the range fails with ENOMEM */
+    if (munmap(priv + 8 * page, page) < 0)
+        err(1, "munmap");
+    errno = 0;
+    if (madvise(priv, size, MADV_DONTNEED) != -1 || errno != ENOMEM)
+        errx(1, "madvise over a hole did not fail with ENOMEM");
+    errno = 0;
+    if (madvise(priv, page, 12345) != -1 || errno != EINVAL)
+        errx(1, "madvise with invalid advice did not fail with EINVAL");
+    printf("madvise errors OK\n");
+
+    munmap(priv, size);
+    munmap(shared, size);
+    return 0;
+}
@@ -0,0 +1,91 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static void fill(char* ptr, size_t size, char seed) {
+    for (size_t i = 0; i < size; i++)
+        ptr[i] = seed + i % 251;
+}
+
+static void check(const char* ptr, size_t size, char seed, const char* what) {
+    for (size_t i = 0; i < size; i++)
+        if (ptr[i] != (char)(seed + i % 251))
+            errx(1, "%s: data mismatch at offset %zu", what, i);
+}
+
+static void check_zero(const char* ptr, size_t size, const char* what) {
+    for (size_t i = 0; i < size; i++)
+        if (ptr[i])
+            errx(1, "%s: grown area not zeroed at offset %zu", what, i);
+}
+
+int main(void) {
+    size_t page = sysconf(_SC_PAGESIZE);
+
+    /* grow in place: find a free hole and map the start of it */
+    char* hole = mmap(NULL, 16 * page, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (hole == MAP_FAILED)
+        err(1, "mmap");
+    if (munmap(hole, 16 * page) < 0)
+        err(1, "munmap");
+    char* ptr = mmap(hole, 2 * page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED,
+                     -1, 0);
+    if (ptr != hole)
+        err(1, "mmap fixed");
+    fill(ptr, 2 * page, 1);
+    char* grown = mremap(ptr, 2 * page, 4 * page, 0);
+    if (grown != ptr)
+        err(1, "mremap in place");
+    check(grown, 2 * page, 1, "in place");
+    check_zero(grown + 2 * page, 2 * page, "in place");
+    fill(grown, 4 * page, 2);
+    grown = mremap(grown, 4 * page, 8 * page, 0);
+    if (grown != ptr)
+        err(1, "mremap in place (second time)");
+    check(grown, 4 * page, 2, "in place (second time)");
+    printf("mremap in place OK\n");
+
+    /* a mapping right after the grown one prevents growing in place */
+    char* blocker = mmap(grown + 8 * page, page, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED,
+                         -1, 0);
+    if (blocker != grown + 8 * page)
+        err(1, "mmap blocker");
+    if (mremap(grown, 8 * page, 16 * page, 0) != MAP_FAILED)
+        errx(1, "mremap without MREMAP_MAYMOVE succeeded while blocked");
+    char* moved = mremap(grown, 8 * page, 16 * page, MREMAP_MAYMOVE);
+    if (moved == MAP_FAILED)
+        err(1, "mremap move");
+    if (moved == grown)
+        errx(1, "mremap did not move a blocked mapping");
+    check(moved, 4 * page, 2, "move");
+    check_zero(moved + 8 * page, 8 * page, "move");
+    printf("mremap move OK\n");
+
+    /* shrinking keeps the address and releases the tail */
+    char* shrunk = mremap(moved, 16 * page, 2 * page, 0);
+    if (shrunk != moved)
+        err(1, "mremap shrink");
+    check(shrunk, 2 * page, 2, "shrink");
+    printf("mremap shrink OK\n");
+
+    /* moving to a fixed address */
+    char* target = mmap(NULL, 4 * page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (target == MAP_FAILED)
+        err(1, "mmap target");
+    char* fixed = mremap(shrunk, 2 * page, 4 * page, MREMAP_MAYMOVE | MREMAP_FIXED, target);
+    if (fixed != target)
+        err(1, "mremap fixed");
+    check(fixed, 2 * page, 2, "fixed");
+    check_zero(fixed + 2 * page, 2 * page, "fixed");
+    printf("mremap fixed OK\n");
+
+    if (mremap(fixed + 1, page, 2 * page, MREMAP_MAYMOVE) != MAP_FAILED)
+        errx(1, "mremap of an unaligned address succeeded");
+
+    if (munmap(fixed, 4 * page) < 0 || munmap(blocker, page) < 0)
+        err(1, "munmap");
+    return 0;
+}
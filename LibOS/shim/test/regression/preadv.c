@@ -0,0 +1,84 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define TEST_FILE "tmp/preadv_test"
+
+static void check_pos(int fd, off_t expected, const char* what) {
+    off_t pos = lseek(fd, 0, SEEK_CUR);
+    if (pos != expected)
+        errx(1, "%s: file position is %ld instead of %ld", what, (long)pos, (long)expected);
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    int fd = open(TEST_FILE, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+        err(1, "open");
+
+    /* gather "hello, " and "world" and an empty buffer at offset 4 */
+    char a[] = "hello, ";
+    char b[] = "world";
+    struct iovec wvec[3] = {{a, strlen(a)}, {NULL, 0}, {b, strlen(b)}};
+    if (pwritev(fd, wvec, 3, 4) != 12)
+        err(1, "pwritev");
+    check_pos(fd, 0, "pwritev");
+
+    /* scatter the 16 bytes over buffers of 4, 7 and 10 bytes: the last one is filled partially */
+    char x[4], y[7], z[10];
+    struct iovec rvec[3] = {{x, sizeof(x)}, {y, sizeof(y)}, {z, sizeof(z)}};
+    if (preadv(fd, rvec, 3, 0) != 16)
+        err(1, "preadv");
+    check_pos(fd, 0, "preadv");
+    if (memcmp(x, "\0\0\0\0", 4) || memcmp(y, "hello, ", 7) || memcmp(z, "world", 5))
+        errx(1, "preadv returned wrong data");
+    if (preadv(fd, rvec, 3, 16) != 0)
+        errx(1, "preadv at the end of file did not return 0");
+    printf("preadv/pwritev OK\n");
+
+    /* readv and writev move the position, and so do preadv2/pwritev2 at offset -1 */
+    if (lseek(fd, 4, SEEK_SET) != 4)
+        err(1, "lseek");
+    struct iovec one = {y, sizeof(y)};
+    if (readv(fd, &one, 1) != sizeof(y) || memcmp(y, "hello, ", 7))
+        errx(1, "readv returned wrong data");
+    check_pos(fd, 11, "readv");
+    if (preadv2(fd, &one, 1, -1, 0) != 5 || memcmp(y, "world", 5))
+        errx(1, "preadv2 at offset -1 returned wrong data");
+    check_pos(fd, 16, "preadv2");
+
+    struct iovec tail = {"!", 1};
+    if (pwritev2(fd, &tail, 1, -1, RWF_DSYNC) != 1)
+        err(1, "pwritev2");
+    check_pos(fd, 17, "pwritev2");
+    if (writev(fd, &tail, 1) != 1)
+        err(1, "writev");
+    if (lseek(fd, 0, SEEK_END) != 18)
+        errx(1, "writev did not extend the file");
+    printf("readv/writev position OK\n");
+
+    /* errors */
+    if (preadv(fd, rvec, 3, -1) >= 0 || errno != EINVAL)
+        errx(1, "preadv at a negative offset did not fail with EINVAL");
+    if (preadv2(fd, rvec, 3, 0, 0x80000000) >= 0 || errno != EOPNOTSUPP)
+        errx(1, "preadv2 with unknown flags did not fail with EOPNOTSUPP");
+
+    int pipefds[2];
+    if (pipe(pipefds) < 0)
+        err(1, "pipe");
+    if (pwritev(pipefds[1], &tail, 1, 0) >= 0 || errno != ESPIPE)
+        errx(1, "pwritev on a pipe did not fail with ESPIPE");
+    printf("preadv errors OK\n");
+
+    close(pipefds[0]);
+    close(pipefds[1]);
+    close(fd);
+    unlink(TEST_FILE);
+    return 0;
+}
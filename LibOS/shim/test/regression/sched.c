@@ -6,7 +6,8 @@
 #include <sys/time.h>
 
 /* This test checks that our dummy implementations work correctly. None of the
- * below syscalls are actually propagated to the host OS or change anything.
+ * below syscalls except for affinity are actually propagated to the host OS or
+ * change anything (affinity is covered by sched_affinity.c).
  * NOTE: This test works correctly only on Graphene (not on Linux). */
 
 int main(int argc, char** argv) {
@@ -28,8 +29,8 @@ int main(int argc, char** argv) {
     }
 
     cpu_set_t my_set;
-    CPU_ZERO(&my_set);
-    if (sched_setaffinity(0, sizeof(cpu_set_t), &my_set) == -1) {
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &my_set) == -1 ||
+            sched_setaffinity(0, sizeof(cpu_set_t), &my_set) == -1) {
         perror("Error setting affinity");
         return 1;
     }
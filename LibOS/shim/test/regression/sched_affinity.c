@@ -0,0 +1,122 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static pthread_barrier_t barrier;
+static pid_t thread_tid;
+
+static void* thread_func(void* arg) {
+    thread_tid = syscall(SYS_gettid);
+    pthread_barrier_wait(&barrier); /* tid published */
+    pthread_barrier_wait(&barrier); /* main thread done with us */
+    return NULL;
+}
+
+/* returns the number of CPUs in a sysfs list like "0-3,8", or -1 if it cannot be read */
+static int read_cpu_list(const char* path, int cpu) {
+    FILE* fp = fopen(path, "r");
+    if (!fp)
+        return -1;
+
+    int count = 0, first, last;
+    int found = cpu < 0;
+    char sep;
+    while (fscanf(fp, "%d", &first) == 1) {
+        last = first;
+        if (fscanf(fp, "%c", &sep) == 1 && sep == '-') {
+            if (fscanf(fp, "%d%c", &last, &sep) < 1)
+                break;
+        }
+        count += last - first + 1;
+        if (cpu >= first && cpu <= last)
+            found = 1;
+        if (sep != ',')
+            break;
+    }
+    fclose(fp);
+    return found ? count : -1;
+}
+
+int main(void) {
+    cpu_set_t orig, set;
+    if (sched_getaffinity(0, sizeof(orig), &orig) < 0)
+        err(1, "sched_getaffinity");
+    int ncpus = CPU_COUNT(&orig);
+    if (!ncpus)
+        errx(1, "empty affinity mask");
+
+    int cpu = -1;
+    for (int i = 0; i < CPU_SETSIZE; i++) {
+        if (CPU_ISSET(i, &orig)) {
+            cpu = i;
+            break;
+        }
+    }
+
+    /* pin ourselves to one CPU and read it back */
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) < 0)
+        err(1, "sched_setaffinity");
+    if (sched_getaffinity(0, sizeof(set), &set) < 0)
+        err(1, "sched_getaffinity after pinning");
+    if (CPU_COUNT(&set) != 1 || !CPU_ISSET(cpu, &set))
+        errx(1, "affinity was not applied (%d CPUs)", CPU_COUNT(&set));
+
+    CPU_ZERO(&set);
+    if (sched_setaffinity(0, sizeof(set), &set) == 0 || errno != EINVAL)
+        errx(1, "empty mask did not fail with EINVAL");
+
+    if (sched_setaffinity(0, sizeof(orig), &orig) < 0)
+        err(1, "restoring affinity");
+    printf("affinity self OK\n");
+
+    /* pin another thread of the process by its tid */
+    pthread_t thread;
+    pthread_barrier_init(&barrier, NULL, 2);
+    if (pthread_create(&thread, NULL, thread_func, NULL))
+        errx(1, "pthread_create");
+    pthread_barrier_wait(&barrier);
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(thread_tid, sizeof(set), &set) < 0)
+        err(1, "sched_setaffinity(thread)");
+    CPU_ZERO(&set);
+    if (sched_getaffinity(thread_tid, sizeof(set), &set) < 0)
+        err(1, "sched_getaffinity(thread)");
+    if (CPU_COUNT(&set) != 1 || !CPU_ISSET(cpu, &set))
+        errx(1, "thread affinity was not applied");
+
+    /* our own mask must not have changed */
+    if (sched_getaffinity(0, sizeof(set), &set) < 0 || !CPU_EQUAL(&set, &orig))
+        errx(1, "pinning the thread changed the caller's affinity");
+
+    pthread_barrier_wait(&barrier);
+    pthread_join(thread, NULL);
+    printf("affinity thread OK\n");
+
+    /* the emulated sysfs lists the online CPUs and their topology */
+    int online = read_cpu_list("/sys/devices/system/cpu/online", -1);
+    if (online < ncpus)
+        errx(1, "/sys/devices/system/cpu/online lists %d CPUs, %d usable", online, ncpus);
+
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list",
+             cpu);
+    if (read_cpu_list(path, cpu) < 1)
+        errx(1, "%s does not list CPU %d", path, cpu);
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_siblings_list",
+             cpu);
+    if (read_cpu_list(path, cpu) < 1)
+        errx(1, "%s does not list CPU %d", path, cpu);
+    printf("sysfs topology OK\n");
+    return 0;
+}
@@ -0,0 +1,100 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define IN_FILE   "tmp/sendfile_in"
+#define OUT_FILE  "tmp/sendfile_out"
+#define COPY_FILE "tmp/sendfile_copy"
+#define FILE_SIZE (100 * 1024)
+#define PIPE_CHUNK 4096
+
+static char data[FILE_SIZE];
+static char buf[FILE_SIZE];
+
+static void read_exactly(int fd, char* ptr, size_t size) {
+    while (size) {
+        ssize_t ret = read(fd, ptr, size);
+        if (ret <= 0)
+            err(1, "read");
+        ptr += ret;
+        size -= ret;
+    }
+}
+
+int main(void) {
+    for (int i = 0; i < FILE_SIZE; i++)
+        data[i] = 'a' + i % 26;
+
+    int in = open(IN_FILE, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (in < 0)
+        err(1, "open " IN_FILE);
+    if (write(in, data, FILE_SIZE) != FILE_SIZE)
+        err(1, "write");
+    if (lseek(in, 0, SEEK_SET) != 0)
+        err(1, "lseek");
+
+    int pipefds[2];
+    if (pipe(pipefds) < 0)
+        err(1, "pipe");
+
+    /* file -> pipe with an explicit offset, the file position must not move */
+    off_t off = 10;
+    if (sendfile(pipefds[1], in, &off, PIPE_CHUNK) != PIPE_CHUNK || off != 10 + PIPE_CHUNK)
+        errx(1, "sendfile returned a wrong count or offset");
+    read_exactly(pipefds[0], buf, PIPE_CHUNK);
+    if (memcmp(buf, data + 10, PIPE_CHUNK) || lseek(in, 0, SEEK_CUR) != 0)
+        errx(1, "sendfile transferred wrong data or moved the file position");
+    puts("sendfile OK");
+
+    /* pipe -> file at an explicit offset */
+    int out = open(OUT_FILE, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (out < 0)
+        err(1, "open " OUT_FILE);
+    if (write(pipefds[1], data, PIPE_CHUNK) != PIPE_CHUNK)
+        err(1, "write");
+    loff_t off_out = 100;
+    if (splice(pipefds[0], NULL, out, &off_out, PIPE_CHUNK, 0) != PIPE_CHUNK ||
+        off_out != 100 + PIPE_CHUNK)
+        errx(1, "splice returned a wrong count or offset");
+    struct stat st;
+    if (fstat(out, &st) < 0 || st.st_size != 100 + PIPE_CHUNK)
+        errx(1, "splice left a wrong file size");
+    if (pread(out, buf, PIPE_CHUNK, 100) != PIPE_CHUNK || memcmp(buf, data, PIPE_CHUNK))
+        errx(1, "splice transferred wrong data");
+    if (splice(in, NULL, out, NULL, PIPE_CHUNK, 0) != -1)
+        errx(1, "splice between two files succeeded");
+    puts("splice OK");
+
+    /* file -> file using the file positions */
+    int copy = open(COPY_FILE, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (copy < 0)
+        err(1, "open " COPY_FILE);
+    ssize_t total = 0;
+    while (total < FILE_SIZE) {
+        ssize_t ret = syscall(SYS_copy_file_range, in, NULL, copy, NULL, FILE_SIZE - total, 0);
+        if (ret <= 0)
+            err(1, "copy_file_range");
+        total += ret;
+    }
+    if (lseek(in, 0, SEEK_CUR) != FILE_SIZE || lseek(copy, 0, SEEK_CUR) != FILE_SIZE)
+        errx(1, "copy_file_range did not advance the file positions");
+    if (fstat(copy, &st) < 0 || st.st_size != FILE_SIZE)
+        errx(1, "copy_file_range left a wrong file size");
+    if (pread(copy, buf, FILE_SIZE, 0) != FILE_SIZE || memcmp(buf, data, FILE_SIZE))
+        errx(1, "copy_file_range transferred wrong data");
+    puts("copy_file_range OK");
+
+    close(copy);
+    close(out);
+    close(in);
+    unlink(COPY_FILE);
+    unlink(OUT_FILE);
+    unlink(IN_FILE);
+    return 0;
+}
@@ -0,0 +1,99 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define PAGES 3
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    size_t size = PAGES * sysconf(_SC_PAGESIZE);
+    key_t key   = (key_t)(0x5348 << 16 | (getpid() & 0xffff));
+
+    int id = shmget(key, size, IPC_CREAT | IPC_EXCL | 0600);
+    if (id < 0 && errno == ENOSYS) {
+        /* the host cannot share memory between processes (Linux-SGX) */
+        printf("shm not supported\n");
+        return 0;
+    }
+    if (id < 0)
+        err(1, "shmget(IPC_CREAT)");
+    if (shmget(key, 0, 0) != id)
+        errx(1, "shmget() of an existing key returned another segment");
+    if (shmget(key, size, IPC_CREAT | IPC_EXCL | 0600) >= 0 || errno != EEXIST)
+        errx(1, "shmget(IPC_EXCL) of an existing key did not fail with EEXIST");
+    if (shmget(key, 2 * size, 0) >= 0 || errno != EINVAL)
+        errx(1, "shmget() larger than the segment did not fail with EINVAL");
+    printf("shm key OK\n");
+
+    char* mem = shmat(id, NULL, 0);
+    if (mem == (void*)-1)
+        err(1, "shmat");
+    for (size_t i = 0; i < size; i++)
+        if (mem[i])
+            errx(1, "new segment is not zeroed at offset %zu", i);
+
+    struct shmid_ds ds;
+    if (shmctl(id, IPC_STAT, &ds) < 0)
+        err(1, "shmctl(IPC_STAT)");
+    if (ds.shm_segsz < size || ds.shm_nattch != 1)
+        errx(1, "IPC_STAT: size %zu, %lu attachments", (size_t)ds.shm_segsz,
+             (unsigned long)ds.shm_nattch);
+    printf("shm stat OK\n");
+
+    strcpy(mem, "parent");
+
+    pid_t pid = fork();
+    if (pid < 0)
+        err(1, "fork");
+    if (pid == 0) {
+        /* the attachment is inherited at the same address */
+        if (strcmp(mem, "parent"))
+            errx(1, "child sees \"%s\"", mem);
+        strcpy(mem + size - 16, "child");
+        if (shmdt(mem) < 0)
+            err(1, "child shmdt");
+        return 0;
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) < 0)
+        err(1, "waitpid");
+    if (!WIFEXITED(status) || WEXITSTATUS(status))
+        errx(1, "child failed");
+    printf("shm fork OK\n");
+
+    if (strcmp(mem + size - 16, "child"))
+        errx(1, "write of the child is not visible in the parent");
+    printf("shm shared OK\n");
+
+    if (shmdt(mem) < 0)
+        err(1, "shmdt");
+    if (shmdt(mem) >= 0 || errno != EINVAL)
+        errx(1, "second shmdt() did not fail with EINVAL");
+
+    mem = shmat(id, NULL, SHM_RDONLY);
+    if (mem == (void*)-1)
+        err(1, "shmat again");
+    if (strcmp(mem, "parent"))
+        errx(1, "segment lost its data after shmdt(): \"%s\"", mem);
+    printf("shm reattach OK\n");
+
+    if (shmctl(id, IPC_RMID, NULL) < 0)
+        err(1, "shmctl(IPC_RMID)");
+    /* the attachment keeps the memory of the removed segment */
+    if (strcmp(mem, "parent"))
+        errx(1, "segment lost its data after IPC_RMID");
+    if (shmdt(mem) < 0)
+        err(1, "shmdt after IPC_RMID");
+    if (shmget(key, 0, 0) >= 0 || errno != ENOENT)
+        errx(1, "shmget() of a removed segment did not fail with ENOENT");
+    printf("shm rmid OK\n");
+    return 0;
+}
@@ -0,0 +1,87 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+static void* kill_thread(void* arg) {
+    (void)arg;
+    usleep(50000);
+    if (kill(getpid(), SIGUSR2) < 0)
+        err(1, "kill");
+    return NULL;
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    sigaddset(&mask, SIGUSR2);
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) < 0)
+        err(1, "sigprocmask");
+
+    int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd < 0)
+        err(1, "signalfd");
+
+    struct signalfd_siginfo info;
+    if (read(fd, &info, sizeof(info)) >= 0 || errno != EAGAIN)
+        errx(1, "read from signalfd without pending signals did not fail with EAGAIN");
+
+    if (kill(getpid(), SIGUSR1) < 0)
+        err(1, "kill");
+
+    struct pollfd pfd = {.fd = fd, .events = POLLIN};
+    if (poll(&pfd, 1, 1000) != 1 || !(pfd.revents & POLLIN))
+        errx(1, "signalfd did not become readable");
+    if (read(fd, &info, sizeof(info)) != sizeof(info))
+        err(1, "read from signalfd");
+    if (info.ssi_signo != SIGUSR1 || info.ssi_pid != (uint32_t)getpid())
+        errx(1, "signalfd returned signal %u from %u", info.ssi_signo, info.ssi_pid);
+    if (poll(&pfd, 1, 0) != 0)
+        errx(1, "signalfd is readable after its signal was read");
+    printf("signalfd read OK\n");
+
+    /* the signal is sent while the main thread waits in epoll */
+    int epfd = epoll_create1(0);
+    if (epfd < 0)
+        err(1, "epoll_create1");
+    struct epoll_event ev = {.events = EPOLLIN, .data.fd = fd};
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+        err(1, "epoll_ctl");
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, kill_thread, NULL))
+        errx(1, "pthread_create");
+    if (epoll_wait(epfd, &ev, 1, 5000) != 1 || ev.data.fd != fd)
+        errx(1, "signalfd did not wake up epoll_wait");
+    if (read(fd, &info, sizeof(info)) != sizeof(info) || info.ssi_signo != SIGUSR2)
+        errx(1, "signalfd did not return SIGUSR2");
+    pthread_join(thread, NULL);
+    printf("signalfd epoll OK\n");
+
+    /* changing the mask of an existing signalfd */
+    sigdelset(&mask, SIGUSR1);
+    if (signalfd(fd, &mask, 0) != fd)
+        err(1, "signalfd(fd)");
+    if (kill(getpid(), SIGUSR1) < 0)
+        err(1, "kill");
+    if (read(fd, &info, sizeof(info)) >= 0 || errno != EAGAIN)
+        errx(1, "signalfd returned a signal which is not in its mask");
+
+    sigset_t pending;
+    if (sigpending(&pending) < 0 || !sigismember(&pending, SIGUSR1))
+        errx(1, "SIGUSR1 is not pending anymore");
+    printf("signalfd mask OK\n");
+
+    close(epfd);
+    close(fd);
+    return 0;
+}
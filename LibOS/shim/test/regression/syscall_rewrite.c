@@ -0,0 +1,91 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NTRIES 1000
+
+long raw_getpid_eax(void);
+long raw_getpid_rax(void);
+long raw_getpid_jump(void);
+long raw_getpid_r8d(void);
+
+/* Functions with symbols, so that the loader finds them and decodes them instruction by
+ * instruction. The first two are rewritten at load time. In the third one the syscall instruction
+ * is reached through a jump, which must still be emulated. The last one moves the number to %r8d
+ * (41 b8 <imm32>), which must not be mistaken for "mov $nr, %eax". */
+__asm__(".pushsection .text\n"
+        ".global raw_getpid_eax\n"
+        ".type raw_getpid_eax, @function\n"
+        "raw_getpid_eax:\n"
+        "movl $39, %eax\n"
+        "syscall\n"
+        "ret\n"
+        ".size raw_getpid_eax, .-raw_getpid_eax\n"
+
+        ".global raw_getpid_rax\n"
+        ".type raw_getpid_rax, @function\n"
+        "raw_getpid_rax:\n"
+        "movq $39, %rax\n"
+        "syscall\n"
+        "ret\n"
+        ".size raw_getpid_rax, .-raw_getpid_rax\n"
+
+        ".global raw_getpid_jump\n"
+        ".type raw_getpid_jump, @function\n"
+        "raw_getpid_jump:\n"
+        "movl $39, %eax\n"
+        "jmp 1f\n"
+        "movl $39, %eax\n"
+        "1: syscall\n"
+        "ret\n"
+        ".size raw_getpid_jump, .-raw_getpid_jump\n"
+
+        ".global raw_getpid_r8d\n"
+        ".type raw_getpid_r8d, @function\n"
+        "raw_getpid_r8d:\n"
+        "movl $39, %eax\n"
+        "movl $39, %r8d\n"
+        "syscall\n"
+        "ret\n"
+        ".size raw_getpid_r8d, .-raw_getpid_r8d\n"
+        ".popsection\n");
+
+/* the mov at `site` was replaced by a jump to a trampoline which starts with the original mov */
+static int is_rewritten(const uint8_t* site, const uint8_t* mov, size_t mov_len) {
+    if (site[0] != 0xe9)
+        return 0;
+    int32_t rel;
+    memcpy(&rel, site + 1, sizeof(rel));
+    return !memcmp(site + 5 + rel, mov, mov_len);
+}
+
+int main(void) {
+    long pid = getpid();
+
+    static const uint8_t mov_eax[] = {0xb8, 39, 0, 0, 0};
+    static const uint8_t mov_rax[] = {0x48, 0xc7, 0xc0, 39, 0, 0, 0};
+    static const uint8_t mov_r8d[] = {0x41, 0xb8, 39, 0, 0, 0, 0x0f, 0x05};
+
+    if (!is_rewritten((uint8_t*)raw_getpid_eax, mov_eax, sizeof(mov_eax)) ||
+        !is_rewritten((uint8_t*)raw_getpid_rax, mov_rax, sizeof(mov_rax))) {
+        printf("Syscall sites were not rewritten\n");
+        return 1;
+    }
+    if (memcmp((uint8_t*)raw_getpid_r8d + 5, mov_r8d, sizeof(mov_r8d))) {
+        printf("A mov to %%r8d was rewritten\n");
+        return 1;
+    }
+    printf("Syscall sites rewritten OK\n");
+
+    for (int i = 0; i < NTRIES; i++) {
+        if (raw_getpid_eax() != pid || raw_getpid_rax() != pid || raw_getpid_jump() != pid ||
+            raw_getpid_r8d() != pid) {
+            printf("Raw syscall returned a wrong result\n");
+            return 1;
+        }
+    }
+
+    printf("Raw syscalls OK\n");
+    return 0;
+}
@@ -0,0 +1,35 @@
+#include <stdio.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define NCALLS 100
+
+int main(void) {
+    for (int i = 0; i < NCALLS; i++)
+        syscall(SYS_getppid);
+
+    FILE* fp = fopen("/proc/syscall_stats", "r");
+    if (!fp) {
+        perror("fopen");
+        return 1;
+    }
+
+    char line[1024];
+    unsigned long calls = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        if (!strncmp(line, "getppid ", strlen("getppid "))) {
+            sscanf(line + strlen("getppid "), "%lu", &calls);
+            break;
+        }
+    }
+    fclose(fp);
+
+    if (calls < NCALLS) {
+        printf("getppid counted %lu times, expected at least %d\n", calls, NCALLS);
+        return 1;
+    }
+
+    printf("Syscall stats OK\n");
+    return 0;
+}
@@ -336,6 +336,39 @@ class TC_30_Syscall(RegressionTestCase):
 
         self.assertIn('Test successful!', stdout)
 
+    def test_054_mremap(self):
+        stdout, _ = self.run_binary(['mremap'])
+
+        self.assertIn('mremap in place OK', stdout)
+        self.assertIn('mremap move OK', stdout)
+        self.assertIn('mremap shrink OK', stdout)
+        self.assertIn('mremap fixed OK', stdout)
+
+    def test_055_madvise(self):
+        stdout, _ = self.run_binary(['madvise'])
+
+        self.assertIn('madvise MADV_DONTNEED OK', stdout)
+        self.assertIn('madvise MADV_FREE OK', stdout)
+        self.assertIn('madvise shared OK', stdout)
+        self.assertIn('madvise errors OK', stdout)
+
+    @unittest.skipIf(HAS_SGX, 'SysV shm is not supported on SGX')
+    def test_056_shm(self):
+        stdout, _ = self.run_binary(['shm'])
+
+        self.assertIn('shm key OK', stdout)
+        self.assertIn('shm stat OK', stdout)
+        self.assertIn('shm fork OK', stdout)
+        self.assertIn('shm shared OK', stdout)
+        self.assertIn('shm reattach OK', stdout)
+        self.assertIn('shm rmid OK', stdout)
+
+    @unittest.skipUnless(HAS_SGX, 'This test is only meaningful on SGX PAL')
+    def test_057_shm_sgx(self):
+        stdout, _ = self.run_binary(['shm'])
+
+        self.assertIn('shm not supported', stdout)
+
     @unittest.skip('sigaltstack isn\'t correctly implemented')
     def test_060_sigaltstack(self):
         stdout, _ = self.run_binary(['sigaltstack'])
@@ -363,12 +396,33 @@ class TC_30_Syscall(RegressionTestCase):
         self.assertIn('eventfd_using_various_flags completed successfully', stdout)
         self.assertIn('eventfd_using_fork completed successfully', stdout)
 
+    def test_071_timerfd(self):
+        stdout, _ = self.run_binary(['timerfd'])
+
+        self.assertIn('timerfd oneshot OK', stdout)
+        self.assertIn('timerfd periodic OK', stdout)
+        self.assertIn('timerfd disarm OK', stdout)
+
+    def test_072_signalfd(self):
+        stdout, _ = self.run_binary(['signalfd'])
+
+        self.assertIn('signalfd read OK', stdout)
+        self.assertIn('signalfd epoll OK', stdout)
+        self.assertIn('signalfd mask OK', stdout)
+
     def test_080_sched(self):
         stdout, _ = self.run_binary(['sched'])
 
         # Scheduling Syscalls Test
         self.assertIn('Test completed successfully', stdout)
 
+    def test_081_sched_affinity(self):
+        stdout, _ = self.run_binary(['sched_affinity'])
+
+        self.assertIn('affinity self OK', stdout)
+        self.assertIn('affinity thread OK', stdout)
+        self.assertIn('sysfs topology OK', stdout)
+
     def test_090_sighandler_reset(self):
         stdout, _ = self.run_binary(['sighandler_reset'])
         self.assertIn('Got signal 17', stdout)
@@ -385,6 +439,11 @@ class TC_31_SyscallSGX(RegressionTestCase):
         # Syscall Instruction Redirection
         self.assertIn('Hello world', stdout)
 
+    def test_010_syscall_rewrite(self):
+        stdout, _ = self.run_binary(['syscall_rewrite'])
+        self.assertIn('Syscall sites rewritten OK', stdout)
+        self.assertIn('Raw syscalls OK', stdout)
+
 class TC_40_FileSystem(RegressionTestCase):
     def test_000_proc(self):
         stdout, _ = self.run_binary(['proc'])
@@ -443,6 +502,35 @@ class TC_40_FileSystem(RegressionTestCase):
         stdout, _ = self.run_binary(['str_close_leak'], timeout=60)
         self.assertIn("Success", stdout)
 
+    def test_050_syscall_stats(self):
+        stdout, _ = self.run_binary(['syscall_stats'])
+        self.assertIn('Syscall stats OK', stdout)
+
+    def test_060_sendfile(self):
+        stdout, _ = self.run_binary(['sendfile'])
+        self.assertIn('sendfile OK', stdout)
+        self.assertIn('splice OK', stdout)
+        self.assertIn('copy_file_range OK', stdout)
+
+    def test_070_aio(self):
+        stdout, _ = self.run_binary(['aio'])
+        self.assertIn('aio read/write OK', stdout)
+        self.assertIn('aio vector/eventfd OK', stdout)
+        self.assertIn('aio errors OK', stdout)
+
+    def test_080_preadv(self):
+        stdout, _ = self.run_binary(['preadv'])
+        self.assertIn('preadv/pwritev OK', stdout)
+        self.assertIn('readv/writev position OK', stdout)
+        self.assertIn('preadv errors OK', stdout)
+
+    def test_090_fallocate(self):
+        stdout, _ = self.run_binary(['fallocate'])
+        self.assertIn('fallocate OK', stdout)
+        self.assertIn('fallocate punch hole OK', stdout)
+        self.assertIn('fadvise/readahead/sync_file_range OK', stdout)
+        self.assertIn('fallocate errors OK', stdout)
+
 class TC_80_Socket(RegressionTestCase):
     def test_000_getsockopt(self):
         stdout, _ = self.run_binary(['getsockopt'])
@@ -456,6 +544,10 @@ class TC_80_Socket(RegressionTestCase):
         # epoll_wait timeout
         self.assertIn('epoll_wait test passed', stdout)
 
+    def test_011_epoll_dup(self):
+        stdout, _ = self.run_binary(['epoll_dup'])
+        self.assertIn("epoll with dup'd fds OK", stdout)
+
     def test_020_poll(self):
         stdout, _ = self.run_binary(['poll'])
         self.assertIn('poll(POLLOUT) returned 1 file descriptors', stdout)
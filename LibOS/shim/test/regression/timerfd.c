@@ -0,0 +1,100 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PERIOD_NS 20000000L /* 20ms */
+
+static uint64_t read_expirations(int fd) {
+    uint64_t count;
+    ssize_t ret = read(fd, &count, sizeof(count));
+    if (ret != sizeof(count))
+        err(1, "read from timerfd");
+    return count;
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0)
+        err(1, "timerfd_create");
+
+    uint64_t count;
+    if (read(fd, &count, sizeof(count)) >= 0 || errno != EAGAIN)
+        errx(1, "read from a disarmed timerfd did not fail with EAGAIN");
+
+    struct itimerspec its = {.it_value = {.tv_nsec = PERIOD_NS}};
+    if (timerfd_settime(fd, 0, &its, NULL) < 0)
+        err(1, "timerfd_settime");
+
+    struct itimerspec cur;
+    if (timerfd_gettime(fd, &cur) < 0)
+        err(1, "timerfd_gettime");
+    if (cur.it_value.tv_sec != 0 || cur.it_value.tv_nsec <= 0 || cur.it_value.tv_nsec > PERIOD_NS)
+        errx(1, "timerfd_gettime reports %ld.%09ld s left", (long)cur.it_value.tv_sec,
+             cur.it_value.tv_nsec);
+
+    struct pollfd pfd = {.fd = fd, .events = POLLIN};
+    if (poll(&pfd, 1, 1000) != 1 || !(pfd.revents & POLLIN))
+        errx(1, "one-shot timerfd did not become readable");
+    if ((count = read_expirations(fd)) != 1)
+        errx(1, "one-shot timerfd expired %lu times", (unsigned long)count);
+    if (poll(&pfd, 1, 3 * PERIOD_NS / 1000000) != 0)
+        errx(1, "one-shot timerfd is readable after being read");
+    printf("timerfd oneshot OK\n");
+
+    /* periodic timer: expirations accumulate while nobody reads */
+    its.it_interval.tv_nsec = PERIOD_NS;
+    if (timerfd_settime(fd, 0, &its, NULL) < 0)
+        err(1, "timerfd_settime");
+    struct timespec ts = {.tv_nsec = 5 * PERIOD_NS + PERIOD_NS / 2};
+    nanosleep(&ts, NULL);
+    count = read_expirations(fd);
+    if (count < 4 || count > 7)
+        errx(1, "periodic timerfd expired %lu times in 5.5 periods", (unsigned long)count);
+
+    int epfd = epoll_create1(0);
+    if (epfd < 0)
+        err(1, "epoll_create1");
+    struct epoll_event ev = {.events = EPOLLIN, .data.fd = fd};
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+        err(1, "epoll_ctl");
+    for (int i = 0; i < 3; i++) {
+        if (epoll_wait(epfd, &ev, 1, 1000) != 1 || ev.data.fd != fd)
+            errx(1, "periodic timerfd did not wake up epoll_wait");
+        read_expirations(fd);
+    }
+    printf("timerfd periodic OK\n");
+
+    /* disarming discards pending expirations */
+    struct itimerspec old;
+    struct itimerspec disarm = {0};
+    nanosleep(&ts, NULL);
+    if (timerfd_settime(fd, 0, &disarm, &old) < 0)
+        err(1, "timerfd_settime(disarm)");
+    if (old.it_interval.tv_sec != 0 || old.it_interval.tv_nsec != PERIOD_NS)
+        errx(1, "timerfd_settime returned a wrong old interval");
+    if (read(fd, &count, sizeof(count)) >= 0 || errno != EAGAIN)
+        errx(1, "disarmed timerfd still has expirations");
+
+    /* absolute expiration time in the past expires immediately */
+    if (clock_gettime(CLOCK_MONOTONIC, &its.it_value) < 0)
+        err(1, "clock_gettime");
+    its.it_interval.tv_nsec = 0;
+    if (timerfd_settime(fd, TFD_TIMER_ABSTIME, &its, NULL) < 0)
+        err(1, "timerfd_settime(TFD_TIMER_ABSTIME)");
+    if (epoll_wait(epfd, &ev, 1, 1000) != 1 || read_expirations(fd) != 1)
+        errx(1, "absolute timerfd did not expire");
+    printf("timerfd disarm OK\n");
+
+    close(epfd);
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,39 @@
+#ifndef FUTEX_LOCK_H
+#define FUTEX_LOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Futex-based mutexes and events shared by the Linux and Linux-SGX PALs. Only the futex words
+ * themselves must be visible to the host (on SGX they are in untrusted memory); everything else
+ * may be kept private.
+ *
+ * A mutex is a three-state futex word (based on "Futexes Are Tricky" by Ulrich Drepper): lockers
+ * first spin for a bounded, adaptively tuned number of iterations, and only mark the mutex as
+ * contended right before sleeping in the host. Unlocking wakes a waiter only if the mutex was
+ * marked as contended, so uncontended handoffs never leave the PAL.
+ *
+ * An event is a futex word which is 1 when signaled, plus a count of the waiters that may sleep
+ * in the host. Setting an event wakes the host only if there are such waiters.
+ */
+
+#define FUTEX_LOCK_UNLOCKED  0
+#define FUTEX_LOCK_LOCKED    1 /* locked, no waiters sleeping in the host */
+#define FUTEX_LOCK_CONTENDED 2 /* locked, waiters may sleep in the host */
+
+/* Upper bound of the adaptive spinning before sleeping in the host */
+#define FUTEX_LOCK_MAX_SPINS 100
+
+/* `spins` is the running average of spins needed to take the mutex (may be updated racily) */
+int futex_lock_timeout(int* word, int* spins, int64_t timeout_us);
+void futex_unlock(int* word);
+
+int futex_event_wait(int* signaled, int* nwaiters, bool isnotification, int64_t timeout_us);
+int futex_event_set(int* signaled, int* nwaiters, bool isnotification, int wakeup);
+
+/* Host futex operations, implemented by each PAL; return 0 or a negative Linux errno */
+int host_futex_wait(int* addr, int val, int64_t timeout_us);
+int host_futex_wake(int* addr, int nwake);
+
+#endif // FUTEX_LOCK_H
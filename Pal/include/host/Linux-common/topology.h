@@ -0,0 +1,23 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <stddef.h>
+
+#include "pal.h"
+
+/*
+ * CPU and NUMA topology of the host, read from sysfs and shared by the Linux and Linux-SGX PALs.
+ * On SGX the files are read through OCALLs, so the result is only a hint for thread placement and
+ * must never be used to index anything by itself.
+ */
+
+/* Fills `cpu_topology`, `cpu_sockets`, `cpu_cores` and `numa_nodes` of `ci`, whose `cpu_num` must
+ * already be set. If the host does not expose its topology, `cpu_topology` is left NULL and the
+ * counts describe a single socket and node; returns 0 or a negative PAL error. */
+int get_cpu_topology(PAL_CPU_INFO* ci);
+
+/* Reads at most `size - 1` bytes of a host pseudo-file and NUL-terminates them, implemented by each
+ * PAL; returns the number of bytes read or a negative Linux errno */
+int host_read_sysfs(const char* path, char* buf, size_t size);
+
+#endif // TOPOLOGY_H
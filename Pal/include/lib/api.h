@@ -206,6 +206,12 @@ extern const char * const * sys_errlist_internal;
 int get_norm_path(const char* path, char* buf, size_t* size);
 int get_base_name(const char* path, char* buf, size_t* size);
 
+/* Parsing CPU lists like "0-3,8" */
+
+int parse_cpu_list(const char* str, unsigned long max_id, int (*fn)(unsigned long id, void* arg),
+                   void* arg);
+int parse_cpu_mask(const char* str, unsigned long* mask, size_t bits);
+
 /* Loading configs / manifests */
 
 #include <list.h>
@@ -248,6 +254,7 @@ int set_config (struct config_store * cfg, const char * key, const char * val);
 #define URI_TYPE_DEV            "dev"
 #define URI_TYPE_EVENTFD        "eventfd"
 #define URI_TYPE_FILE           "file"
+#define URI_TYPE_SHM            "shm"
 
 #define URI_PREFIX_DIR          URI_TYPE_DIR        URI_PREFIX_SEPARATOR
 #define URI_PREFIX_TCP          URI_TYPE_TCP        URI_PREFIX_SEPARATOR
@@ -259,6 +266,7 @@ int set_config (struct config_store * cfg, const char * key, const char * val);
 #define URI_PREFIX_DEV          URI_TYPE_DEV        URI_PREFIX_SEPARATOR
 #define URI_PREFIX_EVENTFD      URI_TYPE_EVENTFD    URI_PREFIX_SEPARATOR
 #define URI_PREFIX_FILE         URI_TYPE_FILE       URI_PREFIX_SEPARATOR
+#define URI_PREFIX_SHM          URI_TYPE_SHM        URI_PREFIX_SEPARATOR
 
 #define URI_PREFIX_FILE_LEN     (static_strlen(URI_PREFIX_FILE))
 
@@ -103,6 +103,9 @@ typedef struct pal_tcb {
     struct pal_tcb * self;
     /* uint64_t for alignment */
     uint64_t libos_tcb[(PAL_LIBOS_TCB_SIZE + sizeof(uint64_t) - 1) / sizeof(uint64_t)];
+    /* per-thread statistics, maintained by the PAL (currently only on Linux-SGX) */
+    PAL_NUM host_calls; /*!< calls to the untrusted host (OCALLs, including exitless ones) */
+    PAL_NUM host_exits; /*!< enclave exits (OCALLs with an exit and asynchronous exits) */
     /* data private to PAL implementation follows this struct. */
 } PAL_TCB;
 
@@ -270,6 +273,7 @@ enum {
     pal_type_mutex,
     pal_type_event,
     pal_type_eventfd,
+    pal_type_waitset,
     PAL_HANDLE_TYPE_BOUND,
 };
 
@@ -280,6 +284,14 @@ enum {
 
 typedef struct PAL_PTR_RANGE_ { PAL_PTR start, end; } PAL_PTR_RANGE;
 
+/*! Placement of one online CPU, as reported by the host */
+typedef struct PAL_CPU_TOPO_ {
+    PAL_NUM id;     /*!< CPU number, as used in affinity masks */
+    PAL_NUM socket; /*!< physical package id */
+    PAL_NUM core;   /*!< core id within the package (shared by hyper-threads) */
+    PAL_NUM node;   /*!< NUMA node */
+} PAL_CPU_TOPO;
+
 typedef struct PAL_CPU_INFO_ {
     PAL_NUM cpu_num;
     PAL_STR cpu_vendor;
@@ -289,12 +301,25 @@ typedef struct PAL_CPU_INFO_ {
     PAL_NUM cpu_stepping;
     double  cpu_bogomips;
     PAL_STR cpu_flags;
+    PAL_NUM cpu_sockets; /*!< number of physical packages */
+    PAL_NUM cpu_cores;   /*!< number of physical cores (all packages) */
+    PAL_NUM numa_nodes;  /*!< number of NUMA nodes */
+    /*! array of cpu_num entries sorted by id, NULL if the host does not expose the topology; on
+     *  SGX this is an untrusted hint */
+    PAL_CPU_TOPO* cpu_topology;
 } PAL_CPU_INFO;
 
 typedef struct PAL_MEM_INFO_ {
     PAL_NUM mem_total;
 } PAL_MEM_INFO;
 
+/*! A phase of the PAL startup (including its host part), see PAL_CONTROL::startup_events */
+typedef struct PAL_STARTUP_EVENT_ {
+    PAL_STR name;  /*!< static string */
+    PAL_NUM start; /*!< in microseconds, on the same clock as DkSystemTimeQuery() */
+    PAL_NUM end;
+} PAL_STARTUP_EVENT;
+
 /********** PAL APIs **********/
 typedef struct PAL_CONTROL_ {
     PAL_STR host_type;
@@ -341,6 +366,17 @@ typedef struct PAL_CONTROL_ {
 
     PAL_CPU_INFO cpu_info; /*!< CPU information (only required ones) */
     PAL_MEM_INFO mem_info; /*!< memory information (only required ones) */
+
+    /*
+     * Startup tracing
+     */
+    PAL_STARTUP_EVENT* startup_events; /*!< phases of the PAL startup, in recording order */
+    PAL_NUM startup_events_num;
+
+    /*
+     * Statistics
+     */
+    PAL_NUM host_futex_calls; /*!< futex calls to the host by mutexes and events, so far */
 } PAL_CONTROL;
 
 #define pal_control (*pal_control_addr())
@@ -407,6 +443,38 @@ DkVirtualMemoryFree(PAL_PTR addr, PAL_NUM size);
 PAL_BOL
 DkVirtualMemoryProtect(PAL_PTR addr, PAL_NUM size, PAL_FLG prot);
 
+/*!
+ * \brief Move a previously allocated memory mapping to a new address.
+ *
+ * \param addr the current address of the mapping
+ * \param new_addr the address to move the mapping to
+ * \param size the size
+ *
+ * After the call, the contents and permissions of [addr, addr + size) are found at
+ * [new_addr, new_addr + size) and the old range is deallocated. Any memory previously allocated at
+ * the new address is replaced. The two ranges must not overlap. Hosts that support it move the
+ * underlying pages instead of copying them.
+ *
+ * All of `addr`, `new_addr` and `size` must be non-zero and aligned at the allocation alignment.
+ */
+PAL_BOL
+DkVirtualMemoryRemap(PAL_PTR addr, PAL_PTR new_addr, PAL_NUM size);
+
+/*!
+ * \brief Discard the contents of a previously allocated memory mapping.
+ *
+ * \param addr the address
+ * \param size the size
+ *
+ * The range stays allocated with the same permissions, but reads as zeros afterwards. Hosts that
+ * support it give the backing physical memory back until the pages are touched again. Only meant
+ * for memory allocated with #DkVirtualMemoryAlloc().
+ *
+ * Both `addr` and `size` must be non-zero and aligned at the allocation alignment.
+ */
+PAL_BOL
+DkVirtualMemoryDiscard(PAL_PTR addr, PAL_NUM size);
+
 
 /*
  * PROCESS CREATION
@@ -516,6 +584,10 @@ enum PAL_OPTION {
  *   a remote TCP socket.
  * * `udp.srv:<ADDR>:<PORT>`, `udp:<ADDR>:<PORT>`: Open a UDP socket to listen or connect to
  *   a remote UDP socket.
+ * * `shm:<name>`: Open a shared memory object visible to all processes of the current instance.
+ *   The returned handle behaves like a file handle; DkStreamMap() of a writable handle creates
+ *   a mapping shared with the other processes. Not supported by hosts which cannot share memory
+ *   between processes (e.g. Linux-SGX).
  */
 PAL_HANDLE
 DkStreamOpen(PAL_STR uri, PAL_FLG access, PAL_FLG share_flags, PAL_FLG create, PAL_FLG options);
@@ -550,6 +622,48 @@ DkStreamRead(PAL_HANDLE handle, PAL_NUM offset, PAL_NUM count, PAL_PTR buffer, P
 PAL_NUM
 DkStreamWrite(PAL_HANDLE handle, PAL_NUM offset, PAL_NUM count, PAL_PTR buffer, PAL_STR dest);
 
+/*! a buffer of DkStreamReadVector() and DkStreamWriteVector(), laid out like `struct iovec` */
+typedef struct PAL_IOVEC_ {
+    PAL_PTR buffer;
+    PAL_NUM size;
+} PAL_IOVEC;
+
+/*!
+ * \brief Read data from an open file into several buffers with one host call.
+ *
+ * Fills the `vlen` buffers of `vec` in order, as one DkStreamRead() of their concatenation at
+ * `offset` would. Only files support this; on failure with `PAL_ERROR_NOTSUPPORT`, the caller
+ * should fall back to one DkStreamRead() per buffer.
+ *
+ * \return The number of bytes read, or PAL_STREAM_ERROR on failure (`PAL_ERROR_ENDOFSTREAM` at
+ *         the end of the file).
+ */
+PAL_NUM
+DkStreamReadVector(PAL_HANDLE handle, PAL_NUM offset, PAL_IOVEC* vec, PAL_NUM vlen);
+
+/*!
+ * \brief Write data from several buffers to an open file with one host call.
+ *
+ * The counterpart of DkStreamReadVector(), writing the concatenation of the buffers at `offset`.
+ */
+PAL_NUM
+DkStreamWriteVector(PAL_HANDLE handle, PAL_NUM offset, PAL_IOVEC* vec, PAL_NUM vlen);
+
+/*!
+ * \brief Transfer data from one open stream to another without copying it into the caller.
+ *
+ * Moves up to `count` bytes from `src` to `dst` on the host (e.g., with `sendfile` or `splice`).
+ * `src_offset` and `dst_offset` are only used if the respective handle is a file. Not all
+ * combinations of streams are supported; in particular, the Linux-SGX PAL refuses trusted files
+ * and encrypted pipes, whose data must be processed inside the enclave. On failure with
+ * `PAL_ERROR_NOTSUPPORT`, the caller should fall back to DkStreamRead() and DkStreamWrite().
+ *
+ * \return The number of bytes transferred (0 at the end of `src`), or PAL_STREAM_ERROR on failure.
+ */
+PAL_NUM
+DkStreamTransfer(PAL_HANDLE src, PAL_NUM src_offset, PAL_HANDLE dst, PAL_NUM dst_offset,
+                 PAL_NUM count);
+
 enum PAL_DELETE {
     PAL_DELETE_RD = 01, /*!< shut down the read side only */
     PAL_DELETE_WR = 02, /*!< shut down the write side only */
@@ -597,6 +711,58 @@ DkStreamSetLength(PAL_HANDLE handle, PAL_NUM length);
 PAL_BOL
 DkStreamFlush(PAL_HANDLE handle);
 
+/*! flags of DkStreamAllocate() */
+enum PAL_ALLOCATE {
+    PAL_ALLOCATE_KEEP_SIZE  = 1, /*!< do not change the length of the file */
+    PAL_ALLOCATE_PUNCH_HOLE = 2, /*!< deallocate the range instead, requires KEEP_SIZE */
+};
+
+/*!
+ * \brief Allocate the storage of a range of a file.
+ *
+ * Afterwards writes to the range do not fail for lack of space. The file is extended if the range
+ * ends beyond it, unless #PAL_ALLOCATE_KEEP_SIZE is given. Only files support this, and not all
+ * hosts do (`PAL_ERROR_NOTSUPPORT`).
+ */
+PAL_BOL
+DkStreamAllocate(PAL_HANDLE handle, PAL_NUM offset, PAL_NUM length, PAL_FLG flags);
+
+/*! access patterns of DkStreamAdvise() */
+enum PAL_ADVICE {
+    PAL_ADVICE_NORMAL = 0,
+    PAL_ADVICE_RANDOM,
+    PAL_ADVICE_SEQUENTIAL,
+    PAL_ADVICE_WILLNEED, /*!< the range will be read soon, e.g. read it ahead */
+    PAL_ADVICE_DONTNEED, /*!< the range will not be read soon, e.g. drop it from caches */
+    PAL_ADVICE_NOREUSE,
+};
+
+/*!
+ * \brief Tell how a range of a file is going to be accessed.
+ *
+ * Only a hint: it does not change the contents of the file. A `length` of 0 means up to the end of
+ * the file.
+ */
+PAL_BOL
+DkStreamAdvise(PAL_HANDLE handle, PAL_NUM offset, PAL_NUM length, PAL_FLG advice);
+
+/*! flags of DkStreamSyncRange() */
+enum PAL_SYNC_RANGE {
+    PAL_SYNC_RANGE_WAIT_BEFORE = 1, /*!< wait for the write-back already going on */
+    PAL_SYNC_RANGE_WRITE       = 2, /*!< start the write-back of the modified data */
+    PAL_SYNC_RANGE_WAIT_AFTER  = 4, /*!< wait for the write-back to finish */
+};
+
+/*!
+ * \brief Write back the modified data of a range of a file.
+ *
+ * Unlike DkStreamFlush(), neither the metadata of the file is written nor, without
+ * #PAL_SYNC_RANGE_WAIT_AFTER, is the write-back waited for. A `length` of 0 means up to the end of
+ * the file.
+ */
+PAL_BOL
+DkStreamSyncRange(PAL_HANDLE handle, PAL_NUM offset, PAL_NUM length, PAL_FLG flags);
+
 /*!
  * \brief Send a PAL handle over another handle.
  *
@@ -715,6 +881,29 @@ noreturn void DkThreadExit(PAL_PTR clear_child_tid);
 PAL_BOL
 DkThreadResume(PAL_HANDLE thread);
 
+/*!
+ * \brief Set the CPU affinity of a thread.
+ *
+ * \param thread the thread to pin; NULL means the current thread
+ * \param cpumask_size size of `cpu_mask` in bytes, a multiple of `sizeof(long)`
+ * \param cpu_mask bitmask of allowed CPUs, in the layout of the Linux `cpu_set_t`
+ *
+ * On Linux-SGX the mask is applied to the host thread currently running the enclave thread.
+ */
+PAL_BOL
+DkThreadSetCpuAffinity(PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask);
+
+/*!
+ * \brief Get the CPU affinity of a thread.
+ *
+ * \param thread the thread to query; NULL means the current thread
+ * \param cpumask_size size of `cpu_mask` in bytes, a multiple of `sizeof(long)`
+ * \param cpu_mask buffer which receives the bitmask of allowed CPUs; bits of CPUs beyond the
+ *  host's maximum CPU number are left untouched
+ */
+PAL_BOL
+DkThreadGetCpuAffinity(PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask);
+
 /*
  * Exception Handling
  */
@@ -848,6 +1037,48 @@ enum PAL_WAIT {
 PAL_BOL DkStreamsWaitEvents(PAL_NUM count, PAL_HANDLE* handle_array, PAL_FLG* events,
                             PAL_FLG* ret_events, PAL_NUM timeout_us);
 
+/*!
+ * \brief Create a wait set
+ *
+ * A wait set is a set of handles which is kept by the host between waits, so that the cost of
+ * waiting does not depend on the number of handles in the set. Handles are added, modified and
+ * removed with DkWaitSetUpdate() and waited on with DkWaitSetWait(). Close the wait set with
+ * DkObjectClose().
+ *
+ * \return the wait set handle, or NULL on failure
+ */
+PAL_HANDLE DkWaitSetCreate(void);
+
+/*!
+ * \brief Add, modify or remove a handle in a wait set
+ *
+ * \param wait_set the wait set
+ * \param handle a stream handle
+ * \param events PAL_WAIT_READ and/or PAL_WAIT_WRITE to add the handle or change its events, or 0
+ *  to remove the handle from the wait set. Removal does not access the handle, so a handle closed
+ *  while in the wait set can (and should) still be removed. A handle reported with
+ *  PAL_WAIT_ERROR keeps being reported until it is removed.
+ * \return true on success, false otherwise
+ */
+PAL_BOL DkWaitSetUpdate(PAL_HANDLE wait_set, PAL_HANDLE handle, PAL_FLG events);
+
+/*!
+ * \brief Wait for events on the handles of a wait set
+ *
+ * \param wait_set the wait set
+ * \param count the size of `handle_array` and `ret_events`
+ * \param[out] handle_array handles with pending events
+ * \param[out] ret_events pending events of the handles in `handle_array`
+ * \param timeout_us is the maximum time that the API should wait (in
+ *  microseconds), or `NO_TIMEOUT` to indicate it is to be blocked until at
+ *  least one handle is ready.
+ * \return the number of handles with pending events, or 0 on failure. The error is
+ *  PAL_ERROR_TRYAGAIN on timeout and if all handles with events were removed during the wait,
+ *  and PAL_ERROR_INTERRUPTED if the wait was interrupted.
+ */
+PAL_NUM DkWaitSetWait(PAL_HANDLE wait_set, PAL_NUM count, PAL_HANDLE* handle_array,
+                      PAL_FLG* ret_events, PAL_NUM timeout_us);
+
 /*!
  * \brief Close (deallocate) a PAL handle.
  */
@@ -0,0 +1,86 @@
+/* Copyright (C) 2014 Stony Brook University
+   This file is part of Graphene Library OS.
+
+   Graphene Library OS is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   as published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+   Graphene Library OS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/*
+ * cpu_list.c
+ *
+ * This file contains functions to parse CPU lists like "0-3,8,10-11", as found in sysfs (for CPUs
+ * and NUMA nodes) and in manifest options.
+ */
+
+#include <api.h>
+#include <pal_error.h>
+
+static bool is_list_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n';
+}
+
+/*
+ * Calls `fn` for every number of the list `str`, in the order of the list, and stops at the first
+ * error returned by `fn`. Items are separated by commas or white space. Numbers greater than
+ * `max_id` are skipped without calling `fn`, so that the cost of parsing is bounded by `max_id`
+ * even if the list comes from an untrusted source.
+ * Returns 0 on success, -PAL_ERROR_INVAL if the list is malformed or the error of `fn`.
+ */
+int parse_cpu_list(const char* str, unsigned long max_id, int (*fn)(unsigned long id, void* arg),
+                   void* arg) {
+    const char* ptr = str;
+    while (*ptr) {
+        while (*ptr == ',' || is_list_space(*ptr))
+            ptr++;
+        if (!*ptr)
+            break;
+
+        char* end;
+        long first = strtol(ptr, &end, 10);
+        if (end == ptr || first < 0)
+            return -PAL_ERROR_INVAL;
+
+        long last = first;
+        if (*end == '-') {
+            ptr  = end + 1;
+            last = strtol(ptr, &end, 10);
+            if (end == ptr || last < first)
+                return -PAL_ERROR_INVAL;
+        }
+
+        if (*end && *end != ',' && !is_list_space(*end))
+            return -PAL_ERROR_INVAL;
+
+        if ((unsigned long)last > max_id)
+            last = max_id;
+        for (long id = first; id <= last; id++) {
+            int ret = fn(id, arg);
+            if (ret < 0)
+                return ret;
+        }
+        ptr = end;
+    }
+    return 0;
+}
+
+static int set_cpu_bit(unsigned long id, void* arg) {
+    unsigned long* mask = arg;
+    mask[id / (sizeof(long) * 8)] |= 1UL << (id % (sizeof(long) * 8));
+    return 0;
+}
+
+/* Sets the bits of the CPUs of the list `str` in `mask`; CPUs beyond `bits` are ignored. */
+int parse_cpu_mask(const char* str, unsigned long* mask, size_t bits) {
+    if (!bits)
+        return 0;
+    return parse_cpu_list(str, bits - 1, set_cpu_bit, mask);
+}
@@ -44,6 +44,23 @@ int main(int argc, char** argv) {
     /* this wait should return immediately */
     DkSynchronizationObjectWait(event1, NO_TIMEOUT);
 
+    /* a synchronization event keeps its signal until exactly one wait takes it */
+    PAL_HANDLE event2 = DkSynchronizationEventCreate(0);
+    if (!event2) {
+        pal_printf("DkSynchronizationEventCreate failed\n");
+        return -1;
+    }
+
+    DkEventSet(event2);
+    if (!DkSynchronizationObjectWait(event2, 0)) {
+        pal_printf("Synchronization event lost its signal\n");
+        return -1;
+    }
+    if (DkSynchronizationObjectWait(event2, 0)) {
+        pal_printf("Synchronization event was not reset\n");
+        return -1;
+    }
+
     pal_printf("Success, leave main thread\n");
     return 0;
 }
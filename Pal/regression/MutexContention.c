@@ -0,0 +1,79 @@
+/* Contention benchmark for PAL mutexes: threads repeatedly take a mutex, which mostly hands it off
+ * between threads, and the host futex calls made per handoff are reported. */
+
+#include "api.h"
+#include "pal.h"
+#include "pal_debug.h"
+
+#define NTHREADS 3
+#define NTRIES   100000
+
+static PAL_HANDLE mutex;
+static PAL_HANDLE done_event;
+static int nfinished = 0;
+
+static volatile long counter = 0;
+static volatile int owner = -1;
+static long handoffs = 0;
+
+static int thread_func(void* arg) {
+    int id = (int)(long)arg;
+
+    for (int i = 0; i < NTRIES; i++) {
+        if (!DkSynchronizationObjectWait(mutex, NO_TIMEOUT)) {
+            pal_printf("Failed to take the mutex\n");
+            DkProcessExit(1);
+        }
+
+        if (owner != id) {
+            owner = id;
+            handoffs++;
+        }
+        counter++;
+
+        DkMutexRelease(mutex);
+    }
+
+    if (__atomic_add_fetch(&nfinished, 1, __ATOMIC_SEQ_CST) == NTHREADS)
+        DkEventSet(done_event);
+
+    DkThreadExit(/*clear_child_tid=*/NULL);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    mutex      = DkMutexCreate(0);
+    done_event = DkNotificationEventCreate(0);
+    if (!mutex || !done_event) {
+        pal_printf("Failed to create the mutex\n");
+        return 1;
+    }
+
+    PAL_NUM futex_calls = pal_control.host_futex_calls;
+    PAL_NUM start       = DkSystemTimeQuery();
+
+    for (long i = 0; i < NTHREADS; i++) {
+        if (!DkThreadCreate(thread_func, (void*)i)) {
+            pal_printf("DkThreadCreate failed\n");
+            return 1;
+        }
+    }
+
+    DkSynchronizationObjectWait(done_event, NO_TIMEOUT);
+
+    PAL_NUM time = DkSystemTimeQuery() - start;
+    futex_calls  = pal_control.host_futex_calls - futex_calls;
+
+    if (counter != NTHREADS * NTRIES) {
+        pal_printf("Mutex contention: wrong counter %ld\n", counter);
+        return 1;
+    }
+
+    pal_printf("Mutex contention: %d threads, %ld acquisitions, %ld handoffs in %ld us\n",
+               NTHREADS, counter, handoffs, time);
+    pal_printf("Mutex contention: %ld host futex calls, %ld.%02ld per handoff\n", futex_calls,
+               handoffs ? futex_calls / handoffs : 0,
+               handoffs ? futex_calls * 100 / handoffs % 100 : 0);
+    pal_printf("Mutex contention OK\n");
+    return 0;
+}
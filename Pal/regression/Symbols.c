@@ -14,6 +14,8 @@ int main(int argc, char** argv, char** envp) {
     PRINT_SYMBOL(DkVirtualMemoryAlloc);
     PRINT_SYMBOL(DkVirtualMemoryFree);
     PRINT_SYMBOL(DkVirtualMemoryProtect);
+    PRINT_SYMBOL(DkVirtualMemoryRemap);
+    PRINT_SYMBOL(DkVirtualMemoryDiscard);
 
     PRINT_SYMBOL(DkProcessCreate);
     PRINT_SYMBOL(DkProcessExit);
@@ -22,11 +24,17 @@ int main(int argc, char** argv, char** envp) {
     PRINT_SYMBOL(DkStreamWaitForClient);
     PRINT_SYMBOL(DkStreamRead);
     PRINT_SYMBOL(DkStreamWrite);
+    PRINT_SYMBOL(DkStreamReadVector);
+    PRINT_SYMBOL(DkStreamWriteVector);
+    PRINT_SYMBOL(DkStreamTransfer);
     PRINT_SYMBOL(DkStreamDelete);
     PRINT_SYMBOL(DkStreamMap);
     PRINT_SYMBOL(DkStreamUnmap);
     PRINT_SYMBOL(DkStreamSetLength);
     PRINT_SYMBOL(DkStreamFlush);
+    PRINT_SYMBOL(DkStreamAllocate);
+    PRINT_SYMBOL(DkStreamAdvise);
+    PRINT_SYMBOL(DkStreamSyncRange);
     PRINT_SYMBOL(DkSendHandle);
     PRINT_SYMBOL(DkReceiveHandle);
     PRINT_SYMBOL(DkStreamAttributesQuery);
@@ -35,12 +43,17 @@ int main(int argc, char** argv, char** envp) {
     PRINT_SYMBOL(DkStreamGetName);
     PRINT_SYMBOL(DkStreamChangeName);
     PRINT_SYMBOL(DkStreamsWaitEvents);
+    PRINT_SYMBOL(DkWaitSetCreate);
+    PRINT_SYMBOL(DkWaitSetUpdate);
+    PRINT_SYMBOL(DkWaitSetWait);
 
     PRINT_SYMBOL(DkThreadCreate);
     PRINT_SYMBOL(DkThreadDelayExecution);
     PRINT_SYMBOL(DkThreadYieldExecution);
     PRINT_SYMBOL(DkThreadExit);
     PRINT_SYMBOL(DkThreadResume);
+    PRINT_SYMBOL(DkThreadSetCpuAffinity);
+    PRINT_SYMBOL(DkThreadGetCpuAffinity);
 
     PRINT_SYMBOL(DkSetExceptionHandler);
     PRINT_SYMBOL(DkExceptionReturn);
@@ -0,0 +1,47 @@
+#include "pal.h"
+#include "pal_debug.h"
+
+#define NHANDLES 3
+
+int main(int argc, char** argv) {
+    PAL_HANDLE handles[NHANDLES];
+    PAL_HANDLE ret_handles[NHANDLES];
+    PAL_FLG ret_events[NHANDLES];
+
+    PAL_HANDLE wait_set = DkWaitSetCreate();
+    if (!wait_set) {
+        pal_printf("DkWaitSetCreate failed\n");
+        return -1;
+    }
+
+    for (int i = 0; i < NHANDLES; i++) {
+        handles[i] = DkStreamOpen("pipe:", PAL_ACCESS_RDWR, 0, 0, 0);
+        if (!handles[i] || !DkWaitSetUpdate(wait_set, handles[i], PAL_WAIT_READ)) {
+            pal_printf("Failed to add pipe %d to the wait set\n", i);
+            return -1;
+        }
+    }
+
+    if (DkWaitSetWait(wait_set, NHANDLES, ret_handles, ret_events, 10000) == 0)
+        pal_printf("Wait on idle pipes timed out\n");
+
+    char byte = 0;
+    DkStreamWrite(handles[1], 0, 1, &byte, NULL);
+
+    PAL_NUM polled = DkWaitSetWait(wait_set, NHANDLES, ret_handles, ret_events, NO_TIMEOUT);
+    if (polled == 1 && ret_handles[0] == handles[1] && (ret_events[0] & PAL_WAIT_READ))
+        pal_printf("Wait returned the written pipe\n");
+
+    if (!DkWaitSetUpdate(wait_set, handles[1], 0)) {
+        pal_printf("Failed to remove pipe 1 from the wait set\n");
+        return -1;
+    }
+
+    if (DkWaitSetWait(wait_set, NHANDLES, ret_handles, ret_events, 10000) == 0)
+        pal_printf("Removed pipe is not reported\n");
+
+    DkObjectClose(wait_set);
+    for (int i = 0; i < NHANDLES; i++)
+        DkObjectClose(handles[i]);
+    return 0;
+}
@@ -133,6 +133,12 @@ class TC_00_BasicSet2(RegressionTestCase):
         self.assertIn('Leave thread 2', stderr)
         self.assertIn('Leave thread 1', stderr)
 
+    def test_WaitSet(self):
+        _, stderr = self.run_binary(['WaitSet'])
+        self.assertIn('Wait on idle pipes timed out', stderr)
+        self.assertIn('Wait returned the written pipe', stderr)
+        self.assertIn('Removed pipe is not reported', stderr)
+
     def test_Yield(self):
         _, stderr = self.run_binary(['Yield'])
         self.assertIn('Enter Parent Thread', stderr)
@@ -263,17 +269,25 @@ class TC_02_Symbols(RegressionTestCase):
         'DkVirtualMemoryAlloc',
         'DkVirtualMemoryFree',
         'DkVirtualMemoryProtect',
+        'DkVirtualMemoryRemap',
+        'DkVirtualMemoryDiscard',
         'DkProcessCreate',
         'DkProcessExit',
         'DkStreamOpen',
         'DkStreamWaitForClient',
         'DkStreamRead',
         'DkStreamWrite',
+        'DkStreamReadVector',
+        'DkStreamWriteVector',
+        'DkStreamTransfer',
         'DkStreamDelete',
         'DkStreamMap',
         'DkStreamUnmap',
         'DkStreamSetLength',
         'DkStreamFlush',
+        'DkStreamAllocate',
+        'DkStreamAdvise',
+        'DkStreamSyncRange',
         'DkSendHandle',
         'DkReceiveHandle',
         'DkStreamAttributesQuery',
@@ -286,6 +300,8 @@ class TC_02_Symbols(RegressionTestCase):
         'DkThreadYieldExecution',
         'DkThreadExit',
         'DkThreadResume',
+        'DkThreadSetCpuAffinity',
+        'DkThreadGetCpuAffinity',
         'DkSetExceptionHandler',
         'DkExceptionReturn',
         'DkMutexCreate',
@@ -296,6 +312,9 @@ class TC_02_Symbols(RegressionTestCase):
         'DkEventClear',
         'DkSynchronizationObjectWait',
         'DkStreamsWaitEvents',
+        'DkWaitSetCreate',
+        'DkWaitSetUpdate',
+        'DkWaitSetWait',
         'DkObjectClose',
         'DkSystemTimeQuery',
         'DkRandomBitsRead',
@@ -491,6 +510,10 @@ class TC_20_SingleProcess(RegressionTestCase):
         self.assertIn('Locked binary semaphore successfully (-1).', stderr)
         self.assertIn('Locked binary semaphore successfully (0).', stderr)
 
+    def test_220_mutex_contention(self):
+        _, stderr = self.run_binary(['MutexContention'])
+        self.assertIn('Mutex contention OK', stderr)
+
     def test_300_memory(self):
         _, stderr = self.run_binary(['Memory'])
 
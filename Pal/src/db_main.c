@@ -41,6 +41,19 @@ PAL_CONTROL * pal_control_addr (void)
 
 struct pal_internal_state pal_state;
 
+static PAL_STARTUP_EVENT startup_events[PAL_STARTUP_EVENTS_MAX];
+static size_t startup_events_num = 0;
+
+void _DkStartupEvent(const char* name, unsigned long start, unsigned long end) {
+    if (startup_events_num >= PAL_STARTUP_EVENTS_MAX)
+        return;
+
+    PAL_STARTUP_EVENT* event = &startup_events[startup_events_num++];
+    event->name  = name;
+    event->start = start;
+    event->end   = end;
+}
+
 static void load_libraries (void)
 {
     /* we will not make any assumption for where the libraries are loaded */
@@ -376,9 +389,14 @@ noreturn void pal_main (
 
     read_environments(&environments);
 
+    unsigned long load_start = _DkSystemTimeQuery();
+
     if (pal_state.root_config)
         load_libraries();
 
+    unsigned long load_end = _DkSystemTimeQuery();
+    _DkStartupEvent("pal: load preloaded libraries", load_start, load_end);
+
     if (exec_handle) {
         if (exec_loaded_addr) {
             ret = add_elf_object(exec_loaded_addr, exec_handle, OBJECT_EXEC);
@@ -388,6 +406,8 @@ noreturn void pal_main (
 
         if (ret < 0)
             INIT_FAIL(ret, pal_strerror(ret));
+
+        _DkStartupEvent("pal: load executable", load_end, _DkSystemTimeQuery());
     }
 
     set_debug_type();
@@ -412,6 +432,9 @@ noreturn void pal_main (
     }
     __pal_control.mem_info.mem_total = _DkMemoryQuota();
 
+    __pal_control.startup_events     = startup_events;
+    __pal_control.startup_events_num = startup_events_num;
+
     /* Now we will start the execution */
     start_execution(arguments, environments);
 
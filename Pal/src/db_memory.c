@@ -107,3 +107,67 @@ DkVirtualMemoryProtect(PAL_PTR addr, PAL_NUM size, PAL_FLG prot) {
 
     LEAVE_PAL_CALL_RETURN(PAL_TRUE);
 }
+
+PAL_BOL
+DkVirtualMemoryRemap(PAL_PTR addr, PAL_PTR new_addr, PAL_NUM size) {
+    ENTER_PAL_CALL(DkVirtualMemoryRemap);
+
+    if (!addr || !new_addr || !size) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    if (!IS_ALLOC_ALIGNED_PTR(addr) || !IS_ALLOC_ALIGNED_PTR(new_addr) || !IS_ALLOC_ALIGNED(size)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    /* the ranges must not overlap */
+    if ((void*)addr < (void*)new_addr + size && (void*)new_addr < (void*)addr + size) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    if (_DkCheckMemoryMappable((void*)addr, size) || _DkCheckMemoryMappable((void*)new_addr, size)) {
+        _DkRaiseFailure(PAL_ERROR_DENIED);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int ret = _DkVirtualMemoryRemap((void*)addr, (void*)new_addr, size);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
+PAL_BOL
+DkVirtualMemoryDiscard(PAL_PTR addr, PAL_NUM size) {
+    ENTER_PAL_CALL(DkVirtualMemoryDiscard);
+
+    if (!addr || !size) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    if (!IS_ALLOC_ALIGNED_PTR(addr) || !IS_ALLOC_ALIGNED(size)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    if (_DkCheckMemoryMappable((void*)addr, size)) {
+        _DkRaiseFailure(PAL_ERROR_DENIED);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int ret = _DkVirtualMemoryDiscard((void*)addr, size);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
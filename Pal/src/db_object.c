@@ -113,3 +113,60 @@ PAL_BOL DkStreamsWaitEvents(PAL_NUM count, PAL_HANDLE* handle_array, PAL_FLG* ev
 
     LEAVE_PAL_CALL_RETURN(PAL_TRUE);
 }
+
+/* PAL call DkWaitSetCreate: create an empty wait set. */
+PAL_HANDLE DkWaitSetCreate(void) {
+    ENTER_PAL_CALL(DkWaitSetCreate);
+
+    PAL_HANDLE handle = NULL;
+    int ret = _DkWaitSetCreate(&handle);
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        handle = NULL;
+    }
+
+    LEAVE_PAL_CALL_RETURN(handle);
+}
+
+/* PAL call DkWaitSetUpdate: add `handle` to the wait set, change its events, or remove it from the
+ * wait set if `events` is 0. Returns PAL_TRUE on success. */
+PAL_BOL DkWaitSetUpdate(PAL_HANDLE wait_set, PAL_HANDLE handle, PAL_FLG events) {
+    ENTER_PAL_CALL(DkWaitSetUpdate);
+
+    /* removal does not access the handle, it may have been closed already */
+    if (!wait_set || !IS_HANDLE_TYPE(wait_set, waitset) || !handle ||
+            (events && UNKNOWN_HANDLE(handle)) || (events & ~(PAL_WAIT_READ | PAL_WAIT_WRITE))) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int ret = _DkWaitSetUpdate(wait_set, handle, events);
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
+/* PAL call DkWaitSetWait: wait for events on the handles of the wait set and return up to `count`
+ * handles with pending events. The wait can be timed out, unless NO_TIMEOUT is given in the
+ * timeout_us argument. Returns the number of handles, or 0 on failure (including timeout). */
+PAL_NUM DkWaitSetWait(PAL_HANDLE wait_set, PAL_NUM count, PAL_HANDLE* handle_array,
+                      PAL_FLG* ret_events, PAL_NUM timeout_us) {
+    ENTER_PAL_CALL(DkWaitSetWait);
+
+    if (!wait_set || !IS_HANDLE_TYPE(wait_set, waitset) || !count || !handle_array ||
+            !ret_events) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(0);
+    }
+
+    int64_t ret = _DkWaitSetWait(wait_set, count, handle_array, ret_events, timeout_us);
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(0);
+    }
+
+    LEAVE_PAL_CALL_RETURN(ret);
+}
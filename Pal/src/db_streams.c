@@ -44,6 +44,8 @@ extern struct handle_ops proc_ops;
 extern struct handle_ops mutex_ops;
 extern struct handle_ops event_ops;
 extern struct handle_ops eventfd_ops;
+extern struct handle_ops waitset_ops;
+extern struct handle_ops shm_ops;
 
 const struct handle_ops* pal_handle_ops[PAL_HANDLE_TYPE_BOUND] = {
     [pal_type_file]    = &file_ops,
@@ -62,6 +64,7 @@ const struct handle_ops* pal_handle_ops[PAL_HANDLE_TYPE_BOUND] = {
     [pal_type_mutex]   = &mutex_ops,
     [pal_type_event]   = &event_ops,
     [pal_type_eventfd] = &eventfd_ops,
+    [pal_type_waitset] = &waitset_ops,
 };
 
 /* parse_stream_uri scan the uri, seperate prefix and search for
@@ -86,6 +89,7 @@ static int parse_stream_uri(const char** uri, char** prefix, struct handle_ops**
             static_assert(static_strlen(URI_PREFIX_TCP) == 4, "URI_PREFIX_TCP has unexpected length");
             static_assert(static_strlen(URI_PREFIX_UDP) == 4, "URI_PREFIX_UDP has unexpected length");
             static_assert(static_strlen(URI_PREFIX_DEV) == 4, "URI_PREFIX_DEV has unexpected length");
+            static_assert(static_strlen(URI_PREFIX_SHM) == 4, "URI_PREFIX_SHM has unexpected length");
 
             if (strstartswith_static(u, URI_PREFIX_DIR))
                 hops = &dir_ops;
@@ -95,6 +99,8 @@ static int parse_stream_uri(const char** uri, char** prefix, struct handle_ops**
                 hops = &udp_ops;
             else if (strstartswith_static(u, URI_PREFIX_DEV))
                 hops = &dev_ops;
+            else if (strstartswith_static(u, URI_PREFIX_SHM))
+                hops = &shm_ops;
             break;
 
         case 5: ;
@@ -351,6 +357,102 @@ DkStreamWrite(PAL_HANDLE handle, PAL_NUM offset, PAL_NUM count, PAL_PTR buffer,
     LEAVE_PAL_CALL_RETURN(ret);
 }
 
+/* _DkStreamReadVector for internal use. Read from stream at absolute offset into several
+   buffers. Only handles with a 'readv' operation support this. */
+int64_t _DkStreamReadVector(PAL_HANDLE handle, uint64_t offset, const PAL_IOVEC* vec,
+                            size_t vlen) {
+    const struct handle_ops* ops = HANDLE_OPS(handle);
+
+    if (!ops)
+        return -PAL_ERROR_BADHANDLE;
+
+    if (!ops->readv)
+        return -PAL_ERROR_NOTSUPPORT;
+
+    int64_t ret = ops->readv(handle, offset, vec, vlen);
+    return ret ? ret : -PAL_ERROR_ENDOFSTREAM;
+}
+
+/* PAL call DkStreamReadVector: Read from stream at absolute offset into several buffers. Return
+   number of bytes if succeeded, or PAL_STREAM_ERROR for failure. Error code is notified. */
+PAL_NUM
+DkStreamReadVector(PAL_HANDLE handle, PAL_NUM offset, PAL_IOVEC* vec, PAL_NUM vlen) {
+    ENTER_PAL_CALL(DkStreamReadVector);
+
+    if (!handle || (!vec && vlen)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_STREAM_ERROR);
+    }
+
+    int64_t ret = _DkStreamReadVector(handle, offset, vec, vlen);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        ret = PAL_STREAM_ERROR;
+    }
+
+    LEAVE_PAL_CALL_RETURN(ret);
+}
+
+/* _DkStreamWriteVector for internal use. Write to stream at absolute offset from several
+   buffers. Only handles with a 'writev' operation support this. */
+int64_t _DkStreamWriteVector(PAL_HANDLE handle, uint64_t offset, const PAL_IOVEC* vec,
+                             size_t vlen) {
+    const struct handle_ops* ops = HANDLE_OPS(handle);
+
+    if (!ops)
+        return -PAL_ERROR_BADHANDLE;
+
+    if (!ops->writev)
+        return -PAL_ERROR_NOTSUPPORT;
+
+    int64_t ret = ops->writev(handle, offset, vec, vlen);
+    return ret ? ret : -PAL_ERROR_ENDOFSTREAM;
+}
+
+/* PAL call DkStreamWriteVector: Write to stream at absolute offset from several buffers. Return
+   number of bytes if succeeded, or PAL_STREAM_ERROR for failure. Error code is notified. */
+PAL_NUM
+DkStreamWriteVector(PAL_HANDLE handle, PAL_NUM offset, PAL_IOVEC* vec, PAL_NUM vlen) {
+    ENTER_PAL_CALL(DkStreamWriteVector);
+
+    if (!handle || (!vec && vlen)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_STREAM_ERROR);
+    }
+
+    int64_t ret = _DkStreamWriteVector(handle, offset, vec, vlen);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        ret = PAL_STREAM_ERROR;
+    }
+
+    LEAVE_PAL_CALL_RETURN(ret);
+}
+
+/* PAL call DkStreamTransfer: Transfer data from one stream to another
+   on the host. Return number of bytes if succeeded,
+   or PAL_STREAM_ERROR for failure. Error code is notified. */
+PAL_NUM DkStreamTransfer(PAL_HANDLE src, PAL_NUM src_offset, PAL_HANDLE dst, PAL_NUM dst_offset,
+                         PAL_NUM count) {
+    ENTER_PAL_CALL(DkStreamTransfer);
+
+    if (!src || !dst) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_STREAM_ERROR);
+    }
+
+    int64_t ret = _DkStreamTransfer(src, src_offset, dst, dst_offset, count);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        ret = PAL_STREAM_ERROR;
+    }
+
+    LEAVE_PAL_CALL_RETURN(ret);
+}
+
 /* _DkStreamAttributesQuery of internal use. The function query attribute
    of streams by their URI */
 int _DkStreamAttributesQuery(const char* uri, PAL_STREAM_ATTR* attr) {
@@ -661,6 +763,115 @@ PAL_BOL DkStreamFlush(PAL_HANDLE handle) {
     LEAVE_PAL_CALL_RETURN(PAL_TRUE);
 }
 
+/* ranges of files are given to the host as signed 64-bit offsets */
+static bool file_range_valid(uint64_t offset, uint64_t length) {
+    return offset <= INT64_MAX && length <= INT64_MAX - offset;
+}
+
+int _DkStreamAllocate(PAL_HANDLE handle, uint64_t offset, uint64_t length, int flags) {
+    if (UNKNOWN_HANDLE(handle))
+        return -PAL_ERROR_BADHANDLE;
+
+    const struct handle_ops* ops = HANDLE_OPS(handle);
+
+    if (!ops)
+        return -PAL_ERROR_BADHANDLE;
+
+    if (!ops->allocate)
+        return -PAL_ERROR_NOTSUPPORT;
+
+    return ops->allocate(handle, offset, length, flags);
+}
+
+PAL_BOL DkStreamAllocate(PAL_HANDLE handle, PAL_NUM offset, PAL_NUM length, PAL_FLG flags) {
+    ENTER_PAL_CALL(DkStreamAllocate);
+
+    if (!handle || !length || !file_range_valid(offset, length) ||
+        (flags & ~(PAL_ALLOCATE_KEEP_SIZE | PAL_ALLOCATE_PUNCH_HOLE)) ||
+        ((flags & PAL_ALLOCATE_PUNCH_HOLE) && !(flags & PAL_ALLOCATE_KEEP_SIZE))) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int ret = _DkStreamAllocate(handle, offset, length, flags);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
+int _DkStreamAdvise(PAL_HANDLE handle, uint64_t offset, uint64_t length, int advice) {
+    if (UNKNOWN_HANDLE(handle))
+        return -PAL_ERROR_BADHANDLE;
+
+    const struct handle_ops* ops = HANDLE_OPS(handle);
+
+    if (!ops)
+        return -PAL_ERROR_BADHANDLE;
+
+    if (!ops->advise)
+        return -PAL_ERROR_NOTSUPPORT;
+
+    return ops->advise(handle, offset, length, advice);
+}
+
+PAL_BOL DkStreamAdvise(PAL_HANDLE handle, PAL_NUM offset, PAL_NUM length, PAL_FLG advice) {
+    ENTER_PAL_CALL(DkStreamAdvise);
+
+    if (!handle || !file_range_valid(offset, length) || advice > PAL_ADVICE_NOREUSE) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int ret = _DkStreamAdvise(handle, offset, length, advice);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
+int _DkStreamSyncRange(PAL_HANDLE handle, uint64_t offset, uint64_t length, int flags) {
+    if (UNKNOWN_HANDLE(handle))
+        return -PAL_ERROR_BADHANDLE;
+
+    const struct handle_ops* ops = HANDLE_OPS(handle);
+
+    if (!ops)
+        return -PAL_ERROR_BADHANDLE;
+
+    /* streams which cannot write back a range can still write back everything */
+    if (!ops->syncrange)
+        return ops->flush ? ops->flush(handle) : -PAL_ERROR_NOTSUPPORT;
+
+    return ops->syncrange(handle, offset, length, flags);
+}
+
+PAL_BOL DkStreamSyncRange(PAL_HANDLE handle, PAL_NUM offset, PAL_NUM length, PAL_FLG flags) {
+    ENTER_PAL_CALL(DkStreamSyncRange);
+
+    if (!handle || !file_range_valid(offset, length) ||
+        (flags & ~(PAL_SYNC_RANGE_WAIT_BEFORE | PAL_SYNC_RANGE_WRITE |
+                   PAL_SYNC_RANGE_WAIT_AFTER))) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int ret = _DkStreamSyncRange(handle, offset, length, flags);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
 /* PAL call DkSendHandle: Write to a process handle.
    Return 1 on success and 0 on failure */
 PAL_BOL DkSendHandle(PAL_HANDLE handle, PAL_HANDLE cargo) {
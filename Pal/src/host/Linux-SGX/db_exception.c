@@ -30,6 +30,7 @@
 #include "pal_security.h"
 #include "api.h"
 #include "ecall_types.h"
+#include "ocall_profile.h"
 
 #include <atomic.h>
 #include <sigset.h>
@@ -176,6 +177,9 @@ void _DkExceptionHandler(
     unsigned int exit_info, sgx_cpu_context_t* uc, PAL_XREGS_STATE* xregs_state) {
     assert(IS_ALIGNED_PTR(xregs_state, PAL_XSTATE_ALIGN));
 
+    if (g_ocall_profile)
+        __atomic_add_fetch(&g_ocall_profile->aex, 1, __ATOMIC_RELAXED);
+
     union {
         sgx_arch_exit_info_t info;
         unsigned int intval;
@@ -71,7 +71,8 @@ static int file_open(PAL_HANDLE* handle, const char* type, const char* uri, int
     sgx_stub_t* stubs;
     uint64_t total;
     void* umem;
-    ret = load_trusted_file(hdl, &stubs, &total, create, &umem);
+    bool stubs_sha256;
+    ret = load_trusted_file(hdl, &stubs, &total, create, &umem, &stubs_sha256);
     if (ret < 0) {
         SGX_DBG(DBG_E,
                 "Accessing file:%s is denied. (%s) "
@@ -87,6 +88,7 @@ static int file_open(PAL_HANDLE* handle, const char* type, const char* uri, int
     hdl->file.stubs  = (PAL_PTR)stubs;
     hdl->file.total  = total;
     hdl->file.umem = umem;
+    hdl->file.stubs_sha256 = stubs_sha256;
 
     *handle = hdl;
     return 0;
@@ -117,7 +119,8 @@ static int64_t file_read(PAL_HANDLE handle, uint64_t offset, uint64_t count, voi
         map_end = ALLOC_ALIGN_UP(total);
 
     ret = copy_and_verify_trusted_file(handle->file.realpath, handle->file.umem + map_start,
-            map_start, map_end, buffer, offset, end - offset, stubs, total);
+            map_start, map_end, buffer, offset, end - offset, stubs, handle->file.stubs_sha256,
+            total);
     if (ret < 0)
         return ret;
 
@@ -141,6 +144,57 @@ static int64_t file_write(PAL_HANDLE handle, uint64_t offset, uint64_t count, co
     return -PAL_ERROR_DENIED;
 }
 
+/* one 'read' or 'write' per buffer, for trusted files (which verify each buffer separately) and
+ * for buffers outside of the enclave */
+static int64_t file_rw_each(PAL_HANDLE handle, uint64_t offset, const PAL_IOVEC* vec, size_t vlen,
+                            bool write) {
+    int64_t total = 0;
+
+    for (size_t i = 0; i < vlen; i++) {
+        if (!vec[i].size)
+            continue;
+
+        int64_t ret = write ? file_write(handle, offset + total, vec[i].size, vec[i].buffer)
+                            : file_read(handle, offset + total, vec[i].size, vec[i].buffer);
+        if (ret < 0)
+            return total ? total : ret;
+
+        total += ret;
+        if ((uint64_t)ret < vec[i].size)
+            break;
+    }
+    return total;
+}
+
+static bool iovec_within_enclave(const PAL_IOVEC* vec, size_t vlen) {
+    for (size_t i = 0; i < vlen; i++)
+        if (!sgx_is_completely_within_enclave(vec[i].buffer, vec[i].size))
+            return false;
+    return true;
+}
+
+/* 'readv' and 'writev' operations for file streams: allowed files are staged in one untrusted
+ * buffer and read or written by the host at once */
+static int64_t file_readv(PAL_HANDLE handle, uint64_t offset, const PAL_IOVEC* vec, size_t vlen) {
+    if (handle->file.stubs || !iovec_within_enclave(vec, vlen))
+        return file_rw_each(handle, offset, vec, vlen, /*write=*/false);
+
+    int64_t ret = ocall_preadv(handle->file.fd, vec, vlen, offset);
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+    return ret;
+}
+
+static int64_t file_writev(PAL_HANDLE handle, uint64_t offset, const PAL_IOVEC* vec, size_t vlen) {
+    if (handle->file.stubs || !iovec_within_enclave(vec, vlen))
+        return file_rw_each(handle, offset, vec, vlen, /*write=*/true);
+
+    int64_t ret = ocall_pwritev(handle->file.fd, vec, vlen, offset);
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+    return ret;
+}
+
 /* 'close' operation for file streams. In this case, it will only
    close the file without deleting it. */
 static int file_close(PAL_HANDLE handle) {
@@ -222,7 +276,8 @@ static int file_map(PAL_HANDLE handle, void** addr, int prot, uint64_t offset, u
 
     if (stubs) {
         ret = copy_and_verify_trusted_file(handle->file.realpath, umem, map_start, map_end, mem,
-                                           offset, end - offset, stubs, total);
+                                           offset, end - offset, stubs,
+                                           handle->file.stubs_sha256, total);
 
         if (ret < 0) {
             SGX_DBG(DBG_E, "file_map - verify trusted returned %d\n", ret);
@@ -254,6 +309,33 @@ static int file_flush(PAL_HANDLE handle) {
     return 0;
 }
 
+/* 'allocate' operation for file stream. Trusted files cannot be modified. */
+static int file_allocate(PAL_HANDLE handle, uint64_t offset, uint64_t length, int flags) {
+    if (handle->file.stubs)
+        return -PAL_ERROR_DENIED;
+
+    int ret = ocall_fallocate(handle->file.fd, flags, offset, length);
+    if (IS_ERR(ret))
+        return ERRNO(ret) == EOPNOTSUPP ? -PAL_ERROR_NOTSUPPORT : unix_to_pal_error(ERRNO(ret));
+
+    if (!(flags & PAL_ALLOCATE_KEEP_SIZE) && offset + length > handle->file.total)
+        handle->file.total = offset + length;
+    return 0;
+}
+
+/* 'advise' operation for file stream. The host only caches the (encrypted or hashed) contents,
+ * so hints are forwarded for trusted files, too. */
+static int file_advise(PAL_HANDLE handle, uint64_t offset, uint64_t length, int advice) {
+    int ret = ocall_fadvise(handle->file.fd, offset, length, advice);
+    return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : 0;
+}
+
+/* 'syncrange' operation for file stream. */
+static int file_syncrange(PAL_HANDLE handle, uint64_t offset, uint64_t length, int flags) {
+    int ret = ocall_sync_file_range(handle->file.fd, offset, length, flags);
+    return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : 0;
+}
+
 static inline int file_stat_type(struct stat* stat) {
     if (S_ISREG(stat->st_mode))
         return pal_type_file;
@@ -371,11 +453,16 @@ struct handle_ops file_ops = {
     .open           = &file_open,
     .read           = &file_read,
     .write          = &file_write,
+    .readv          = &file_readv,
+    .writev         = &file_writev,
     .close          = &file_close,
     .delete         = &file_delete,
     .map            = &file_map,
     .setlength      = &file_setlength,
     .flush          = &file_flush,
+    .allocate       = &file_allocate,
+    .advise         = &file_advise,
+    .syncrange      = &file_syncrange,
     .attrquery      = &file_attrquery,
     .attrquerybyhdl = &file_attrquerybyhdl,
     .attrsetbyhdl   = &file_attrsetbyhdl,
@@ -591,3 +678,21 @@ struct handle_ops dir_ops = {
     .attrsetbyhdl   = &file_attrsetbyhdl,
     .rename         = &dir_rename,
 };
+
+/* Shared memory objects would have to live in untrusted memory and could not be protected against
+   the host, so they are not supported. */
+static int shm_open(PAL_HANDLE* handle, const char* type, const char* uri, int access, int share,
+                    int create, int options) {
+    __UNUSED(handle);
+    __UNUSED(type);
+    __UNUSED(uri);
+    __UNUSED(access);
+    __UNUSED(share);
+    __UNUSED(create);
+    __UNUSED(options);
+    return -PAL_ERROR_NOTSUPPORT;
+}
+
+struct handle_ops shm_ops = {
+    .open = &shm_open,
+};
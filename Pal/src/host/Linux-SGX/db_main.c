@@ -31,6 +31,7 @@
 #include "pal_linux.h"
 #include "pal_linux_defs.h"
 #include "pal_security.h"
+#include "topology.h"
 
 #include <asm/ioctls.h>
 #include <asm/mman.h>
@@ -281,6 +282,15 @@ void pal_linux_main(char * uptr_args, uint64_t args_size,
     pal_sec.start_time = sec_info.start_time;
 #endif
 
+    /* host-side startup phases; untrusted, but only used for PAL_CONTROL::startup_events */
+    _DkStartupEvent("host: load manifest and files", sec_info.host_start_time,
+                    sec_info.ecreate_time);
+    _DkStartupEvent("host: ECREATE, EADD and EEXTEND", sec_info.ecreate_time,
+                    sec_info.einit_start_time);
+    _DkStartupEvent("host: EINIT", sec_info.einit_start_time, sec_info.einit_end_time);
+    _DkStartupEvent("host: prepare enclave entry", sec_info.einit_end_time, sec_info.ecall_time);
+    _DkStartupEvent("pal: enter enclave", sec_info.ecall_time, start_time);
+
     /* For {p,u,g}ids we can at least do some minimal checking. */
 
     /* ppid should be positive when interpreted as signed. It's 0 if we don't
@@ -331,6 +341,9 @@ void pal_linux_main(char * uptr_args, uint64_t args_size,
         ocall_exit(rv, /*is_exitgroup=*/true);
     }
 
+    unsigned long phase_start = _DkSystemTimeQuery();
+    _DkStartupEvent("pal: relocate and initialize enclave", start_time, phase_start);
+
     if (args_size > MAX_ARGS_SIZE || env_size > MAX_ENV_SIZE) {
         return;
     }
@@ -364,6 +377,10 @@ void pal_linux_main(char * uptr_args, uint64_t args_size,
             SGX_DBG(DBG_E, "Failed to initialize child process: %d\n", rv);
             ocall_exit(rv, /*is_exitgroup=*/true);
         }
+
+        unsigned long phase_end = _DkSystemTimeQuery();
+        _DkStartupEvent("pal: attest and connect to parent", phase_start, phase_end);
+        phase_start = phase_end;
     }
 
     /* now let's mark our enclave as initialized */
@@ -406,6 +423,10 @@ void pal_linux_main(char * uptr_args, uint64_t args_size,
     __pal_control.manifest_preload.start = (PAL_PTR) manifest_addr;
     __pal_control.manifest_preload.end = (PAL_PTR) manifest_addr + manifest_size;
 
+    unsigned long phase_end = _DkSystemTimeQuery();
+    _DkStartupEvent("pal: parse manifest", phase_start, phase_end);
+    phase_start = phase_end;
+
     if ((rv = init_trusted_files()) < 0) {
         SGX_DBG(DBG_E, "Failed to load the checksums of trusted files: %d\n", rv);
         ocall_exit(rv, true);
@@ -421,6 +442,13 @@ void pal_linux_main(char * uptr_args, uint64_t args_size,
         ocall_exit(rv, true);
     }
 
+    if ((rv = init_thread_pool()) < 0) {
+        SGX_DBG(DBG_E, "Failed to initialize the enclave thread pool: %d\n", rv);
+        ocall_exit(rv, true);
+    }
+
+    _DkStartupEvent("pal: initialize trusted files", phase_start, _DkSystemTimeQuery());
+
 #if PRINT_ENCLAVE_STAT == 1
     printf("                >>>>>>>> "
            "Enclave loading time =      %10ld milliseconds\n",
@@ -518,6 +546,20 @@ static double get_bogomips(void) {
     return sanitize_bogomips_value(get_bogomips_from_cpuinfo_buf(buf, sizeof(buf)));
 }
 
+int host_read_sysfs(const char* path, char* buf, size_t size) {
+    int fd = ocall_open(path, O_RDONLY, 0);
+    if (IS_ERR(fd))
+        return fd;
+
+    int ret = ocall_read(fd, buf, size - 1);
+    ocall_close(fd);
+    if (IS_ERR(ret))
+        return ret;
+
+    buf[ret] = '\0';
+    return ret;
+}
+
 int _DkGetCPUInfo (PAL_CPU_INFO * ci)
 {
     unsigned int words[PAL_CPUID_WORD_NUM];
@@ -590,5 +632,10 @@ int _DkGetCPUInfo (PAL_CPU_INFO * ci)
         SGX_DBG(DBG_E, "Warning: bogomips could not be retrieved, passing 0.0 to the application\n");
     }
 
+    /* read from the untrusted host, but only used as a hint for thread placement */
+    if (get_cpu_topology(ci) < 0) {
+        SGX_DBG(DBG_E, "Warning: could not read the CPU topology, reporting a single socket and NUMA node\n");
+    }
+
     return rv;
 }
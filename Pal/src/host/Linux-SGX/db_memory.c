@@ -91,6 +91,31 @@ int _DkVirtualMemoryProtect(void* addr, uint64_t size, int prot) {
     return 0;
 }
 
+/* Without EDMM, EPC pages cannot be moved to another enclave address, so the contents are copied
+ * into the new enclave pages. The new pages are not zeroed first since they are fully
+ * overwritten. */
+int _DkVirtualMemoryRemap(void* addr, void* new_addr, uint64_t size) {
+    if (!sgx_is_completely_within_enclave(addr, size))
+        return -PAL_ERROR_INVAL;
+
+    void* mem = get_enclave_pages(new_addr, size, /*is_pal_internal=*/false);
+    if (!mem)
+        return -PAL_ERROR_DENIED;
+
+    memcpy(mem, addr, size);
+    return free_enclave_pages(addr, size);
+}
+
+/* Without EDMM, EPC pages cannot be trimmed from a running enclave and stay committed; the pages
+ * are only zeroed, which is what the caller observes afterwards. */
+int _DkVirtualMemoryDiscard(void* addr, uint64_t size) {
+    if (!sgx_is_completely_within_enclave(addr, size))
+        return -PAL_ERROR_INVAL;
+
+    memset(addr, 0, size);
+    return 0;
+}
+
 uint64_t _DkMemoryQuota(void) {
     return pal_sec.heap_max - pal_sec.heap_min;
 }
@@ -18,8 +18,7 @@
  * db_mutex.c
  *
  * This file contains APIs that provide operations of (futex based) mutexes.
- * Based on "Mutexes and Condition Variables using Futexes"
- * (http://locklessinc.com/articles/mutex_cv_futex)
+ * The mutex itself is shared with the Linux PAL, see futex_lock.c.
  */
 
 #include <asm/errno.h>
@@ -30,6 +29,7 @@
 #include <linux/time.h>
 
 #include "api.h"
+#include "futex_lock.h"
 #include "pal.h"
 #include "pal_debug.h"
 #include "pal_defs.h"
@@ -39,64 +39,36 @@
 #include "pal_linux_defs.h"
 #include "pal_linux_error.h"
 
-#define MUTEX_SPINLOCK_TIMES 100
-#define MUTEX_UNLOCKED       0
-#define MUTEX_LOCKED         1
+/*
+ * Chia-Che 12/7/2017: futex words point to untrusted memory, so
+ * can be used for futex. Potentially this design may allow
+ * attackers to change the mutex value and cause DoS.
+ */
+int host_futex_wait(int* addr, int val, int64_t timeout_us) {
+    int ret = ocall_futex(addr, FUTEX_WAIT, val, timeout_us);
+    return IS_ERR(ret) ? ret : 0;
+}
+
+int host_futex_wake(int* addr, int nwake) {
+    return ocall_futex(addr, FUTEX_WAKE, nwake, -1);
+}
 
 int _DkMutexCreate(PAL_HANDLE* handle, int initialCount) {
     PAL_HANDLE mut = malloc(HANDLE_SIZE(mutex));
     SET_HANDLE_TYPE(mut, mutex);
-    atomic_set(&mut->mutex.mut.nwaiters, 0);
-    mut->mutex.mut.locked = malloc_untrusted(sizeof(int64_t));
+    mut->mutex.mut.spins  = 0;
+    mut->mutex.mut.locked = malloc_untrusted(sizeof(int));
     if (!mut->mutex.mut.locked) {
         free(mut);
         return -PAL_ERROR_NOMEM;
     }
-    *(mut->mutex.mut.locked) = initialCount;
-    *handle                  = mut;
+    *mut->mutex.mut.locked = initialCount ? FUTEX_LOCK_LOCKED : FUTEX_LOCK_UNLOCKED;
+    *handle                = mut;
     return 0;
 }
 
 int _DkMutexLockTimeout(struct mutex_handle* m, int64_t timeout_us) {
-    int ret = 0;
-
-    if (MUTEX_UNLOCKED == cmpxchg(m->locked, MUTEX_UNLOCKED, MUTEX_LOCKED))
-        goto success;
-
-    if (timeout_us == 0) {
-        ret = -PAL_ERROR_TRYAGAIN;
-        goto out;
-    }
-
-    // Bump up the waiters count; we are probably going to block
-    atomic_inc(&m->nwaiters);
-
-    while (MUTEX_LOCKED == cmpxchg(m->locked, MUTEX_UNLOCKED, MUTEX_LOCKED)) {
-        /*
-         * Chia-Che 12/7/2017: m->locked points to untrusted memory, so
-         * can be used for futex. Potentially this design may allow
-         * attackers to change the mutex value and cause DoS.
-         */
-        ret = ocall_futex((int*)m->locked, FUTEX_WAIT, MUTEX_LOCKED, timeout_us);
-
-        if (IS_ERR(ret)) {
-            if (ERRNO(ret) == EWOULDBLOCK) {
-                ret = -PAL_ERROR_TRYAGAIN;
-                atomic_dec(&m->nwaiters);
-            } else {
-                ret = unix_to_pal_error(ERRNO(ret));
-                atomic_dec(&m->nwaiters);
-            }
-            goto out;
-        }
-    }
-
-    atomic_dec(&m->nwaiters);
-
-success:
-    ret = 0;
-out:
-    return ret;
+    return futex_lock_timeout(m->locked, &m->spins, timeout_us);
 }
 
 int _DkMutexLock(struct mutex_handle* m) {
@@ -108,22 +80,8 @@ int _DkMutexAcquireTimeout(PAL_HANDLE handle, int64_t timeout_us) {
 }
 
 int _DkMutexUnlock(struct mutex_handle* m) {
-    int ret = 0;
-    int need_wake;
-
-    /* Unlock */
-    *(m->locked) = MUTEX_UNLOCKED;  // TODO: this is not atomic!
-    /* We need to make sure the write to locked is visible to lock-ers
-     * before we read the waiter count. */
-    MB();
-
-    need_wake = atomic_read(&m->nwaiters);
-
-    /* If we need to wake someone up... */
-    if (need_wake)
-        ocall_futex((int*)m->locked, FUTEX_WAKE, 1, -1);
-
-    return ret;
+    futex_unlock(m->locked);
+    return 0;
 }
 
 void _DkMutexRelease(PAL_HANDLE handle) {
@@ -139,7 +97,7 @@ static int mutex_wait(PAL_HANDLE handle, int64_t timeout_us) {
 }
 
 static int mutex_close(PAL_HANDLE handle) {
-    free_untrusted((int64_t*)handle->mutex.mut.locked);
+    free_untrusted(handle->mutex.mut.locked);
     return 0;
 }
 
@@ -17,9 +17,10 @@
 /*
  * db_object.c
  *
- * This file contains APIs for waiting on PAL handles (polling).
+ * This file contains APIs for waiting on PAL handles (polling) and for wait sets.
  */
 
+#include <linux/eventpoll.h>
 #include <linux/poll.h>
 #include <linux/time.h>
 #include <linux/wait.h>
@@ -46,6 +47,8 @@ int _DkSynchronizationObjectWait(PAL_HANDLE handle, int64_t timeout_us) {
     return ops->wait(handle, timeout_us);
 }
 
+#define WAIT_EVENTS_STACK_FDS 64
+
 /* Wait for specific events on all handles in the handle array and return multiple events
  * (including errors) reported by the host. Return 0 on success, PAL error on failure. */
 int _DkStreamsWaitEvents(size_t count, PAL_HANDLE* handle_array, PAL_FLG* events, PAL_FLG* ret_events,
@@ -55,15 +58,24 @@ int _DkStreamsWaitEvents(size_t count, PAL_HANDLE* handle_array, PAL_FLG* events
     if (count == 0)
         return 0;
 
-    struct pollfd* fds = malloc(count * MAX_FDS * sizeof(*fds));
-    if (!fds) {
-        return -PAL_ERROR_NOMEM;
-    }
+    /* waits on a few handles (poll() on a handful of FDs, the IPC and async helpers) need no heap
+     * allocations; large sets of handles should be kept in a wait set instead */
+    struct pollfd stack_fds[WAIT_EVENTS_STACK_FDS];
+    size_t stack_offsets[WAIT_EVENTS_STACK_FDS];
+    struct pollfd* fds = stack_fds;
+    size_t* offsets = stack_offsets;
 
-    size_t* offsets = malloc(count * MAX_FDS * sizeof(*offsets));
-    if (!offsets) {
-        free(fds);
-        return -PAL_ERROR_NOMEM;
+    if (count * MAX_FDS > WAIT_EVENTS_STACK_FDS) {
+        fds = malloc(count * MAX_FDS * sizeof(*fds));
+        if (!fds) {
+            return -PAL_ERROR_NOMEM;
+        }
+
+        offsets = malloc(count * MAX_FDS * sizeof(*offsets));
+        if (!offsets) {
+            free(fds);
+            return -PAL_ERROR_NOMEM;
+        }
     }
 
     /* collect all FDs of all PAL handles that may report read/write events */
@@ -153,7 +165,232 @@ int _DkStreamsWaitEvents(size_t count, PAL_HANDLE* handle_array, PAL_FLG* events
 
     ret = 0;
 out:
-    free(fds);
-    free(offsets);
+    if (fds != stack_fds) {
+        free(fds);
+        free(offsets);
+    }
     return ret;
 }
+
+/*
+ * Wait sets keep their handles registered in a host epoll instance, so that a wait costs one host
+ * call regardless of the number of handles in the set. The registered handles are kept in a table
+ * of slots; the epoll data of each host FD is the slot of its handle times MAX_FDS plus the index
+ * of the FD in the handle. Results of a wait are translated back through the table under the wait
+ * set lock, so a handle removed concurrently with a wait is never reported. Neither removal nor
+ * waiting accesses the registered handles, so a handle closed while still in the wait set is
+ * harmless until it is removed. The epoll data comes back from the untrusted host, so it is only
+ * ever used as an index into the trusted table.
+ */
+struct waitset_item {
+    PAL_HANDLE handle;        /* NULL if the slot is free */
+    PAL_IDX fds[MAX_FDS];     /* host FDs of the handle, so that removal does not access it */
+    int fdevents[MAX_FDS];    /* epoll events registered for each FD */
+};
+
+#define WAITSET_INIT_SIZE  64
+#define WAITSET_MAX_EVENTS 64
+
+static int waitset_close(PAL_HANDLE handle) {
+    ocall_close(handle->waitset.fd);
+    free(handle->waitset.items);
+    return 0;
+}
+
+struct handle_ops waitset_ops = {
+    .close = &waitset_close,
+};
+
+int _DkWaitSetCreate(PAL_HANDLE* handle) {
+    int fd = ocall_epoll_create(EPOLL_CLOEXEC);
+    if (IS_ERR(fd))
+        return unix_to_pal_error(ERRNO(fd));
+
+    PAL_HANDLE hdl = malloc(HANDLE_SIZE(waitset));
+    if (!hdl) {
+        ocall_close(fd);
+        return -PAL_ERROR_NOMEM;
+    }
+
+    SET_HANDLE_TYPE(hdl, waitset);
+    HANDLE_HDR(hdl)->flags = 0;
+    hdl->waitset.fd    = fd;
+    hdl->waitset.items = NULL;
+    hdl->waitset.size  = 0;
+    spinlock_init(&hdl->waitset.lock);
+
+    *handle = hdl;
+    return 0;
+}
+
+/* epoll events to register for each FD of `handle`; FDs shared between input and output (e.g. of
+ * a device) are registered once, under their first index */
+static void waitset_fd_events(PAL_HANDLE handle, PAL_FLG events, int fdevents[MAX_FDS]) {
+    PAL_FLG flags = HANDLE_HDR(handle)->flags;
+
+    for (size_t j = 0; j < MAX_FDS; j++) {
+        fdevents[j] = 0;
+        if (handle->generic.fds[j] == PAL_IDX_POISON || (flags & ERROR(j)))
+            continue;
+
+        int fdevent = 0;
+        fdevent |= ((flags & RFD(j)) && (events & PAL_WAIT_READ)) ? EPOLLIN : 0;
+        fdevent |= ((flags & WFD(j)) && (events & PAL_WAIT_WRITE)) ? EPOLLOUT : 0;
+
+        size_t k = 0;
+        while (k < j && handle->generic.fds[k] != handle->generic.fds[j])
+            k++;
+        fdevents[k] |= fdevent;
+    }
+}
+
+static int waitset_ctl(PAL_HANDLE wait_set, int op, int fd, int fdevents, uint64_t data) {
+    struct epoll_event ev = {.events = fdevents, .data = data};
+    int ret = ocall_epoll_ctl(wait_set->waitset.fd, op, fd, &ev);
+    if (IS_ERR(ret)) {
+        /* the host removes closed FDs by itself */
+        if (op == EPOLL_CTL_DEL && (ERRNO(ret) == ENOENT || ERRNO(ret) == EBADF))
+            return 0;
+        return unix_to_pal_error(ERRNO(ret));
+    }
+    return 0;
+}
+
+int _DkWaitSetUpdate(PAL_HANDLE wait_set, PAL_HANDLE handle, PAL_FLG events) {
+    int ret = 0;
+
+    _DkInternalLock(&wait_set->waitset.lock);
+
+    struct waitset_item* items = wait_set->waitset.items;
+    size_t size = wait_set->waitset.size;
+    size_t slot = size;
+    size_t free_slot = size;
+    for (size_t i = 0; i < size; i++) {
+        if (items[i].handle == handle) {
+            slot = i;
+            break;
+        }
+        if (!items[i].handle && free_slot == size)
+            free_slot = i;
+    }
+
+    if (slot == size) {
+        if (!events) {
+            ret = -PAL_ERROR_INVAL;
+            goto out;
+        }
+
+        if (free_slot == size) {
+            size_t new_size = size ? size * 2 : WAITSET_INIT_SIZE;
+            struct waitset_item* new_items = malloc(new_size * sizeof(*new_items));
+            if (!new_items) {
+                ret = -PAL_ERROR_NOMEM;
+                goto out;
+            }
+            if (size)
+                memcpy(new_items, items, size * sizeof(*items));
+            memset(new_items + size, 0, (new_size - size) * sizeof(*new_items));
+            free(items);
+            items = wait_set->waitset.items = new_items;
+            wait_set->waitset.size = new_size;
+        }
+
+        slot = free_slot;
+        memset(&items[slot], 0, sizeof(items[slot]));
+        items[slot].handle = handle;
+    }
+
+    struct waitset_item* item = &items[slot];
+    int fdevents[MAX_FDS] = {0};
+    if (events)
+        waitset_fd_events(handle, events, fdevents);
+
+    for (size_t j = 0; j < MAX_FDS; j++) {
+        if (item->fdevents[j] == fdevents[j])
+            continue;
+
+        if (!item->fdevents[j])
+            item->fds[j] = handle->generic.fds[j];
+
+        int op = !item->fdevents[j] ? EPOLL_CTL_ADD : !fdevents[j] ? EPOLL_CTL_DEL : EPOLL_CTL_MOD;
+        ret = waitset_ctl(wait_set, op, item->fds[j], fdevents[j], slot * MAX_FDS + j);
+        if (ret < 0)
+            break;
+        item->fdevents[j] = fdevents[j];
+    }
+
+    if (ret < 0) {
+        /* do not leave the handle half-registered */
+        for (size_t j = 0; j < MAX_FDS; j++)
+            if (item->fdevents[j])
+                waitset_ctl(wait_set, EPOLL_CTL_DEL, item->fds[j], 0, 0);
+        memset(item->fdevents, 0, sizeof(item->fdevents));
+    }
+
+    bool registered = false;
+    for (size_t j = 0; j < MAX_FDS; j++)
+        registered = registered || item->fdevents[j];
+    if (!registered)
+        item->handle = NULL;
+
+out:
+    _DkInternalUnlock(&wait_set->waitset.lock);
+    return ret;
+}
+
+int64_t _DkWaitSetWait(PAL_HANDLE wait_set, size_t count, PAL_HANDLE* handle_array,
+                       PAL_FLG* ret_events, int64_t timeout_us) {
+    struct epoll_event evs[WAITSET_MAX_EVENTS];
+    int max_events = count < WAITSET_MAX_EVENTS ? count : WAITSET_MAX_EVENTS;
+
+    int ret = ocall_epoll_wait(wait_set->waitset.fd, evs, max_events, timeout_us);
+    if (IS_ERR(ret)) {
+        switch (ERRNO(ret)) {
+            case EINTR:
+            case ERESTART:
+                return -PAL_ERROR_INTERRUPTED;
+            default:
+                return unix_to_pal_error(ERRNO(ret));
+        }
+    }
+
+    if (!ret) {
+        /* timed out */
+        return -PAL_ERROR_TRYAGAIN;
+    }
+
+    size_t nhandles = 0;
+
+    _DkInternalLock(&wait_set->waitset.lock);
+    struct waitset_item* items = wait_set->waitset.items;
+    for (int i = 0; i < ret; i++) {
+        size_t slot = evs[i].data / MAX_FDS;
+        size_t j    = evs[i].data % MAX_FDS;
+        if (slot >= wait_set->waitset.size || !items[slot].handle || !items[slot].fdevents[j])
+            continue;
+
+        PAL_HANDLE hdl = items[slot].handle;
+        size_t k = 0;
+        while (k < nhandles && handle_array[k] != hdl)
+            k++;
+        if (k == nhandles) {
+            handle_array[nhandles] = hdl;
+            ret_events[nhandles]   = 0;
+            nhandles++;
+        }
+
+        if (evs[i].events & EPOLLIN)
+            ret_events[k] |= PAL_WAIT_READ;
+        if (evs[i].events & EPOLLOUT)
+            ret_events[k] |= PAL_WAIT_WRITE;
+        if (evs[i].events & (EPOLLHUP | EPOLLERR))
+            ret_events[k] |= PAL_WAIT_ERROR;
+    }
+    _DkInternalUnlock(&wait_set->waitset.lock);
+
+    /* only events of handles removed during the wait, report as a spurious wakeup */
+    if (!nhandles)
+        return -PAL_ERROR_TRYAGAIN;
+
+    return nhandles;
+}
@@ -227,6 +227,7 @@ static int check_child_mr_enclave(PAL_HANDLE child, sgx_measurement_t* mr_enclav
     /* Always accept the same mr_enclave as child process */
     if (!memcmp(mr_enclave, &pal_sec.mr_enclave, sizeof(sgx_measurement_t))) {
         SGX_DBG(DBG_S, "trusted child: <forked>\n");
+        child->process.same_enclave = PAL_TRUE;
         return 0;
     }
 
@@ -271,6 +272,7 @@ int _DkProcessCreate (PAL_HANDLE * handle, const char * uri, const char ** args)
     child->process.pid         = child_pid;
     child->process.nonblocking = PAL_FALSE;
     child->process.ssl_ctx     = NULL;
+    child->process.same_enclave = PAL_FALSE;
 
     ret = _DkStreamKeyExchange(child, &child->process.session_key);
     if (ret < 0)
@@ -297,6 +299,11 @@ int _DkProcessCreate (PAL_HANDLE * handle, const char * uri, const char ** args)
     if (ret != sizeof(g_master_key))
         goto failed;
 
+    /* let a child with the same manifest reuse the stubs of the files we already verified */
+    ret = send_trusted_file_stubs(child->process.ssl_ctx, child->process.same_enclave);
+    if (ret < 0)
+        goto failed;
+
     *handle = child;
     return 0;
 
@@ -307,7 +314,6 @@ failed:
 
 static int check_parent_mr_enclave(PAL_HANDLE parent, sgx_measurement_t* mr_enclave,
                                    struct pal_enclave_state* remote_state) {
-    __UNUSED(mr_enclave);
     sgx_sign_data_t sign_data;
     int ret = generate_sign_data(&parent->process.session_key, remote_state->enclave_id,
                                  &sign_data);
@@ -317,6 +323,10 @@ static int check_parent_mr_enclave(PAL_HANDLE parent, sgx_measurement_t* mr_encl
     if (memcmp(&remote_state->enclave_data, &sign_data, sizeof(sign_data)))
         return 1;
 
+    /* only a parent with the same mr_enclave may hand down verified trusted-file stubs */
+    parent->process.same_enclave =
+        !memcmp(mr_enclave, &pal_sec.mr_enclave, sizeof(sgx_measurement_t));
+
     /* XXX: For now, accept any enclave, but eventually should challenge the parent process */
     return 0;
 }
@@ -331,6 +341,7 @@ int init_child_process (PAL_HANDLE * parent_handle)
     parent->process.pid         = pal_sec.ppid;
     parent->process.nonblocking = PAL_FALSE;
     parent->process.ssl_ctx     = NULL;
+    parent->process.same_enclave = PAL_FALSE;
 
     int ret = _DkStreamKeyExchange(parent, &parent->process.session_key);
     if (ret < 0)
@@ -357,6 +368,11 @@ int init_child_process (PAL_HANDLE * parent_handle)
     if (ret != sizeof(g_master_key))
         return ret;
 
+    /* installed into the trusted files once they are read from the manifest */
+    ret = receive_trusted_file_stubs(parent->process.ssl_ctx, parent->process.same_enclave);
+    if (ret < 0)
+        return ret;
+
     *parent_handle = parent;
     return 0;
 }
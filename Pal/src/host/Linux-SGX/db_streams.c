@@ -398,3 +398,66 @@ int _DkReceiveHandle(PAL_HANDLE hdl, PAL_HANDLE* cargo) {
     *cargo = handle;
     return 0;
 }
+
+/* returns the host FD of `handle` used for reads (or writes), -1 if there is none */
+static int handle_host_fd(PAL_HANDLE handle, bool write) {
+    for (int i = 0; i < MAX_FDS; i++)
+        if (HANDLE_HDR(handle)->flags & (write ? WFD(i) : RFD(i)))
+            return handle->generic.fds[i];
+    return -1;
+}
+
+/* Data transferred on the host never enters the enclave, so it can be neither verified nor
+ * decrypted: trusted files (whose contents must be checked against their hashes) and named pipes
+ * (which are TLS-encrypted) must go through DkStreamRead/DkStreamWrite. */
+static bool handle_transferable(PAL_HANDLE handle) {
+    switch (PAL_GET_TYPE(handle)) {
+        case pal_type_file:
+            return !handle->file.stubs;
+        case pal_type_pipeprv:
+        case pal_type_dev:
+        case pal_type_tcp:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*!
+ * \brief Transfer up to `count` bytes from `src` to `dst` on the host, bypassing the enclave.
+ *
+ * See _DkStreamTransfer() of the Linux PAL. Only allowed files, private pipes, devices and TCP
+ * sockets can be transferred from and to.
+ *
+ * \return Number of bytes transferred (0 at the end of `src`), negative PAL error code otherwise;
+ *         -PAL_ERROR_NOTSUPPORT if the streams cannot be transferred on the host.
+ */
+int64_t _DkStreamTransfer(PAL_HANDLE src, uint64_t src_offset, PAL_HANDLE dst, uint64_t dst_offset,
+                          uint64_t count) {
+    if (!handle_transferable(src) || !handle_transferable(dst))
+        return -PAL_ERROR_NOTSUPPORT;
+
+    int src_fd = handle_host_fd(src, /*write=*/false);
+    int dst_fd = handle_host_fd(dst, /*write=*/true);
+    if (src_fd < 0 || dst_fd < 0)
+        return -PAL_ERROR_DENIED;
+
+    if (src_offset > INT64_MAX || dst_offset > INT64_MAX)
+        return -PAL_ERROR_INVAL;
+
+    ssize_t ret = ocall_transfer(src_fd, IS_HANDLE_TYPE(src, file) ? (int64_t)src_offset : -1,
+                                 dst_fd, IS_HANDLE_TYPE(dst, file) ? (int64_t)dst_offset : -1,
+                                 count);
+    if (IS_ERR(ret)) {
+        switch (ERRNO(ret)) {
+            case EINVAL:
+            case ENOSYS:
+            case EXDEV:
+            case EOPNOTSUPP:
+                return -PAL_ERROR_NOTSUPPORT;
+            default:
+                return unix_to_pal_error(ERRNO(ret));
+        }
+    }
+    return ret;
+}
@@ -31,6 +31,7 @@
 #include "api.h"
 #include "ecall_types.h"
 
+#include <linux/futex.h>
 #include <linux/signal.h>
 #include <linux/mman.h>
 #include <linux/sched.h>
@@ -50,6 +51,18 @@ struct thread_param {
 
 extern void * enclave_base;
 
+/*
+ * Enclave thread pool (manifest option "sgx.thread_pool"). Instead of leaving the enclave and
+ * terminating its host thread, an exiting thread parks inside the enclave, waiting on an
+ * untrusted futex word for new work. _DkThreadCreate hands new threads to parked enclave threads
+ * first and only asks the host for a new thread (and TCS) when none is parked. This turns thread
+ * creation into an in-enclave handoff and keeps the number of TCSs in use bounded by the peak
+ * number of concurrent threads.
+ */
+static bool thread_pool_enabled = false;
+static int thread_pool_parked = 0;   /* trusted count of parked enclave threads */
+static int* thread_pool_tickets;     /* untrusted futex word: number of pending handoffs */
+
 /*
  * We do not currently handle tid counter wrap-around, and could, in
  * principle, end up with two threads with the same ID. This is ok, as strict
@@ -94,6 +107,64 @@ void pal_start_thread (void)
     _DkThreadExit(/*clear_child_tid=*/NULL);
 }
 
+int init_thread_pool(void) {
+    char cfgbuf[CONFIG_MAX];
+    ssize_t len = get_config(pal_state.root_config, "sgx.thread_pool", cfgbuf, sizeof(cfgbuf));
+    if (len <= 0 || !(len == 1 && cfgbuf[0] == '1'))
+        return 0;
+
+    thread_pool_tickets = malloc_untrusted(sizeof(*thread_pool_tickets));
+    if (!thread_pool_tickets)
+        return -PAL_ERROR_NOMEM;
+    *thread_pool_tickets = 0;
+    thread_pool_enabled = true;
+    return 0;
+}
+
+static bool thread_pool_take_parked(void) {
+    int parked = __atomic_load_n(&thread_pool_parked, __ATOMIC_SEQ_CST);
+    while (parked > 0) {
+        if (__atomic_compare_exchange_n(&thread_pool_parked, &parked, parked - 1,
+                                        /*weak=*/false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+            return true;
+    }
+    return false;
+}
+
+static bool thread_pool_take_ticket(void) {
+    int tickets = __atomic_load_n(thread_pool_tickets, __ATOMIC_SEQ_CST);
+    while (tickets > 0) {
+        if (__atomic_compare_exchange_n(thread_pool_tickets, &tickets, tickets - 1,
+                                        /*weak=*/false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+            return true;
+    }
+    return false;
+}
+
+/* Runs on a fresh enclave stack of an exited thread; never returns. The tickets are untrusted,
+ * so a spurious wakeup only results in pal_start_thread() finding no handle and the thread
+ * parking again. */
+static noreturn void thread_pool_park(int* clear_child_tid) {
+    SET_ENCLAVE_TLS(ready_for_exceptions, 0UL);
+    SET_ENCLAVE_TLS(thread, NULL);
+
+    /* the exiting thread no longer uses its LibOS stack, let LibOS reclaim it */
+    if (clear_child_tid)
+        __atomic_store_n(clear_child_tid, 0, __ATOMIC_RELEASE);
+
+    __atomic_add_fetch(&thread_pool_parked, 1, __ATOMIC_SEQ_CST);
+    while (true) {
+        if (!thread_pool_take_ticket()) {
+            ocall_futex(thread_pool_tickets, FUTEX_WAIT, 0, -1);
+            continue;
+        }
+        /* returns only if there was no handle to start; otherwise the thread comes back here
+         * through _DkThreadExit() */
+        pal_start_thread();
+        __atomic_add_fetch(&thread_pool_parked, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
 /* _DkThreadCreate for internal use. Create an internal thread
    inside the current process. The arguments callback and param
    specify the starting function and parameters */
@@ -118,7 +189,15 @@ int _DkThreadCreate (PAL_HANDLE * handle, int (*callback) (void *),
     LISTP_ADD_TAIL(&new_thread->thread, &thread_list, list);
     _DkInternalUnlock(&thread_list_lock);
 
-    int ret = ocall_clone_thread();
+    int ret;
+    if (thread_pool_enabled && thread_pool_take_parked()) {
+        /* the host only provides the wakeup; the parked thread picks up the handle from
+         * thread_list and does not trust the ticket count */
+        __atomic_add_fetch(thread_pool_tickets, 1, __ATOMIC_SEQ_CST);
+        ret = ocall_futex(thread_pool_tickets, FUTEX_WAKE, 1, -1);
+    } else {
+        ret = ocall_clone_thread();
+    }
     if (IS_ERR(ret))
         return unix_to_pal_error(ERRNO(ret));
 
@@ -154,6 +233,18 @@ noreturn void _DkThreadExit(int* clear_child_tid) {
         _DkInternalLock(&thread_list_lock);
         LISTP_DEL(exiting_thread, &thread_list, list);
         _DkInternalUnlock(&thread_list_lock);
+
+        if (thread_pool_enabled) {
+            /* park on the initial stack of this TCS: the current stack may be the one LibOS
+             * frees once clear_child_tid is erased */
+            void* stack = enclave_base + GET_ENCLAVE_TLS(initial_stack_offset);
+            __asm__ volatile("movq %0, %%rsp\n"
+                             "andq $~0xF, %%rsp\n"
+                             "callq *%2\n"
+                             :: "r"(stack), "D"(clear_child_tid), "r"(thread_pool_park)
+                             : "memory");
+            __builtin_unreachable();
+        }
     }
 
     ocall_exit(0, /*is_exitgroup=*/false);
@@ -165,6 +256,19 @@ int _DkThreadResume (PAL_HANDLE threadHandle)
     return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : ret;
 }
 
+int _DkThreadSetCpuAffinity(PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask) {
+    /* affinity is a property of the host thread which runs the enclave thread (bound to its TCS) */
+    void* tcs = thread ? thread->thread.tcs : enclave_base + GET_ENCLAVE_TLS(tcs_offset);
+    int ret = ocall_sched_setaffinity(tcs, cpumask_size, cpu_mask);
+    return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : 0;
+}
+
+int _DkThreadGetCpuAffinity(PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask) {
+    void* tcs = thread ? thread->thread.tcs : enclave_base + GET_ENCLAVE_TLS(tcs_offset);
+    int ret = ocall_sched_getaffinity(tcs, cpumask_size, cpu_mask);
+    return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : 0;
+}
+
 struct handle_ops thread_ops = {
     /* nothing */
 };
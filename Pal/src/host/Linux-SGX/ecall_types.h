@@ -9,6 +9,7 @@ enum {
 
 struct pal_sec;
 struct rpc_queue;
+struct ocall_profile;
 
 typedef struct {
     char*             ms_args;
@@ -17,4 +18,5 @@ typedef struct {
     size_t            ms_env_size;
     struct pal_sec*   ms_sec_info;
     struct rpc_queue* rpc_queue; /* pointer to RPC queue in untrusted mem */
+    struct ocall_profile* ocall_profile; /* pointer to OCALL profile in untrusted mem */
 } ms_ecall_enclave_start_t;
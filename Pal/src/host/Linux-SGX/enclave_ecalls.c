@@ -4,6 +4,7 @@
 #include <api.h>
 
 #include "ecall_types.h"
+#include "ocall_profile.h"
 #include "rpc_queue.h"
 
 #define SGX_CAST(type, item) ((type)(item))
@@ -30,6 +31,21 @@ static int verify_and_init_rpc_queue(rpc_queue_t* untrusted_rpc_queue) {
     return 0;
 }
 
+/* returns 0 if ocall_profile is valid/not requested, otherwise -1 */
+static int verify_and_init_ocall_profile(ocall_profile_t* untrusted_ocall_profile) {
+    g_ocall_profile = NULL;
+
+    if (!untrusted_ocall_profile)
+        return 0;
+
+    if (!sgx_is_completely_outside_enclave(untrusted_ocall_profile,
+                                           sizeof(*untrusted_ocall_profile)))
+        return -1;
+
+    g_ocall_profile = untrusted_ocall_profile;
+    return 0;
+}
+
 /*
  * Called from enclave_entry.S to execute ecalls.
  *
@@ -91,6 +107,9 @@ void handle_ecall(long ecall_index, void* ecall_args, void* exit_target, void* e
         if (verify_and_init_rpc_queue(ms->rpc_queue))
             return;
 
+        if (verify_and_init_ocall_profile(ms->ocall_profile))
+            return;
+
         /* xsave size must be initialized early */
         init_xsave_size(ms->ms_sec_info->enclave_attributes.xfrm);
 
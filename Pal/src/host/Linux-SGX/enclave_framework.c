@@ -18,7 +18,9 @@ void * enclave_base, * enclave_top;
 
 struct pal_enclave_config pal_enclave_config;
 
-static int register_trusted_file(const char* uri, const char* checksum_str, bool check_duplicates);
+static int register_trusted_file(const char* uri, const char* checksum_str,
+                                 const char* chunks_str, bool check_duplicates);
+static void apply_inherited_stubs(void);
 
 bool sgx_is_completely_within_enclave (const void * addr, uint64_t size)
 {
@@ -226,6 +228,16 @@ int init_enclave_key (void)
  * hashes are stored as "stubs" for each file. For a performance reason,
  * each per-chunk hash is a 128-bit AES-CMAC hash value, using a secret
  * key generated at the beginning of the enclave.
+ *
+ * If the manifest was signed with "sgx.precompute_chunk_hashes = 1", the
+ * signer has already computed a SHA256 hash of every chunk and stored them
+ * in a side file ("sgx.trusted_chunks_file"). The manifest then records,
+ * for each trusted file, the offset of its hashes in the side file and a
+ * root hash over the file size and all of its chunk hashes
+ * ("sgx.trusted_chunks.xxx"). Opening such a file only reads and checks
+ * the chunk hashes against the root; the file contents are verified chunk
+ * by chunk on access, so the cost of opening no longer depends on the file
+ * size.
  */
 
 DEFINE_LIST(trusted_file);
@@ -237,36 +249,284 @@ struct trusted_file {
     char uri[URI_MAX];
     sgx_checksum_t checksum;
     sgx_stub_t * stubs;
+    bool stubs_sha256;             /* stubs are SHA256 chunk hashes precomputed by the signer */
+    bool has_chunk_hashes;
+    uint64_t chunk_hashes_offset;  /* offset of the chunk hashes in sgx.trusted_chunks_file */
+    sgx_checksum_t chunk_hashes_root;
+    uint64_t verify_usec;          /* time spent verifying the file (reported to children) */
 };
 
 DEFINE_LISTP(trusted_file);
-static LISTP_TYPE(trusted_file) trusted_file_list = LISTP_INIT;
+
+/*
+ * Trusted files must match the opened URI exactly, so they are kept in a hash table keyed by
+ * the normalized URI (chained through `trusted_file.list`). Allowed files match whole subtrees,
+ * so they are kept in a trie of path components; a lookup walks the opened path once and stops
+ * at the first node that carries an allowed entry. Both indexes are built by
+ * init_trusted_files() and only grow afterwards (sgx.allow_file_creation); they are protected
+ * by `trusted_file_lock`.
+ */
+#define TRUSTED_FILE_TABLE_INIT_SIZE 64
+
+static LISTP_TYPE(trusted_file) * trusted_file_table = NULL;
+static size_t trusted_file_table_size = 0; /* number of buckets, always a power of two */
+static size_t trusted_file_count = 0;
+
+DEFINE_LIST(allowed_node);
+DEFINE_LISTP(allowed_node);
+struct allowed_node {
+    LIST_TYPE(allowed_node) siblings;
+    LISTP_TYPE(allowed_node) children;
+    struct trusted_file * tf; /* set if this node is itself an allowed file or directory */
+    size_t name_len;
+    char name[];
+};
+
+static struct allowed_node * allowed_file_root = NULL;
+
 static spinlock_t trusted_file_lock = INIT_SPINLOCK_UNLOCKED;
 static int trusted_file_indexes = 0;
 static bool allow_file_creation = 0;
 static int file_check_policy = FILE_CHECK_POLICY_STRICT;
+static int trusted_chunks_fd = -1;
+
+/* stubs received from the parent enclave, applied once init_trusted_files() has run */
+static uint8_t* inherited_stubs = NULL;
+static size_t inherited_stubs_size = 0;
+static uint64_t inherited_stubs_nfiles = 0;
+static bool inherited_stubs_same_key = false;
+
+/* FNV-1a over the URI bytes */
+static uint64_t hash_trusted_uri(const char* uri, size_t uri_len) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < uri_len; i++) {
+        hash ^= (unsigned char)uri[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
 
-/* Assumes `path` is normalized */
-static bool path_is_equal_or_subpath(const struct trusted_file* tf,
-                                     const char* path,
-                                     size_t path_len) {
-    if (tf->uri_len > path_len || memcmp(tf->uri, path, tf->uri_len)) {
-        /* tf->uri is not prefix of `path` */
-        return false;
+/* Caller must hold `trusted_file_lock` */
+static struct trusted_file* lookup_trusted_uri(const char* uri, size_t uri_len) {
+    if (!trusted_file_table)
+        return NULL;
+
+    struct trusted_file* tf;
+    size_t bucket = hash_trusted_uri(uri, uri_len) & (trusted_file_table_size - 1);
+    LISTP_FOR_EACH_ENTRY(tf, &trusted_file_table[bucket], list) {
+        if (tf->uri_len == uri_len && !memcmp(tf->uri, uri, uri_len))
+            return tf;
     }
-    if (tf->uri_len == path_len) {
-        /* Both are equal */
-        return true;
+    return NULL;
+}
+
+/* Caller must hold `trusted_file_lock`. The table is doubled when the load factor exceeds 1. */
+static int insert_trusted_uri(struct trusted_file* new) {
+    if (trusted_file_count >= trusted_file_table_size) {
+        size_t new_size = trusted_file_table_size ? trusted_file_table_size * 2
+                                                  : TRUSTED_FILE_TABLE_INIT_SIZE;
+        LISTP_TYPE(trusted_file) * new_table = calloc(new_size, sizeof(*new_table));
+        if (!new_table)
+            return -PAL_ERROR_NOMEM;
+
+        for (size_t i = 0; i < trusted_file_table_size; i++) {
+            struct trusted_file* tf;
+            struct trusted_file* tmp;
+            LISTP_FOR_EACH_ENTRY_SAFE(tf, tmp, &trusted_file_table[i], list) {
+                LISTP_DEL(tf, &trusted_file_table[i], list);
+                size_t bucket = hash_trusted_uri(tf->uri, tf->uri_len) & (new_size - 1);
+                LISTP_ADD_TAIL(tf, &new_table[bucket], list);
+            }
+        }
+
+        free(trusted_file_table);
+        trusted_file_table      = new_table;
+        trusted_file_table_size = new_size;
     }
-    if (tf->uri[tf->uri_len - 1] == '/' || path[tf->uri_len] == '/') {
-        /* tf->uri is a subpath of `path` */
+
+    size_t bucket = hash_trusted_uri(new->uri, new->uri_len) & (trusted_file_table_size - 1);
+    LISTP_ADD_TAIL(new, &trusted_file_table[bucket], list);
+    trusted_file_count++;
+    return 0;
+}
+
+/*
+ * Returns the next component of the normalized `*path` (without the "file:" prefix) and
+ * advances `*path` past it. The root of an absolute path is returned as the component "/", so
+ * that "/a" and "a" end up in different subtrees. Returns false when no components are left.
+ */
+static bool next_path_component(const char** path, const char** name, size_t* name_len) {
+    const char* p = *path;
+
+    if (*p == '/') {
+        *name     = p;
+        *name_len = 1;
+        *path     = p + 1;
         return true;
     }
-    if (tf->uri_len == URI_PREFIX_FILE_LEN && !memcmp(tf->uri, URI_PREFIX_FILE, URI_PREFIX_FILE_LEN)) {
-        /* Empty path is a prefix of everything */
-        return true;
+    if (!*p)
+        return false;
+
+    const char* end = p;
+    while (*end && *end != '/')
+        end++;
+
+    *name     = p;
+    *name_len = end - p;
+    *path     = *end ? end + 1 : end;
+    return true;
+}
+
+static struct allowed_node* alloc_allowed_node(const char* name, size_t name_len) {
+    struct allowed_node* node = malloc(sizeof(*node) + name_len);
+    if (!node)
+        return NULL;
+
+    INIT_LIST_HEAD(node, siblings);
+    INIT_LISTP(&node->children);
+    node->tf       = NULL;
+    node->name_len = name_len;
+    memcpy(node->name, name, name_len);
+    return node;
+}
+
+/*
+ * Returns the node for `path` (normalized, without the "file:" prefix). If `create` is true,
+ * missing nodes are allocated on the way. Caller must hold `trusted_file_lock`.
+ */
+static struct allowed_node* walk_allowed_path(const char* path, bool create) {
+    if (!allowed_file_root) {
+        if (!create || !(allowed_file_root = alloc_allowed_node("", 0)))
+            return NULL;
+    }
+
+    struct allowed_node* node = allowed_file_root;
+    const char* name;
+    size_t name_len;
+
+    while (next_path_component(&path, &name, &name_len)) {
+        struct allowed_node* child;
+        struct allowed_node* found = NULL;
+        LISTP_FOR_EACH_ENTRY(child, &node->children, siblings) {
+            if (child->name_len == name_len && !memcmp(child->name, name, name_len)) {
+                found = child;
+                break;
+            }
+        }
+
+        if (!found) {
+            if (!create || !(found = alloc_allowed_node(name, name_len)))
+                return NULL;
+            LISTP_ADD(found, &node->children, siblings);
+        }
+        node = found;
+    }
+
+    return node;
+}
+
+/*
+ * Returns the allowed entry which is equal to `path` or one of its parent directories (`path` is
+ * normalized, without the "file:" prefix), or NULL. Caller must hold `trusted_file_lock`.
+ */
+static struct trusted_file* lookup_allowed_path(const char* path) {
+    struct allowed_node* node = allowed_file_root;
+    if (!node)
+        return NULL;
+
+    const char* name;
+    size_t name_len;
+
+    while (!node->tf) {
+        if (!next_path_component(&path, &name, &name_len))
+            return NULL;
+
+        struct allowed_node* child;
+        struct allowed_node* found = NULL;
+        LISTP_FOR_EACH_ENTRY(child, &node->children, siblings) {
+            if (child->name_len == name_len && !memcmp(child->name, name, name_len)) {
+                found = child;
+                break;
+            }
+        }
+        if (!found)
+            return NULL;
+        node = found;
+    }
+
+    return node->tf;
+}
+
+/* Returns the trusted or allowed entry registered for exactly `uri`, or NULL. Caller must hold
+ * `trusted_file_lock`. */
+static struct trusted_file* lookup_registered_uri(const char* uri, size_t uri_len) {
+    struct trusted_file* tf = lookup_trusted_uri(uri, uri_len);
+    if (tf)
+        return tf;
+
+    if (!strstartswith_static(uri, URI_PREFIX_FILE))
+        return NULL;
+
+    struct allowed_node* node = walk_allowed_path(uri + URI_PREFIX_FILE_LEN, /*create=*/false);
+    return node ? node->tf : NULL;
+}
+
+/*
+ * Reads the chunk hashes precomputed by the signer for `tf` from sgx.trusted_chunks_file and
+ * checks them against the root hash recorded in the manifest. The root covers the file size as
+ * well, so that the host cannot truncate or extend the file. On success, returns the array of
+ * per-chunk SHA256 hashes in `*hashes_ptr`.
+ */
+static int load_chunk_hashes(struct trusted_file* tf, sgx_checksum_t** hashes_ptr) {
+    if (trusted_chunks_fd < 0)
+        return -PAL_ERROR_DENIED;
+
+    uint64_t nchunks = tf->size / TRUSTED_STUB_SIZE + (tf->size % TRUSTED_STUB_SIZE ? 1 : 0);
+    size_t hashes_size = nchunks * sizeof(sgx_checksum_t);
+
+    sgx_checksum_t* hashes = malloc(hashes_size);
+    if (!hashes)
+        return -PAL_ERROR_NOMEM;
+
+    int ret;
+    size_t bytes = 0;
+    while (bytes < hashes_size) {
+        ssize_t rv = ocall_pread(trusted_chunks_fd, (void*)hashes + bytes, hashes_size - bytes,
+                                 tf->chunk_hashes_offset + bytes);
+        if (IS_ERR(rv)) {
+            if (ERRNO(rv) == EINTR)
+                continue;
+            ret = unix_to_pal_error(ERRNO(rv));
+            goto failed;
+        }
+        if (!rv) {
+            ret = -PAL_ERROR_DENIED;
+            goto failed;
+        }
+        bytes += rv;
     }
-    return false;
+
+    LIB_SHA256_CONTEXT sha;
+    sgx_checksum_t root;
+    uint64_t size = tf->size;
+    if ((ret = lib_SHA256Init(&sha)) < 0 ||
+        (ret = lib_SHA256Update(&sha, (uint8_t*)&size, sizeof(size))) < 0 ||
+        (ret = lib_SHA256Update(&sha, (uint8_t*)hashes, hashes_size)) < 0 ||
+        (ret = lib_SHA256Final(&sha, (uint8_t*)root.bytes)) < 0)
+        goto failed;
+
+    if (memcmp(&root, &tf->chunk_hashes_root, sizeof(root))) {
+        SGX_DBG(DBG_E, "Precomputed chunk hashes of %s do not match the manifest\n", tf->uri);
+        ret = -PAL_ERROR_DENIED;
+        goto failed;
+    }
+
+    *hashes_ptr = hashes;
+    return 0;
+
+failed:
+    free(hashes);
+    return ret;
 }
 
 /*
@@ -277,17 +537,20 @@ static bool path_is_equal_or_subpath(const struct trusted_file* tf,
  * stubptr:  buffer for catching matched file stub.
  * sizeptr:  size pointer
  * create:   this file is newly created or not
+ * stubs_sha256: set if the stubs are SHA256 hashes precomputed by the signer
+ *               (rather than AES-CMACs computed inside the enclave)
  *
  * Returns 0 if succeeded, or an error code otherwise.
  */
 int load_trusted_file (PAL_HANDLE file, sgx_stub_t ** stubptr,
-                       uint64_t * sizeptr, int create, void** umem)
+                       uint64_t * sizeptr, int create, void** umem, bool* stubs_sha256)
 {
     *stubptr = NULL;
+    *stubs_sha256 = false;
     *sizeptr = 0;
     *umem = NULL;
 
-    struct trusted_file * tf = NULL, * tmp;
+    struct trusted_file * tf = NULL;
     char uri[URI_MAX];
     char normpath[URI_MAX];
     int ret, fd = file->file.fd;
@@ -300,13 +563,6 @@ int load_trusted_file (PAL_HANDLE file, sgx_stub_t ** stubptr,
         return ret;
     }
 
-    /* Allow to create the file when allow_file_creation is turned on;
-       The created file is added to allowed_file list for later access */
-    if (create && allow_file_creation) {
-       register_trusted_file(uri, NULL, /*check_duplicates=*/true);
-       return 0;
-    }
-
     /* Normalize the uri */
     if (!strstartswith_static(uri, URI_PREFIX_FILE)) {
         SGX_DBG(DBG_E, "Invalid URI [%s]: Trusted files must start with 'file:'\n", uri);
@@ -325,23 +581,21 @@ int load_trusted_file (PAL_HANDLE file, sgx_stub_t ** stubptr,
     }
     len += URI_PREFIX_FILE_LEN;
 
+    /* Allow to create the file when allow_file_creation is turned on;
+       The created file is added to allowed files for later access */
+    if (create && allow_file_creation) {
+       register_trusted_file(normpath, NULL, NULL, /*check_duplicates=*/true);
+       return 0;
+    }
+
     spinlock_lock(&trusted_file_lock);
 
-    LISTP_FOR_EACH_ENTRY(tmp, &trusted_file_list, list) {
-        if (tmp->stubs) {
-            /* trusted files: must be exactly the same URI */
-            if (tmp->uri_len == len && !memcmp(tmp->uri, normpath, len + 1)) {
-                tf = tmp;
-                break;
-            }
-        } else {
-            /* allowed files: must be a subfolder or file */
-            if (path_is_equal_or_subpath(tmp, normpath, len)) {
-                tf = tmp;
-                break;
-            }
-        }
-    }
+    /* trusted files: must be exactly the same URI */
+    tf = lookup_trusted_uri(normpath, len);
+
+    /* allowed files: must be a subfolder or file */
+    if (!tf)
+        tf = lookup_allowed_path(normpath + URI_PREFIX_FILE_LEN);
 
     spinlock_unlock(&trusted_file_lock);
 
@@ -385,10 +639,25 @@ int load_trusted_file (PAL_HANDLE file, sgx_stub_t ** stubptr,
     if (tf->stubs) {
         *stubptr = tf->stubs;
         *sizeptr = tf->size;
+        *stubs_sha256 = tf->stubs_sha256;
         return 0;
     }
 #endif
 
+    unsigned long verify_start = _DkSystemTimeQuery();
+
+    if (tf->has_chunk_hashes) {
+        sgx_checksum_t* hashes = NULL;
+        ret = load_chunk_hashes(tf, &hashes);
+        if (!ret) {
+            stubs = (sgx_stub_t*)hashes;
+            *stubs_sha256 = true;
+            goto verified;
+        }
+        /* fall back to hashing the whole file against sgx.trusted_checksum */
+        SGX_DBG(DBG_S, "Cannot use precomputed chunk hashes of %s: %d\n", tf->uri, ret);
+    }
+
     int nstubs = tf->size / TRUSTED_STUB_SIZE +
                 (tf->size % TRUSTED_STUB_SIZE ? 1 : 0);
 
@@ -465,10 +734,13 @@ int load_trusted_file (PAL_HANDLE file, sgx_stub_t ** stubptr,
         goto failed;
     }
 
+verified:
     spinlock_lock(&trusted_file_lock);
     if (tf->stubs || tf->index == -PAL_ERROR_DENIED)
         free(tf->stubs);
     *stubptr = tf->stubs = stubs;
+    tf->stubs_sha256 = *stubs_sha256;
+    tf->verify_usec = _DkSystemTimeQuery() - verify_start;
     ret = tf->index;
     spinlock_unlock(&trusted_file_lock);
     return ret;
@@ -527,12 +799,42 @@ static void set_file_check_policy (int policy)
  * either aligned, or equal to 'total_size'. 'buffer' is the in-enclave
  * buffer for copying the file content. 'offset' is the offset within the file
  * for copying into the buffer. 'size' is the size of the in-enclave buffer.
- * 'stubs' contain the checksums of all the chunks in a file.
+ * 'stubs' contain the checksums of all the chunks in a file: AES-CMACs, or
+ * SHA256 hashes if 'stubs_sha256' is set (see load_trusted_file()).
  */
+
+/* Hash of a single file chunk, matching the kind of stubs of the file */
+struct chunk_hash {
+    bool sha256;
+    union {
+        LIB_AESCMAC_CONTEXT aes_cmac;
+        LIB_SHA256_CONTEXT sha;
+    };
+};
+
+static int chunk_hash_init(struct chunk_hash* h, bool sha256) {
+    h->sha256 = sha256;
+    if (sha256)
+        return lib_SHA256Init(&h->sha);
+    return lib_AESCMACInit(&h->aes_cmac, (uint8_t*)&enclave_key, sizeof(enclave_key));
+}
+
+static int chunk_hash_update(struct chunk_hash* h, const uint8_t* data, uint64_t size) {
+    if (h->sha256)
+        return lib_SHA256Update(&h->sha, data, size);
+    return lib_AESCMACUpdate(&h->aes_cmac, data, size);
+}
+
+static int chunk_hash_final(struct chunk_hash* h, sgx_checksum_t* hash) {
+    if (h->sha256)
+        return lib_SHA256Final(&h->sha, (uint8_t*)hash->bytes);
+    return lib_AESCMACFinish(&h->aes_cmac, (uint8_t*)hash->bytes, sizeof(*hash));
+}
+
 int copy_and_verify_trusted_file (const char * path, const void * umem,
                     uint64_t umem_start, uint64_t umem_end,
                     void * buffer, uint64_t offset, uint64_t size,
-                    sgx_stub_t * stubs, uint64_t total_size)
+                    sgx_stub_t * stubs, bool stubs_sha256, uint64_t total_size)
 {
     /* Check that the untrusted mapping is aligned to TRUSTED_STUB_SIZE
      * and includes the range for copying into the buffer */
@@ -543,13 +845,15 @@ int copy_and_verify_trusted_file (const char * path, const void * umem,
      * may not be copied into the file content, depending on the offset of
      * the content within the file. */
     uint64_t checking = umem_start;
-    /* The stubs is an array of 128-bit hash values of the file chunks.
-     * from the beginning of the file. 's' points to the stub that needs to
-     * be checked for the current offset. */
-    sgx_stub_t * s = stubs + checking / TRUSTED_STUB_SIZE;
+    /* The stubs is an array of hash values of the file chunks (128-bit
+     * AES-CMACs or 256-bit SHA256 hashes) from the beginning of the file.
+     * 's' points to the stub that needs to be checked for the current
+     * offset. */
+    size_t stub_size = stubs_sha256 ? sizeof(sgx_checksum_t) : sizeof(sgx_stub_t);
+    const char * s = (const char *)stubs + checking / TRUSTED_STUB_SIZE * stub_size;
     int ret = 0;
 
-    for (; checking < umem_end ; checking += TRUSTED_STUB_SIZE, s++) {
+    for (; checking < umem_end ; checking += TRUSTED_STUB_SIZE, s += stub_size) {
         /* Check one chunk at a time. */
         uint64_t checking_size = MIN(total_size - checking, TRUSTED_STUB_SIZE);
         uint64_t checking_end = checking + checking_size;
@@ -562,16 +866,24 @@ int copy_and_verify_trusted_file (const char * path, const void * umem,
             memcpy(buffer + checking - offset, umem + checking - umem_start,
                    checking_size);
 
-            /* Storing the checksum (using AES-CMAC) inside hash. */
-            ret = lib_AESCMAC((uint8_t*)&enclave_key, sizeof(enclave_key),
-                              buffer + checking - offset, checking_size,
-                              (uint8_t*)&hash, sizeof(hash));
+            /* Storing the checksum (using AES-CMAC or SHA256) inside hash. */
+            if (stubs_sha256) {
+                LIB_SHA256_CONTEXT sha;
+                if ((ret = lib_SHA256Init(&sha)) >= 0 &&
+                    (ret = lib_SHA256Update(&sha, buffer + checking - offset,
+                                            checking_size)) >= 0)
+                    ret = lib_SHA256Final(&sha, (uint8_t*)hash.bytes);
+            } else {
+                ret = lib_AESCMAC((uint8_t*)&enclave_key, sizeof(enclave_key),
+                                  buffer + checking - offset, checking_size,
+                                  (uint8_t*)&hash, sizeof(hash));
+            }
         } else {
             /* If the checking chunk only partially overlaps with the region,
              * read the file content in smaller chunks and only copy the part
              * needed by the caller. */
-            LIB_AESCMAC_CONTEXT aes_cmac;
-            ret = lib_AESCMACInit(&aes_cmac, (uint8_t*)&enclave_key, sizeof(enclave_key));
+            struct chunk_hash chunk_hash;
+            ret = chunk_hash_init(&chunk_hash, stubs_sha256);
             if (ret < 0)
                 goto failed;
 
@@ -588,7 +900,7 @@ int copy_and_verify_trusted_file (const char * path, const void * umem,
                        chunk_size);
 
                 /* Update the hash for the current chunk */
-                ret = lib_AESCMACUpdate(&aes_cmac, small_chunk, chunk_size);
+                ret = chunk_hash_update(&chunk_hash, small_chunk, chunk_size);
                 if (ret < 0)
                     goto failed;
 
@@ -608,8 +920,8 @@ int copy_and_verify_trusted_file (const char * path, const void * umem,
                            copy_end - copy_start);
             }
 
-            /* Storing the checksum (using AES-CMAC) inside hash. */
-            ret = lib_AESCMACFinish(&aes_cmac, (uint8_t*)&hash, sizeof(hash));
+            /* Storing the checksum (using AES-CMAC or SHA256) inside hash. */
+            ret = chunk_hash_final(&chunk_hash, &hash);
         }
 
         if (ret < 0)
@@ -624,7 +936,7 @@ int copy_and_verify_trusted_file (const char * path, const void * umem,
          *
          * XXX: Maybe we should zero the buffer after denying the access?
          */
-        if (memcmp(s, &hash, sizeof(sgx_stub_t))) {
+        if (memcmp(s, &hash, stub_size)) {
             SGX_DBG(DBG_E, "Accesing file:%s is denied. Does not match with MAC"
                     " at chunk starting at %lu-%lu.\n",
                     path, checking, checking_end);
@@ -638,23 +950,44 @@ failed:
     return -PAL_ERROR_DENIED;
 }
 
-static int register_trusted_file(const char* uri, const char* checksum_str, bool check_duplicates) {
-    struct trusted_file * tf = NULL, * new;
+/* Parses "<offset>:<root hash>" from sgx.trusted_chunks.xxx into `tf` */
+static int parse_chunk_hashes(struct trusted_file* tf, const char* chunks_str) {
+    char* end;
+    long offset = strtol(chunks_str, &end, 10);
+    if (end == chunks_str || *end != ':' || offset < 0)
+        return -PAL_ERROR_INVAL;
+
+    const char* hex = end + 1;
+    for (size_t i = 0; i < sizeof(sgx_checksum_t); i++) {
+        int8_t hi = hex2dec(hex[i * 2]);
+        int8_t lo = hi < 0 ? -1 : hex2dec(hex[i * 2 + 1]);
+        if (lo < 0)
+            return -PAL_ERROR_INVAL;
+        tf->chunk_hashes_root.bytes[i] = hi * 16 + lo;
+    }
+
+    tf->chunk_hashes_offset = offset;
+    tf->has_chunk_hashes    = true;
+    return 0;
+}
+
+static int register_trusted_file(const char* uri, const char* checksum_str,
+                                 const char* chunks_str, bool check_duplicates) {
+    struct trusted_file * new;
     size_t uri_len = strlen(uri);
     int ret;
 
+    if (!strstartswith_static(uri, URI_PREFIX_FILE))
+        return -PAL_ERROR_INVAL;
+
     if (check_duplicates) {
         /* this check is only done during runtime (when creating a new file) and not needed during
-         * initialization (because manifest is assumed to have no duplicates); skipping this check
-         * significantly improves startup time */
+         * initialization (because manifest is assumed to have no duplicates) */
         spinlock_lock(&trusted_file_lock);
-        LISTP_FOR_EACH_ENTRY(tf, &trusted_file_list, list) {
-            if (tf->uri_len == uri_len && !memcmp(tf->uri, uri, uri_len)) {
-                spinlock_unlock(&trusted_file_lock);
-                return 0;
-            }
-        }
+        bool registered = lookup_registered_uri(uri, uri_len) != NULL;
         spinlock_unlock(&trusted_file_lock);
+        if (registered)
+            return 0;
     }
 
     new = malloc(sizeof(struct trusted_file));
@@ -666,6 +999,9 @@ static int register_trusted_file(const char* uri, const char* checksum_str, bool
     memcpy(new->uri, uri, uri_len + 1);
     new->size = 0;
     new->stubs = NULL;
+    new->stubs_sha256 = false;
+    new->has_chunk_hashes = false;
+    new->verify_usec = 0;
 
     if (checksum_str) {
         PAL_STREAM_ATTR attr;
@@ -711,6 +1047,12 @@ static int register_trusted_file(const char* uri, const char* checksum_str, bool
             return -PAL_ERROR_INVAL;
         }
 
+        if (chunks_str && parse_chunk_hashes(new, chunks_str) < 0) {
+            SGX_DBG(DBG_E, "Invalid precomputed chunk hashes for %s: %s\n", uri, chunks_str);
+            free(new);
+            return -PAL_ERROR_INVAL;
+        }
+
         new->index = (++trusted_file_indexes);
         SGX_DBG(DBG_S, "trusted: [%ld] %s %s\n", new->index,
                 checksum_text, new->uri);
@@ -722,28 +1064,44 @@ static int register_trusted_file(const char* uri, const char* checksum_str, bool
 
     spinlock_lock(&trusted_file_lock);
 
-    if (check_duplicates) {
+    if (check_duplicates && lookup_registered_uri(uri, uri_len)) {
         /* this check is only done during runtime and not needed during initialization (see above);
          * we check again because same file could have been added by another thread in meantime */
-        LISTP_FOR_EACH_ENTRY(tf, &trusted_file_list, list) {
-            if (tf->uri_len == uri_len && !memcmp(tf->uri, uri, uri_len)) {
-                spinlock_unlock(&trusted_file_lock);
-                free(new);
-                return 0;
-            }
+        spinlock_unlock(&trusted_file_lock);
+        free(new);
+        return 0;
+    }
+
+    bool inserted = false;
+    ret = 0;
+
+    if (new->index) {
+        ret = insert_trusted_uri(new);
+        inserted = !ret;
+    } else {
+        struct allowed_node* node = walk_allowed_path(new->uri + URI_PREFIX_FILE_LEN,
+                                                      /*create=*/true);
+        if (!node) {
+            ret = -PAL_ERROR_NOMEM;
+        } else if (!node->tf) {
+            /* for duplicate allowed entries in the manifest, the first one wins */
+            node->tf = new;
+            inserted = true;
         }
     }
 
-    LISTP_ADD_TAIL(new, &trusted_file_list, list);
     spinlock_unlock(&trusted_file_lock);
 
-    return 0;
+    if (!inserted)
+        free(new);
+    return ret;
 }
 
 static int init_trusted_file (const char * key, const char * uri)
 {
     char cskey[URI_MAX], * tmp;
     char checksum[URI_MAX];
+    char chunks[URI_MAX];
     char normpath[URI_MAX];
 
     tmp = strcpy_static(cskey, "sgx.trusted_checksum.", URI_MAX);
@@ -753,6 +1111,13 @@ static int init_trusted_file (const char * key, const char * uri)
     if (ret < 0)
         return 0;
 
+    bool has_chunks = false;
+    if (trusted_chunks_fd >= 0) {
+        tmp = strcpy_static(cskey, "sgx.trusted_chunks.", URI_MAX);
+        memcpy(tmp, key, strlen(key) + 1);
+        has_chunks = get_config(pal_state.root_config, cskey, chunks, sizeof(chunks)) > 0;
+    }
+
     /* Normalize the uri */
     if (!strstartswith_static(uri, URI_PREFIX_FILE)) {
         SGX_DBG(DBG_E, "Invalid URI [%s]: Trusted files must start with 'file:'\n", uri);
@@ -770,7 +1135,8 @@ static int init_trusted_file (const char * key, const char * uri)
         return ret;
     }
 
-    return register_trusted_file(normpath, checksum, /*check_duplicates=*/false);
+    return register_trusted_file(normpath, checksum, has_chunks ? chunks : NULL,
+                                 /*check_duplicates=*/false);
 }
 
 int init_trusted_files (void) {
@@ -783,6 +1149,22 @@ int init_trusted_files (void) {
     char* k;
     char* tmp;
 
+    /* chunk hashes precomputed by the signer (sgx.precompute_chunk_hashes) */
+    if (get_config(store, "sgx.trusted_chunks_file", uri, sizeof(uri)) > 0) {
+        if (!strstartswith_static(uri, URI_PREFIX_FILE)) {
+            SGX_DBG(DBG_E, "Invalid URI [%s]: sgx.trusted_chunks_file must start with 'file:'\n",
+                    uri);
+            return -PAL_ERROR_INVAL;
+        }
+        ret = ocall_open(uri + URI_PREFIX_FILE_LEN, O_RDONLY | O_CLOEXEC, 0);
+        if (IS_ERR(ret)) {
+            /* not fatal: trusted files are then checked against their whole-file checksums */
+            SGX_DBG(DBG_E, "Cannot open %s, precomputed chunk hashes are not used\n", uri);
+        } else {
+            trusted_chunks_fd = ret;
+        }
+    }
+
     if (pal_sec.exec_name[0] != '\0') {
         ret = init_trusted_file("exec", pal_sec.exec_name);
         if (ret < 0)
@@ -902,7 +1284,7 @@ no_trusted:
             goto out;
         }
 
-        register_trusted_file(norm_path, NULL, /*check_duplicates=*/false);
+        register_trusted_file(norm_path, NULL, NULL, /*check_duplicates=*/false);
     }
 
 no_allowed:
@@ -913,11 +1295,239 @@ no_allowed:
     else
         allow_file_creation = false;
 
+    apply_inherited_stubs();
+
 out:
     free(cfgbuf);
     return ret;
 }
 
+/*
+ * A child enclave created with the same manifest (i.e., the same mr_enclave) as its parent
+ * trusts exactly the same files with the same checksums. Instead of letting the child hash
+ * again every file its parent has already verified, the parent sends the stubs of all verified
+ * trusted files over the secure process channel right after the master key, and the child
+ * installs them into its own trusted file entries.
+ *
+ * Stubs precomputed by the signer (SHA256) do not depend on any key. AES-CMAC stubs are only
+ * usable if the child derived the same enclave_key, which it checks by comparing the
+ * `key_check` sent by the parent with its own. A child only installs stubs received from a
+ * parent with the same mr_enclave, and only for files whose checksum and size match its own
+ * entries; the parent always sends the header, so both ends stay in sync.
+ */
+struct trusted_stubs_hdr {
+    uint64_t nfiles;
+    uint64_t size;         /* size of the entries following the header */
+    sgx_mac_t key_check;   /* AES-CMAC of `trusted_stubs_key_check` under enclave_key */
+};
+
+struct trusted_stubs_entry {
+    uint64_t size;
+    uint64_t verify_usec;
+    sgx_checksum_t checksum;
+    uint32_t uri_len;
+    uint8_t stubs_sha256;
+    uint8_t reserved[3];
+    /* followed by the URI (without the terminating null byte) and the stubs */
+};
+
+static const char trusted_stubs_key_check[16] = "trusted stubs";
+
+static size_t trusted_stubs_size(uint64_t file_size, bool stubs_sha256) {
+    uint64_t nstubs = file_size / TRUSTED_STUB_SIZE + (file_size % TRUSTED_STUB_SIZE ? 1 : 0);
+    return nstubs * (stubs_sha256 ? sizeof(sgx_checksum_t) : sizeof(sgx_stub_t));
+}
+
+static size_t trusted_stubs_entry_size(size_t uri_len, uint64_t file_size, bool stubs_sha256) {
+    return ALIGN_UP(sizeof(struct trusted_stubs_entry) + uri_len +
+                    trusted_stubs_size(file_size, stubs_sha256), sizeof(uint64_t));
+}
+
+static int get_trusted_stubs_key_check(sgx_mac_t* mac) {
+    return lib_AESCMAC((uint8_t*)&enclave_key, sizeof(enclave_key),
+                       (const uint8_t*)trusted_stubs_key_check, sizeof(trusted_stubs_key_check),
+                       (uint8_t*)mac, sizeof(*mac));
+}
+
+/* SSL records are limited in size, so large buffers take several reads/writes */
+static int secure_write_all(LIB_SSL_CONTEXT* ssl_ctx, const uint8_t* buf, size_t len) {
+    while (len) {
+        int bytes = _DkStreamSecureWrite(ssl_ctx, buf, len);
+        if (bytes < 0)
+            return bytes;
+        buf += bytes;
+        len -= bytes;
+    }
+    return 0;
+}
+
+static int secure_read_all(LIB_SSL_CONTEXT* ssl_ctx, uint8_t* buf, size_t len) {
+    while (len) {
+        int bytes = _DkStreamSecureRead(ssl_ctx, buf, len);
+        if (bytes < 0)
+            return bytes;
+        buf += bytes;
+        len -= bytes;
+    }
+    return 0;
+}
+
+int send_trusted_file_stubs(LIB_SSL_CONTEXT* ssl_ctx, bool same_enclave) {
+    struct trusted_stubs_hdr hdr;
+    void* entries = NULL;
+    int ret;
+
+    memset(&hdr, 0, sizeof(hdr));
+    ret = get_trusted_stubs_key_check(&hdr.key_check);
+    if (ret < 0)
+        return ret;
+
+    spinlock_lock(&trusted_file_lock);
+
+    if (same_enclave) {
+        for (size_t i = 0; i < trusted_file_table_size; i++) {
+            struct trusted_file* tf;
+            LISTP_FOR_EACH_ENTRY(tf, &trusted_file_table[i], list) {
+                if (tf->index > 0 && tf->stubs)
+                    hdr.size += trusted_stubs_entry_size(tf->uri_len, tf->size, tf->stubs_sha256);
+            }
+        }
+    }
+
+    if (hdr.size) {
+        entries = malloc(hdr.size);
+        if (!entries) {
+            spinlock_unlock(&trusted_file_lock);
+            return -PAL_ERROR_NOMEM;
+        }
+
+        uint8_t* ptr = entries;
+        for (size_t i = 0; i < trusted_file_table_size; i++) {
+            struct trusted_file* tf;
+            LISTP_FOR_EACH_ENTRY(tf, &trusted_file_table[i], list) {
+                if (tf->index <= 0 || !tf->stubs)
+                    continue;
+
+                struct trusted_stubs_entry* entry = (struct trusted_stubs_entry*)ptr;
+                size_t stubs_size = trusted_stubs_size(tf->size, tf->stubs_sha256);
+                memset(entry, 0, sizeof(*entry));
+                entry->size         = tf->size;
+                entry->verify_usec  = tf->verify_usec;
+                entry->checksum     = tf->checksum;
+                entry->uri_len      = tf->uri_len;
+                entry->stubs_sha256 = tf->stubs_sha256;
+                memcpy(entry + 1, tf->uri, tf->uri_len);
+                memcpy((uint8_t*)(entry + 1) + tf->uri_len, tf->stubs, stubs_size);
+
+                ptr += trusted_stubs_entry_size(tf->uri_len, tf->size, tf->stubs_sha256);
+                hdr.nfiles++;
+            }
+        }
+    }
+
+    spinlock_unlock(&trusted_file_lock);
+
+    ret = secure_write_all(ssl_ctx, (uint8_t*)&hdr, sizeof(hdr));
+    if (!ret && hdr.size)
+        ret = secure_write_all(ssl_ctx, entries, hdr.size);
+
+    if (!ret && hdr.nfiles)
+        SGX_DBG(DBG_S, "Sent stubs of %lu trusted files to child\n", hdr.nfiles);
+
+    free(entries);
+    return ret;
+}
+
+int receive_trusted_file_stubs(LIB_SSL_CONTEXT* ssl_ctx, bool same_enclave) {
+    struct trusted_stubs_hdr hdr;
+    int ret = secure_read_all(ssl_ctx, (uint8_t*)&hdr, sizeof(hdr));
+    if (ret < 0)
+        return ret;
+
+    if (!hdr.size)
+        return 0;
+
+    uint8_t* entries = malloc(hdr.size);
+    if (!entries)
+        return -PAL_ERROR_NOMEM;
+
+    /* always consume the entries to keep the stream in sync */
+    ret = secure_read_all(ssl_ctx, entries, hdr.size);
+    if (ret < 0 || !same_enclave) {
+        free(entries);
+        return ret;
+    }
+
+    sgx_mac_t key_check;
+    ret = get_trusted_stubs_key_check(&key_check);
+    if (ret < 0) {
+        free(entries);
+        return ret;
+    }
+
+    /* only the signer-precomputed stubs are usable if the stub keys differ */
+    inherited_stubs_same_key = !memcmp(&key_check, &hdr.key_check, sizeof(key_check));
+    inherited_stubs_nfiles   = hdr.nfiles;
+    inherited_stubs_size     = hdr.size;
+    inherited_stubs          = entries;
+    return 0;
+}
+
+static void apply_inherited_stubs(void) {
+    if (!inherited_stubs)
+        return;
+
+    uint8_t* ptr = inherited_stubs;
+    uint8_t* end = inherited_stubs + inherited_stubs_size;
+    uint64_t ninstalled = 0;
+    uint64_t saved_usec = 0;
+
+    spinlock_lock(&trusted_file_lock);
+
+    for (uint64_t i = 0; i < inherited_stubs_nfiles; i++) {
+        struct trusted_stubs_entry* entry = (struct trusted_stubs_entry*)ptr;
+        if ((size_t)(end - ptr) < sizeof(*entry) || entry->uri_len >= URI_MAX)
+            break;
+
+        size_t entry_size = trusted_stubs_entry_size(entry->uri_len, entry->size,
+                                                     entry->stubs_sha256);
+        if ((size_t)(end - ptr) < entry_size)
+            break;
+        ptr += entry_size;
+
+        if (!entry->stubs_sha256 && !inherited_stubs_same_key)
+            continue;
+
+        const char* uri = (const char*)(entry + 1);
+        struct trusted_file* tf = lookup_trusted_uri(uri, entry->uri_len);
+        if (!tf || tf->index <= 0 || tf->stubs || tf->size != entry->size ||
+                memcmp(&tf->checksum, &entry->checksum, sizeof(tf->checksum)))
+            continue;
+
+        size_t stubs_size = trusted_stubs_size(entry->size, entry->stubs_sha256);
+        sgx_stub_t* stubs = malloc(stubs_size);
+        if (!stubs)
+            break;
+        memcpy(stubs, uri + entry->uri_len, stubs_size);
+
+        tf->stubs        = stubs;
+        tf->stubs_sha256 = entry->stubs_sha256;
+        tf->verify_usec  = entry->verify_usec;
+        ninstalled++;
+        saved_usec += entry->verify_usec;
+    }
+
+    spinlock_unlock(&trusted_file_lock);
+
+    SGX_DBG(DBG_I, "Inherited stubs of %lu/%lu trusted files from parent "
+            "(saved up to %lu us of verification)\n", ninstalled, inherited_stubs_nfiles,
+            saved_usec);
+
+    free(inherited_stubs);
+    inherited_stubs = NULL;
+    inherited_stubs_size = 0;
+}
+
 int init_trusted_children (void)
 {
     struct config_store * store = pal_state.root_config;
@@ -15,6 +15,7 @@
 #include "pal_internal.h"
 #include "pal_linux.h"
 #include "pal_linux_error.h"
+#include "ocall_profile.h"
 #include "rpc_queue.h"
 #include "sgx_attest.h"
 #include "spinlock.h"
@@ -29,7 +30,19 @@
 /* global pointer to a single untrusted queue, all accesses must be protected by g_rpc_queue->lock */
 rpc_queue_t* g_rpc_queue;
 
+ocall_profile_t* g_ocall_profile;
+
+/* must be called right before the OCALL, when its arguments are on the untrusted stack */
+static void profile_ocall_ustack(uint64_t code) {
+    if (!g_ocall_profile || code >= OCALL_NR)
+        return;
+    uint64_t bytes = GET_ENCLAVE_TLS(ustack_top) - GET_ENCLAVE_TLS(ustack);
+    __atomic_add_fetch(&g_ocall_profile->ocalls[code].ustack_bytes, bytes, __ATOMIC_RELAXED);
+}
+
 static long sgx_exitless_ocall(uint64_t code, void* ms) {
+    profile_ocall_ustack(code);
+
     /* perform OCALL with enclave exit if no RPC queue (i.e., no exitless); no need for atomics
      * because this pointer is set only once at enclave initialization */
     if (!g_rpc_queue)
@@ -60,8 +73,12 @@ static long sgx_exitless_ocall(uint64_t code, void* ms) {
         /* no space in queue: all RPC threads are busy with outstanding ocalls; fallback to normal
          * syscall path with enclave exit */
         sgx_reset_ustack(old_ustack);
+        if (g_ocall_profile && code < OCALL_NR)
+            __atomic_add_fetch(&g_ocall_profile->ocalls[code].exitless_fallbacks, 1,
+                               __ATOMIC_RELAXED);
         return sgx_ocall(code, ms);
     }
+    pal_get_tcb()->host_calls++;
 
     /* wait till request processing is finished; try spinlock first */
     int timedout = spinlock_lock_timeout(&req->lock, RPC_SPINLOCK_TIMEOUT);
@@ -543,6 +560,129 @@ out:
     return retval;
 }
 
+/* Like ocall_pread(), but the data is scattered over the buffers of `vec`, which must be inside
+ * the enclave. The host reads their total size into one untrusted buffer with a single pread. */
+ssize_t ocall_preadv(int fd, const PAL_IOVEC* vec, size_t vlen, off_t offset) {
+    long retval = 0;
+    void* obuf = NULL;
+    ms_ocall_pread_t* ms;
+    void* ms_buf;
+    bool need_munmap = false;
+
+    size_t count = 0;
+    for (size_t i = 0; i < vlen; i++)
+        if (__builtin_add_overflow(count, vec[i].size, &count))
+            return -EINVAL;
+
+    void* old_ustack = sgx_prepare_ustack();
+    if (count > MAX_UNTRUSTED_STACK_BUF) {
+        retval = ocall_mmap_untrusted_cache(ALLOC_ALIGN_UP(count), &obuf, &need_munmap);
+        if (IS_ERR(retval)) {
+            sgx_reset_ustack(old_ustack);
+            return retval;
+        }
+        ms_buf = obuf;
+    } else {
+        ms_buf = sgx_alloc_on_ustack(count);
+        if (!ms_buf) {
+            retval = -EPERM;
+            goto out;
+        }
+    }
+
+    ms = sgx_alloc_on_ustack_aligned(sizeof(*ms), alignof(*ms));
+    if (!ms) {
+        retval = -EPERM;
+        goto out;
+    }
+
+    ms->ms_fd = fd;
+    ms->ms_count = count;
+    ms->ms_offset = offset;
+    ms->ms_buf = ms_buf;
+
+    retval = sgx_exitless_ocall(OCALL_PREAD, ms);
+    if (retval > 0 && (size_t)retval > count) {
+        retval = -EPERM;
+    } else if (retval > 0) {
+        size_t done = 0;
+        for (size_t i = 0; i < vlen && done < (size_t)retval; i++) {
+            size_t size = MIN(vec[i].size, (size_t)retval - done);
+            if (size && !sgx_copy_to_enclave(vec[i].buffer, size, ms_buf + done, size)) {
+                retval = -EPERM;
+                break;
+            }
+            done += size;
+        }
+    }
+
+out:
+    sgx_reset_ustack(old_ustack);
+    if (obuf)
+        ocall_munmap_untrusted_cache(obuf, ALLOC_ALIGN_UP(count), need_munmap);
+    return retval;
+}
+
+/* Like ocall_pwrite(), but the data is gathered from the buffers of `vec`, which must be inside
+ * the enclave, into one untrusted buffer written by the host with a single pwrite. */
+ssize_t ocall_pwritev(int fd, const PAL_IOVEC* vec, size_t vlen, off_t offset) {
+    long retval = 0;
+    void* obuf = NULL;
+    ms_ocall_pwrite_t* ms;
+    void* ms_buf;
+    bool need_munmap = false;
+
+    size_t count = 0;
+    for (size_t i = 0; i < vlen; i++) {
+        if (__builtin_add_overflow(count, vec[i].size, &count))
+            return -EINVAL;
+        if (!sgx_is_completely_within_enclave(vec[i].buffer, vec[i].size))
+            return -EPERM;
+    }
+
+    void* old_ustack = sgx_prepare_ustack();
+    if (count > MAX_UNTRUSTED_STACK_BUF) {
+        /* the buffers are too big and may overflow untrusted stack, so use untrusted heap */
+        retval = ocall_mmap_untrusted_cache(ALLOC_ALIGN_UP(count), &obuf, &need_munmap);
+        if (IS_ERR(retval)) {
+            sgx_reset_ustack(old_ustack);
+            return retval;
+        }
+        ms_buf = obuf;
+    } else {
+        ms_buf = sgx_alloc_on_ustack(count);
+        if (!ms_buf) {
+            retval = -EPERM;
+            goto out;
+        }
+    }
+
+    size_t done = 0;
+    for (size_t i = 0; i < vlen; i++) {
+        memcpy(ms_buf + done, vec[i].buffer, vec[i].size);
+        done += vec[i].size;
+    }
+
+    ms = sgx_alloc_on_ustack_aligned(sizeof(*ms), alignof(*ms));
+    if (!ms) {
+        retval = -EPERM;
+        goto out;
+    }
+
+    ms->ms_fd = fd;
+    ms->ms_count = count;
+    ms->ms_offset = offset;
+    ms->ms_buf = ms_buf;
+
+    retval = sgx_exitless_ocall(OCALL_PWRITE, ms);
+
+out:
+    sgx_reset_ustack(old_ustack);
+    if (obuf)
+        ocall_munmap_untrusted_cache(obuf, ALLOC_ALIGN_UP(count), need_munmap);
+    return retval;
+}
+
 int ocall_fstat (int fd, struct stat * buf)
 {
     int retval = 0;
@@ -1206,6 +1346,7 @@ int ocall_sleep (unsigned long * microsec)
     ms->ms_microsec = microsec ? *microsec : 0;
 
     /* NOTE: no reason to use exitless for sleep() */
+    profile_ocall_ustack(OCALL_SLEEP);
     retval = sgx_ocall(OCALL_SLEEP, ms);
     if (microsec) {
         if (!retval)
@@ -1323,6 +1464,224 @@ int ocall_load_debug(const char * command)
     return retval;
 }
 
+ssize_t ocall_transfer(int src_fd, int64_t src_offset, int dst_fd, int64_t dst_offset,
+                       size_t count) {
+    ssize_t retval = 0;
+    ms_ocall_transfer_t* ms;
+
+    void* old_ustack = sgx_prepare_ustack();
+    ms = sgx_alloc_on_ustack_aligned(sizeof(*ms), alignof(*ms));
+    if (!ms) {
+        sgx_reset_ustack(old_ustack);
+        return -EPERM;
+    }
+
+    ms->ms_src_fd = src_fd;
+    ms->ms_src_offset = src_offset;
+    ms->ms_dst_fd = dst_fd;
+    ms->ms_dst_offset = dst_offset;
+    ms->ms_count = count;
+
+    retval = sgx_exitless_ocall(OCALL_TRANSFER, ms);
+
+    if (retval > 0 && (size_t)retval > count)
+        retval = -EPERM;
+
+    sgx_reset_ustack(old_ustack);
+    return retval;
+}
+
+int ocall_epoll_create(int flags) {
+    int retval = 0;
+    ms_ocall_epoll_create_t* ms;
+
+    void* old_ustack = sgx_prepare_ustack();
+    ms = sgx_alloc_on_ustack_aligned(sizeof(*ms), alignof(*ms));
+    if (!ms) {
+        sgx_reset_ustack(old_ustack);
+        return -EPERM;
+    }
+
+    ms->ms_flags = flags;
+
+    retval = sgx_exitless_ocall(OCALL_EPOLL_CREATE, ms);
+
+    sgx_reset_ustack(old_ustack);
+    return retval;
+}
+
+int ocall_epoll_ctl(int epfd, int op, int fd, struct epoll_event* event) {
+    int retval = 0;
+    ms_ocall_epoll_ctl_t* ms;
+
+    void* old_ustack = sgx_prepare_ustack();
+    ms = sgx_alloc_on_ustack_aligned(sizeof(*ms), alignof(*ms));
+    if (!ms) {
+        sgx_reset_ustack(old_ustack);
+        return -EPERM;
+    }
+
+    ms->ms_epfd  = epfd;
+    ms->ms_op    = op;
+    ms->ms_fd    = fd;
+    ms->ms_event = *event;
+
+    retval = sgx_exitless_ocall(OCALL_EPOLL_CTL, ms);
+
+    sgx_reset_ustack(old_ustack);
+    return retval;
+}
+
+int ocall_epoll_wait(int epfd, struct epoll_event* events, int maxevents, int64_t timeout_us) {
+    int retval = 0;
+    size_t events_bytes = maxevents * sizeof(struct epoll_event);
+    ms_ocall_epoll_wait_t* ms;
+
+    void* old_ustack = sgx_prepare_ustack();
+    ms = sgx_alloc_on_ustack_aligned(sizeof(*ms), alignof(*ms));
+    if (!ms) {
+        sgx_reset_ustack(old_ustack);
+        return -EPERM;
+    }
+
+    ms->ms_epfd       = epfd;
+    ms->ms_maxevents  = maxevents;
+    ms->ms_timeout_us = timeout_us;
+    ms->ms_events     = sgx_alloc_on_ustack(events_bytes);
+    if (!ms->ms_events) {
+        sgx_reset_ustack(old_ustack);
+        return -EPERM;
+    }
+
+    retval = sgx_exitless_ocall(OCALL_EPOLL_WAIT, ms);
+
+    if (retval > maxevents) {
+        retval = -EPERM;
+    } else if (retval > 0) {
+        /* the returned events are untrusted; the caller validates their data */
+        if (!sgx_copy_to_enclave(events, events_bytes, ms->ms_events,
+                                 retval * sizeof(struct epoll_event))) {
+            sgx_reset_ustack(old_ustack);
+            return -EPERM;
+        }
+    }
+
+    sgx_reset_ustack(old_ustack);
+    return retval;
+}
+
+int ocall_sched_setaffinity(void* tcs, size_t cpumask_size, void* cpu_mask) {
+    int retval = 0;
+    ms_ocall_sched_affinity_t* ms;
+
+    void* old_ustack = sgx_prepare_ustack();
+    ms = sgx_alloc_on_ustack_aligned(sizeof(*ms), alignof(*ms));
+    if (!ms) {
+        sgx_reset_ustack(old_ustack);
+        return -EPERM;
+    }
+
+    ms->ms_tcs          = tcs;
+    ms->ms_cpumask_size = cpumask_size;
+    ms->ms_cpu_mask     = sgx_copy_to_ustack(cpu_mask, cpumask_size);
+    if (!ms->ms_cpu_mask) {
+        sgx_reset_ustack(old_ustack);
+        return -EPERM;
+    }
+
+    retval = sgx_exitless_ocall(OCALL_SCHED_SETAFFINITY, ms);
+
+    sgx_reset_ustack(old_ustack);
+    return retval;
+}
+
+int ocall_sched_getaffinity(void* tcs, size_t cpumask_size, void* cpu_mask) {
+    int retval = 0;
+    ms_ocall_sched_affinity_t* ms;
+
+    void* old_ustack = sgx_prepare_ustack();
+    ms = sgx_alloc_on_ustack_aligned(sizeof(*ms), alignof(*ms));
+    if (!ms) {
+        sgx_reset_ustack(old_ustack);
+        return -EPERM;
+    }
+
+    ms->ms_tcs          = tcs;
+    ms->ms_cpumask_size = cpumask_size;
+    ms->ms_cpu_mask     = sgx_alloc_on_ustack_aligned(cpumask_size, alignof(long));
+    if (!ms->ms_cpu_mask) {
+        sgx_reset_ustack(old_ustack);
+        return -EPERM;
+    }
+
+    retval = sgx_exitless_ocall(OCALL_SCHED_GETAFFINITY, ms);
+
+    /* on success the host returns the number of bytes it wrote */
+    if (retval > (int)cpumask_size) {
+        retval = -EPERM;
+    } else if (retval > 0) {
+        if (!sgx_copy_to_enclave(cpu_mask, cpumask_size, ms->ms_cpu_mask, retval)) {
+            sgx_reset_ustack(old_ustack);
+            return -EPERM;
+        }
+    }
+
+    sgx_reset_ustack(old_ustack);
+    return retval;
+}
+
+int ocall_fallocate(int fd, int mode, uint64_t offset, uint64_t length) {
+    int retval = 0;
+    ms_ocall_fallocate_t* ms;
+
+    void* old_ustack = sgx_prepare_ustack();
+    ms = sgx_alloc_on_ustack_aligned(sizeof(*ms), alignof(*ms));
+    if (!ms) {
+        sgx_reset_ustack(old_ustack);
+        return -EPERM;
+    }
+
+    ms->ms_fd     = fd;
+    ms->ms_mode   = mode;
+    ms->ms_offset = offset;
+    ms->ms_length = length;
+
+    retval = sgx_exitless_ocall(OCALL_FALLOCATE, ms);
+
+    sgx_reset_ustack(old_ustack);
+    return retval;
+}
+
+static int ocall_file_range(int code, int fd, uint64_t offset, uint64_t length, int flags) {
+    int retval = 0;
+    ms_ocall_file_range_t* ms;
+
+    void* old_ustack = sgx_prepare_ustack();
+    ms = sgx_alloc_on_ustack_aligned(sizeof(*ms), alignof(*ms));
+    if (!ms) {
+        sgx_reset_ustack(old_ustack);
+        return -EPERM;
+    }
+
+    ms->ms_fd     = fd;
+    ms->ms_flags  = flags;
+    ms->ms_offset = offset;
+    ms->ms_length = length;
+
+    retval = sgx_exitless_ocall(code, ms);
+
+    sgx_reset_ustack(old_ustack);
+    return retval;
+}
+
+int ocall_fadvise(int fd, uint64_t offset, uint64_t length, int advice) {
+    return ocall_file_range(OCALL_FADVISE, fd, offset, length, advice);
+}
+
+int ocall_sync_file_range(int fd, uint64_t offset, uint64_t length, int flags) {
+    return ocall_file_range(OCALL_SYNC_FILE_RANGE, fd, offset, length, flags);
+}
+
 int ocall_eventfd (unsigned int initval, int flags)
 {
     int retval = 0;
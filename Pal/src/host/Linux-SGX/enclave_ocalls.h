@@ -5,6 +5,7 @@
 #include "pal_linux.h"
 
 #include <asm/stat.h>
+#include <linux/eventpoll.h>
 #include <linux/socket.h>
 #include <linux/poll.h>
 #include <sys/types.h>
@@ -32,6 +33,10 @@ ssize_t ocall_pread(int fd, void* buf, size_t count, off_t offset);
 
 ssize_t ocall_pwrite(int fd, const void* buf, size_t count, off_t offset);
 
+ssize_t ocall_preadv(int fd, const PAL_IOVEC* vec, size_t vlen, off_t offset);
+
+ssize_t ocall_pwritev(int fd, const PAL_IOVEC* vec, size_t vlen, off_t offset);
+
 int ocall_fstat (int fd, struct stat * buf);
 
 int ocall_fionread (int fd);
@@ -96,6 +101,25 @@ int ocall_load_debug (const char * command);
 
 int ocall_eventfd (unsigned int initval, int flags);
 
+ssize_t ocall_transfer(int src_fd, int64_t src_offset, int dst_fd, int64_t dst_offset,
+                       size_t count);
+
+int ocall_epoll_create(int flags);
+
+int ocall_epoll_ctl(int epfd, int op, int fd, struct epoll_event* event);
+
+int ocall_epoll_wait(int epfd, struct epoll_event* events, int maxevents, int64_t timeout_us);
+
+int ocall_sched_setaffinity(void* tcs, size_t cpumask_size, void* cpu_mask);
+
+int ocall_sched_getaffinity(void* tcs, size_t cpumask_size, void* cpu_mask);
+
+int ocall_fallocate(int fd, int mode, uint64_t offset, uint64_t length);
+
+int ocall_fadvise(int fd, uint64_t offset, uint64_t length, int advice);
+
+int ocall_sync_file_range(int fd, uint64_t offset, uint64_t length, int flags);
+
 /*!
  * \brief Execute untrusted code in PAL to obtain a quote from the Quoting Enclave.
  *
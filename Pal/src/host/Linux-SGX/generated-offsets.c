@@ -81,6 +81,8 @@ void dummy(void)
 
     /* struct enclave_tls */
     OFFSET(SGX_COMMON_SELF, enclave_tls, common.self);
+    OFFSET(SGX_COMMON_HOST_CALLS, enclave_tls, common.host_calls);
+    OFFSET(SGX_COMMON_HOST_EXITS, enclave_tls, common.host_exits);
     OFFSET(SGX_ENCLAVE_SIZE, enclave_tls, enclave_size);
     OFFSET(SGX_TCS_OFFSET, enclave_tls, tcs_offset);
     OFFSET(SGX_INITIAL_STACK_OFFSET, enclave_tls, initial_stack_offset);
@@ -157,6 +159,7 @@ void dummy(void)
     DEFINE(ENCLAVE_STACK_SIZE, ENCLAVE_STACK_SIZE);
     DEFINE(ENCLAVE_SIG_STACK_SIZE, ENCLAVE_SIG_STACK_SIZE);
     DEFINE(DEFAULT_HEAP_MIN, DEFAULT_HEAP_MIN);
+    DEFINE(TRUSTED_STUB_SIZE, TRUSTED_STUB_SIZE);
 
     /* pal_linux.h */
     DEFINE(PAGESIZE, PRESET_PAGESIZE);
@@ -0,0 +1,40 @@
+/*
+ * OCALL profiler. If "sgx.ocall_profile" is set in the manifest, the untrusted runtime allocates
+ * an ocall_profile_t in untrusted memory and passes it to the enclave at ECALL_ENCLAVE_START.
+ * Both sides then account each OCALL type in it:
+ *
+ *   - the untrusted runtime counts the OCALLs it handles, separately for the exiting path and for
+ *     RPC threads (exitless path), and the time spent in the handlers;
+ *   - the enclave counts the bytes it put on the untrusted stack for the OCALL arguments and
+ *     buffers, the exitless OCALLs that fell back to an enclave exit because the RPC queue was
+ *     full, and the asynchronous exits (AEX) that delivered an exception or signal to the enclave.
+ *
+ * The profile is written to the given file when the process exits (child processes append their
+ * host PID to the file name). The profile resides in *untrusted memory*: the enclave only ever
+ * increments its counters and never reads them back.
+ */
+#ifndef OCALL_PROFILE_H_
+#define OCALL_PROFILE_H_
+
+#include <stdint.h>
+
+#include "ocall_types.h"
+
+struct ocall_profile_entry {
+    /* untrusted runtime */
+    uint64_t calls;              /* OCALLs handled with an enclave exit */
+    uint64_t exitless_calls;     /* OCALLs handled by an RPC thread */
+    uint64_t cycles;             /* TSC cycles spent in the handler, both paths */
+    /* enclave */
+    uint64_t ustack_bytes;       /* bytes allocated on the untrusted stack */
+    uint64_t exitless_fallbacks; /* exitless OCALLs issued with an exit (RPC queue full) */
+};
+
+typedef struct ocall_profile {
+    struct ocall_profile_entry ocalls[OCALL_NR];
+    uint64_t aex; /* asynchronous exits that delivered an exception or signal (enclave) */
+} ocall_profile_t;
+
+extern ocall_profile_t* g_ocall_profile; /* NULL if profiling is disabled */
+
+#endif /* OCALL_PROFILE_H_ */
@@ -2,6 +2,10 @@
  * This is for enclave to make ocalls to untrusted runtime.
  */
 
+#ifndef OCALL_TYPES_H_
+#define OCALL_TYPES_H_
+
+#include <linux/eventpoll.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <sys/types.h>
@@ -59,6 +63,15 @@ enum {
     OCALL_LOAD_DEBUG,
     OCALL_EVENTFD,
     OCALL_GET_QUOTE,
+    OCALL_TRANSFER,
+    OCALL_EPOLL_CREATE,
+    OCALL_EPOLL_CTL,
+    OCALL_EPOLL_WAIT,
+    OCALL_SCHED_SETAFFINITY,
+    OCALL_SCHED_GETAFFINITY,
+    OCALL_FALLOCATE,
+    OCALL_FADVISE,
+    OCALL_SYNC_FILE_RANGE,
     OCALL_NR,
 };
 
@@ -279,4 +292,53 @@ typedef struct {
     size_t            ms_quote_len;
 } ms_ocall_get_quote_t;
 
+typedef struct {
+    int ms_src_fd;
+    int64_t ms_src_offset; /* -1 if the source is not a file */
+    int ms_dst_fd;
+    int64_t ms_dst_offset; /* -1 if the destination is not a file */
+    uint64_t ms_count;
+} ms_ocall_transfer_t;
+
+typedef struct {
+    int ms_flags;
+} ms_ocall_epoll_create_t;
+
+typedef struct {
+    int ms_epfd;
+    int ms_op;
+    int ms_fd;
+    struct epoll_event ms_event;
+} ms_ocall_epoll_ctl_t;
+
+typedef struct {
+    int ms_epfd;
+    struct epoll_event* ms_events;
+    int ms_maxevents;
+    int64_t ms_timeout_us;
+} ms_ocall_epoll_wait_t;
+
+typedef struct {
+    void* ms_tcs;
+    uint64_t ms_cpumask_size;
+    void* ms_cpu_mask;
+} ms_ocall_sched_affinity_t;
+
+typedef struct {
+    int ms_fd;
+    int ms_mode;
+    uint64_t ms_offset;
+    uint64_t ms_length;
+} ms_ocall_fallocate_t;
+
+/* used by OCALL_FADVISE (advice) and OCALL_SYNC_FILE_RANGE (flags) */
+typedef struct {
+    int ms_fd;
+    int ms_flags;
+    uint64_t ms_offset;
+    uint64_t ms_length;
+} ms_ocall_file_range_t;
+
 #pragma pack(pop)
+
+#endif /* OCALL_TYPES_H_ */
@@ -42,26 +42,19 @@ void free_untrusted (void * mem);
 
 #include <list.h>
 
-/* Simpler mutex design: a single variable that tracks whether the mutex
- * is locked (just waste a 64 bit word for now).  State is 1 (locked) or
- * 0 (unlocked).
- *
- * Keep a count of how many threads are waiting on the mutex.
+/* Three-state futex mutex (see futex_lock.h): `locked` points to the futex word in untrusted
+ * memory, `spins` tunes the adaptive spinning before sleeping in the host.
  *
  * If DEBUG_MUTEX is defined, mutex_handle will record the owner of
  * mutex locking. */
 struct mutex_handle {
-    volatile int64_t * locked;
-    struct atomic_int nwaiters;
+    int* locked;
+    int spins;
 #ifdef DEBUG_MUTEX
     int owner;
 #endif
 };
 
-/* Initializer of Mutexes */
-#define MUTEX_HANDLE_INIT    { .u = 0 }
-#define INIT_MUTEX_HANDLE(m)  do { (m)->u = 0; } while (0)
-
 DEFINE_LIST(pal_handle_thread);
 struct pal_handle_thread {
     PAL_HDR reserved;
@@ -98,6 +91,7 @@ typedef struct pal_handle
             /* below fields are used only for trusted files */
             PAL_PTR stubs;    /* contains hashes of file chunks */
             PAL_PTR umem;     /* valid only when stubs != NULL */
+            PAL_BOL stubs_sha256; /* stubs are SHA256 hashes precomputed by the signer */
         } file;
 
         struct {
@@ -158,6 +152,7 @@ typedef struct pal_handle
             PAL_BOL nonblocking;
             PAL_SESSION_KEY session_key;
             void* ssl_ctx;
+            PAL_BOL same_enclave; /* the other end has the same mr_enclave */
         } process;
 
         struct pal_handle_thread thread;
@@ -170,11 +165,18 @@ typedef struct pal_handle
             } mutex;
 
             struct {
-                struct atomic_int * signaled;
-                struct atomic_int nwaiters;
+                int* signaled; /* futex word in untrusted memory */
+                int nwaiters;
                 PAL_BOL isnotification;
             } event;
         };
+
+        struct {
+            PAL_IDX fd;    /* host epoll instance */
+            PAL_PTR items; /* registered handles, indexed by slot (see db_object.c) */
+            PAL_NUM size;
+            PAL_LOCK lock;
+        } waitset;
     };
 } * PAL_HANDLE;
 
@@ -135,12 +135,13 @@ int init_trusted_files (void);
  * stubptr:  buffer for catching matched file stub.
  * sizeptr:  size pointer
  * create:   this file is newly created or not
+ * stubs_sha256: set if stubs are SHA256 hashes precomputed by the signer
  *
  * return:  0 succeed
  */
 
 int load_trusted_file(PAL_HANDLE file, sgx_stub_t** stubptr, uint64_t* sizeptr, int create,
-                      void** umem);
+                      void** umem, bool* stubs_sha256);
 
 enum {
     FILE_CHECK_POLICY_STRICT = 0,
@@ -154,11 +155,13 @@ int get_file_check_policy (void);
 int copy_and_verify_trusted_file (const char * path, const void * umem,
                     uint64_t umem_start, uint64_t umem_end,
                     void * buffer, uint64_t offset, uint64_t size,
-                    sgx_stub_t * stubs, uint64_t total_size);
+                    sgx_stub_t * stubs, bool stubs_sha256, uint64_t total_size);
 
 int init_trusted_children (void);
 int register_trusted_child (const char * uri, const char * mr_enclave_str);
 
+int init_thread_pool(void);
+
 /* exchange and establish a 256-bit session key */
 int _DkStreamKeyExchange(PAL_HANDLE stream, PAL_SESSION_KEY* key);
 
@@ -219,6 +222,17 @@ int _DkStreamSecureRead(LIB_SSL_CONTEXT* ssl_ctx, uint8_t* buf, size_t len);
 int _DkStreamSecureWrite(LIB_SSL_CONTEXT* ssl_ctx, const uint8_t* buf, size_t len);
 int _DkStreamSecureSave(LIB_SSL_CONTEXT* ssl_ctx, const uint8_t** obuf, size_t* olen);
 
+/*
+ * send_trusted_file_stubs, receive_trusted_file_stubs:
+ * Hand down the stubs of already verified trusted files from a parent to a child enclave
+ *
+ * @ssl_ctx:      secure process channel between the parent and the child
+ * @same_enclave: the other end has the same mr_enclave (the stubs are only sent and installed
+ *                in that case)
+ */
+int send_trusted_file_stubs(LIB_SSL_CONTEXT* ssl_ctx, bool same_enclave);
+int receive_trusted_file_stubs(LIB_SSL_CONTEXT* ssl_ctx, bool same_enclave);
+
 #include "sgx_arch.h"
 
 #define PAL_ENCLAVE_INITIALIZED     0x0001ULL
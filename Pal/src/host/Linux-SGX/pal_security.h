@@ -59,6 +59,14 @@ struct pal_sec {
 #if PRINT_ENCLAVE_STAT == 1
     PAL_NUM         start_time;
 #endif
+
+    /* host-side startup timestamps (in microseconds) for PAL_CONTROL::startup_events; they
+     * come from the untrusted host and are only used for reporting */
+    PAL_NUM         host_start_time;
+    PAL_NUM         ecreate_time;
+    PAL_NUM         einit_start_time;
+    PAL_NUM         einit_end_time;
+    PAL_NUM         ecall_time;
 };
 
 #ifdef IN_ENCLAVE
@@ -1,4 +1,5 @@
 #include "ecall_types.h"
+#include "ocall_profile.h"
 #include "ocall_types.h"
 #include "pal_linux_error.h"
 #include "pal_security.h"
@@ -55,8 +56,10 @@ static long sgx_ocall_exit(void* pms)
     }
 
     /* exit the whole process if exit_group() */
-    if (ms->ms_is_exitgroup)
+    if (ms->ms_is_exitgroup) {
+        dump_ocall_profile();
         INLINE_SYSCALL(exit_group, 1, (int)ms->ms_exitcode);
+    }
 
     /* otherwise call SGX-related thread reset and exit this thread */
     block_async_signals(true);
@@ -66,6 +69,7 @@ static long sgx_ocall_exit(void* pms)
 
     if (!current_enclave_thread_cnt()) {
         /* no enclave threads left, kill the whole process */
+        dump_ocall_profile();
         INLINE_SYSCALL(exit_group, 1, (int)ms->ms_exitcode);
     }
 
@@ -650,6 +654,91 @@ static long sgx_ocall_get_quote(void* pms) {
                           &ms->ms_quote, &ms->ms_quote_len);
 }
 
+/* same as _DkStreamTransfer() of the Linux PAL: copy_file_range() between two files, sendfile()
+ * from a file and splice() otherwise */
+static long sgx_ocall_transfer(void* pms) {
+    ms_ocall_transfer_t* ms = (ms_ocall_transfer_t*)pms;
+    long ret;
+    ODEBUG(OCALL_TRANSFER, ms);
+
+    int64_t src_off = ms->ms_src_offset;
+    int64_t dst_off = ms->ms_dst_offset;
+
+    if (src_off >= 0 && dst_off >= 0)
+        ret = INLINE_SYSCALL(copy_file_range, 6, ms->ms_src_fd, &src_off, ms->ms_dst_fd, &dst_off,
+                             ms->ms_count, 0);
+    else if (src_off >= 0)
+        ret = INLINE_SYSCALL(sendfile, 4, ms->ms_dst_fd, ms->ms_src_fd, &src_off, ms->ms_count);
+    else
+        ret = INLINE_SYSCALL(splice, 6, ms->ms_src_fd, NULL, ms->ms_dst_fd,
+                             dst_off >= 0 ? &dst_off : NULL, ms->ms_count, 0);
+
+    return ret;
+}
+
+static long sgx_ocall_epoll_create(void* pms) {
+    ms_ocall_epoll_create_t* ms = (ms_ocall_epoll_create_t*)pms;
+    long ret;
+    ODEBUG(OCALL_EPOLL_CREATE, ms);
+    ret = INLINE_SYSCALL(epoll_create1, 1, ms->ms_flags);
+    return ret;
+}
+
+static long sgx_ocall_epoll_ctl(void* pms) {
+    ms_ocall_epoll_ctl_t* ms = (ms_ocall_epoll_ctl_t*)pms;
+    long ret;
+    ODEBUG(OCALL_EPOLL_CTL, ms);
+    ret = INLINE_SYSCALL(epoll_ctl, 4, ms->ms_epfd, ms->ms_op, ms->ms_fd, &ms->ms_event);
+    return ret;
+}
+
+static long sgx_ocall_epoll_wait(void* pms) {
+    ms_ocall_epoll_wait_t* ms = (ms_ocall_epoll_wait_t*)pms;
+    long ret;
+    ODEBUG(OCALL_EPOLL_WAIT, ms);
+    int timeout_ms = ms->ms_timeout_us < 0 ? -1 : (int)((ms->ms_timeout_us + 999) / 1000);
+    ret = INLINE_SYSCALL(epoll_wait, 4, ms->ms_epfd, ms->ms_events, ms->ms_maxevents, timeout_ms);
+    return ret;
+}
+
+static long sgx_ocall_sched_setaffinity(void* pms) {
+    ms_ocall_sched_affinity_t* ms = (ms_ocall_sched_affinity_t*)pms;
+    ODEBUG(OCALL_SCHED_SETAFFINITY, ms);
+    /* the enclave thread may be the one issuing an exitless OCALL, so look up its host thread */
+    int tid = get_tid_from_tcs(ms->ms_tcs);
+    if (tid < 0)
+        return tid;
+    return INLINE_SYSCALL(sched_setaffinity, 3, tid, ms->ms_cpumask_size, ms->ms_cpu_mask);
+}
+
+static long sgx_ocall_sched_getaffinity(void* pms) {
+    ms_ocall_sched_affinity_t* ms = (ms_ocall_sched_affinity_t*)pms;
+    ODEBUG(OCALL_SCHED_GETAFFINITY, ms);
+    int tid = get_tid_from_tcs(ms->ms_tcs);
+    if (tid < 0)
+        return tid;
+    return INLINE_SYSCALL(sched_getaffinity, 3, tid, ms->ms_cpumask_size, ms->ms_cpu_mask);
+}
+
+static long sgx_ocall_fallocate(void* pms) {
+    ms_ocall_fallocate_t* ms = (ms_ocall_fallocate_t*)pms;
+    ODEBUG(OCALL_FALLOCATE, ms);
+    return INLINE_SYSCALL(fallocate, 4, ms->ms_fd, ms->ms_mode, ms->ms_offset, ms->ms_length);
+}
+
+static long sgx_ocall_fadvise(void* pms) {
+    ms_ocall_file_range_t* ms = (ms_ocall_file_range_t*)pms;
+    ODEBUG(OCALL_FADVISE, ms);
+    return INLINE_SYSCALL(fadvise64, 4, ms->ms_fd, ms->ms_offset, ms->ms_length, ms->ms_flags);
+}
+
+static long sgx_ocall_sync_file_range(void* pms) {
+    ms_ocall_file_range_t* ms = (ms_ocall_file_range_t*)pms;
+    ODEBUG(OCALL_SYNC_FILE_RANGE, ms);
+    return INLINE_SYSCALL(sync_file_range, 4, ms->ms_fd, ms->ms_offset, ms->ms_length,
+                          ms->ms_flags);
+}
+
 sgx_ocall_fn_t ocall_table[OCALL_NR] = {
         [OCALL_EXIT]             = sgx_ocall_exit,
         [OCALL_MMAP_UNTRUSTED]   = sgx_ocall_mmap_untrusted,
@@ -689,6 +778,15 @@ sgx_ocall_fn_t ocall_table[OCALL_NR] = {
         [OCALL_LOAD_DEBUG]       = sgx_ocall_load_debug,
         [OCALL_EVENTFD]          = sgx_ocall_eventfd,
         [OCALL_GET_QUOTE]        = sgx_ocall_get_quote,
+        [OCALL_TRANSFER]         = sgx_ocall_transfer,
+        [OCALL_EPOLL_CREATE]     = sgx_ocall_epoll_create,
+        [OCALL_EPOLL_CTL]        = sgx_ocall_epoll_ctl,
+        [OCALL_EPOLL_WAIT]       = sgx_ocall_epoll_wait,
+        [OCALL_SCHED_SETAFFINITY] = sgx_ocall_sched_setaffinity,
+        [OCALL_SCHED_GETAFFINITY] = sgx_ocall_sched_getaffinity,
+        [OCALL_FALLOCATE]        = sgx_ocall_fallocate,
+        [OCALL_FADVISE]          = sgx_ocall_fadvise,
+        [OCALL_SYNC_FILE_RANGE]  = sgx_ocall_sync_file_range,
     };
 
 #define EDEBUG(code, ms) do {} while (0)
@@ -705,6 +803,18 @@ static int rpc_thread_loop(void* arg) {
     __sigdelset(&mask, SIGUSR2);
     INLINE_SYSCALL(rt_sigprocmask, 4, SIG_SETMASK, &mask, NULL, sizeof(mask));
 
+    /* RPC threads spin, so keep them off the CPUs of the enclave threads if asked to */
+    for (size_t i = 0; i < ARRAY_SIZE(pal_enclave.rpc_thread_cpus); i++) {
+        if (pal_enclave.rpc_thread_cpus[i]) {
+            int ret = INLINE_SYSCALL(sched_setaffinity, 3, 0, sizeof(pal_enclave.rpc_thread_cpus),
+                                     pal_enclave.rpc_thread_cpus);
+            if (IS_ERR(ret))
+                SGX_DBG(DBG_E, "Pinning RPC thread to sgx.rpc_thread_cpus failed (%d)\n",
+                        ERRNO(ret));
+            break;
+        }
+    }
+
     spinlock_lock(&g_rpc_queue->lock);
     g_rpc_queue->rpc_threads[g_rpc_queue->rpc_threads_cnt] = mytid;
     g_rpc_queue->rpc_threads_cnt++;
@@ -718,8 +828,12 @@ static int rpc_thread_loop(void* arg) {
         }
 
         /* call actual function and notify awaiting enclave thread when done */
-        sgx_ocall_fn_t f = ocall_table[req->ocall_index];
-        req->result = f(req->buffer);
+        if (g_ocall_profile) {
+            req->result = sgx_profile_ocall(req->ocall_index, req->buffer, /*exitless=*/true);
+        } else {
+            sgx_ocall_fn_t f = ocall_table[req->ocall_index];
+            req->result = f(req->buffer);
+        }
 
         /* this code is based on Mutex 2 from Futexes are Tricky */
         int old_lock_state = __atomic_fetch_sub(&req->lock.lock, 1, __ATOMIC_ACQ_REL);
@@ -804,6 +918,7 @@ int ecall_enclave_start (char * args, size_t args_size, char * env, size_t env_s
     ms.ms_env_size = env_size;
     ms.ms_sec_info = &pal_enclave.pal_sec;
     ms.rpc_queue = g_rpc_queue;
+    ms.ocall_profile = g_ocall_profile;
     EDEBUG(ECALL_ENCLAVE_START, &ms);
     return sgx_ecall(ECALL_ENCLAVE_START, &ms);
 }
@@ -62,6 +62,9 @@ uint16_t htons (uint16_t shortval);
 uint32_t ntohl (uint32_t longval);
 uint16_t ntohs (uint16_t shortval);
 
+/* covers the CPUs that RPC threads can be pinned to */
+#define RPC_CPU_MASK_SIZE 128
+
 extern struct pal_enclave {
     /* attributes */
     unsigned long baseaddr;
@@ -70,6 +73,9 @@ extern struct pal_enclave {
     unsigned long rpc_thread_num;
     unsigned long ssaframesize;
 
+    /* CPUs the RPC threads are pinned to (sgx.rpc_thread_cpus), all zeroes if not pinned */
+    unsigned long rpc_thread_cpus[RPC_CPU_MASK_SIZE / sizeof(unsigned long)];
+
     /* files */
     int manifest;
     int exec;
@@ -136,6 +142,7 @@ int sgx_raise (int event);
 void async_exit_pointer (void);
 
 int interrupt_thread (void * tcs);
+int get_tid_from_tcs(void* tcs);
 int clone_thread (void);
 
 void create_tcs_mapper (void * tcs_base, unsigned int thread_num);
@@ -153,4 +160,9 @@ int sgx_signal_setup (void);
 int block_signals (bool block, const int * sigs, int nsig);
 int block_async_signals (bool block);
 
+/* OCALL profiler ("sgx.ocall_profile"), see ocall_profile.h */
+int init_ocall_profile(struct config_store* config);
+long sgx_profile_ocall(unsigned long code, void* ms, bool exitless);
+void dump_ocall_profile(void);
+
 #endif
@@ -45,6 +45,12 @@ char * alloc_concat(const char * p, size_t plen,
     return buf;
 }
 
+static unsigned long host_time_usec(void) {
+    struct timeval tv;
+    INLINE_SYSCALL(gettimeofday, 2, &tv, NULL);
+    return tv.tv_sec * 1000000UL + tv.tv_usec;
+}
+
 static unsigned long parse_int (const char * str)
 {
     unsigned long num = 0;
@@ -317,6 +323,18 @@ int initialize_enclave (struct pal_enclave * enclave)
         enclave->rpc_thread_num = 0;  /* by default, do not use exitless feature */
     }
 
+    if (get_config(enclave->config, "sgx.rpc_thread_cpus", cfgbuf, sizeof(cfgbuf)) > 0) {
+        if (parse_cpu_mask(cfgbuf, enclave->rpc_thread_cpus, RPC_CPU_MASK_SIZE * 8) < 0) {
+            SGX_DBG(DBG_E, "Invalid CPU list in sgx.rpc_thread_cpus\n");
+            ret = -EINVAL;
+            goto out;
+        }
+    }
+
+    ret = init_ocall_profile(enclave->config);
+    if (ret < 0)
+        goto out;
+
     if (get_config(enclave->config, "sgx.static_address", cfgbuf, sizeof(cfgbuf)) > 0 && cfgbuf[0] == '1') {
         enclave->baseaddr = ALIGN_DOWN_POW2(heap_min, enclave->size);
     } else {
@@ -340,6 +358,7 @@ int initialize_enclave (struct pal_enclave * enclave)
     memset(&enclave_secs, 0, sizeof(enclave_secs));
     enclave_secs.base = enclave->baseaddr;
     enclave_secs.size = enclave->size;
+    enclave->pal_sec.ecreate_time = host_time_usec();
     ret = create_enclave(&enclave_secs, &enclave_token);
     if (ret < 0) {
         SGX_DBG(DBG_E, "Creating enclave failed: %d\n", -ret);
@@ -599,11 +618,13 @@ int initialize_enclave (struct pal_enclave * enclave)
         }
     }
 
+    enclave->pal_sec.einit_start_time = host_time_usec();
     ret = init_enclave(&enclave_secs, &enclave_sigstruct, &enclave_token);
     if (ret < 0) {
         SGX_DBG(DBG_E, "Initializing enclave failed: %d\n", -ret);
         goto out;
     }
+    enclave->pal_sec.einit_end_time = host_time_usec();
 
     create_tcs_mapper((void *) enclave_secs.base + tcs_area->addr, enclave->thread_num);
 
@@ -750,10 +771,9 @@ static int load_enclave (struct pal_enclave * enclave,
     struct pal_sec * pal_sec = &enclave->pal_sec;
     int ret;
 
+    pal_sec->host_start_time = host_time_usec();
 #if PRINT_ENCLAVE_STAT == 1
-    struct timeval tv;
-    INLINE_SYSCALL(gettimeofday, 2, &tv, NULL);
-    pal_sec->start_time = tv.tv_sec * 1000000UL + tv.tv_usec;
+    pal_sec->start_time = pal_sec->host_start_time;
 #endif
 
     ret = open_gsgx();
@@ -917,6 +937,7 @@ static int load_enclave (struct pal_enclave * enclave,
     pal_thread_init(tcb);
 
     /* start running trusted PAL */
+    pal_sec->ecall_time = host_time_usec();
     ecall_enclave_start(args, args_size, env, env_size);
 
     unmap_tcs();
@@ -0,0 +1,192 @@
+/*
+ * sgx_profile.c
+ *
+ * Untrusted part of the OCALL profiler (see ocall_profile.h): times the OCALL handlers of the
+ * untrusted runtime and writes the profile, including the counters maintained by the enclave,
+ * when the process exits.
+ */
+
+#include "ocall_profile.h"
+#include "pal_internal.h"
+#include "sgx_internal.h"
+
+#include <asm/errno.h>
+#include <asm/fcntl.h>
+#include <asm/mman.h>
+
+extern sgx_ocall_fn_t ocall_table[OCALL_NR];
+
+ocall_profile_t* g_ocall_profile = NULL;
+
+static char ocall_profile_path[256];
+static uint64_t start_tsc;
+static uint64_t start_usec;
+static bool ocall_profile_dumped = false;
+
+static const char* ocall_names[OCALL_NR] = {
+    [OCALL_EXIT]             = "exit",
+    [OCALL_MMAP_UNTRUSTED]   = "mmap_untrusted",
+    [OCALL_MUNMAP_UNTRUSTED] = "munmap_untrusted",
+    [OCALL_CPUID]            = "cpuid",
+    [OCALL_OPEN]             = "open",
+    [OCALL_CLOSE]            = "close",
+    [OCALL_READ]             = "read",
+    [OCALL_WRITE]            = "write",
+    [OCALL_PREAD]            = "pread",
+    [OCALL_PWRITE]           = "pwrite",
+    [OCALL_FSTAT]            = "fstat",
+    [OCALL_FIONREAD]         = "fionread",
+    [OCALL_FSETNONBLOCK]     = "fsetnonblock",
+    [OCALL_FCHMOD]           = "fchmod",
+    [OCALL_FSYNC]            = "fsync",
+    [OCALL_FTRUNCATE]        = "ftruncate",
+    [OCALL_MKDIR]            = "mkdir",
+    [OCALL_GETDENTS]         = "getdents",
+    [OCALL_RESUME_THREAD]    = "resume_thread",
+    [OCALL_CLONE_THREAD]     = "clone_thread",
+    [OCALL_CREATE_PROCESS]   = "create_process",
+    [OCALL_FUTEX]            = "futex",
+    [OCALL_SOCKETPAIR]       = "socketpair",
+    [OCALL_LISTEN]           = "listen",
+    [OCALL_ACCEPT]           = "accept",
+    [OCALL_CONNECT]          = "connect",
+    [OCALL_RECV]             = "recv",
+    [OCALL_SEND]             = "send",
+    [OCALL_SETSOCKOPT]       = "setsockopt",
+    [OCALL_SHUTDOWN]         = "shutdown",
+    [OCALL_GETTIME]          = "gettime",
+    [OCALL_SLEEP]            = "sleep",
+    [OCALL_POLL]             = "poll",
+    [OCALL_RENAME]           = "rename",
+    [OCALL_DELETE]           = "delete",
+    [OCALL_LOAD_DEBUG]       = "load_debug",
+    [OCALL_EVENTFD]          = "eventfd",
+    [OCALL_GET_QUOTE]        = "get_quote",
+    [OCALL_TRANSFER]         = "transfer",
+    [OCALL_EPOLL_CREATE]     = "epoll_create",
+    [OCALL_EPOLL_CTL]        = "epoll_ctl",
+    [OCALL_EPOLL_WAIT]       = "epoll_wait",
+    [OCALL_SCHED_SETAFFINITY] = "sched_setaffinity",
+    [OCALL_SCHED_GETAFFINITY] = "sched_getaffinity",
+    [OCALL_FALLOCATE]        = "fallocate",
+    [OCALL_FADVISE]          = "fadvise",
+    [OCALL_SYNC_FILE_RANGE]  = "sync_file_range",
+};
+
+static inline uint64_t get_tsc(void) {
+    uint32_t lo, hi;
+    __asm__ volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static uint64_t get_usec(void) {
+    struct timeval tv;
+    INLINE_SYSCALL(gettimeofday, 2, &tv, NULL);
+    return tv.tv_sec * 1000000UL + tv.tv_usec;
+}
+
+int init_ocall_profile(struct config_store* config) {
+    char cfgbuf[CONFIG_MAX];
+    ssize_t len = get_config(config, "sgx.ocall_profile", cfgbuf, sizeof(cfgbuf));
+    if (len <= 0)
+        return 0;
+
+    if (!strstartswith_static(cfgbuf, URI_PREFIX_FILE)) {
+        SGX_DBG(DBG_E, "sgx.ocall_profile must be a file: URI (%s)\n", cfgbuf);
+        return -EINVAL;
+    }
+
+    /* child processes read the same manifest, give each its own file (sgx_init_child_process()
+     * already set ppid) */
+    const char* path = cfgbuf + URI_PREFIX_FILE_LEN;
+    if (!pal_enclave.pal_sec.ppid)
+        snprintf(ocall_profile_path, sizeof(ocall_profile_path), "%s", path);
+    else
+        snprintf(ocall_profile_path, sizeof(ocall_profile_path), "%s.%d", path,
+                 (int)INLINE_SYSCALL(getpid, 0));
+
+    ocall_profile_t* profile = (ocall_profile_t*)INLINE_SYSCALL(
+        mmap, 6, NULL, ALIGN_UP(sizeof(*profile), PRESET_PAGESIZE), PROT_READ | PROT_WRITE,
+        MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (IS_ERR_P(profile))
+        return -ENOMEM;
+
+    start_tsc  = get_tsc();
+    start_usec = get_usec();
+    g_ocall_profile = profile;
+    return 0;
+}
+
+/* Called by sgx_entry.S instead of the handler when profiling is enabled, and by RPC threads. The
+ * OCALL is counted before calling the handler because OCALL_EXIT may not return. */
+long sgx_profile_ocall(unsigned long code, void* ms, bool exitless) {
+    if (code >= OCALL_NR)
+        return -EINVAL;
+
+    struct ocall_profile_entry* entry = &g_ocall_profile->ocalls[code];
+    __atomic_add_fetch(exitless ? &entry->exitless_calls : &entry->calls, 1, __ATOMIC_RELAXED);
+
+    uint64_t start = get_tsc();
+    long ret = ocall_table[code](ms);
+    __atomic_add_fetch(&entry->cycles, get_tsc() - start, __ATOMIC_RELAXED);
+    return ret;
+}
+
+static int write_all(int fd, const char* buf, size_t size) {
+    while (size) {
+        ssize_t ret = INLINE_SYSCALL(write, 3, fd, buf, size);
+        if (IS_ERR(ret)) {
+            if (ERRNO(ret) == EINTR)
+                continue;
+            return ret;
+        }
+        buf  += ret;
+        size -= ret;
+    }
+    return 0;
+}
+
+/* Several threads may exit the process at the same time, only the first one writes the profile.
+ * The profile stays allocated and g_ocall_profile is never reset: RPC threads and other exiting
+ * threads may still be counting OCALLs in it. */
+void dump_ocall_profile(void) {
+    ocall_profile_t* profile = g_ocall_profile;
+    if (!profile || __atomic_exchange_n(&ocall_profile_dumped, true, __ATOMIC_RELAXED))
+        return;
+
+    /* TSC cycles are converted using the TSC rate observed since init_ocall_profile() */
+    uint64_t elapsed_tsc  = get_tsc() - start_tsc;
+    uint64_t elapsed_usec = get_usec() - start_usec;
+    double usec_per_cycle = elapsed_tsc ? (double)elapsed_usec / elapsed_tsc : 0;
+
+    int fd = INLINE_SYSCALL(open, 3, ocall_profile_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                            0644);
+    if (IS_ERR(fd)) {
+        SGX_DBG(DBG_E, "Cannot open OCALL profile %s: %d\n", ocall_profile_path, ERRNO(fd));
+        return;
+    }
+
+    char line[256];
+    int len = snprintf(line, sizeof(line),
+                       "# ocall calls exitless_calls exitless_fallbacks time_us ustack_bytes\n");
+    int ret = write_all(fd, line, len);
+
+    for (int i = 0; !ret && i < OCALL_NR; i++) {
+        struct ocall_profile_entry* entry = &profile->ocalls[i];
+        if (!entry->calls && !entry->exitless_calls)
+            continue;
+        len = snprintf(line, sizeof(line), "%s %lu %lu %lu %lu %lu\n", ocall_names[i],
+                       entry->calls, entry->exitless_calls, entry->exitless_fallbacks,
+                       (uint64_t)(entry->cycles * usec_per_cycle), entry->ustack_bytes);
+        ret = write_all(fd, line, MIN(len, (int)sizeof(line) - 1));
+    }
+
+    if (!ret) {
+        len = snprintf(line, sizeof(line), "# aex %lu\n", profile->aex);
+        ret = write_all(fd, line, len);
+    }
+    if (ret < 0)
+        SGX_DBG(DBG_E, "Cannot write OCALL profile %s: %d\n", ocall_profile_path, ERRNO(ret));
+
+    INLINE_SYSCALL(close, 1, fd);
+}
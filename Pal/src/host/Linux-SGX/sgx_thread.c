@@ -224,14 +224,22 @@ int clone_thread(void) {
     return 0;
 }
 
-int interrupt_thread (void * tcs)
-{
-    int index = (sgx_arch_tcs_t *) tcs - enclave_tcs;
-    struct thread_map * map = &enclave_thread_map[index];
-    if (index >= enclave_thread_num)
+/* returns the host thread currently running the enclave thread with TCS `tcs`, -EINVAL if none */
+int get_tid_from_tcs(void* tcs) {
+    long index = (sgx_arch_tcs_t*)tcs - enclave_tcs;
+    if (index < 0 || index >= enclave_thread_num)
         return -EINVAL;
-    if (!map->tid)
+    unsigned int tid = __atomic_load_n(&enclave_thread_map[index].tid, __ATOMIC_RELAXED);
+    if (!tid)
         return -EINVAL;
-    INLINE_SYSCALL(tgkill, 3, pal_enclave.pal_sec.pid, map->tid, SIGCONT);
+    return tid;
+}
+
+int interrupt_thread (void * tcs)
+{
+    int tid = get_tid_from_tcs(tcs);
+    if (tid < 0)
+        return tid;
+    INLINE_SYSCALL(tgkill, 3, pal_enclave.pal_sec.pid, tid, SIGCONT);
     return 0;
 }
@@ -233,6 +233,26 @@ def get_checksum(filename):
     return digest.digest()
 
 
+def get_chunk_hashes(filename):
+    '''Compute the SHA256 hash of every TRUSTED_STUB_SIZE chunk of a file.
+
+    Returns the concatenated chunk hashes and the root hash over the file size
+    (little-endian 64-bit) followed by all chunk hashes.
+    '''
+    hashes = []
+    size = 0
+    with open(filename, 'rb') as file:
+        while True:
+            chunk = file.read(offs.TRUSTED_STUB_SIZE)
+            if not chunk:
+                break
+            size += len(chunk)
+            hashes.append(hashlib.sha256(chunk).digest())
+    hashes = b''.join(hashes)
+    root = hashlib.sha256(struct.pack('<Q', size) + hashes).digest()
+    return hashes, root
+
+
 def get_trusted_files(manifest, args, check_exist=True, do_checksum=True):
     targets = dict()
 
@@ -848,11 +868,24 @@ def main_sign(args):
               " sgx.ra_client_spid in the manifest. ***")
 
     # Get trusted checksums and measurements
+    precompute_chunks = manifest.get('sgx.precompute_chunk_hashes', '0') == '1'
+    if precompute_chunks:
+        chunks_path = args['output'] + '.chunks'
+        manifest['sgx.trusted_chunks_file'] = 'file:' + os.path.basename(chunks_path)
+        chunks_file = open(chunks_path, 'wb')
+
     print("Trusted files:")
     for key, val in get_trusted_files(manifest, args).items():
-        (uri, _, checksum) = val
+        (uri, target, checksum) = val
         print("    %s %s" % (checksum, uri))
         manifest['sgx.trusted_checksum.' + key] = checksum
+        if precompute_chunks:
+            (hashes, root) = get_chunk_hashes(target)
+            manifest['sgx.trusted_chunks.' + key] = '%d:%s' % (chunks_file.tell(), root.hex())
+            chunks_file.write(hashes)
+
+    if precompute_chunks:
+        chunks_file.close()
 
     print("Trusted children:")
     for key, val in get_trusted_children(manifest).items():
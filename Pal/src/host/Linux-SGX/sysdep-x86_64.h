@@ -44,6 +44,11 @@
 #define __NR_semtimedop 220
 #endif
 
+/* copy_file_range() was added in Linux 4.5 */
+#ifndef __NR_copy_file_range
+#define __NR_copy_file_range 326
+#endif
+
 #ifdef __ASSEMBLER__
 
 /* ELF uses byte-counts for .align, most others use log2 of count of bytes.  */
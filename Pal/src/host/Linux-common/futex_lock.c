@@ -0,0 +1,128 @@
+#include <asm/errno.h>
+#include <limits.h>
+
+#include "api.h"
+#include "atomic.h"
+#include "futex_lock.h"
+#include "pal.h"
+#include "pal_error.h"
+#include "pal_internal.h"
+#include "pal_linux_error.h"
+
+static int host_futex_wait_counted(int* addr, int val, int64_t timeout_us) {
+    __atomic_add_fetch(&__pal_control.host_futex_calls, 1, __ATOMIC_RELAXED);
+    return host_futex_wait(addr, val, timeout_us);
+}
+
+static int host_futex_wake_counted(int* addr, int nwake) {
+    __atomic_add_fetch(&__pal_control.host_futex_calls, 1, __ATOMIC_RELAXED);
+    return host_futex_wake(addr, nwake);
+}
+
+/* Spins while the mutex is held by someone else, for up to twice the average number of spins
+ * that were needed recently (plus some slack), so that spinning stops paying off quickly for
+ * mutexes which are held for long. */
+static bool futex_lock_spin(int* word, int* spins) {
+    int avg = __atomic_load_n(spins, __ATOMIC_RELAXED);
+    int max = MIN(FUTEX_LOCK_MAX_SPINS, avg * 2 + 10);
+    int i;
+    bool locked = false;
+
+    for (i = 0; i < max; i++) {
+        int val = FUTEX_LOCK_UNLOCKED;
+        if (__atomic_load_n(word, __ATOMIC_RELAXED) == FUTEX_LOCK_UNLOCKED &&
+            __atomic_compare_exchange_n(word, &val, FUTEX_LOCK_LOCKED, /*weak=*/false,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            locked = true;
+            break;
+        }
+        CPU_RELAX();
+    }
+
+    __atomic_store_n(spins, avg + (i - avg) / 8, __ATOMIC_RELAXED);
+    return locked;
+}
+
+int futex_lock_timeout(int* word, int* spins, int64_t timeout_us) {
+    int val = FUTEX_LOCK_UNLOCKED;
+    if (__atomic_compare_exchange_n(word, &val, FUTEX_LOCK_LOCKED, /*weak=*/false,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return 0;
+
+    if (timeout_us == 0)
+        return -PAL_ERROR_TRYAGAIN;
+
+    if (futex_lock_spin(word, spins))
+        return 0;
+
+    /* From now on the mutex is taken as contended: we cannot know whether other waiters are still
+     * sleeping, so the unlock has to wake one of them. */
+    while (__atomic_exchange_n(word, FUTEX_LOCK_CONTENDED, __ATOMIC_ACQUIRE) !=
+           FUTEX_LOCK_UNLOCKED) {
+        int ret = host_futex_wait_counted(word, FUTEX_LOCK_CONTENDED, timeout_us);
+        /* EAGAIN: the mutex was released before we went to sleep */
+        if (ret < 0 && ret != -EAGAIN)
+            return unix_to_pal_error(-ret);
+    }
+    return 0;
+}
+
+void futex_unlock(int* word) {
+    if (__atomic_exchange_n(word, FUTEX_LOCK_UNLOCKED, __ATOMIC_RELEASE) == FUTEX_LOCK_CONTENDED)
+        host_futex_wake_counted(word, 1);
+}
+
+/* Takes the signal of a synchronization event, or checks a notification event */
+static bool futex_event_try(int* signaled, bool isnotification) {
+    if (isnotification)
+        return __atomic_load_n(signaled, __ATOMIC_ACQUIRE) != 0;
+
+    int val = 1;
+    return __atomic_compare_exchange_n(signaled, &val, 0, /*weak=*/false, __ATOMIC_ACQUIRE,
+                                       __ATOMIC_RELAXED);
+}
+
+int futex_event_wait(int* signaled, int* nwaiters, bool isnotification, int64_t timeout_us) {
+    int ret = 0;
+
+    if (futex_event_try(signaled, isnotification))
+        return 0;
+
+    if (timeout_us == 0)
+        return -PAL_ERROR_TRYAGAIN;
+
+    /* Registering as a waiter before checking the event again (in the host) pairs with the setter
+     * storing the signal before reading the number of waiters, so a wakeup cannot be lost. */
+    __atomic_add_fetch(nwaiters, 1, __ATOMIC_SEQ_CST);
+
+    while (!futex_event_try(signaled, isnotification)) {
+        ret = host_futex_wait_counted(signaled, 0, timeout_us);
+        /* EAGAIN: the event was set before we went to sleep */
+        if (ret < 0 && ret != -EAGAIN) {
+            ret = unix_to_pal_error(-ret);
+            break;
+        }
+        ret = 0;
+    }
+
+    __atomic_sub_fetch(nwaiters, 1, __ATOMIC_SEQ_CST);
+    return ret;
+}
+
+int futex_event_set(int* signaled, int* nwaiters, bool isnotification, int wakeup) {
+    /* setting an already signaled event does not wake anyone again */
+    if (__atomic_exchange_n(signaled, 1, __ATOMIC_SEQ_CST) != 0)
+        return 0;
+
+    int nwake = __atomic_load_n(nwaiters, __ATOMIC_SEQ_CST);
+    if (!nwake)
+        return 0;
+
+    if (!isnotification)
+        nwake = 1;
+    else if (wakeup != -1 && nwake > wakeup)
+        nwake = wakeup;
+
+    int ret = host_futex_wake_counted(signaled, nwake);
+    return ret < 0 ? unix_to_pal_error(-ret) : ret;
+}
@@ -0,0 +1,168 @@
+#include <stdbool.h>
+
+#include "api.h"
+#include "pal.h"
+#include "pal_error.h"
+#include "pal_internal.h"
+#include "topology.h"
+
+#define SYSFS_CPU_DIR  "/sys/devices/system/cpu"
+#define SYSFS_NODE_DIR "/sys/devices/system/node"
+
+/* bound on CPU numbers, so that users can size CPU masks after the topology (Linux supports at most
+ * 8192 CPUs) */
+#define MAX_CPU_ID (1 << 16)
+
+/* bound on NUMA node numbers (Linux supports at most 1024 nodes) */
+#define MAX_NODE_ID (1 << 10)
+
+/* large enough for the CPU list of a node even when its CPUs are interleaved with other nodes */
+#define SYSFS_BUF_SIZE 4096
+
+static long read_sysfs_long(const char* path, char* buf) {
+    if (host_read_sysfs(path, buf, SYSFS_BUF_SIZE) <= 0)
+        return 0;
+    long val = strtol(buf, NULL, 10);
+    return val < 0 ? 0 : val;
+}
+
+struct topo_list {
+    PAL_CPU_TOPO* topo;
+    size_t num;
+    size_t max;
+    PAL_NUM node;  /* node whose CPU list is being parsed */
+    char* node_buf;
+};
+
+static int add_cpu(unsigned long id, void* arg) {
+    struct topo_list* list = arg;
+    /* the host lists CPUs in ascending order, which lets find_cpu() bisect */
+    if (list->num == list->max || (list->num && list->topo[list->num - 1].id >= id))
+        return -PAL_ERROR_INVAL;
+    list->topo[list->num++].id = id;
+    return 0;
+}
+
+static PAL_CPU_TOPO* find_cpu(struct topo_list* list, unsigned long id) {
+    size_t lo = 0, hi = list->num;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (list->topo[mid].id == id)
+            return &list->topo[mid];
+        if (list->topo[mid].id < id)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return NULL;
+}
+
+static int set_cpu_node(unsigned long id, void* arg) {
+    struct topo_list* list = arg;
+    PAL_CPU_TOPO* cpu = find_cpu(list, id);
+    if (cpu) /* offline CPUs are listed too */
+        cpu->node = list->node;
+    return 0;
+}
+
+static int read_node(unsigned long node, void* arg) {
+    struct topo_list* list = arg;
+    char path[64];
+    snprintf(path, sizeof(path), SYSFS_NODE_DIR "/node%lu/cpulist", node);
+    if (host_read_sysfs(path, list->node_buf, SYSFS_BUF_SIZE) <= 0)
+        return 0;
+    list->node = node;
+    /* CPUs above the last online one are offline, there is nothing to set for them */
+    return parse_cpu_list(list->node_buf, list->topo[list->num - 1].id, set_cpu_node, list);
+}
+
+static bool same_socket(const PAL_CPU_TOPO* a, const PAL_CPU_TOPO* b) {
+    return a->socket == b->socket;
+}
+
+static bool same_core(const PAL_CPU_TOPO* a, const PAL_CPU_TOPO* b) {
+    return a->socket == b->socket && a->core == b->core;
+}
+
+static bool same_node(const PAL_CPU_TOPO* a, const PAL_CPU_TOPO* b) {
+    return a->node == b->node;
+}
+
+/* there are at most a few hundred CPUs, so quadratic time is fine */
+static PAL_NUM count_distinct(const PAL_CPU_TOPO* topo, size_t num,
+                              bool (*same)(const PAL_CPU_TOPO*, const PAL_CPU_TOPO*)) {
+    PAL_NUM count = 0;
+    for (size_t i = 0; i < num; i++) {
+        size_t j = 0;
+        while (j < i && !same(&topo[j], &topo[i]))
+            j++;
+        if (j == i)
+            count++;
+    }
+    return count;
+}
+
+int get_cpu_topology(PAL_CPU_INFO* ci) {
+    ci->cpu_topology = NULL;
+    ci->cpu_sockets  = 1;
+    ci->cpu_cores    = ci->cpu_num;
+    ci->numa_nodes   = 1;
+
+    int ret;
+    char* buf = malloc(SYSFS_BUF_SIZE);
+    struct topo_list list = {
+        .topo = calloc(ci->cpu_num, sizeof(PAL_CPU_TOPO)),
+        .max  = ci->cpu_num,
+    };
+    if (!buf || !list.topo) {
+        ret = -PAL_ERROR_NOMEM;
+        goto out;
+    }
+
+    if (host_read_sysfs(SYSFS_CPU_DIR "/online", buf, SYSFS_BUF_SIZE) <= 0) {
+        ret = -PAL_ERROR_STREAMNOTEXIST;
+        goto out;
+    }
+    /* CPUs above MAX_CPU_ID are skipped, the count below does not match then */
+    ret = parse_cpu_list(buf, MAX_CPU_ID - 1, add_cpu, &list);
+    if (ret < 0)
+        goto out;
+    if (!list.num || list.num != ci->cpu_num) {
+        /* CPUs went on- or offline since cpu_num was computed (or the host is lying) */
+        ret = -PAL_ERROR_INCONSIST;
+        goto out;
+    }
+
+    for (size_t i = 0; i < list.num; i++) {
+        char path[80];
+        snprintf(path, sizeof(path), SYSFS_CPU_DIR "/cpu%lu/topology/physical_package_id",
+                 list.topo[i].id);
+        list.topo[i].socket = read_sysfs_long(path, buf);
+        snprintf(path, sizeof(path), SYSFS_CPU_DIR "/cpu%lu/topology/core_id", list.topo[i].id);
+        list.topo[i].core = read_sysfs_long(path, buf);
+    }
+
+    /* kernels without NUMA support have no node directory; everything is then on node 0 */
+    if (host_read_sysfs(SYSFS_NODE_DIR "/has_cpu", buf, SYSFS_BUF_SIZE) > 0) {
+        list.node_buf = malloc(SYSFS_BUF_SIZE);
+        if (!list.node_buf) {
+            ret = -PAL_ERROR_NOMEM;
+            goto out;
+        }
+        ret = parse_cpu_list(buf, MAX_NODE_ID - 1, read_node, &list);
+        free(list.node_buf);
+        if (ret < 0)
+            goto out;
+    }
+
+    ci->cpu_sockets  = count_distinct(list.topo, list.num, same_socket);
+    ci->cpu_cores    = count_distinct(list.topo, list.num, same_core);
+    ci->numa_nodes   = count_distinct(list.topo, list.num, same_node);
+    ci->cpu_topology = list.topo;
+    list.topo = NULL;
+    ret = 0;
+out:
+    free(list.topo);
+    free(buf);
+    return ret;
+}
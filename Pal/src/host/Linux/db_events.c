@@ -26,6 +26,7 @@
 #include <linux/time.h>
 
 #include "api.h"
+#include "futex_lock.h"
 #include "pal.h"
 #include "pal_debug.h"
 #include "pal_defs.h"
@@ -38,99 +39,28 @@ int _DkEventCreate(PAL_HANDLE* event, bool initialState, bool isnotification) {
     PAL_HANDLE ev = malloc(HANDLE_SIZE(event));
     SET_HANDLE_TYPE(ev, event);
     ev->event.isnotification = isnotification;
-    atomic_set(&ev->event.signaled, initialState ? 1 : 0);
-    atomic_set(&ev->event.nwaiters, 0);
+    ev->event.signaled       = initialState ? 1 : 0;
+    ev->event.nwaiters       = 0;
     *event = ev;
     return 0;
 }
 
 int _DkEventSet(PAL_HANDLE event, int wakeup) {
-    int ret = 0;
-
-    if (event->event.isnotification) {
-        // Leave it signaled, wake all
-        if (atomic_cmpxchg(&event->event.signaled, 0, 1) == 0) {
-            int nwaiters = atomic_read(&event->event.nwaiters);
-            if (nwaiters) {
-                if (wakeup != -1 && nwaiters > wakeup)
-                    nwaiters = wakeup;
-
-                ret = INLINE_SYSCALL(futex, 6, &event->event.signaled, FUTEX_WAKE, nwaiters, NULL,
-                                     NULL, 0);
-                if (IS_ERR(ret))
-                    atomic_set(&event->event.signaled, 0);
-            }
-        }
-    } else {
-        // Only one thread wakes up, leave unsignaled
-        ret = INLINE_SYSCALL(futex, 6, &event->event.signaled, FUTEX_WAKE, 1, NULL, NULL, 0);
-    }
-
-    return IS_ERR(ret) ? -PAL_ERROR_TRYAGAIN : ret;
+    return futex_event_set(&event->event.signaled, &event->event.nwaiters,
+                           event->event.isnotification, wakeup);
 }
 
 int _DkEventWaitTimeout(PAL_HANDLE event, int64_t timeout_us) {
-    int ret = 0;
-
-    if (timeout_us < 0)
-        return _DkEventWait(event);
-
-    if (!event->event.isnotification || !atomic_read(&event->event.signaled)) {
-        struct timespec waittime;
-        int64_t sec      = timeout_us / 1000000UL;
-        int64_t microsec = timeout_us - (sec * 1000000UL);
-        waittime.tv_sec  = sec;
-        waittime.tv_nsec = microsec * 1000;
-
-        atomic_inc(&event->event.nwaiters);
-
-        do {
-            ret =
-                INLINE_SYSCALL(futex, 6, &event->event.signaled, FUTEX_WAIT, 0, &waittime, NULL, 0);
-
-            if (IS_ERR(ret)) {
-                if (ERRNO(ret) == EWOULDBLOCK) {
-                    ret = 0;
-                } else {
-                    ret = unix_to_pal_error(ERRNO(ret));
-                    break;
-                }
-            }
-        } while (event->event.isnotification && !atomic_read(&event->event.signaled));
-
-        atomic_dec(&event->event.nwaiters);
-    }
-
-    return ret;
+    return futex_event_wait(&event->event.signaled, &event->event.nwaiters,
+                            event->event.isnotification, timeout_us);
 }
 
 int _DkEventWait(PAL_HANDLE event) {
-    int ret = 0;
-
-    if (!event->event.isnotification || !atomic_read(&event->event.signaled)) {
-        atomic_inc(&event->event.nwaiters);
-
-        do {
-            ret = INLINE_SYSCALL(futex, 6, &event->event.signaled, FUTEX_WAIT, 0, NULL, NULL, 0);
-
-            if (IS_ERR(ret)) {
-                if (ERRNO(ret) == EWOULDBLOCK) {
-                    ret = 0;
-                } else {
-                    ret = unix_to_pal_error(ERRNO(ret));
-                    break;
-                }
-            }
-        } while (event->event.isnotification && !atomic_read(&event->event.signaled));
-
-        atomic_dec(&event->event.nwaiters);
-    }
-
-    return ret;
+    return _DkEventWaitTimeout(event, -1);
 }
 
 int _DkEventClear(PAL_HANDLE event) {
-    atomic_set(&event->event.signaled, 0);
+    __atomic_store_n(&event->event.signaled, 0, __ATOMIC_RELAXED);
     return 0;
 }
 
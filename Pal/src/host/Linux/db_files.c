@@ -35,6 +35,8 @@
 typedef __kernel_pid_t pid_t;
 #undef __GLIBC__
 #include <linux/stat.h>
+#include <linux/falloc.h>
+#include <linux/fadvise.h>
 #include <asm/errno.h>
 
 /* 'open' operation for file streams */
@@ -96,6 +98,26 @@ static int64_t file_write (PAL_HANDLE handle, uint64_t offset, uint64_t count,
     return ret;
 }
 
+/* 'readv' and 'writev' operations for file streams: a single host preadv/pwritev, which takes
+   PAL_IOVEC as it is laid out like struct iovec */
+static int64_t file_readv(PAL_HANDLE handle, uint64_t offset, const PAL_IOVEC* vec, size_t vlen) {
+    int64_t ret = INLINE_SYSCALL(preadv, 5, handle->file.fd, vec, vlen, offset, 0);
+
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+
+    return ret;
+}
+
+static int64_t file_writev(PAL_HANDLE handle, uint64_t offset, const PAL_IOVEC* vec, size_t vlen) {
+    int64_t ret = INLINE_SYSCALL(pwritev, 5, handle->file.fd, vec, vlen, offset, 0);
+
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+
+    return ret;
+}
+
 /* 'close' operation for file streams. In this case, it will only
    close the file withou deleting it. */
 static int file_close (PAL_HANDLE handle)
@@ -178,6 +200,38 @@ static int file_flush (PAL_HANDLE handle)
     return 0;
 }
 
+/* the flags of DkStreamAllocate(), DkStreamAdvise() and DkStreamSyncRange() are passed to the
+ * host as they are */
+static_assert(PAL_ALLOCATE_KEEP_SIZE == FALLOC_FL_KEEP_SIZE &&
+              PAL_ALLOCATE_PUNCH_HOLE == FALLOC_FL_PUNCH_HOLE, "PAL_ALLOCATE_* differ from Linux");
+static_assert(PAL_ADVICE_WILLNEED == POSIX_FADV_WILLNEED &&
+              PAL_ADVICE_DONTNEED == POSIX_FADV_DONTNEED &&
+              PAL_ADVICE_NOREUSE == POSIX_FADV_NOREUSE, "PAL_ADVICE_* differ from Linux");
+
+/* 'allocate' operation for file stream. */
+static int file_allocate(PAL_HANDLE handle, uint64_t offset, uint64_t length, int flags) {
+    int ret = INLINE_SYSCALL(fallocate, 4, handle->file.fd, flags, offset, length);
+
+    if (IS_ERR(ret))
+        return ERRNO(ret) == EOPNOTSUPP ? -PAL_ERROR_NOTSUPPORT : unix_to_pal_error(ERRNO(ret));
+
+    return 0;
+}
+
+/* 'advise' operation for file stream. */
+static int file_advise(PAL_HANDLE handle, uint64_t offset, uint64_t length, int advice) {
+    int ret = INLINE_SYSCALL(fadvise64, 4, handle->file.fd, offset, length, advice);
+
+    return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : 0;
+}
+
+/* 'syncrange' operation for file stream. */
+static int file_syncrange(PAL_HANDLE handle, uint64_t offset, uint64_t length, int flags) {
+    int ret = INLINE_SYSCALL(sync_file_range, 4, handle->file.fd, offset, length, flags);
+
+    return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : 0;
+}
+
 static inline int file_stat_type (struct stat * stat)
 {
     if (S_ISREG(stat->st_mode))
@@ -307,11 +361,16 @@ struct handle_ops file_ops = {
         .open               = &file_open,
         .read               = &file_read,
         .write              = &file_write,
+        .readv              = &file_readv,
+        .writev             = &file_writev,
         .close              = &file_close,
         .delete             = &file_delete,
         .map                = &file_map,
         .setlength          = &file_setlength,
         .flush              = &file_flush,
+        .allocate           = &file_allocate,
+        .advise             = &file_advise,
+        .syncrange          = &file_syncrange,
         .attrquery          = &file_attrquery,
         .attrquerybyhdl     = &file_attrquerybyhdl,
         .attrsetbyhdl       = &file_attrsetbyhdl,
@@ -560,3 +619,101 @@ struct handle_ops dir_ops = {
         .attrsetbyhdl       = &file_attrsetbyhdl,
         .rename             = &dir_rename,
     };
+
+#define SHM_DIR     "/dev/shm"
+#define SHM_PREFIX  "graphene-%lu-"
+#define SHM_LOCK    "graphene-%lu.lock"
+
+/* 'open' operation for shared memory objects. "shm:<name>" is backed by a file in the host's
+   tmpfs; the name is prefixed with the instance id, so all processes of one instance (and only
+   them) see the same object. The handle is a regular file handle, so mapping it without
+   PAL_PROT_WRITECOPY creates a mapping shared with the other processes. Objects which are not
+   deleted explicitly are deleted when the last process of the instance exits (see
+   delete_instance_shm()). */
+static int shm_open (PAL_HANDLE * handle, const char * type, const char * uri,
+                     int access, int share, int create, int options)
+{
+    if (strcmp_static(type, URI_TYPE_SHM))
+        return -PAL_ERROR_INVAL;
+
+    if (!*uri || strchr(uri, '/'))
+        return -PAL_ERROR_INVAL;
+
+    char path[URI_MAX];
+    int len = snprintf(path, sizeof(path), SHM_DIR "/" SHM_PREFIX "%s",
+                       pal_state.instance_id, uri);
+    if (len < 0 || (size_t) len >= sizeof(path))
+        return -PAL_ERROR_TOOLONG;
+
+    return file_ops.open(handle, URI_TYPE_FILE, path, access, share, create, options);
+}
+
+struct handle_ops shm_ops = {
+        .open               = &shm_open,
+    };
+
+/* Every process of the instance holds a shared lock on the lock file of the instance, so that
+   the last one to exit can tell that it is the last (see delete_instance_shm()). The file is
+   opened with O_CLOEXEC: child processes take their own lock. */
+static int instance_lock_fd = -1;
+
+void init_instance_shm (PAL_NUM instance_id)
+{
+    char path[sizeof(SHM_DIR) + 32];
+    int len = snprintf(path, sizeof(path), SHM_DIR "/" SHM_LOCK, instance_id);
+    if (len < 0 || (size_t) len >= sizeof(path))
+        return;
+
+    int fd = INLINE_SYSCALL(open, 3, path, O_RDONLY|O_CREAT|O_CLOEXEC, 0600);
+    if (IS_ERR(fd))
+        return;
+
+    if (IS_ERR(INLINE_SYSCALL(flock, 2, fd, LOCK_SH))) {
+        INLINE_SYSCALL(close, 1, fd);
+        return;
+    }
+
+    instance_lock_fd = fd;
+}
+
+/* Deletes all shared memory objects of the current instance if this is the last process of the
+   instance to exit: only then can its shared lock on the lock file be made exclusive. */
+void delete_instance_shm (void)
+{
+    if (instance_lock_fd < 0)
+        return;
+
+    if (IS_ERR(INLINE_SYSCALL(flock, 2, instance_lock_fd, LOCK_EX|LOCK_NB)))
+        return;
+
+    char prefix[32];
+    int prefix_len = snprintf(prefix, sizeof(prefix), SHM_PREFIX, pal_state.instance_id);
+    if (prefix_len < 0 || (size_t) prefix_len >= sizeof(prefix))
+        return;
+
+    int fd = INLINE_SYSCALL(open, 3, SHM_DIR, O_RDONLY|O_DIRECTORY|O_CLOEXEC, 0);
+    if (IS_ERR(fd))
+        return;
+
+    char buf[DIRBUF_SIZE];
+    while (true) {
+        int size = INLINE_SYSCALL(getdents64, 3, fd, buf, sizeof(buf));
+        if (IS_ERR(size) || !size)
+            break;
+
+        for (int off = 0 ; off < size ; ) {
+            struct linux_dirent64 * dirent = (struct linux_dirent64 *) (buf + off);
+            if (strlen(dirent->d_name) > (size_t) prefix_len &&
+                !memcmp(dirent->d_name, prefix, prefix_len))
+                INLINE_SYSCALL(unlinkat, 3, fd, dirent->d_name, 0);
+            off += dirent->d_reclen;
+        }
+    }
+
+    INLINE_SYSCALL(close, 1, fd);
+
+    char path[sizeof(SHM_DIR) + 32];
+    int len = snprintf(path, sizeof(path), SHM_DIR "/" SHM_LOCK, pal_state.instance_id);
+    if (len > 0 && (size_t) len < sizeof(path))
+        INLINE_SYSCALL(unlink, 1, path);
+}
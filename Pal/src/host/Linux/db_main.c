@@ -31,6 +31,7 @@
 #include "pal_linux.h"
 #include "pal_linux_defs.h"
 #include "pal_security.h"
+#include "topology.h"
 
 #include <asm/errno.h>
 #include <asm/ioctls.h>
@@ -313,6 +314,10 @@ done_init:
 
     signal_setup();
 
+    init_instance_shm(linux_state.parent_process_id);
+
+    _DkStartupEvent("pal: initialize", start_time, _DkSystemTimeQuery());
+
     /* call to main function */
     pal_main((PAL_NUM) linux_state.parent_process_id,
              manifest, exec, NULL, parent, first_thread, argv, envp);
@@ -447,6 +452,20 @@ static double get_bogomips(void) {
     return sanitize_bogomips_value(get_bogomips_from_cpuinfo_buf(buf, sizeof(buf)));
 }
 
+int host_read_sysfs(const char* path, char* buf, size_t size) {
+    int fd = INLINE_SYSCALL(open, 3, path, O_RDONLY | O_CLOEXEC, 0);
+    if (IS_ERR(fd))
+        return -ERRNO(fd);
+
+    int ret = INLINE_SYSCALL(read, 3, fd, buf, size - 1);
+    INLINE_SYSCALL(close, 1, fd);
+    if (IS_ERR(ret))
+        return -ERRNO(ret);
+
+    buf[ret] = '\0';
+    return ret;
+}
+
 int _DkGetCPUInfo (PAL_CPU_INFO * ci)
 {
     unsigned int words[PAL_CPUID_WORD_NUM];
@@ -524,5 +543,9 @@ int _DkGetCPUInfo (PAL_CPU_INFO * ci)
         printf("Warning: bogomips could not be retrieved, passing 0.0 to the application\n");
     }
 
+    if (get_cpu_topology(ci) < 0) {
+        printf("Warning: could not read the CPU topology, reporting a single socket and NUMA node\n");
+    }
+
     return rv;
 }
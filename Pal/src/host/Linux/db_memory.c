@@ -30,6 +30,7 @@
 #include "api.h"
 
 #include <asm/mman.h>
+#include <linux/mman.h>
 #include <asm/fcntl.h>
 
 bool _DkCheckMemoryMappable (const void * addr, size_t size)
@@ -69,6 +70,23 @@ int _DkVirtualMemoryProtect (void * addr, size_t size, int prot)
     return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : 0;
 }
 
+int _DkVirtualMemoryRemap (void * addr, void * new_addr, size_t size)
+{
+    /* the host kernel moves the page table entries, no data is copied */
+    void * mem = (void *) INLINE_SYSCALL(mremap, 5, addr, size, size,
+                                         MREMAP_MAYMOVE|MREMAP_FIXED, new_addr);
+
+    return IS_ERR_P(mem) ? unix_to_pal_error(ERRNO_P(mem)) : 0;
+}
+
+int _DkVirtualMemoryDiscard (void * addr, size_t size)
+{
+    /* private anonymous pages are dropped and read back as zeros */
+    int ret = INLINE_SYSCALL(madvise, 3, addr, size, MADV_DONTNEED);
+
+    return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : 0;
+}
+
 static int read_proc_meminfo (const char * key, unsigned long * val)
 {
     int fd = INLINE_SYSCALL(open, 3, "/proc/meminfo", O_RDONLY, 0);
@@ -426,6 +426,9 @@ noreturn void _DkProcessExit (int exitcode)
         }
     }
 
+    /* shared memory objects of the instance go away with its last process */
+    delete_instance_shm();
+
     INLINE_SYSCALL(exit_group, 1, exitcode);
     while (true) {
         /* nothing */;
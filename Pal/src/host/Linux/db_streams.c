@@ -382,3 +382,71 @@ int _DkReceiveHandle(PAL_HANDLE hdl, PAL_HANDLE* cargo) {
     *cargo = handle;
     return 0;
 }
+
+/* returns the host FD of `handle` used for reads (or writes), -1 if there is none */
+static int handle_host_fd(PAL_HANDLE handle, bool write) {
+    for (int i = 0; i < MAX_FDS; i++)
+        if (HANDLE_HDR(handle)->flags & (write ? WFD(i) : RFD(i)))
+            return handle->generic.fds[i];
+    return -1;
+}
+
+static bool handle_transferable(PAL_HANDLE handle) {
+    switch (PAL_GET_TYPE(handle)) {
+        case pal_type_file:
+        case pal_type_pipe:
+        case pal_type_pipecli:
+        case pal_type_pipeprv:
+        case pal_type_dev:
+        case pal_type_tcp:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*!
+ * \brief Transfer up to `count` bytes from `src` to `dst` with a single host syscall.
+ *
+ * Uses copy_file_range() between two files, sendfile() from a file and splice() otherwise (the
+ * latter requires one of the streams to be a pipe). Offsets are only used for files.
+ *
+ * \return Number of bytes transferred (0 at the end of `src`), negative PAL error code otherwise;
+ *         -PAL_ERROR_NOTSUPPORT if the host cannot transfer between these streams.
+ */
+int64_t _DkStreamTransfer(PAL_HANDLE src, uint64_t src_offset, PAL_HANDLE dst, uint64_t dst_offset,
+                          uint64_t count) {
+    if (!handle_transferable(src) || !handle_transferable(dst))
+        return -PAL_ERROR_NOTSUPPORT;
+
+    int src_fd = handle_host_fd(src, /*write=*/false);
+    int dst_fd = handle_host_fd(dst, /*write=*/true);
+    if (src_fd < 0 || dst_fd < 0)
+        return -PAL_ERROR_DENIED;
+
+    int64_t src_off = src_offset;
+    int64_t dst_off = dst_offset;
+    bool src_file = IS_HANDLE_TYPE(src, file);
+    bool dst_file = IS_HANDLE_TYPE(dst, file);
+    long ret;
+
+    if (src_file && dst_file)
+        ret = INLINE_SYSCALL(copy_file_range, 6, src_fd, &src_off, dst_fd, &dst_off, count, 0);
+    else if (src_file)
+        ret = INLINE_SYSCALL(sendfile, 4, dst_fd, src_fd, &src_off, count);
+    else
+        ret = INLINE_SYSCALL(splice, 6, src_fd, NULL, dst_fd, dst_file ? &dst_off : NULL, count, 0);
+
+    if (IS_ERR(ret)) {
+        switch (ERRNO(ret)) {
+            case EINVAL:
+            case ENOSYS:
+            case EXDEV:
+            case EOPNOTSUPP:
+                return -PAL_ERROR_NOTSUPPORT;
+            default:
+                return unix_to_pal_error(ERRNO(ret));
+        }
+    }
+    return ret;
+}
@@ -300,6 +300,23 @@ int _DkThreadResume (PAL_HANDLE threadHandle)
     return 0;
 }
 
+int _DkThreadSetCpuAffinity(PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask) {
+    /* tid 0 is the calling thread for the host */
+    int tid = thread ? thread->thread.tid : 0;
+    int ret = INLINE_SYSCALL(sched_setaffinity, 3, tid, cpumask_size, cpu_mask);
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+    return 0;
+}
+
+int _DkThreadGetCpuAffinity(PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask) {
+    int tid = thread ? thread->thread.tid : 0;
+    int ret = INLINE_SYSCALL(sched_getaffinity, 3, tid, cpumask_size, cpu_mask);
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+    return 0;
+}
+
 struct handle_ops thread_ops = {
     /* nothing */
 };
@@ -29,23 +29,21 @@
 
 #include <atomic.h>
 
-/* Simpler mutex design: a single variable that tracks whether the
- * mutex is locked (just waste a 64 bit word for now).  State is 1 (locked) or
- * 0 (unlocked).
- * Keep a count of how many threads are waiting on the mutex.
+/* Three-state futex mutex (see futex_lock.h): `locked` is the futex word, `spins` tunes the
+ * adaptive spinning before sleeping in the host.
  * If DEBUG_MUTEX is defined,
  * mutex_handle will record the owner of mutex locking. */
 typedef struct mutex_handle {
-    volatile int64_t locked;
-    struct atomic_int nwaiters;
+    int locked;
+    int spins;
 #ifdef DEBUG_MUTEX
     int owner;
 #endif
 } PAL_LOCK;
 
 /* Initializer of Mutexes */
-#define MUTEX_HANDLE_INIT    { .locked = 0, .nwaiters.counter = 0 }
-#define INIT_MUTEX_HANDLE(m)  do { (m)->locked = 0; atomic_set(&(m)->nwaiters, 0); } while (0)
+#define MUTEX_HANDLE_INIT    { .locked = 0, .spins = 0 }
+#define INIT_MUTEX_HANDLE(m)  do { (m)->locked = 0; (m)->spins = 0; } while (0)
 
 #define LOCK_INIT MUTEX_HANDLE_INIT
 #define INIT_LOCK(lock) INIT_MUTEX_HANDLE(lock)
@@ -153,10 +151,17 @@ typedef struct pal_handle
         } mutex;
 
         struct {
-            struct atomic_int signaled;
-            struct atomic_int nwaiters;
+            int signaled; /* futex word */
+            int nwaiters;
             PAL_BOL isnotification;
         } event;
+
+        struct {
+            PAL_IDX fd;    /* host epoll instance */
+            PAL_PTR items; /* registered handles, indexed by slot (see db_object.c) */
+            PAL_NUM size;
+            PAL_LOCK lock;
+        } waitset;
     };
 } * PAL_HANDLE;
 
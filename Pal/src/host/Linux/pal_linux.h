@@ -147,6 +147,10 @@ int clone (int (*__fn) (void * __arg), void * __child_stack,
 /* set/unset CLOEXEC flags of all fds in a handle */
 int handle_set_cloexec (PAL_HANDLE handle, bool enable);
 
+/* delete the shared memory objects of the instance when its last process exits */
+void init_instance_shm (PAL_NUM instance_id);
+void delete_instance_shm (void);
+
 /* serialize/deserialize a handle into/from a malloc'ed buffer */
 int handle_serialize (PAL_HANDLE handle, void ** data);
 int handle_deserialize (PAL_HANDLE * handle, const void * data, int size);
@@ -37,6 +37,9 @@ static inline __attribute__((unused)) int unix_to_pal_error(int unix_errno) {
             return -PAL_ERROR_CONNFAILED;
         case EAFNOSUPPORT:
             return -PAL_ERROR_AFNOSUPPORT;
+        case ENOSPC:
+        case EDQUOT:
+            return -PAL_ERROR_NOSPACE;
         default:
             return -PAL_ERROR_DENIED;
     }
@@ -159,3 +159,12 @@ struct handle_ops dir_ops = {
     .attrquerybyhdl = &dir_attrquerybyhdl,
     .rename         = &dir_rename,
 };
+
+static int shm_open(PAL_HANDLE* handle, const char* type, const char* uri, int access, int share,
+                    int create, int options) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+struct handle_ops shm_ops = {
+    .open = &shm_open,
+};
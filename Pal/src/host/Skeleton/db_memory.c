@@ -43,6 +43,14 @@ int _DkVirtualMemoryProtect(void* addr, uint64_t size, int prot) {
     return -PAL_ERROR_NOTIMPLEMENTED;
 }
 
+int _DkVirtualMemoryRemap(void* addr, void* new_addr, uint64_t size) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int _DkVirtualMemoryDiscard(void* addr, uint64_t size) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
 unsigned long _DkMemoryQuota(void) {
     return 0;
 }
@@ -39,3 +39,20 @@ int _DkStreamsWaitEvents(size_t count, PAL_HANDLE* handle_array, PAL_FLG* events
                          int64_t timeout_us) {
     return -PAL_ERROR_NOTIMPLEMENTED;
 }
+
+struct handle_ops waitset_ops = {
+    /* nothing */
+};
+
+int _DkWaitSetCreate(PAL_HANDLE* handle) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int _DkWaitSetUpdate(PAL_HANDLE wait_set, PAL_HANDLE handle, PAL_FLG events) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int64_t _DkWaitSetWait(PAL_HANDLE wait_set, size_t count, PAL_HANDLE* handle_array,
+                       PAL_FLG* ret_events, int64_t timeout_us) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
@@ -49,3 +49,10 @@ int _DkSendHandle(PAL_HANDLE hdl, PAL_HANDLE cargo) {
 int _DkReceiveHandle(PAL_HANDLE hdl, PAL_HANDLE* cargo) {
     return -PAL_ERROR_NOTIMPLEMENTED;
 }
+
+/* _DkStreamTransfer for internal use. Transfer data between two streams
+   without copying it through the PAL. */
+int64_t _DkStreamTransfer(PAL_HANDLE src, uint64_t src_offset, PAL_HANDLE dst, uint64_t dst_offset,
+                          uint64_t count) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
@@ -93,6 +93,10 @@ typedef struct pal_handle {
         struct {
             PAL_IDX fd;
         } event;
+
+        struct {
+            PAL_IDX fd;
+        } waitset;
     };
 } * PAL_HANDLE;
 
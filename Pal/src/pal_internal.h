@@ -62,6 +62,11 @@ struct handle_ops {
     int64_t (*write) (PAL_HANDLE handle, uint64_t offset, uint64_t count,
                       const void * buffer);
 
+    /* 'readv' and 'writev' are used by DkStreamReadVector and DkStreamWriteVector; they read
+       or write the buffers in order, like 'read' and 'write' of their concatenation */
+    int64_t (*readv) (PAL_HANDLE handle, uint64_t offset, const PAL_IOVEC * vec, size_t vlen);
+    int64_t (*writev) (PAL_HANDLE handle, uint64_t offset, const PAL_IOVEC * vec, size_t vlen);
+
     /* 'readbyaddr' and 'writebyaddr' are the same as read and write,
        but with extra field to specify address */
     int64_t (*readbyaddr) (PAL_HANDLE handle, uint64_t offset, uint64_t count,
@@ -92,6 +97,12 @@ struct handle_ops {
     /* 'flush' is used by DkStreamFlush. It syncs the stream to the device */
     int (*flush) (PAL_HANDLE handle);
 
+    /* 'allocate', 'advise' and 'syncrange' are used by DkStreamAllocate, DkStreamAdvise and
+       DkStreamSyncRange, on ranges of files. */
+    int (*allocate) (PAL_HANDLE handle, uint64_t offset, uint64_t length, int flags);
+    int (*advise) (PAL_HANDLE handle, uint64_t offset, uint64_t length, int advice);
+    int (*syncrange) (PAL_HANDLE handle, uint64_t offset, uint64_t length, int flags);
+
     /* 'waitforclient' is used by DkStreamWaitforClient. It accepts an
        connection */
     int (*waitforclient) (PAL_HANDLE server, PAL_HANDLE *client);
@@ -233,6 +244,11 @@ int64_t _DkStreamRead (PAL_HANDLE handle, uint64_t offset, uint64_t count,
                        void * buf, char * addr, int addrlen);
 int64_t _DkStreamWrite (PAL_HANDLE handle, uint64_t offset, uint64_t count,
                         const void * buf, const char * addr, int addrlen);
+int64_t _DkStreamReadVector(PAL_HANDLE handle, uint64_t offset, const PAL_IOVEC* vec, size_t vlen);
+int64_t _DkStreamWriteVector(PAL_HANDLE handle, uint64_t offset, const PAL_IOVEC* vec,
+                             size_t vlen);
+int64_t _DkStreamTransfer(PAL_HANDLE src, uint64_t src_offset, PAL_HANDLE dst, uint64_t dst_offset,
+                          uint64_t count);
 int _DkStreamAttributesQuery (const char * uri, PAL_STREAM_ATTR * attr);
 int _DkStreamAttributesQueryByHandle (PAL_HANDLE hdl, PAL_STREAM_ATTR * attr);
 int _DkStreamMap (PAL_HANDLE handle, void ** addr, int prot, uint64_t offset,
@@ -240,6 +256,9 @@ int _DkStreamMap (PAL_HANDLE handle, void ** addr, int prot, uint64_t offset,
 int _DkStreamUnmap (void * addr, uint64_t size);
 int64_t _DkStreamSetLength (PAL_HANDLE handle, uint64_t length);
 int _DkStreamFlush (PAL_HANDLE handle);
+int _DkStreamAllocate(PAL_HANDLE handle, uint64_t offset, uint64_t length, int flags);
+int _DkStreamAdvise(PAL_HANDLE handle, uint64_t offset, uint64_t length, int advice);
+int _DkStreamSyncRange(PAL_HANDLE handle, uint64_t offset, uint64_t length, int flags);
 int _DkStreamGetName (PAL_HANDLE handle, char * buf, int size);
 const char * _DkStreamRealpath (PAL_HANDLE hdl);
 int _DkSendHandle(PAL_HANDLE hdl, PAL_HANDLE cargo);
@@ -252,6 +271,8 @@ noreturn void _DkThreadExit(int* clear_child_tid);
 int _DkThreadDelayExecution (unsigned long * duration);
 void _DkThreadYieldExecution (void);
 int _DkThreadResume (PAL_HANDLE threadHandle);
+int _DkThreadSetCpuAffinity(PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask);
+int _DkThreadGetCpuAffinity(PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask);
 int _DkProcessCreate (PAL_HANDLE * handle, const char * uri,
                       const char ** args);
 noreturn void _DkProcessExit (int exitCode);
@@ -275,6 +296,8 @@ int _DkEventClear (PAL_HANDLE event);
 int _DkVirtualMemoryAlloc (void ** paddr, uint64_t size, int alloc_type, int prot);
 int _DkVirtualMemoryFree (void * addr, uint64_t size);
 int _DkVirtualMemoryProtect (void * addr, uint64_t size, int prot);
+int _DkVirtualMemoryRemap (void * addr, void * new_addr, uint64_t size);
+int _DkVirtualMemoryDiscard (void * addr, uint64_t size);
 
 /* DkObject calls */
 int _DkObjectReference (PAL_HANDLE objectHandle);
@@ -282,6 +305,10 @@ int _DkObjectClose (PAL_HANDLE objectHandle);
 int _DkSynchronizationObjectWait(PAL_HANDLE handle, int64_t timeout_us);
 int _DkStreamsWaitEvents(size_t count, PAL_HANDLE* handle_array, PAL_FLG* events, PAL_FLG* ret_events,
                          int64_t timeout_us);
+int _DkWaitSetCreate(PAL_HANDLE* handle);
+int _DkWaitSetUpdate(PAL_HANDLE wait_set, PAL_HANDLE handle, PAL_FLG events);
+int64_t _DkWaitSetWait(PAL_HANDLE wait_set, size_t count, PAL_HANDLE* handle_array,
+                       PAL_FLG* ret_events, int64_t timeout_us);
 
 /* DkException calls & structures */
 PAL_EVENT_HANDLER _DkGetExceptionHandler (PAL_NUM event_num);
@@ -294,6 +321,11 @@ void _DkInternalUnlock(PAL_LOCK* mut);
 bool _DkInternalIsLocked(PAL_LOCK* mut);
 unsigned long _DkSystemTimeQuery (void);
 
+/* Records a phase of the PAL startup for PAL_CONTROL::startup_events; `name` must be a static
+ * string. Phases beyond PAL_STARTUP_EVENTS_MAX are dropped. */
+#define PAL_STARTUP_EVENTS_MAX 32
+void _DkStartupEvent(const char* name, unsigned long start, unsigned long end);
+
 /*
  * Cryptographically secure random.
  * 0 on success, negative on failure.